@@ -126,6 +126,19 @@ static int base_handle_id;
 /* Main lock for adding / removing handles */
 static struct mutex llist_mutex SHAREDBSS_ATTR;
 
+#ifdef HAVE_ALBUMART
+/* Scaled album art that wasn't in the cache on disk yet, written out from
+   the buffer when the thread is idle */
+#define ALBUMART_JOBS 4
+
+static struct albumart_job
+{
+    int handle_id;
+    struct albumart_cache_key key;
+} albumart_jobs[ALBUMART_JOBS];
+static int num_albumart_jobs;       /* protected by llist_mutex */
+#endif /* HAVE_ALBUMART */
+
 #define HLIST_HANDLE(node) \
     ({ struct lld_node *__node = (node); \
        (struct memory_handle *)__node; })
@@ -655,13 +668,24 @@ static bool buffer_handle(int handle_id, size_t to_buffer)
     trigger_cpu_boost();
 
     if (h->type == TYPE_ID3) {
-        if (!get_metadata(ringbuf_ptr(h->data), h->fd, h->path)) {
+        /* parse behind the record header, then pack it down in place */
+        struct mp3entry *id3 = ringbuf_ptr(h->data) +
+                               sizeof (struct mp3entry_packed);
+        if (!get_metadata(id3, h->fd, h->path)) {
             /* metadata parsing failed: clear the buffer. */
-            wipe_mp3entry(ringbuf_ptr(h->data));
+            wipe_mp3entry(id3);
         }
         close_fd(&h->fd);
-        h->widx = ringbuf_add(h->data, h->filesize);
-        h->end  = h->filesize;
+        size_t size = pack_mp3entry(ringbuf_ptr(h->data), id3);
+
+        /* the slack after the record is given back when the handle is next
+           shrunk, or right away to the next handle if this one is last */
+        mutex_lock(&llist_mutex);
+        h->filesize = size;
+        h->widx = ringbuf_add(h->data, size);
+        h->end  = size;
+        mutex_unlock(&llist_mutex);
+
         send_event(BUFFER_EVENT_FINISHED, &handle_id);
         return true;
     }
@@ -786,21 +810,13 @@ static struct memory_handle * shrink_handle(struct memory_handle *h)
         if (!move_handle(&h, &delta, data_size))
             return h;
 
-        size_t olddata = h->data;
         h->data = ringbuf_add(h->data, delta);
         h->ridx = ringbuf_add(h->ridx, delta);
         h->widx = ringbuf_add(h->widx, delta);
 
+        /* packed mp3entries don't point into themselves and move as is */
         switch (h->type)
         {
-            case TYPE_ID3:
-                if (h->filesize != sizeof(struct mp3entry))
-                    break;
-                /* when moving an mp3entry we need to readjust its pointers */
-                adjust_mp3entry(ringbuf_ptr(h->data), ringbuf_ptr(h->data),
-                                ringbuf_ptr(olddata));
-                break;
-
             case TYPE_BITMAP:
                 /* adjust the bitmap's pointer */
                 ((struct bitmap *)ringbuf_ptr(h->data))->data =
@@ -848,15 +864,19 @@ static bool fill_buffer(void)
 #ifdef HAVE_ALBUMART
 /* Given a file descriptor to a bitmap file, write the bitmap data to the
    buffer, with a struct bitmap and the actual data immediately following.
+   A copy already scaled to the size is taken from the cache on disk if there
+   is one; otherwise the image is decoded and queued for the cache.
    Return value is the total size (struct + data). */
 static int load_image(int fd, const char *path,
                       struct bufopen_bitmap_data *data,
-                      size_t bufidx)
+                      size_t bufidx, int handle_id)
 {
     int rc;
     struct bitmap *bmp = ringbuf_ptr(bufidx);
     struct dim *dim = data->dim;
     struct mp3_albumart *aa = data->embedded_albumart;
+    struct albumart_cache_key key;
+    bool cache;
 
     /* get the desired image size */
     bmp->width = dim->width, bmp->height = dim->height;
@@ -869,6 +889,16 @@ static int load_image(int fd, const char *path,
     int free = (int)MIN(buffer_len - bytes_used(), buffer_len - bufidx)
                         - sizeof(struct bitmap);
 
+    cache = albumart_cache_key(&key, path, fd, aa, dim);
+    if (cache) {
+        rc = albumart_cache_load(&key, bmp, free);
+        if (rc > 0)
+            return rc + sizeof(struct bitmap);
+
+        /* a failed load may have changed the size */
+        bmp->width = dim->width, bmp->height = dim->height;
+    }
+
 #ifdef HAVE_JPEG
     if (aa != NULL) {
         lseek(fd, aa->pos, SEEK_SET);
@@ -883,8 +913,38 @@ static int load_image(int fd, const char *path,
         rc = read_bmp_fd(fd, bmp, free, FORMAT_NATIVE|FORMAT_DITHER|
                          FORMAT_RESIZE|FORMAT_KEEP_ASPECT, NULL);
 
+    if (cache && rc > 0 && num_albumart_jobs < ALBUMART_JOBS) {
+        struct albumart_job *job = &albumart_jobs[num_albumart_jobs++];
+        job->handle_id = handle_id;
+        job->key = key;
+    }
+
     return rc + (rc > 0 ? sizeof(struct bitmap) : 0);
-    (void)path;
+}
+
+/* Write the oldest queued bitmap to the album art cache, if its handle is
+   still around. Only the buffering thread closes and moves handles, so the
+   data stays put while it's written without holding the lock. */
+static void write_albumart_job(void)
+{
+    struct albumart_job job;
+
+    mutex_lock(&llist_mutex);
+
+    job = albumart_jobs[0];
+    memmove(&albumart_jobs[0], &albumart_jobs[1],
+            --num_albumart_jobs*sizeof (albumart_jobs[0]));
+
+    struct memory_handle *h = find_handle(job.handle_id);
+    if (h && (h->type != TYPE_BITMAP || h->end < h->filesize))
+        h = NULL;
+
+    mutex_unlock(&llist_mutex);
+
+    if (h) {
+        albumart_cache_store(&job.key, ringbuf_ptr(h->data),
+                             h->filesize - sizeof(struct bitmap));
+    }
 }
 #endif /* HAVE_ALBUMART */
 
@@ -930,7 +990,8 @@ int bufopen(const char *file, off_t offset, enum data_type type,
         /* ID3 case: allocate space, init the handle and return. */
         mutex_lock(&llist_mutex);
 
-        h = add_handle(H_ALLOCALL, sizeof(struct mp3entry), file, &data);
+        /* room to parse a full mp3entry; shrinks to the packed record */
+        h = add_handle(H_ALLOCALL, MP3ENTRY_PACKED_MAX, file, &data);
 
         if (h) {
             handle_id = h->id;
@@ -940,7 +1001,7 @@ int bufopen(const char *file, off_t offset, enum data_type type,
             h->data     = data;
             h->ridx     = data;
             h->widx     = data;
-            h->filesize = sizeof(struct mp3entry);
+            h->filesize = MP3ENTRY_PACKED_MAX;
             h->start    = 0;
             h->pos      = 0;
             h->end      = 0;
@@ -1027,7 +1088,7 @@ int bufopen(const char *file, off_t offset, enum data_type type,
 #ifdef HAVE_ALBUMART
     if (type == TYPE_BITMAP) {
         /* Bitmap file: we load the data instead of the file */
-        int rc = load_image(fd, file, user_data, data);
+        int rc = load_image(fd, file, user_data, data, handle_id);
         if (rc <= 0) {
             handle_id = ERR_FILE_ERROR;
         } else {
@@ -1087,6 +1148,11 @@ int bufalloc(const void *src, size_t size, enum data_type type)
 
     int handle_id = ERR_BUFFER_FULL;
 
+    /* specially take care of struct mp3entry: it's stored packed */
+    bool pack = src && type == TYPE_ID3 && size == sizeof(struct mp3entry);
+    if (pack)
+        size = mp3entry_packed_size(src);
+
     mutex_lock(&llist_mutex);
 
     size_t data;
@@ -1096,9 +1162,8 @@ int bufalloc(const void *src, size_t size, enum data_type type)
         handle_id = h->id;
 
         if (src) {
-            if (type == TYPE_ID3 && size == sizeof(struct mp3entry)) {
-                /* specially take care of struct mp3entry */
-                copy_mp3entry(ringbuf_ptr(data), src);
+            if (pack) {
+                pack_mp3entry(ringbuf_ptr(data), src);
             } else {
                 memcpy(ringbuf_ptr(data), src, size);
             }
@@ -1698,6 +1763,12 @@ static void NORETURN_ATTR buffering_thread(void)
                     filling = fill_buffer();
                 }
             }
+#ifdef HAVE_ALBUMART
+            else if (num_albumart_jobs > 0) {
+                /* Nothing to buffer, one thumbnail per timeout */
+                write_albumart_job();
+            }
+#endif
         }
     }
 }
@@ -1758,6 +1829,9 @@ bool buffering_reset(char *buf, size_t buflen)
 
     num_handles = 0;
     base_handle_id = -1;
+#ifdef HAVE_ALBUMART
+    num_albumart_jobs = 0;
+#endif
 
     /* Set the high watermark as 75% full...or 25% empty :)
        This is the greatest fullness that will trigger low-buffer events
@@ -466,17 +466,24 @@ static void load_codec(const struct codec_load_info *ev_data)
         dsp_configure(ci.dsp, DSP_RESET, 0);
     }
 
+    const char *codec_fn = get_codec_filename(data.afmt);
+
+    /* First see if it's still resident */
+    if (codec_fn)
+        status = codec_load_cached(codec_fn, &ci);
+
     if (data.hid >= 0)
     {
-        /* First try buffer load */
-        status = codec_load_buf(data.hid, &ci);
+        /* Then try buffer load */
+        if (status < 0)
+            status = codec_load_buf(data.hid, codec_fn, &ci);
+
         bufclose(data.hid);
     }
 
     if (status < 0)
     {
         /* Either not a valid handle or the buffer method failed */
-        const char *codec_fn = get_codec_filename(data.afmt);
         if (codec_fn)
             status = codec_load_file(codec_fn, &ci);
     }
@@ -173,11 +173,143 @@ void *codec_get_buffer_callback(size_t *size)
     return buf;
 }
 
+/** resident codec images **/
+#if (CONFIG_PLATFORM & PLATFORM_NATIVE)
+/* Hosted builds load codecs as shared objects, so there's no image to keep */
+#if MEMORYSIZE >= 16
+#define CODEC_CACHE_SIZE (512*1024)
+#elif MEMORYSIZE >= 8
+#define CODEC_CACHE_SIZE (256*1024)
+#endif
+#endif /* PLATFORM_NATIVE */
+
+#ifndef CODEC_CACHE_SIZE
+#define CODEC_CACHE_SIZE 0
+#endif
+
+/* Images are packed at the start of the memory in the order of the entries;
+   only ever touched by whoever loads codecs, which the audio thread
+   serializes */
+static struct codec_cache_entry
+{
+    char name[16];              /* codec root file name, empty if unused */
+    unsigned char *image;       /* copy of the file as loaded to codecbuf */
+    size_t size;
+    unsigned long last_use;     /* for finding the least recently used */
+} cache_entries[CODEC_CACHE_ENTRIES];
+
+static unsigned char *cache_buf;
+static unsigned long cache_use_count;
+static struct codec_cache_stats cache_stats;
+
+/* Bytes playback should set aside for the cache */
+size_t codec_cache_size(void)
+{
+    return CODEC_CACHE_SIZE;
+}
+
+/* Hand over memory for the images, or take it back with NULL; whatever was
+   resident is forgotten */
+void codec_cache_init(void *buf, size_t size)
+{
+    memset(cache_entries, 0, sizeof (cache_entries));
+    cache_buf = buf;
+    cache_stats.size = buf ? size : 0;
+    cache_stats.used = 0;
+}
+
+static struct codec_cache_entry * cache_find(const char *codec)
+{
+    for (int i = 0; i < CODEC_CACHE_ENTRIES; i++)
+    {
+        struct codec_cache_entry *e = &cache_entries[i];
+        if (e->name[0] && !strcmp(e->name, codec))
+        {
+            e->last_use = ++cache_use_count;
+            return e;
+        }
+    }
+
+    return NULL;
+}
+
+/* Drop an entry and slide the images behind it down over its space */
+static void cache_evict(struct codec_cache_entry *victim)
+{
+    unsigned char *end = victim->image + victim->size;
+
+    for (int i = 0; i < CODEC_CACHE_ENTRIES; i++)
+    {
+        struct codec_cache_entry *e = &cache_entries[i];
+        if (e->name[0] && e->image >= end)
+        {
+            memmove(e->image - victim->size, e->image, e->size);
+            e->image -= victim->size;
+        }
+    }
+
+    cache_stats.used -= victim->size;
+    cache_stats.evictions++;
+    victim->name[0] = '\0';
+}
+
+/* Keep a copy of the codec just loaded to codecbuf, before its init
+   clobbers it */
+static void cache_store(const char *codec, size_t size)
+{
+    struct codec_cache_entry *slot;
+
+    if (size > cache_stats.size || strlen(codec) >= sizeof (cache_entries[0].name) ||
+        cache_find(codec))
+        return;
+
+    while (1)
+    {
+        struct codec_cache_entry *lru = NULL;
+        slot = NULL;
+
+        for (int i = 0; i < CODEC_CACHE_ENTRIES; i++)
+        {
+            struct codec_cache_entry *e = &cache_entries[i];
+            if (!e->name[0])
+                slot = e;
+            else if (!lru || e->last_use < lru->last_use)
+                lru = e;
+        }
+
+        if (slot && cache_stats.size - cache_stats.used >= size)
+            break;
+
+        cache_evict(lru);
+    }
+
+    strcpy(slot->name, codec);
+    slot->image = cache_buf + cache_stats.used;
+    slot->size = size;
+    slot->last_use = ++cache_use_count;
+    memcpy(slot->image, codecbuf, size);
+    cache_stats.used += size;
+}
+
+void codec_cache_get_stats(struct codec_cache_stats *stats)
+{
+    *stats = cache_stats;
+
+    for (int i = 0; i < CODEC_CACHE_ENTRIES; i++)
+    {
+        struct codec_cache_entry *e = &cache_entries[i];
+        stats->names[i] = e->name[0] ? e->name : NULL;
+        stats->sizes[i] = e->name[0] ? e->size : 0;
+    }
+}
+
 /** codec loading and call interface **/
 static void *curr_handle = NULL;
 static struct codec_header *c_hdr = NULL;
 
-static int codec_load_ram(struct codec_api *api)
+/* codec is the name to keep the image under, NULL if it isn't to be kept */
+static int codec_load_ram(struct codec_api *api, const char *codec,
+                          size_t image_size)
 {
     struct lc_header *hdr;
 
@@ -217,13 +349,42 @@ static int codec_load_ram(struct codec_api *api)
     codec_size = 0;
 #endif
 
+    if (cache_buf && codec)
+        cache_store(codec, image_size);
+
     *(c_hdr->api) = api;
 
     logf("Codec: calling entrypoint");
     return c_hdr->entry_point(CODEC_LOAD);
 }
 
-int codec_load_buf(int hid, struct codec_api *api)
+int codec_load_cached(const char *codec, struct codec_api *api)
+{
+    if (cache_buf == NULL)
+        return CODEC_ERROR;
+
+    struct codec_cache_entry *e = cache_find(codec);
+
+    if (e == NULL) {
+        cache_stats.misses++;
+        return CODEC_ERROR;
+    }
+
+    cache_stats.hits++;
+
+    memcpy(codecbuf, e->image, e->size);
+
+    curr_handle = lc_open_from_mem(codecbuf, e->size);
+
+    if (curr_handle == NULL) {
+        logf("Codec: load error");
+        return CODEC_ERROR;
+    }
+
+    return codec_load_ram(api, NULL, 0);
+}
+
+int codec_load_buf(int hid, const char *codec, struct codec_api *api)
 {
     int rc = bufread(hid, CODEC_SIZE, codecbuf);
 
@@ -239,23 +400,28 @@ int codec_load_buf(int hid, struct codec_api *api)
         return CODEC_ERROR;
     }
 
-    return codec_load_ram(api);
+    return codec_load_ram(api, codec, rc);
 }
 
 int codec_load_file(const char *plugin, struct codec_api *api)
 {
     char path[MAX_PATH];
+    size_t image_size = 0;
 
     codec_get_full_path(path, plugin);
 
+#if (CONFIG_PLATFORM & PLATFORM_NATIVE)
+    curr_handle = lc_open_ex(path, codecbuf, CODEC_SIZE, &image_size);
+#else
     curr_handle = lc_open(path, codecbuf, CODEC_SIZE);
+#endif
 
     if (curr_handle == NULL) {
         logf("Codec: cannot read file");
         return CODEC_ERROR;
     }
 
-    return codec_load_ram(api);
+    return codec_load_ram(api, image_size ? plugin : NULL, image_size);
 }
 
 int codec_run_proc(void)
@@ -118,6 +118,20 @@ static char *get_string(const char *line)
     return start;
 }
 
+/* parse a "mm:ss:ff" index time into CD frames (1/75 s) */
+static unsigned long parse_msf(const char *s)
+{
+    unsigned long frames = 60*CUE_FRAMES_PER_SEC * atoi(s);
+    s = strchr(s, ':');
+    if (!s)
+        return frames;
+    frames += CUE_FRAMES_PER_SEC * atoi(++s);
+    s = strchr(s, ':');
+    if (!s)
+        return frames;
+    return frames + atoi(++s);
+}
+
 /* parse cuesheet "cue_file" and store the information in "cue" */
 bool parse_cuesheet(struct cuesheet_file *cue_file, struct cuesheet *cue)
 {
@@ -202,17 +216,14 @@ bool parse_cuesheet(struct cuesheet_file *cue_file, struct cuesheet *cue)
         {
             cue->track_count++;
         }
-        else if (!strncmp(s, "INDEX 01", 8))
+        else if (!strncmp(s, "INDEX 01", 8) && cue->track_count > 0)
         {
+            struct cue_track_info *track = &cue->tracks[cue->track_count-1];
             s = strchr(s,' ');
             s = skip_whitespace(s);
             s = strchr(s,' ');
             s = skip_whitespace(s);
-            cue->tracks[cue->track_count-1].offset = 60*1000 * atoi(s);
-            s = strchr(s,':') + 1;
-            cue->tracks[cue->track_count-1].offset += 1000 * atoi(s);
-            s = strchr(s,':') + 1;
-            cue->tracks[cue->track_count-1].offset += 13 * atoi(s);
+            track->offset = CUE_FRAMES_TO_MS(parse_msf(s));
         }
         else if (!strncmp(s, "TITLE", 5)
                  || !strncmp(s, "PERFORMER", 9)
@@ -323,13 +334,20 @@ static bool seek(unsigned long pos)
    and updates the information about the current track. */
 int cue_find_current_track(struct cuesheet *cue, unsigned long curpos)
 {
-    int i=0;
-    while (i < cue->track_count-1 && cue->tracks[i+1].offset < curpos)
-        i++;
+    /* offsets are ascending - find the last track starting before curpos */
+    int lo = 0, hi = cue->track_count - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (cue->tracks[mid].offset < curpos)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
 
-    cue->curr_track_idx = i;
-    cue->curr_track = cue->tracks + i;
-    return i;
+    cue->curr_track_idx = lo;
+    cue->curr_track = cue->tracks + lo;
+    return lo;
 }
 
 /* callback that gives list item titles for the cuesheet browser */
@@ -30,6 +30,11 @@
 #define MAX_NAME 80    /* Max length of information strings */
 #define MAX_TRACKS 99  /* Max number of tracks in a cuesheet */
 
+/* Index points are given in CD frames; 75 frames per second */
+#define CUE_FRAMES_PER_SEC 75
+/* Round up so a seek to a track start never lands in the previous track */
+#define CUE_FRAMES_TO_MS(f) (((f)*1000 + CUE_FRAMES_PER_SEC-1) / CUE_FRAMES_PER_SEC)
+
 struct cue_track_info {
     char title[MAX_NAME*3+1];
     char performer[MAX_NAME*3+1];
@@ -63,6 +63,7 @@
 #include "rtc.h"
 #include "storage.h"
 #include "fs_defines.h"
+#include "disk_cache.h"
 #include "eeprom_24cxx.h"
 #if (CONFIG_STORAGE & STORAGE_MMC) || (CONFIG_STORAGE & STORAGE_SD)
 #include "sdmmc.h"
@@ -88,6 +89,7 @@
 #include "pcmbuf.h"
 #include "buffering.h"
 #include "playback.h"
+#include "codecs.h"
 #if defined(HAVE_SPDIF_OUT) || defined(HAVE_SPDIF_IN)
 #include "spdif.h"
 #endif
@@ -184,6 +186,217 @@ static bool dbg_os(void)
     return simplelist_show_list(&info);
 }
 
+#ifdef HAVE_THREAD_ACCOUNTING
+/* per-thread figures over the last sampling interval */
+static struct sched_sample
+{
+    uint32_t     runtime;       /* totals at the last sample */
+    uint32_t     pip_runtime;
+    uint32_t     switches;
+    uint32_t     wakeups;
+    uint32_t     latency_total;
+    unsigned int load;          /* CPU use (permille) */
+    unsigned int pip_load;      /* ...of it on inherited priority */
+    unsigned int rate;          /* switches/s */
+    uint32_t     latency;       /* average wakeup latency (us) */
+} sched_samples[MAXTHREADS];
+static long sched_sample_tick;
+static uint32_t sched_idle_wakeups;     /* all cores, at the last sample */
+static unsigned int sched_idle_rate;    /* idle wakeups/s */
+static char sched_title[40];
+
+static void sched_take_sample(void)
+{
+    long tick = current_tick;
+    unsigned long elapsed = (tick - sched_sample_tick) * (1000000 / HZ);
+
+    if (elapsed == 0)
+        elapsed = 1;
+
+    for (int i = 0; i < MAXTHREADS; i++)
+    {
+        struct sched_sample *s = &sched_samples[i];
+        struct thread_debug_info info;
+
+        if (thread_get_debug_info(i, &info) <= 0)
+        {
+            memset(s, 0, sizeof (*s));
+            continue;
+        }
+
+        uint32_t wakeups = info.wakeups - s->wakeups;
+
+        s->load     = 1000ull * (info.runtime - s->runtime) / elapsed;
+        s->pip_load = 1000ull * (info.pip_runtime - s->pip_runtime) / elapsed;
+        s->rate     = 1000000ull * (info.switches - s->switches) / elapsed;
+        s->latency  = wakeups ?
+                        (info.latency_total - s->latency_total) / wakeups : 0;
+
+        s->runtime       = info.runtime;
+        s->pip_runtime   = info.pip_runtime;
+        s->switches      = info.switches;
+        s->wakeups       = info.wakeups;
+        s->latency_total = info.latency_total;
+    }
+
+    uint32_t idle_wakeups = 0;
+    for (unsigned int core = 0; core < NUM_CORES; core++)
+        idle_wakeups += thread_get_idle_wakeups(core);
+
+    sched_idle_rate = 1000000ull * (idle_wakeups - sched_idle_wakeups) / elapsed;
+    sched_idle_wakeups = idle_wakeups;
+    sched_sample_tick = tick;
+
+    snprintf(sched_title, sizeof (sched_title),
+             "Load (PIP) sw lat inh, %u wake/s:", sched_idle_rate);
+}
+
+static const char* sched_stats_getname(int selected_item, void *data,
+                                       char *buffer, size_t buffer_len)
+{
+    (void)data;
+
+    struct thread_debug_info info;
+    if (thread_get_debug_info(selected_item, &info) <= 0)
+    {
+        snprintf(buffer, buffer_len, "%2d: ---", selected_item);
+        return buffer;
+    }
+
+    struct sched_sample *s = &sched_samples[selected_item];
+    snprintf(buffer, buffer_len,
+             "%2d: %3u.%u%% (%u.%u%%) %u/s %lu/%lu us %lu %s",
+             selected_item, s->load / 10, s->load % 10,
+             s->pip_load / 10, s->pip_load % 10, s->rate,
+             (unsigned long)s->latency, (unsigned long)info.latency_max,
+             (unsigned long)info.inherits, info.name);
+    return buffer;
+}
+
+static int sched_stats_action_callback(int action, struct gui_synclist *lists)
+{
+    if (action == ACTION_NONE)
+    {
+        if (TIME_AFTER(current_tick, sched_sample_tick + HZ - 1))
+        {
+            sched_take_sample();
+            gui_synclist_set_title(lists, sched_title, Icon_NOICON);
+        }
+        action = ACTION_REDRAW;
+    }
+    return action;
+}
+
+/* CPU use (and how much of it on an inherited priority), switch rate,
+   average/max wakeup latency and number of inheritances for each thread,
+   plus how often the cores wake from idle */
+static bool dbg_sched_stats(void)
+{
+    /* the first interval is up to now */
+    memset(sched_samples, 0, sizeof (sched_samples));
+    sched_idle_wakeups = 0;
+    sched_sample_tick = 0;
+    sched_take_sample();
+
+    struct simplelist_info info;
+    simplelist_info_init(&info, sched_title, MAXTHREADS, NULL);
+    info.hide_selection = true;
+    info.scroll_all = true;
+    info.timeout = HZ;
+    info.action_callback = sched_stats_action_callback;
+    info.get_name = sched_stats_getname;
+
+    return simplelist_show_list(&info);
+}
+
+/* snapshot of the latest trace events of all cores */
+static struct sched_trace
+{
+    int count[NUM_CORES];
+    struct thread_trace_event events[NUM_CORES][THREAD_TRACE_SIZE];
+} sched_trace;
+
+static const char * sched_trace_format(int item, char *buffer,
+                                       size_t buffer_len)
+{
+    static const char * const types[] =
+    {
+        [THREAD_TRACE_SWITCH]   = "run",
+        [THREAD_TRACE_READY]    = "ready",
+        [THREAD_TRACE_BLOCK]    = "block",
+        [THREAD_TRACE_PRIORITY] = "prio",
+    };
+
+    unsigned int core = 0;
+#if NUM_CORES > 1
+    while (core < NUM_CORES - 1 && item >= sched_trace.count[core])
+        item -= sched_trace.count[core++];
+#endif
+
+    /* times are relative to the core's latest event */
+    const struct thread_trace_event *ev = &sched_trace.events[core][item];
+    const struct thread_trace_event *last =
+        &sched_trace.events[core][sched_trace.count[core] - 1];
+
+    struct thread_debug_info info;
+    if (thread_get_debug_info(ev->slot, &info) <= 0)
+        strcpy(info.name, "?");
+
+    snprintf(buffer, buffer_len, IF_COP("%u ") "-%lu %s %d:%s p%u %u",
+             IF_COP(core,) (unsigned long)(last->time - ev->time),
+             types[ev->type], ev->slot, info.name, ev->priority, ev->arg);
+    return buffer;
+}
+
+static const char* sched_trace_getname(int selected_item, void *data,
+                                       char *buffer, size_t buffer_len)
+{
+    (void)data;
+    return sched_trace_format(selected_item, buffer, buffer_len);
+}
+
+static int sched_trace_action_callback(int action, struct gui_synclist *lists)
+{
+    if (action == ACTION_STD_OK)
+    {
+        /* export the snapshot */
+        int fd = creat("/sched_trace.txt", 0666);
+        if (fd >= 0)
+        {
+            char buf[64];
+            int count = gui_synclist_get_nb_items(lists);
+            for (int i = 0; i < count; i++)
+                fdprintf(fd, "%s\n", sched_trace_format(i, buf, sizeof buf));
+            close(fd);
+        }
+
+        splash(HZ, fd >= 0 ? "Saved /sched_trace.txt" : "Save failed");
+        action = ACTION_REDRAW;
+    }
+    return action;
+}
+
+/* recent scheduler events, oldest first; select saves them to a file */
+static bool dbg_sched_trace(void)
+{
+    int total = 0;
+    for (unsigned int core = 0; core < NUM_CORES; core++)
+    {
+        int count = thread_get_trace(core, sched_trace.events[core],
+                                     THREAD_TRACE_SIZE);
+        sched_trace.count[core] = MAX(count, 0);
+        total += sched_trace.count[core];
+    }
+
+    struct simplelist_info info;
+    simplelist_info_init(&info, "Scheduler trace", total, NULL);
+    info.scroll_all = true;
+    info.action_callback = sched_trace_action_callback;
+    info.get_name = sched_trace_getname;
+    return simplelist_show_list(&info);
+}
+#endif /* HAVE_THREAD_ACCOUNTING */
+
 #ifdef __linux__
 #include "cpuinfo-linux.h"
 
@@ -440,6 +653,88 @@ static bool dbg_buffering_thread(void)
     return false;
 }
 
+static int prefetch_plan_action_callback(int action, struct gui_synclist *lists)
+{
+    struct prefetch_plan plan;
+    audio_get_prefetch_plan(&plan);
+
+    simplelist_set_line_count(0);
+    simplelist_addline("Ahead: %lus", plan.ahead / 1000);
+    simplelist_addline("Watermark: %lu B", (unsigned long)plan.watermark);
+    simplelist_addline("Next refill: %lds",
+                       TIME_AFTER(plan.next_refill, current_tick) ?
+                       (plan.next_refill - current_tick) / HZ : 0);
+    simplelist_addline("Last refill: %lds ago",
+                       (current_tick - plan.last_refill) / HZ);
+    simplelist_addline("Refills: %u, deferred: %u", plan.refills,
+                       plan.deferred);
+
+    long since = (current_tick - plan.tick) / HZ;
+    for (int i = 0; i < plan.count; i++)
+    {
+        long start = plan.tracks[i].start / 1000 - since;
+        simplelist_addline("%d: %+ld:%02ld %lus %luK/%luK", i,
+                           start / 60, labs(start) % 60,
+                           plan.tracks[i].length / 1000,
+                           plan.tracks[i].buffered / 1024,
+                           plan.tracks[i].cost / 1024);
+    }
+
+    if (action == ACTION_NONE)
+        action = ACTION_REDRAW;
+
+    return action;
+    (void)lists;
+}
+
+static bool dbg_prefetch_plan(void)
+{
+    struct simplelist_info info;
+    simplelist_info_init(&info, "Prefetch plan", 5 + PREFETCH_PLAN_TRACKS,
+                         NULL);
+    info.action_callback = prefetch_plan_action_callback;
+    info.hide_selection = true;
+    info.scroll_all = true;
+    info.timeout = HZ;
+    return simplelist_show_list(&info);
+}
+
+static int codec_cache_action_callback(int action, struct gui_synclist *lists)
+{
+    struct codec_cache_stats stats;
+    codec_cache_get_stats(&stats);
+
+    simplelist_set_line_count(0);
+    simplelist_addline("Size: %luK/%luK", (unsigned long)stats.used / 1024,
+                       (unsigned long)stats.size / 1024);
+    simplelist_addline("Hits: %u, misses: %u", stats.hits, stats.misses);
+    simplelist_addline("Evictions: %u", stats.evictions);
+
+    for (int i = 0; i < CODEC_CACHE_ENTRIES; i++)
+    {
+        if (stats.names[i])
+            simplelist_addline("%s: %luK", stats.names[i],
+                               (unsigned long)stats.sizes[i] / 1024);
+    }
+
+    if (action == ACTION_NONE)
+        action = ACTION_REDRAW;
+
+    return action;
+    (void)lists;
+}
+
+static bool dbg_codec_cache(void)
+{
+    struct simplelist_info info;
+    simplelist_info_init(&info, "Codec cache", 3 + CODEC_CACHE_ENTRIES, NULL);
+    info.action_callback = codec_cache_action_callback;
+    info.hide_selection = true;
+    info.scroll_all = true;
+    info.timeout = HZ;
+    return simplelist_show_list(&info);
+}
+
 static const char* bf_getname(int selected_item, void *data,
                                    char *buffer, size_t buffer_len)
 {
@@ -482,6 +777,122 @@ static bool dbg_buflib_allocs(void)
     return simplelist_show_list(&info);
 }
 
+#ifdef HAVE_BUFLIB_TRACE
+static struct
+{
+    struct buflib_trace_event events[BUFLIB_TRACE_SIZE];
+    long sample_tick;
+    uint32_t sample_moves;
+    unsigned int move_rate;  /* moves per second */
+} buflib_trace_view;
+
+/* one line per event, read by utils/analysis/buflib_trace.py */
+static void buflib_trace_export(int fd)
+{
+    static const char * const types[] =
+    {
+        [BUFLIB_TRACE_ALLOC]   = "alloc",
+        [BUFLIB_TRACE_FREE]    = "free",
+        [BUFLIB_TRACE_MOVE]    = "move",
+        [BUFLIB_TRACE_SHRINK]  = "shrink",
+        [BUFLIB_TRACE_FAIL]    = "fail",
+        [BUFLIB_TRACE_COMPACT] = "compact",
+    };
+
+    int count = buflib_get_trace(buflib_trace_view.events, BUFLIB_TRACE_SIZE);
+
+    fdprintf(fd, "# buflib trace, size %lu, hz %d\n",
+             (unsigned long)core_get_buffer_size(), HZ);
+    fdprintf(fd, "# time type handle offset size from name\n");
+    for (int i = 0; i < count; i++)
+    {
+        const struct buflib_trace_event *ev = &buflib_trace_view.events[i];
+        fdprintf(fd, "%lu %s %d %ld %ld %ld %s\n",
+                 (unsigned long)ev->time, types[ev->type], ev->handle,
+                 (long)ev->offset, (long)ev->size, (long)ev->from,
+                 ev->name[0] ? ev->name : "-");
+    }
+}
+
+static int buflib_trace_action_callback(int action, struct gui_synclist *lists)
+{
+    const struct buflib_trace *trace = core_get_trace();
+
+    if (action == ACTION_STD_OK)
+    {
+        int fd = creat("/buflib_trace.txt", 0666);
+        if (fd >= 0)
+        {
+            buflib_trace_export(fd);
+            close(fd);
+        }
+
+        splash(HZ, fd >= 0 ? "Saved /buflib_trace.txt" : "Save failed");
+        action = ACTION_REDRAW;
+    }
+
+    long elapsed = current_tick - buflib_trace_view.sample_tick;
+    if (elapsed >= HZ)
+    {
+        buflib_trace_view.move_rate =
+            (trace->moves - buflib_trace_view.sample_moves) * HZ / elapsed;
+        buflib_trace_view.sample_moves = trace->moves;
+        buflib_trace_view.sample_tick = current_tick;
+    }
+
+    struct buflib_frag_stats frag;
+    core_get_frag_stats(&frag);
+
+    /* share of the free space that the largest free block can't serve */
+    unsigned int frag_permille = 0;
+    if (frag.total_free)
+        frag_permille = 1000 - (uint64_t)frag.largest_free * 1000 /
+                               frag.total_free;
+
+    simplelist_set_line_count(0);
+    simplelist_addline("Free: %lu B in %d blocks",
+                       (unsigned long)frag.total_free, frag.free_blocks);
+    simplelist_addline("Largest free: %lu B",
+                       (unsigned long)frag.largest_free);
+    simplelist_addline("Fragmentation: %u.%u%%",
+                       frag_permille / 10, frag_permille % 10);
+    simplelist_addline("Moves: %lu (%u/s), %lu B",
+                       (unsigned long)trace->moves,
+                       buflib_trace_view.move_rate,
+                       (unsigned long)trace->move_bytes);
+    simplelist_addline("Allocs: %lu Frees: %lu",
+                       (unsigned long)trace->allocs,
+                       (unsigned long)trace->frees);
+    simplelist_addline("Shrinks: %lu Fails: %lu",
+                       (unsigned long)trace->shrinks,
+                       (unsigned long)trace->fails);
+    simplelist_addline("Compactions: %lu",
+                       (unsigned long)trace->compactions);
+
+    if (action == ACTION_NONE)
+        action = ACTION_REDRAW;
+
+    return action;
+    (void)lists;
+}
+
+/* allocator activity and fragmentation; select saves the event trace */
+static bool dbg_buflib_trace(void)
+{
+    buflib_trace_view.sample_tick = current_tick;
+    buflib_trace_view.sample_moves = core_get_trace()->moves;
+    buflib_trace_view.move_rate = 0;
+
+    struct simplelist_info info;
+    simplelist_info_init(&info, "buflib trace", 7, NULL);
+    info.action_callback = buflib_trace_action_callback;
+    info.hide_selection = true;
+    info.scroll_all = true;
+    info.timeout = HZ;
+    return simplelist_show_list(&info);
+}
+#endif /* HAVE_BUFLIB_TRACE */
+
 #if (CONFIG_PLATFORM & PLATFORM_NATIVE)
 static const char* dbg_partitions_getname(int selected_item, void *data,
                                           char *buffer, size_t buffer_len)
@@ -1697,6 +2108,42 @@ static bool dbg_disk_info(void)
     info.scroll_all = true;
     return simplelist_show_list(&info);
 }
+
+static int disk_cache_callback(int btn, struct gui_synclist *lists)
+{
+    struct dc_stats stats;
+    dc_get_stats(&stats);
+
+    simplelist_set_line_count(0);
+
+    unsigned long probes = stats.hits + stats.misses;
+    unsigned int hitrate = probes ? 1000ull*stats.hits / probes : 0;
+
+    simplelist_addline("Entries: %u (%u B)", stats.entries,
+                       stats.entries*DC_CACHE_BUFSIZE);
+    simplelist_addline("Hits: %lu (%u.%u%%)", stats.hits,
+                       hitrate / 10, hitrate % 10);
+    simplelist_addline("Misses: %lu", stats.misses);
+    simplelist_addline("Read ahead: %lu", stats.readaheads);
+    simplelist_addline("Evictions: %lu", stats.evictions);
+    simplelist_addline("Writebacks: %lu", stats.writebacks);
+
+    if (btn == ACTION_NONE)
+        btn = ACTION_REDRAW;
+
+    return btn;
+    (void)lists;
+}
+
+static bool dbg_disk_cache(void)
+{
+    struct simplelist_info info;
+    simplelist_info_init(&info, "Disk Cache", 6, NULL);
+    info.action_callback = disk_cache_callback;
+    info.hide_selection = true;
+    info.scroll_all = true;
+    return simplelist_show_list(&info);
+}
 #endif /* PLATFORM_NATIVE */
 
 #ifdef HAVE_DIRCACHE
@@ -2532,6 +2979,10 @@ static const struct {
         { "Catch mem accesses", dbg_set_memory_guard },
 #endif
         { "View OS stacks", dbg_os },
+#ifdef HAVE_THREAD_ACCOUNTING
+        { "View scheduler stats", dbg_sched_stats },
+        { "View scheduler trace", dbg_sched_trace },
+#endif
 #ifdef __linux__
         { "View CPU stats", dbg_cpuinfo },
 #endif
@@ -2550,6 +3001,7 @@ static const struct {
 #endif
 #if (CONFIG_PLATFORM & PLATFORM_NATIVE)
         { "View disk info", dbg_disk_info },
+        { "View disk cache", dbg_disk_cache },
 #if (CONFIG_STORAGE & STORAGE_ATA)
         { "Dump ATA identify info", dbg_identify_info},
 #ifdef HAVE_ATA_SMART
@@ -2565,10 +3017,15 @@ static const struct {
         { "View database info", dbg_tagcache_info },
 #endif
         { "View buffering thread", dbg_buffering_thread },
+        { "View prefetch plan", dbg_prefetch_plan },
+        { "View codec cache", dbg_codec_cache },
 #ifdef PM_DEBUG
         { "pm histogram", peak_meter_histogram},
 #endif /* PM_DEBUG */
         { "View buflib allocs", dbg_buflib_allocs },
+#ifdef HAVE_BUFLIB_TRACE
+        { "View buflib trace", dbg_buflib_trace },
+#endif
 #ifndef SIMULATOR
 #if CONFIG_TUNER
         { "FM Radio", dbg_fm_radio },
@@ -221,6 +221,12 @@ static int INIT_ATTR init_dircache(bool preinit)
             firmware_settings.disk_clean = false;
     }
     else
+#elif defined(DIRCACHE_SNAPSHOT)
+    if (preinit)
+    {
+        result = dircache_load();
+    }
+    else
 #endif /* HAVE_EEPROM_SETTINGS */
     if (!preinit)
     {
@@ -40,6 +40,10 @@
 #ifdef HAVE_PLAY_FREQ
 #include "talk.h"
 #endif
+#ifdef HAVE_ALBUMART
+#include "yesno.h"
+#include "albumart.h"
+#endif
 
 #if defined(HAVE_CROSSFADE)
 static int setcrossfadeonexit_callback(int action,
@@ -90,6 +94,7 @@ static int buffermargin_callback(int action,
 }
 MENUITEM_SETTING(buffer_margin, &global_settings.buffer_margin,
                  buffermargin_callback);
+MENUITEM_SETTING(prefetch_interval, &global_settings.prefetch_interval, NULL);
 #endif /*HAVE_DISK_STORAGE */
 MENUITEM_SETTING(fade_on_stop, &global_settings.fade_on_stop, NULL);
 MENUITEM_SETTING(party_mode, &global_settings.party_mode, NULL);
@@ -194,6 +199,24 @@ MAKE_MENU(unplug_menu, ID2P(LANG_HEADPHONE_UNPLUG), 0, Icon_NOICON,
 
 MENUITEM_SETTING(skip_length, &global_settings.skip_length, NULL);
 MENUITEM_SETTING(prevent_skip, &global_settings.prevent_skip, NULL);
+MENUITEM_SETTING(instant_skip, &global_settings.instant_skip, NULL);
+#ifdef HAVE_ALBUMART
+MENUITEM_SETTING(albumart_cache_size, &global_settings.albumart_cache_size,
+                 NULL);
+
+static int clear_albumart_cache(void)
+{
+    if (yesno_pop(ID2P(LANG_REALLY_DELETE)))
+    {
+        albumart_cache_clear();
+        splash(HZ, ID2P(LANG_DELETED));
+    }
+    return 0;
+}
+MENUITEM_FUNCTION(albumart_cache_clear_item, 0,
+                  ID2P(LANG_ALBUMART_CACHE_CLEAR), clear_albumart_cache,
+                  NULL, NULL, Icon_NOICON);
+#endif
 MENUITEM_SETTING(resume_rewind, &global_settings.resume_rewind, NULL);
 MENUITEM_SETTING(pause_rewind, &global_settings.pause_rewind, NULL);
 #ifdef HAVE_PLAY_FREQ
@@ -206,7 +229,7 @@ MAKE_MENU(playback_settings,ID2P(LANG_PLAYBACK),0,
           &shuffle_item, &repeat_mode, &play_selected,
           &ff_rewind_settings_menu,
 #ifdef HAVE_DISK_STORAGE
-          &buffer_margin,
+          &buffer_margin, &prefetch_interval,
 #endif
           &fade_on_stop, &party_mode,
 
@@ -223,7 +246,10 @@ MAKE_MENU(playback_settings,ID2P(LANG_PLAYBACK),0,
 #ifdef HAVE_HEADPHONE_DETECTION
          ,&unplug_menu
 #endif
-         ,&skip_length, &prevent_skip
+         ,&skip_length, &prevent_skip, &instant_skip
+#ifdef HAVE_ALBUMART
+         ,&albumart_cache_size, &albumart_cache_clear_item
+#endif
 
           ,&resume_rewind
           ,&pause_rewind
@@ -677,6 +677,43 @@ void pcmbuf_monitor_track_change(bool monitor)
     pcm_play_unlock();
 }
 
+/* Skip straight to the start of the next track if it has already been decoded
+   behind a pending track change - the codec keeps on decoding it. Returns
+   false if there is nothing to skip to. */
+bool pcmbuf_skip_to_track_change(void)
+{
+    bool skipped = false;
+
+    pcm_play_lock();
+
+    size_t index = chunk_transidx;
+
+    if (index_committed(index) && index_next(index) != chunk_widx &&
+#ifdef HAVE_CROSSFADE
+        crossfade_status == CROSSFADE_INACTIVE &&
+#endif
+        fade_state == PCM_NOT_FADING)
+    {
+        logf("skip to track change");
+
+        /* Restart from the first chunk of the new track */
+        mixer_channel_stop(PCM_MIXER_CHAN_PLAYBACK);
+
+        chunk_ridx = index_next(index);
+        chunk_transidx = INVALID_BUF_INDEX;
+        pcmbuf_sync_position = false;
+
+        skipped = true;
+    }
+
+    pcm_play_unlock();
+
+    if (skipped)
+        start_audio_playback();
+
+    return skipped;
+}
+
 void pcmbuf_start_track_change(enum pcm_track_change_type type)
 {
     /* Commit all outstanding data before starting next track - tracks don't
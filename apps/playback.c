@@ -108,6 +108,10 @@
  */
 
 /** Miscellaneous **/
+/* Most bytes of core allocations to move per idle timeout while the file
+   buffer is full */
+#define AUDIO_COMPACT_STEP  (32*1024)
+
 extern unsigned int audio_thread_id;   /* from audio_thread.c */
 extern struct event_queue audio_queue; /* from audio_thread.c */
 extern bool audio_is_initialized;      /* from audio_thread.c */
@@ -135,6 +139,8 @@ static struct audio_scratch_memory
 {
     struct mp3entry codec_id3; /* (A,C) */
     struct mp3entry unbuffered_id3;
+    struct mp3entry load_id3;  /* (A) buffered metadata being updated */
+    struct mp3entry peek_id3;  /* (A) buffered metadata being looked at */
     struct cuesheet *curr_cue; /* Will follow this structure */
 } * audio_scratch_memory = NULL;
 
@@ -260,8 +266,17 @@ static int playlist_peek_offset = 0;
 #ifdef HAVE_DISK_STORAGE
 /* Buffer margin A.K.A. anti-skip buffer (in seconds) */
 static size_t buffer_margin = 5;
+
+/* Minimum time between buffer refills (in seconds, 0 = none) */
+static int prefetch_interval = 0;
+
+/* Has the current refill been put off for the prefetch interval? */
+static bool refill_deferred = false; /* (A) */
 #endif
 
+/* Schedule of the tracks ahead, for the watermark and for debugging */
+static struct prefetch_plan prefetch_plan; /* (A, O-) */
+
 /* Values returned for track loading */
 enum track_load_status
 {
@@ -362,33 +377,38 @@ static struct mp3entry * valid_mp3entry(const struct mp3entry *id3)
            id3->codectype != AFMT_UNKNOWN ? (struct mp3entry *)id3 : NULL;
 }
 
-/* Return a pointer to an mp3entry on the buffer, as it is */
-static struct mp3entry * bufgetid3(int handle_id)
+/* Read an mp3entry from the buffer, unpacked */
+static bool bufreadid3(int handle_id, struct mp3entry *id3out)
 {
     if (handle_id < 0)
-        return NULL;
-
-    struct mp3entry *id3;
-    ssize_t ret = bufgetdata(handle_id, 0, (void *)&id3);
+        return false;
 
-    if (ret != sizeof(struct mp3entry))
-        return NULL;
+    void *packed;
+    ssize_t ret = bufgetdata(handle_id, 0, &packed);
 
-    return id3;
+    return ret > 0 && unpack_mp3entry(id3out, packed, ret);
 }
 
-/* Read an mp3entry from the buffer, adjusted */
-static bool bufreadid3(int handle_id, struct mp3entry *id3out)
+/* Store changes made to an mp3entry read with bufreadid3 back on the buffer;
+   only the fields may change, not the strings */
+static void bufwriteid3(int handle_id, const struct mp3entry *id3)
 {
-    struct mp3entry *id3 = bufgetid3(handle_id);
+    if (handle_id < 0)
+        return;
 
-    if (id3)
-    {
-        copy_mp3entry(id3out, id3);
-        return true;
-    }
+    void *packed;
+    ssize_t ret = bufgetdata(handle_id, 0, &packed);
 
-    return false;
+    if (ret > 0 && (size_t)ret == mp3entry_packed_size(id3))
+        pack_mp3entry(packed, id3);
+}
+
+/* Return the buffered mp3entry unpacked into scratch memory, which stays
+   valid until the next call */
+static struct mp3entry * bufpeekid3(int handle_id)
+{
+    struct mp3entry *id3 = &audio_scratch_memory->peek_id3;
+    return bufreadid3(handle_id, id3) ? id3 : NULL;
 }
 
 /* Lock the id3 mutex */
@@ -823,7 +843,7 @@ static void audio_reset_buffer_noalloc(
 {
     /*
      * Layout audio buffer as follows:
-     * [|SCRATCH|BUFFERING|PCM]
+     * [|SCRATCH|CODECS|BUFFERING|PCM]
      */
     logf("%s()", __func__);
 
@@ -852,6 +872,19 @@ static void audio_reset_buffer_noalloc(
     filebuf += allocsize;
     filebuflen -= allocsize;
 
+    /* Resident codec images, if that leaves enough to buffer with */
+    allocsize = ALIGN_UP(codec_cache_size(), sizeof (intptr_t));
+    if (allocsize > 0 && allocsize + AUDIO_BUFFER_RESERVE <= filebuflen)
+    {
+        codec_cache_init(filebuf, allocsize);
+        filebuf += allocsize;
+        filebuflen -= allocsize;
+    }
+    else
+    {
+        codec_cache_init(NULL, 0);
+    }
+
     buffering_reset(filebuf, filebuflen);
 
     buffer_state = AUDIOBUF_STATE_INITIALIZED;
@@ -955,6 +988,7 @@ static int shrink_callback(int handle, unsigned hints, void* start, size_t old_s
     if (give_up)
     {
         buffer_state = AUDIOBUF_STATE_TRASHED;
+        codec_cache_init(NULL, 0);
         audiobuf_handle = core_free(audiobuf_handle);
         return BUFLIB_CB_OK;
     }
@@ -990,6 +1024,7 @@ static void audio_reset_buffer(void)
 {
     if (audiobuf_handle > 0)
     {
+        codec_cache_init(NULL, 0);
         core_free(audiobuf_handle);
         audiobuf_handle = 0;
     }
@@ -1003,6 +1038,172 @@ static void audio_reset_buffer(void)
         panicf("%s(): OOM!\n", __func__);
 }
 
+/* Estimated bytes of a track's audio from its bitrate and length, or the
+   size the metadata gives if that's all there is */
+static unsigned long prefetch_track_cost(const struct mp3entry *id3)
+{
+    uint64_t cost = (uint64_t)id3->bitrate * id3->length / 8;
+    return cost ? cost : id3->filesize;
+}
+
+/* Lay out the tracks from the playing one on: when each plays and how much
+   of it is buffered. Returns the watermark that leaves 'seconds' of play time
+   on the buffer, taken from the last tracks at their own byte rates. */
+static size_t audio_plan_prefetch(int seconds)
+{
+    struct prefetch_plan *plan = &prefetch_plan;
+    struct track_info info, user_cur;
+    unsigned long start = 0;
+    unsigned long ahead = 0;
+
+    plan->tick = current_tick;
+    plan->count = 0;
+
+    for (int i = 0; track_list_user_current(i, &info); i++)
+    {
+        struct mp3entry *id3 = valid_mp3entry(bufpeekid3(info.id3_hid));
+        if (!id3)
+            break;
+
+        unsigned long length = id3->length;
+        off_t size = buf_filesize(info.audio_hid);
+        off_t have = 0;
+        unsigned long buffered = 0;
+
+        if (size > 0)
+        {
+            have = size - buf_handle_remaining(info.audio_hid);
+            buffered = (uint64_t)length * have / size;
+        }
+
+        if (i == 0)
+        {
+            /* only what's left of the playing track counts */
+            unsigned long elapsed = id3_get(PLAYING_ID3)->elapsed;
+            length -= MIN(elapsed, length);
+            buffered -= MIN(elapsed, buffered);
+        }
+
+        if (plan->count < PREFETCH_PLAN_TRACKS)
+        {
+            plan->tracks[plan->count].cost = prefetch_track_cost(id3);
+            plan->tracks[plan->count].buffered = have;
+            plan->tracks[plan->count].start = start;
+            plan->tracks[plan->count].length = length;
+            plan->count++;
+        }
+
+        ahead += buffered;
+        start += length;
+    }
+
+    /* The first track that didn't fit is next in line */
+    struct mp3entry *ub_id3 = id3_get(UNBUFFERED_ID3);
+    if (plan->count < PREFETCH_PLAN_TRACKS && valid_mp3entry(ub_id3))
+    {
+        plan->tracks[plan->count].cost = prefetch_track_cost(ub_id3);
+        plan->tracks[plan->count].buffered = 0;
+        plan->tracks[plan->count].start = start;
+        plan->tracks[plan->count].length = ub_id3->length;
+        plan->count++;
+    }
+
+    plan->ahead = ahead;
+
+    unsigned long need = seconds * 1000;
+    plan->next_refill = plan->tick +
+        (ahead > need ? (ahead - need) * HZ / 1000 : 0);
+
+    /* What is left on the buffer when the watermark is reached is the end
+       of the last tracks */
+    size_t bytes = 0;
+    uint64_t rate = 0; /* bytes per second of the last track looked at */
+
+    if (!track_list_user_current(0, &user_cur))
+        return 0;
+
+    for (int i = 0; need > 0 && track_list_last(-i, &info); i++)
+    {
+        struct mp3entry *id3 = valid_mp3entry(bufpeekid3(info.id3_hid));
+        off_t size = buf_filesize(info.audio_hid);
+
+        if (id3 && id3->length > 0 && size > 0)
+        {
+            off_t have = size - buf_handle_remaining(info.audio_hid);
+            unsigned long ms = MIN((uint64_t)id3->length * have / size, need);
+
+            rate = (uint64_t)size * 1000 / id3->length;
+            bytes += rate * ms / 1000;
+            need -= ms;
+        }
+
+        if (info.self_hid == user_cur.self_hid)
+            break;
+    }
+
+    /* No buffered track told its byte rate: go by the nominal bitrate of
+       the last one */
+    if (rate == 0 && track_list_last(0, &info))
+    {
+        struct mp3entry *id3 = valid_mp3entry(bufpeekid3(info.id3_hid));
+        if (id3)
+            rate = id3->bitrate * (1000/8);
+    }
+
+    /* The buffer doesn't hold 'seconds' yet: ask for the rest at the same
+       rate so that the refill starts right away */
+    bytes += rate * need / 1000;
+
+    return bytes;
+}
+
+/* A refill began: everything up to the watermark is being reloaded */
+static void audio_prefetch_refill_started(void)
+{
+    prefetch_plan.last_refill = current_tick;
+    prefetch_plan.refills++;
+#ifdef HAVE_DISK_STORAGE
+    refill_deferred = false;
+#endif
+}
+
+#ifdef HAVE_DISK_STORAGE
+/* Put off a refill that comes sooner than the prefetch interval after the
+   last one until the buffer is down to what covers a disk spin-up, so the
+   disk spins up at most once per interval as far as the anti-skip margin
+   allows. Returns true if the refill should wait. */
+static bool audio_defer_refill(void)
+{
+    if (prefetch_interval <= 0 || refill_deferred ||
+        TIME_AFTER(current_tick,
+                   prefetch_plan.last_refill + prefetch_interval*HZ))
+        return false;
+
+    struct buffering_debug d;
+    buffering_get_debugdata(&d);
+
+    /* The buffering thread is topping up open handles: the disk is
+       spinning anyway */
+    if (d.data_rem > 0)
+        return false;
+
+    int spinup = storage_spinup_time();
+    size_t bytes = audio_plan_prefetch(spinup ? (spinup / HZ) + 1 : 5);
+
+    if (bytes == 0 || d.useful_data <= bytes)
+        return false;
+
+    logf("refill deferred: %zu", bytes);
+    refill_deferred = true;
+    prefetch_plan.deferred++;
+    prefetch_plan.watermark = bytes;
+    buf_set_watermark(bytes);
+    add_event_ex(BUFFER_EVENT_BUFFER_LOW, true,
+                 buffer_event_buffer_low_callback, NULL);
+    return true;
+}
+#endif /* HAVE_DISK_STORAGE */
+
 /* Set the buffer margin to begin rebuffering when 'seconds' from empty */
 static void audio_update_filebuf_watermark(int seconds)
 {
@@ -1041,18 +1242,21 @@ static void audio_update_filebuf_watermark(int seconds)
     seconds = 1;
 #endif
 
-    /* Watermark is a function of the bitrate of the last track in the buffer */
+    /* Watermark is a function of the bitrates of the last tracks in the
+       buffer */
+    size_t planned = audio_plan_prefetch(seconds);
     struct track_info info;
     struct mp3entry *id3 = NULL;
 
     if (track_list_last(0, &info))
-        id3 = valid_mp3entry(bufgetid3(info.id3_hid));
+        id3 = valid_mp3entry(bufpeekid3(info.id3_hid));
 
     if (id3)
     {
         if (!rbcodec_format_is_atomic(id3->codectype))
         {
-            bytes = id3->bitrate * (1000/8) * seconds;
+            /* Without a plan, by the bitrate of the last track */
+            bytes = planned ? planned : id3->bitrate * (1000/8) * seconds;
         }
         else
         {
@@ -1073,6 +1277,7 @@ static void audio_update_filebuf_watermark(int seconds)
 
     /* Actually setting zero disables the notification and we use that
        to detect that it has been reset */
+    prefetch_plan.watermark = MAX(bytes, 1);
     buf_set_watermark(MAX(bytes, 1));
     logf("fwmark: %zu", bytes);
 }
@@ -1212,7 +1417,7 @@ static void playing_id3_sync(struct track_info *user_infop,
 {
     id3_mutex_lock();
 
-    struct mp3entry *id3 = bufgetid3(user_infop->id3_hid);
+    struct mp3entry *id3 = bufpeekid3(user_infop->id3_hid);
     struct mp3entry *playing_id3 = id3_get(PLAYING_ID3);
 
     pcm_play_lock();
@@ -1240,6 +1445,7 @@ static void playing_id3_sync(struct track_info *user_infop,
     {
         id3->elapsed = elapsed;
         id3->offset = offset;
+        bufwriteid3(user_infop->id3_hid, id3);
     }
 
     id3_mutex_unlock();
@@ -1538,18 +1744,13 @@ static bool audio_start_codec(bool auto_skip)
     struct track_info info;
     track_list_current(0, &info);
 
-    struct mp3entry *cur_id3 = valid_mp3entry(bufgetid3(info.id3_hid));
+    struct mp3entry *cur_id3 = &audio_scratch_memory->load_id3;
 
-    if (!cur_id3)
+    if (!bufreadid3(info.id3_hid, cur_id3) || !valid_mp3entry(cur_id3))
         return false;
 
-    buf_pin_handle(info.id3_hid, true);
-
     if (!audio_init_codec(&info, cur_id3))
-    {
-        buf_pin_handle(info.id3_hid, false);
         return false;
-    }
 
 #ifdef HAVE_TAGCACHE
     bool autoresume_enable = global_settings.autoresume_enable;
@@ -1623,7 +1824,8 @@ static bool audio_start_codec(bool auto_skip)
         send_track_event(PLAYBACK_EVENT_TRACK_BUFFER, 0, cur_id3);
     }
 
-    buf_pin_handle(info.id3_hid, false);
+    /* Keep the resume position for the buffered track */
+    bufwriteid3(info.id3_hid, cur_id3);
     return true;
 
     (void)auto_skip; /* ifndef HAVE_TAGCACHE */
@@ -1767,7 +1969,7 @@ static bool audio_buffer_codec(struct track_info *track_infop,
     struct track_info prev_info;
     track_list_last(-1, &prev_info);
 
-    struct mp3entry *prev_id3 = bufgetid3(prev_info.id3_hid);
+    struct mp3entry *prev_id3 = bufpeekid3(prev_info.id3_hid);
 
     /* If the previous codec is the same as this one, there is no need to
        put another copy of it on the file buffer (in other words, only
@@ -1960,13 +2162,14 @@ static int audio_finish_load_track(struct track_info *infop)
     struct track_info cur_info;
     track_list_current(0, &cur_info);
 
-    struct mp3entry *track_id3 = valid_mp3entry(bufgetid3(infop->id3_hid));
+    struct mp3entry *track_id3 = &audio_scratch_memory->load_id3;
 
-    if (!track_id3)
+    if (!bufreadid3(infop->id3_hid, track_id3) || !valid_mp3entry(track_id3))
     {
         /* This is an error condition. Track cannot be played without valid
            metadata; skip the track. */
         logf("No metadata");
+        track_id3 = NULL;
         trackstat = LOAD_TRACK_ERR_FINISH_FAILED;
         goto audio_finish_load_track_exit;
     }
@@ -2102,6 +2305,9 @@ static int audio_finish_load_track(struct track_info *infop)
     }
 
 audio_finish_load_track_exit:
+    if (track_id3)
+        bufwriteid3(infop->id3_hid, track_id3);
+
     if (trackstat >= LOAD_TRACK_OK && !track_info_sync(infop))
     {
         logf("Track info sync failed");
@@ -2212,6 +2418,11 @@ static void audio_on_buffering(int event)
         if (filling != STATE_FULL && filling != STATE_END_OF_PLAYLIST)
             return; /* Should be nothing left to fill */
 
+#ifdef HAVE_DISK_STORAGE
+        if (audio_defer_refill())
+            return;
+#endif
+
         /* Clear old tracks and continue buffering where it left off */
         action = TRACK_LIST_KEEP_NEW;
         peek_offset = playlist_peek_offset;
@@ -2233,6 +2444,7 @@ static void audio_on_buffering(int event)
     case TRACK_SKIP_NONE:
     case TRACK_SKIP_AUTO:
     case TRACK_SKIP_AUTO_NEW_PLAYLIST:
+        audio_prefetch_refill_started();
         audio_reset_and_rebuffer(action, peek_offset);
         break;
 
@@ -2266,7 +2478,7 @@ static void audio_on_finish_load_track(int id3_hid)
     if (info.self_hid == user_cur.self_hid)
     {
         /* Just loaded the metadata right after the current position */
-        audio_update_and_announce_next_track(bufgetid3(info.id3_hid));
+        audio_update_and_announce_next_track(bufpeekid3(info.id3_hid));
     }
 
     if (audio_finish_load_track(&info) != LOAD_TRACK_READY)
@@ -2371,18 +2583,15 @@ static void audio_finalise_track_change(void)
 
     struct track_info info;
     bool have_info = track_list_current(0, &info);
-    struct mp3entry *track_id3 = NULL;
 
     id3_mutex_lock();
 
     /* Update the current cuesheet if any and enabled */
     if (have_info)
-    {
         buf_read_cuesheet(info.cuesheet_hid);
-        track_id3 = bufgetid3(info.id3_hid);
-    }
 
-    id3_write(PLAYING_ID3, track_id3);
+    if (!have_info || !bufreadid3(info.id3_hid, id3_get(PLAYING_ID3)))
+        id3_write(PLAYING_ID3, NULL);
 
     /* The skip is technically over */
     skip_pending = TRACK_SKIP_NONE;
@@ -2390,8 +2599,10 @@ static void audio_finalise_track_change(void)
     /* Sync the next track information */
     have_info = track_list_current(1, &info);
 
-    id3_write(NEXTTRACK_ID3, have_info ? bufgetid3(info.id3_hid) :
-                                         id3_get(UNBUFFERED_ID3));
+    if (!have_info)
+        id3_write(NEXTTRACK_ID3, id3_get(UNBUFFERED_ID3));
+    else if (!bufreadid3(info.id3_hid, id3_get(NEXTTRACK_ID3)))
+        id3_write(NEXTTRACK_ID3, NULL);
 
     id3_mutex_unlock();
 
@@ -2515,7 +2726,7 @@ static void audio_on_codec_complete(int status)
                issue and a pointless full reload of all the track's
                metadata may be avoided */
 
-            struct mp3entry *track_id3 = bufgetid3(info.id3_hid);
+            struct mp3entry *track_id3 = bufpeekid3(info.id3_hid);
 
             if (track_id3 && !rbcodec_format_is_atomic(track_id3->codectype))
             {
@@ -2706,6 +2917,7 @@ static void audio_start_playback(const struct audio_resume_info *resume_info,
     }
 
     /* Fill the buffer */
+    audio_prefetch_refill_started();
     int trackstat = audio_fill_file_buffer();
 
     if (trackstat >= LOAD_TRACK_OK)
@@ -2820,6 +3032,16 @@ static void audio_on_skip(void)
     if (play_status == PLAY_STOPPED)
         return;
 
+    if (toskip == 1 && skip_pending == TRACK_SKIP_AUTO && !ff_rw_mode &&
+        global_settings.instant_skip && pcmbuf_skip_to_track_change())
+    {
+        /* The codec already moved on to the next track - play what it has
+           decoded of it and complete the change as a manual skip */
+        track_event_flags = TEF_NONE;
+        audio_on_track_changed();
+        return;
+    }
+
     /* Force codec to abort this track */
     halt_decoding_track(true);
 
@@ -3113,6 +3335,7 @@ static void audio_on_audio_flush(void)
         audio_update_and_announce_next_track(NULL);
 
         /* Ignore return since it's about the next track, not this one */
+        audio_prefetch_refill_started();
         audio_fill_file_buffer();
 
         if (skip_pending == TRACK_SKIP_NONE)
@@ -3262,6 +3485,11 @@ void audio_playback_handler(struct queue_event *ev)
 
         case SYS_TIMEOUT:
             LOGFQUEUE_SYS_TIMEOUT("playback < SYS_TIMEOUT");
+            /* Nothing to buffer - tidy up the core buffer a little so a
+               later large allocation finds less to move. This returns at
+               once unless a free has left a hole since the last step. */
+            if (filling == STATE_FULL || filling == STATE_FINISHED)
+                core_compact_step(AUDIO_COMPACT_STEP);
             break;
 
         default:
@@ -3575,7 +3803,10 @@ void audio_hard_stop(void)
     voice_stop();
 #endif
     if (audiobuf_handle > 0)
+    {
+        codec_cache_init(NULL, 0);
         audiobuf_handle = core_free(audiobuf_handle);
+    }
 }
 
 /* Resume playback if paused */
@@ -3766,6 +3997,12 @@ size_t audio_get_filebuflen(void)
     return buf_length();
 }
 
+/* Return a copy of the last prefetch plan */
+void audio_get_prefetch_plan(struct prefetch_plan *plan)
+{
+    *plan = prefetch_plan;
+}
+
 /* How many tracks exist on the buffer - full or partial */
 unsigned int audio_track_count(void)
     __attribute__((alias("track_list_count")));
@@ -3798,6 +4035,14 @@ void audio_set_buffer_margin(int seconds)
     LOGFQUEUE("audio > audio Q_AUDIO_UPDATE_WATERMARK: %u",(unsigned) seconds);
     audio_queue_post(Q_AUDIO_UPDATE_WATERMARK, (unsigned) seconds); /*SECONDS*/
 }
+
+/* Set the minimum time between buffer refills in SECONDS, 0 for none; takes
+   effect at the next refill */
+void audio_set_prefetch_interval(int seconds)
+{
+    logf("prefetch interval: %d", seconds);
+    prefetch_interval = seconds;
+}
 #endif /* HAVE_DISK_STORAGE */
 
 #ifdef HAVE_CROSSFADE
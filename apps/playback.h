@@ -88,6 +88,29 @@ void audio_set_playback_frequency(int setting);
 
 size_t audio_get_filebuflen(void);
 
+/* The tracks ahead as the audio thread last laid them out: when each will
+   play and how much of it is on the buffer */
+#define PREFETCH_PLAN_TRACKS 8
+struct prefetch_plan
+{
+    long tick;                  /* when the plan was made */
+    int count;                  /* tracks in the schedule */
+    struct
+    {
+        unsigned long cost;     /* estimated bytes of the track's audio */
+        unsigned long buffered; /* bytes of it on the buffer */
+        unsigned long start;    /* ms after tick until it plays */
+        unsigned long length;   /* ms of it left to play */
+    } tracks[PREFETCH_PLAN_TRACKS];
+    unsigned long ahead;        /* ms of buffered play time */
+    size_t watermark;           /* bytes left when refilling starts */
+    long next_refill;           /* estimated tick of the next refill */
+    long last_refill;           /* tick the last refill started */
+    unsigned int refills;       /* refills started */
+    unsigned int deferred;      /* refills put off for the prefetch interval */
+};
+void audio_get_prefetch_plan(struct prefetch_plan *plan);
+
 unsigned int playback_status(void);
 
 #endif /* _PLAYBACK_H */
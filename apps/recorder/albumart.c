@@ -30,6 +30,12 @@
 #include "pathfuncs.h"
 #include "settings.h"
 #include "wps.h"
+#ifndef PLUGIN
+#include "file.h"
+#include "dir.h"
+#include "crc32.h"
+#include "rbpaths.h"
+#endif
 
 /* Define LOGF_ENABLE to enable logf output in this file */
 /*#define LOGF_ENABLE*/
@@ -367,4 +373,271 @@ void draw_album_art(struct gui_wps *gwps, int handle_id, bool clear)
     }
 }
 
+/** Scaled album art cache **/
+
+/* Written after the bitmap data, so that a single read of the file puts the
+   data where it belongs with this right behind it */
+struct albumart_cache_trailer
+{
+    uint32_t magic;
+    struct albumart_cache_key key;
+    int32_t size;           /* bytes of bitmap data */
+    int16_t width;          /* of the scaled bitmap */
+    int16_t height;
+#if (LCD_DEPTH > 1) || defined(HAVE_REMOTE_LCD) && (LCD_REMOTE_DEPTH > 1)
+    int32_t format;
+#endif
+#ifdef HAVE_LCD_COLOR
+    int32_t alpha_offset;
+#endif
+};
+
+/* Bitmaps are in the native format, so they're only good for this depth */
+#define ALBUMART_CACHE_MAGIC (('A' << 24) | ('A' << 16) | (2 << 8) | LCD_DEPTH)
+
+/* Files are spread over this many directories to keep lookups short; the
+   size limit applies to each of them in equal parts */
+#define ALBUMART_CACHE_DIRS 16
+
+/* Bytes at the end of embedded art that identify it */
+#define ALBUMART_CACHE_TAIL 512
+
+static void albumart_cache_dir(char *buf, size_t size,
+                               const struct albumart_cache_key *key)
+{
+    snprintf(buf, size, ALBUMART_CACHE_DIR "/%lx",
+             (unsigned long)key->source_crc % ALBUMART_CACHE_DIRS);
+}
+
+static void albumart_cache_path(char *buf, size_t size,
+                                const struct albumart_cache_key *key)
+{
+    snprintf(buf, size, ALBUMART_CACHE_DIR "/%lx/%08lx%08lx.%ux%u",
+             (unsigned long)key->source_crc % ALBUMART_CACHE_DIRS,
+             (unsigned long)key->source_crc, (unsigned long)key->source_size,
+             (unsigned)key->width, (unsigned)key->height);
+}
+
+bool albumart_cache_key(struct albumart_cache_key *key, const char *path,
+                        int fd, const struct mp3_albumart *embedded,
+                        const struct dim *dim)
+{
+    if (!global_settings.albumart_cache_size)
+        return false;
+
+    memset(key, 0, sizeof (*key));
+
+    if (embedded)
+    {
+        /* Tracks of an album usually carry the same picture, so it is
+           known by its contents rather than by the track */
+        unsigned char tail[ALBUMART_CACHE_TAIL];
+        size_t len = MIN(embedded->size, sizeof (tail));
+
+        if (lseek(fd, embedded->pos + embedded->size - len, SEEK_SET) < 0 ||
+            read(fd, tail, len) != (ssize_t)len)
+            return false;
+
+        key->source_crc = crc_32(tail, len, 0xffffffff);
+        key->source_size = embedded->size;
+    }
+    else
+    {
+        key->source_crc = crc_32(path, strlen(path), 0xffffffff);
+        key->source_size = filesize(fd);
+    }
+
+    key->width = dim->width;
+    key->height = dim->height;
+    return true;
+}
+
+int albumart_cache_load(const struct albumart_cache_key *key,
+                        struct bitmap *bmp, int maxsize)
+{
+    struct albumart_cache_trailer trailer;
+    char path[MAX_PATH];
+
+    albumart_cache_path(path, sizeof (path), key);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    ssize_t rc = read(fd, bmp->data, maxsize);
+    close(fd);
+
+    if (rc < (ssize_t)sizeof (trailer))
+        return -1;
+
+    rc -= sizeof (trailer);
+    memcpy(&trailer, bmp->data + rc, sizeof (trailer));
+
+    /* a truncated file or one that didn't fit fails the size check */
+    if (trailer.magic != ALBUMART_CACHE_MAGIC ||
+        memcmp(&trailer.key, key, sizeof (*key)) || trailer.size != rc)
+    {
+        logf("Album art cache miss: %s", path);
+        return -1;
+    }
+
+    bmp->width = trailer.width;
+    bmp->height = trailer.height;
+#if (LCD_DEPTH > 1) || defined(HAVE_REMOTE_LCD) && (LCD_REMOTE_DEPTH > 1)
+    bmp->format = trailer.format;
+    bmp->maskdata = NULL;
+#endif
+#ifdef HAVE_LCD_COLOR
+    bmp->alpha_offset = trailer.alpha_offset;
+#endif
+
+    return rc;
+}
+
+/* Remove the oldest files in the directory, whose path is in a MAX_PATH
+   buffer, until size more bytes stay within its share of the limit.
+   Returns false if that can't be done. */
+static bool albumart_cache_make_room(char *dirpath, size_t size)
+{
+    off_t limit = (off_t)global_settings.albumart_cache_size * 1024 * 1024
+                    / ALBUMART_CACHE_DIRS;
+    size_t dirlen = strlen(dirpath);
+    bool ok = false;
+
+    if ((off_t)size > limit)
+        return false;
+
+    while (1)
+    {
+        DIR *dir = opendir(dirpath);
+        if (!dir)
+            return true; /* a new directory */
+
+        struct dirent *entry;
+        off_t used = 0;
+        time_t oldest_time = 0;
+        char oldest[MAX_PATH];
+        oldest[0] = '\0';
+
+        while ((entry = readdir(dir)))
+        {
+            struct dirinfo info = dir_get_info(dir, entry);
+            if (info.attribute & ATTR_DIRECTORY)
+                continue;
+
+            used += info.size;
+            if (!oldest[0] || info.mtime < oldest_time)
+            {
+                oldest_time = info.mtime;
+                strlcpy(oldest, entry->d_name, sizeof (oldest));
+            }
+        }
+
+        closedir(dir);
+
+        if (used + (off_t)size <= limit)
+        {
+            ok = true;
+            break;
+        }
+
+        if (!oldest[0])
+            break;
+
+        int rc = -1;
+        if (path_append(dirpath + dirlen, PA_SEP_HARD, oldest,
+                        MAX_PATH - dirlen) < MAX_PATH - dirlen)
+        {
+            logf("Album art cache full, removing %s", dirpath);
+            rc = remove(dirpath);
+        }
+        dirpath[dirlen] = '\0';
+        if (rc < 0)
+            break;
+    }
+
+    return ok;
+}
+
+bool albumart_cache_store(const struct albumart_cache_key *key,
+                          const struct bitmap *bmp, int size)
+{
+    struct albumart_cache_trailer trailer =
+    {
+        .magic  = ALBUMART_CACHE_MAGIC,
+        .key    = *key,
+        .size   = size,
+        .width  = bmp->width,
+        .height = bmp->height,
+#if (LCD_DEPTH > 1) || defined(HAVE_REMOTE_LCD) && (LCD_REMOTE_DEPTH > 1)
+        .format = bmp->format,
+#endif
+#ifdef HAVE_LCD_COLOR
+        .alpha_offset = bmp->alpha_offset,
+#endif
+    };
+    char path[MAX_PATH];
+
+    if (!global_settings.albumart_cache_size)
+        return false;
+
+    albumart_cache_dir(path, sizeof (path), key);
+    if (!albumart_cache_make_room(path, size + sizeof (trailer)))
+        return false;
+
+    /* fails harmlessly if they're already there */
+    mkdir(ALBUMART_CACHE_DIR);
+    mkdir(path);
+
+    albumart_cache_path(path, sizeof (path), key);
+
+    int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0)
+        return false;
+
+    bool ok = write(fd, bmp->data, size) == size &&
+              write(fd, &trailer, sizeof (trailer)) == sizeof (trailer);
+    close(fd);
+
+    if (ok)
+        logf("Album art cached: %s", path);
+    else
+        remove(path);
+
+    return ok;
+}
+
+void albumart_cache_clear(void)
+{
+    char path[MAX_PATH];
+
+    for (int i = 0; i < ALBUMART_CACHE_DIRS; i++)
+    {
+        snprintf(path, sizeof (path), ALBUMART_CACHE_DIR "/%x", i);
+        size_t dirlen = strlen(path);
+
+        DIR *dir = opendir(path);
+        if (!dir)
+            continue;
+
+        struct dirent *entry;
+        while ((entry = readdir(dir)))
+        {
+            struct dirinfo info = dir_get_info(dir, entry);
+            if (info.attribute & ATTR_DIRECTORY)
+                continue;
+
+            if (path_append(path + dirlen, PA_SEP_HARD, entry->d_name,
+                            sizeof (path) - dirlen) < sizeof (path) - dirlen)
+                remove(path);
+            path[dirlen] = '\0';
+        }
+
+        closedir(dir);
+        rmdir(path);
+    }
+
+    rmdir(ALBUMART_CACHE_DIR);
+}
+
 #endif /* PLUGIN */
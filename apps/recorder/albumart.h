@@ -39,6 +39,37 @@ bool find_albumart(const struct mp3entry *id3, char *buf, int buflen,
 /* Draw the album art bitmap from the given handle ID onto the given Skin.
    Call with clear = true to clear the bitmap instead of drawing it. */
 void draw_album_art(struct gui_wps *gwps, int handle_id, bool clear);
+
+/* Identifies a scaled bitmap in the album art cache on disk */
+struct albumart_cache_key
+{
+    uint32_t source_crc;    /* of the image file's path, or of the end of
+                               embedded art */
+    uint32_t source_size;   /* bytes of the image */
+    uint16_t width;         /* size asked for by the skin */
+    uint16_t height;
+};
+
+/* Fill in the key for the image in the open file fd at path; embedded is
+   NULL unless the art is embedded in the track. Returns false if the cache
+   is turned off or the image can't be read. */
+bool albumart_cache_key(struct albumart_cache_key *key, const char *path,
+                        int fd, const struct mp3_albumart *embedded,
+                        const struct dim *dim);
+
+/* Read the cached bitmap for key to bmp->data, which has room for maxsize
+   bytes, and set up bmp. Returns the size of the bitmap data, or < 0 if
+   there's no usable copy. */
+int albumart_cache_load(const struct albumart_cache_key *key,
+                        struct bitmap *bmp, int maxsize);
+
+/* Write bmp, with size bytes of bitmap data, to the cache under key. The
+   oldest files make way if that would exceed the size setting. */
+bool albumart_cache_store(const struct albumart_cache_key *key,
+                          const struct bitmap *bmp, int size);
+
+/* Remove everything in the cache */
+void albumart_cache_clear(void);
 #endif
 
 bool search_albumart_files(const struct mp3entry *id3, const char *size_string,
@@ -779,6 +779,7 @@ void settings_apply(bool read_disk)
 
 #ifdef HAVE_DISK_STORAGE
     audio_set_buffer_margin(global_settings.buffer_margin);
+    audio_set_prefetch_interval(global_settings.prefetch_interval);
 #endif
 
 #ifdef HAVE_LCD_CONTRAST
@@ -462,6 +462,8 @@ struct user_settings
 #ifdef HAVE_DISK_STORAGE
     int disk_spindown; /* time until disk spindown, in seconds (0=off) */
     int buffer_margin; /* audio buffer watermark margin, in seconds */
+    int prefetch_interval; /* minimum time between buffer refills, in
+                              seconds (0=off) */
 #endif
 
     int dirfilter;     /* 0=display all, 1=only supported, 2=only music,
@@ -716,6 +718,10 @@ struct user_settings
     int speaker_mode; /* 0: off, 1: on, 2: auto (only if headphone detection) */
 #endif /* HAVE_SPEAKER */
     bool prevent_skip;
+    bool instant_skip; /* skip into the next track's decoded audio */
+#ifdef HAVE_ALBUMART
+    int albumart_cache_size; /* MB of scaled album art kept on disk, 0=off */
+#endif
 
 #ifdef HAVE_TOUCHSCREEN
     int touch_mode;
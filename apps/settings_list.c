@@ -1226,6 +1226,11 @@ const struct settings_list settings[] = {
                   LANG_MP3BUFFER_MARGIN, 5, "antiskip", NULL, UNIT_SEC,
                   NULL, NULL,
                   NULL,8, 5,15,30,60,120,180,300,600),
+    TABLE_SETTING(F_TIME_SETTING | F_ALLOW_ARBITRARY_VALS, prefetch_interval,
+                  LANG_PREFETCH_INTERVAL, 0, "prefetch interval", "off",
+                  UNIT_SEC, formatter_time_unit_0_is_off,
+                  getlang_time_unit_0_is_off, audio_set_prefetch_interval,
+                  7, 0,60,120,300,600,900,1800),
 #endif
     /* disk */
 #ifdef HAVE_DISK_STORAGE
@@ -2076,6 +2081,12 @@ const struct settings_list settings[] = {
                     tsc_is_changed, tsc_set_default),
 #endif
     OFFON_SETTING(0, prevent_skip, LANG_PREVENT_SKIPPING, false, "prevent track skip", NULL),
+    OFFON_SETTING(0, instant_skip, LANG_INSTANT_SKIP, true, "instant skip", NULL),
+#ifdef HAVE_ALBUMART
+    TABLE_SETTING(0, albumart_cache_size, LANG_ALBUMART_CACHE, 8,
+                  "album art cache", "off", UNIT_MB, formatter_unit_0_is_off,
+                  getlang_unit_0_is_off, NULL, 7, 0,1,2,4,8,16,32),
+#endif
 
 #ifdef HAVE_PITCHCONTROL
     OFFON_SETTING(0, pitch_mode_semitone, LANG_SEMITONE, false,
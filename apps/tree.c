@@ -1195,6 +1195,11 @@ void tree_flush(void)
 
     if (global_settings.dircache)
     {
+    #if defined(DIRCACHE_SNAPSHOT) && !defined(HAVE_EEPROM_SETTINGS)
+        /* this snapshot is verified when loaded so it is taken while the
+           cache is still live */
+        dircache_save();
+    #endif
         dircache_suspend();
 
         struct dircache_info info;
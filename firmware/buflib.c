@@ -35,6 +35,9 @@
 #include "panic.h"
 #include "crc32.h"
 #include "system.h" /* for ALIGN_*() */
+#ifdef HAVE_BUFLIB_TRACE
+#include "kernel.h" /* for current_tick */
+#endif
 
 /* The main goal of this design is fast fetching of the pointer for a handle.
  * For that reason, the handles are stored in a table at the end of the buffer
@@ -76,6 +79,15 @@
  * union buflib_data* L;
  * for(L = start; L < end; L += abs(L->val)) { .... }
  *
+ * Free blocks of at least BUFLIB_FREE_MIN elements are also kept in one of
+ * BUFLIB_NUM_FREE_LISTS doubly linked lists, segregated by power-of-two size
+ * classes. The links are stored in the free block itself, right after the
+ * length marker, as offsets from the buffer start:
+ * |-L|next|prev|YYYYYYY|
+ * Allocation takes the best fitting listed block, so it never has to walk
+ * the allocated blocks. Smaller free blocks are left for merging and
+ * compaction to pick up. The lists are rebuilt after each compaction.
+ *
  * 
  * The allocator functions are passed a context struct so that two allocators
  * can be run, for example, one per core may be used, with convenience wrappers
@@ -98,10 +110,232 @@
 #define BPANICF panicf
 
 #define IS_MOVABLE(a) (!a[2].ops || a[2].ops->move_callback)
+
+/* A free block needs room for its length and both links to be listed */
+#define BUFLIB_FREE_MIN 3
+#define FREE_NEXT(b) (b)[1].val
+#define FREE_PREV(b) (b)[2].val
+/* blocks a compaction step looks at to find one to fill a hole with */
+#define BUFLIB_STEP_SEARCH 32
+
 static union buflib_data* find_first_free(struct buflib_context *ctx);
 static union buflib_data* find_block_before(struct buflib_context *ctx,
                                             union buflib_data* block,
                                             bool is_free);
+static void release_block(struct buflib_context *ctx,
+                          union buflib_data *freed_block);
+
+#ifdef HAVE_BUFLIB_TRACE
+/* the context being traced and where to */
+static struct buflib_context *trace_ctx;
+static struct buflib_trace *trace;
+
+/* Start an event for the block; NULL if the context isn't traced */
+static struct buflib_trace_event*
+trace_event(struct buflib_context *ctx, unsigned int type, int handle,
+            union buflib_data *block, intptr_t len)
+{
+    if (LIKELY(ctx != trace_ctx))
+        return NULL;
+
+    struct buflib_trace_event *ev =
+        &trace->events[trace->pos++ & (BUFLIB_TRACE_SIZE - 1)];
+
+    ev->time    = current_tick;
+    ev->type    = type;
+    ev->handle  = handle;
+    ev->offset  = block ? (block - ctx->buf_start)*sizeof(union buflib_data) : 0;
+    ev->size    = len*sizeof(union buflib_data);
+    ev->from    = 0;
+    ev->name[0] = '\0';
+    return ev;
+}
+
+static void
+trace_block(struct buflib_context *ctx, unsigned int type, int handle,
+            union buflib_data *block)
+{
+    struct buflib_trace_event *ev = trace_event(ctx, type, handle, block,
+                                                block->val);
+    if (ev)
+    {
+        const char *name = buflib_get_name(ctx, handle);
+        if (name)
+            strlcpy(ev->name, name, sizeof (ev->name));
+
+        if (type == BUFLIB_TRACE_ALLOC)
+            trace->allocs++;
+        else if (type == BUFLIB_TRACE_FREE)
+            trace->frees++;
+        else if (type == BUFLIB_TRACE_SHRINK)
+            trace->shrinks++;
+    }
+}
+
+static void
+trace_move(struct buflib_context *ctx, int handle, union buflib_data *block,
+           int shift)
+{
+    struct buflib_trace_event *ev = trace_event(ctx, BUFLIB_TRACE_MOVE,
+                                                handle, block, block->val);
+    if (ev)
+    {
+        const char *name = buflib_get_name(ctx, handle);
+        if (name)
+            strlcpy(ev->name, name, sizeof (ev->name));
+
+        ev->from = ev->offset - shift*(int)sizeof(union buflib_data);
+        trace->moves++;
+        trace->move_bytes += ev->size;
+    }
+}
+
+static void
+trace_fail(struct buflib_context *ctx, size_t size)
+{
+    if (trace_event(ctx, BUFLIB_TRACE_FAIL, 0, NULL, size))
+        trace->fails++;
+}
+
+static void
+trace_compact(struct buflib_context *ctx, intptr_t gained)
+{
+    if (trace_event(ctx, BUFLIB_TRACE_COMPACT, 0, NULL, gained))
+        trace->compactions++;
+}
+
+void buflib_trace_enable(struct buflib_context *ctx,
+                         struct buflib_trace *newtrace)
+{
+    if (newtrace)
+        memset(newtrace, 0, sizeof (*newtrace));
+
+    trace = newtrace;
+    trace_ctx = newtrace ? ctx : NULL;
+}
+
+int buflib_get_trace(struct buflib_trace_event *events, int count)
+{
+    if (!trace || !events || count <= 0)
+        return 0;
+
+    unsigned int pos = trace->pos;
+    unsigned int avail = MIN(pos, BUFLIB_TRACE_SIZE);
+    if ((unsigned int)count > avail)
+        count = avail;
+
+    for (int i = 0; i < count; i++)
+        events[i] = trace->events[(pos - count + i) & (BUFLIB_TRACE_SIZE - 1)];
+
+    return count;
+}
+#else /* !HAVE_BUFLIB_TRACE */
+#define trace_block(ctx, type, handle, block) \
+    do {} while (0)
+#define trace_move(ctx, handle, block, shift) \
+    do {} while (0)
+#define trace_fail(ctx, size) \
+    do {} while (0)
+#define trace_compact(ctx, gained) \
+    do {} while (0)
+#endif /* HAVE_BUFLIB_TRACE */
+
+/* Size class of a free block of len elements: 3 is in class 0, then each
+ * power of two gets its own class with the last one taking all the rest */
+static inline int free_list_class(intptr_t len)
+{
+    int class = 0;
+    for (len >>= 2; len > 0 && class < BUFLIB_NUM_FREE_LISTS - 1; len >>= 1)
+        class++;
+    return class;
+}
+
+/* Put a free block (negative length marker) on its size class' list */
+static void free_list_add(struct buflib_context *ctx, union buflib_data *block)
+{
+    intptr_t len = -block->val;
+    if (len < BUFLIB_FREE_MIN)
+        return;
+
+    intptr_t *head = &ctx->free_lists[free_list_class(len)];
+    intptr_t offset = block - ctx->buf_start;
+
+    FREE_NEXT(block) = *head;
+    FREE_PREV(block) = -1;
+    if (*head >= 0)
+        FREE_PREV(ctx->buf_start + *head) = offset;
+    *head = offset;
+}
+
+/* Take a free block off its list; must be called before its length marker
+ * changes or its links are overwritten */
+static void free_list_remove(struct buflib_context *ctx,
+                             union buflib_data *block)
+{
+    intptr_t len = -block->val;
+    if (len < BUFLIB_FREE_MIN)
+        return;
+
+    intptr_t next = FREE_NEXT(block), prev = FREE_PREV(block);
+
+    if (prev >= 0)
+        FREE_NEXT(ctx->buf_start + prev) = next;
+    else
+        ctx->free_lists[free_list_class(len)] = next;
+
+    if (next >= 0)
+        FREE_PREV(ctx->buf_start + next) = prev;
+}
+
+/* Re-index all free blocks, after compaction moved everything around */
+static void free_lists_rebuild(struct buflib_context *ctx)
+{
+    for (int i = 0; i < BUFLIB_NUM_FREE_LISTS; i++)
+        ctx->free_lists[i] = -1;
+
+    for (union buflib_data *block = find_first_free(ctx);
+         block < ctx->alloc_end; block += abs(block->val))
+    {
+        if (block->val < 0)
+            free_list_add(ctx, block);
+    }
+}
+
+/* Find the smallest listed free block of at least size elements. Since the
+ * classes are ordered, the smallest fit in the first class having any fit is
+ * the overall best fit. */
+static union buflib_data* free_list_find(struct buflib_context *ctx,
+                                         size_t size)
+{
+    for (int class = free_list_class(size); class < BUFLIB_NUM_FREE_LISTS;
+         class++)
+    {
+        union buflib_data *best = NULL;
+        size_t best_len = 0;
+
+        for (intptr_t offset = ctx->free_lists[class]; offset >= 0;)
+        {
+            union buflib_data *block = ctx->buf_start + offset;
+            size_t len = -block->val;
+
+            if (len >= size && (!best || len < best_len))
+            {
+                best = block;
+                best_len = len;
+                if (len == size)
+                    break;
+            }
+
+            offset = FREE_NEXT(block);
+        }
+
+        if (best)
+            return best;
+    }
+
+    return NULL;
+}
+
 /* Initialize buffer manager */
 void
 buflib_init(struct buflib_context *ctx, void *buf, size_t size)
@@ -123,6 +357,7 @@ buflib_init(struct buflib_context *ctx, void *buf, size_t size)
      */
     ctx->alloc_end = bd_buf;
     ctx->compact = true;
+    free_lists_rebuild(ctx);
 
     if (size == 0)
     {
@@ -292,6 +527,7 @@ move_block(struct buflib_context* ctx, union buflib_data* block, int shift)
     {
         tmp->alloc = new_start; /* update handle table */
         memmove(new_block, block, block->val * sizeof(union buflib_data));
+        trace_move(ctx, handle, new_block, shift);
         retval = true;
     }
 
@@ -381,9 +617,144 @@ buflib_compact(struct buflib_context *ctx)
      */
     ctx->alloc_end += shift;
     ctx->compact = true;
+    free_lists_rebuild(ctx);
+    trace_compact(ctx, -shift);
     return ret || shift;
 }
 
+/* Advance to the first free block at or after block, or alloc_end */
+static union buflib_data*
+find_next_free(struct buflib_context *ctx, union buflib_data *block)
+{
+    while (block < ctx->alloc_end && block->val > 0)
+        block += block->val;
+    return block;
+}
+
+/* Do part of a compaction, moving at most max_bytes of allocations. Blocks
+ * that don't fit in what is left of the budget stay where they are until a
+ * later step or a full compaction. Every step leaves a valid buffer behind,
+ * so steps may be spread out over time. The search for blocks to fill holes
+ * with is bounded by BUFLIB_STEP_SEARCH for the whole step.
+ *
+ * Returns the number of bytes moved; 0 means there is nothing left to do
+ * within that budget.
+ */
+size_t
+buflib_compact_step(struct buflib_context *ctx, size_t max_bytes)
+{
+    intptr_t budget = max_bytes / sizeof(union buflib_data);
+    intptr_t moved = 0;
+    int search = BUFLIB_STEP_SEARCH;
+    /* set if anything movable was left in place */
+    bool unfinished = false;
+
+    /* no holes */
+    if (ctx->compact)
+        return 0;
+
+    for (union buflib_data *block = find_first_free(ctx);
+         block < ctx->alloc_end;)
+    {
+        /* block is always a free one here */
+        intptr_t len = -block->val;
+        union buflib_data *next = block + len;
+
+        if (next == ctx->alloc_end)
+        {   /* free space at the end joins the unallocated area */
+            free_list_remove(ctx, block);
+            ctx->alloc_end = block;
+            break;
+        }
+
+        intptr_t next_len = next->val;
+        if (next_len < 0)
+        {   /* merge free blocks left side by side by a compaction */
+            free_list_remove(ctx, block);
+            free_list_remove(ctx, next);
+            block->val += next_len;
+            free_list_add(ctx, block);
+            continue;
+        }
+
+        /* first choice: slide the following block down */
+        if (IS_MOVABLE(next))
+        {
+            if (next_len <= budget - moved)
+            {
+                free_list_remove(ctx, block);
+                if (move_block(ctx, next, -len))
+                {
+                    moved += next_len;
+                    block += next_len;
+                    block->val = -len;
+                    free_list_add(ctx, block);
+                    continue;
+                }
+                free_list_add(ctx, block);
+            }
+            unfinished = true;
+        }
+
+        /* second choice: fill the hole with a later block that fits */
+        union buflib_data *fill = NULL;
+        for (union buflib_data *this = next + next_len;
+             this < ctx->alloc_end; this += abs(this->val))
+        {
+            if (search-- <= 0)
+            {   /* give up looking; a later step carries on */
+                unfinished = true;
+                break;
+            }
+            if (this->val <= 0 || this->val > len || !IS_MOVABLE(this))
+                continue;
+            if (this->val <= budget - moved)
+            {
+                fill = this;
+                break;
+            }
+            unfinished = true;
+        }
+
+        if (fill)
+        {
+            intptr_t fill_len = fill->val;
+            free_list_remove(ctx, block);
+            if (move_block(ctx, fill, block - fill))
+            {
+                moved += fill_len;
+                if (fill_len < len)
+                {
+                    block += fill_len;
+                    block->val = fill_len - len;
+                    free_list_add(ctx, block);
+                }
+                else
+                    block = next;
+                /* the block's old place is free now */
+                release_block(ctx, fill);
+                block = find_next_free(ctx, block);
+                continue;
+            }
+            free_list_add(ctx, block);
+            unfinished = true;
+        }
+
+        /* leave the hole for now */
+        block = find_next_free(ctx, next);
+    }
+
+    if (!unfinished)
+    {
+        /* the walk for unused handles needs one in use to stop at */
+        if (ctx->alloc_end > ctx->buf_start)
+            handle_table_shrink(ctx);
+        ctx->compact = true;
+    }
+
+    return moved * sizeof(union buflib_data);
+}
+
 /* Compact the buffer by trying both shrinking and moving.
  *
  * Try to move first. If unsuccesfull, try to shrink. If that was successful
@@ -555,14 +926,24 @@ handle_alloc:
          * if possible */
         if (buflib_compact_and_shrink(ctx, hints))
             goto handle_alloc;
+        trace_fail(ctx, size);
         return -1;
     }
 
 buffer_alloc:
-    /* need to re-evaluate last before the loop because the last allocation
-     * possibly made room in its front to fit this, so last would be wrong */
+    /* need to re-evaluate last because the last allocation possibly made
+     * room in its front to fit this, so last would be wrong */
     last = false;
-    for (block = find_first_free(ctx);;block += block_len)
+    /* The search is best-fit among the free blocks before the end of
+     * allocation, any fragmentation this causes will be handled at
+     * compaction. */
+    block = free_list_find(ctx, size);
+    if (block)
+    {
+        block_len = -block->val;
+        free_list_remove(ctx, block);
+    }
+    else
     {
         /* If the last used block extends all the way to the handle table, the
          * block "after" it doesn't have a header. Because of this, it's easier
@@ -570,24 +951,11 @@ buffer_alloc:
          * calculate the free space at the end by comparing it to the
          * last_handle pointer.
          */
-        if(block == ctx->alloc_end)
-        {
-            last = true;
-            block_len = ctx->last_handle - block;
-            if ((size_t)block_len < size)
-                block = NULL;
-            break;
-        }
-        block_len = block->val;
-        /* blocks with positive length are already allocated. */
-        if(block_len > 0)
-            continue;
-        block_len = -block_len;
-        /* The search is first-fit, any fragmentation this causes will be
-         * handled at compaction.
-         */
-        if ((size_t)block_len >= size)
-            break;
+        block = ctx->alloc_end;
+        last = true;
+        block_len = ctx->last_handle - block;
+        if ((size_t)block_len < size)
+            block = NULL;
     }
     if (!block)
     {
@@ -600,6 +968,7 @@ buffer_alloc:
         } else {
             handle->val=1;
             handle_free(ctx, handle);
+            trace_fail(ctx, size);
             return -2;
         }
     }
@@ -625,13 +994,18 @@ buffer_alloc:
             (unsigned int)size, (void *)handle, (void *)ops,
             (unsigned int)crc_slot->crc, name ? block[3].name:"");
 
+    trace_block(ctx, BUFLIB_TRACE_ALLOC, ctx->handle_table - handle, block);
+
     block += size;
     /* alloc_end must be kept current if we're taking the last block. */
     if (last)
         ctx->alloc_end = block;
     /* Only free blocks *before* alloc_end have tagged length. */
     else if ((size_t)block_len > size)
+    {
         block->val = size - block_len;
+        free_list_add(ctx, block);
+    }
     /* Return the handle index as a positive integer. */
     return ctx->handle_table - handle;
 }
@@ -677,19 +1051,19 @@ find_block_before(struct buflib_context *ctx, union buflib_data* block,
     return NULL;
 }
 
-/* Free the buffer associated with handle_num. */
-int
-buflib_free(struct buflib_context *ctx, int handle_num)
+/* Mark an allocated block free, merging it with any free neighbours or the
+ * free space at the end of allocation. */
+static void
+release_block(struct buflib_context *ctx, union buflib_data *freed_block)
 {
-    union buflib_data *handle = ctx->handle_table - handle_num,
-                      *freed_block = handle_to_block(ctx, handle_num),
-                      *block, *next_block;
+    union buflib_data *block, *next_block;
     /* We need to find the block before the current one, to see if it is free
      * and can be merged with this one.
      */
     block = find_block_before(ctx, freed_block, true);
     if (block)
     {
+        free_list_remove(ctx, block);
         block->val -= freed_block->val;
     }
     else
@@ -711,8 +1085,23 @@ buflib_free(struct buflib_context *ctx, int handle_num)
     else {
         ctx->compact = false;
         if (next_block->val < 0)
+        {
+            free_list_remove(ctx, next_block);
             block->val += next_block->val;
+        }
+        free_list_add(ctx, block);
     }
+}
+
+/* Free the buffer associated with handle_num. */
+int
+buflib_free(struct buflib_context *ctx, int handle_num)
+{
+    union buflib_data *handle = ctx->handle_table - handle_num,
+                      *freed_block = handle_to_block(ctx, handle_num);
+
+    trace_block(ctx, BUFLIB_TRACE_FREE, handle_num, freed_block);
+    release_block(ctx, freed_block);
     handle_free(ctx, handle);
     handle->alloc = NULL;
 
@@ -798,6 +1187,39 @@ buflib_available(struct buflib_context* ctx)
     return free_space;
 }
 
+/* Gather how the free space is split up */
+void
+buflib_get_frag_stats(struct buflib_context* ctx,
+                      struct buflib_frag_stats *stats)
+{
+    size_t total = 0, largest = 0;
+    int count = 0;
+
+    for (union buflib_data *this = find_first_free(ctx);
+         this < ctx->alloc_end; this += abs(this->val))
+    {
+        if (this->val < 0)
+        {
+            size_t len = -this->val;
+            total += len;
+            largest = MAX(largest, len);
+            count++;
+        }
+    }
+
+    size_t end = ctx->last_handle - ctx->alloc_end;
+    if (end > 0)
+    {
+        total += end;
+        largest = MAX(largest, end);
+        count++;
+    }
+
+    stats->total_free   = total * sizeof(union buflib_data);
+    stats->largest_free = largest * sizeof(union buflib_data);
+    stats->free_blocks  = count;
+}
+
 /*
  * Allocate all available (as returned by buflib_available()) memory and return
  * a handle to it
@@ -879,7 +1301,13 @@ buflib_shrink(struct buflib_context* ctx, int handle, void* new_start, size_t ne
         /* find the block before in order to merge with the new free space */
         union buflib_data *free_before = find_block_before(ctx, block, true);
         if (free_before)
+        {
+            free_list_remove(ctx, free_before);
             free_before->val += block->val;
+            free_list_add(ctx, free_before);
+        }
+        else
+            free_list_add(ctx, block);
 
         /* We didn't handle size changes yet, assign block to the new one
          * the code below the wants block whether it changed or not */
@@ -898,15 +1326,20 @@ buflib_shrink(struct buflib_context* ctx, int handle, void* new_start, size_t ne
             ctx->alloc_end = new_next_block;
         else if (old_next_block->val < 0)
         {   /* enlarge next block by moving it up */
-            new_next_block->val = old_next_block->val - (old_next_block - new_next_block);
+            intptr_t len = old_next_block->val - (old_next_block - new_next_block);
+            free_list_remove(ctx, old_next_block);
+            new_next_block->val = len;
+            free_list_add(ctx, new_next_block);
         }
         else if (old_next_block != new_next_block)
         {   /* creating a hole */
             /* must be negative to indicate being unallocated */
             new_next_block->val = new_next_block - old_next_block;
+            free_list_add(ctx, new_next_block);
         }
     }
 
+    trace_block(ctx, BUFLIB_TRACE_SHRINK, handle, new_block);
     return true;
 }
 
@@ -90,7 +90,22 @@
  *
  * r0->r1->r2->q0->q1->q2->NULL
  * ^resolved0  ^queued0
- */
+ *
+ * Snapshots:
+ * The cache may be saved to storage at shutdown and loaded on the next boot.
+ * Each volume in the snapshot is identified by its serial number, size and
+ * free space and is dropped if any of these don't match. Without an EEPROM
+ * to say the disk was left clean, the volume root must also match and the
+ * snapshot is put into service at once while a background pass reads every
+ * directory, keeps the ones that agree with the cache and rescans the rest.
+ * Until the pass has settled a directory, lookups in it read through to the
+ * storage and don't take anything from the snapshot.
+ */
+
+#if defined(DIRCACHE_SNAPSHOT) && !defined(HAVE_EEPROM_SETTINGS)
+/* a loaded snapshot is verified against the storage */
+#define DIRCACHE_VERIFY
+#endif
 
 #ifdef DIRCACHE_NATIVE
 #define dircache_lock()   file_internal_lock_WRITER()
@@ -103,6 +118,9 @@ struct sab
     struct filestr_base   stream;    /* scan directory stream */
     struct file_base_info info;      /* scanned entry info */
     bool volatile         quit;      /* halt all scanning */
+#ifdef DIRCACHE_VERIFY
+    bool                  verify;    /* compare cached contents first */
+#endif
     struct sab_component  *stackend; /* end of stack pointer */
     struct sab_component  *top;      /* current top of stack */
     struct sab_component
@@ -110,6 +128,9 @@ struct sab
         int volatile      idx;       /* cache index of directory */
         int               *downp;    /* pointer to ce->down */
         int *volatile     prevp;     /* previous item accessed */
+    #ifdef HAVE_EXFAT
+        struct fat_file   fatfile;   /* the directory (for opening subdirs) */
+    #endif
     } stack[];                       /* "recursion" stack */
 };
 
@@ -212,7 +233,7 @@ static struct dircache
     size_t       sizeused;            /* bytes of .size bytes actually used */
     union {
     unsigned int numentries;          /* entry count (including holes) */
-#ifdef HAVE_EEPROM_SETTINGS
+#ifdef DIRCACHE_SNAPSHOT
     size_t       sizeentries;         /* used when persisting */
 #endif
     };
@@ -256,12 +277,25 @@ static struct dircache_runinfo
     unsigned char         *pname;  /* alias of .p to assist name resolution */
     };
     struct buflib_callbacks ops;   /* buflib ops callbacks */
+#ifdef DIRCACHE_HASH
+    /* name index info */
+    int          hashhandle;       /* buflib index handle */
+    int          *phash;           /* address of index slots */
+    unsigned int hashmask;         /* number of slots - 1 */
+    unsigned int hashcount;        /* number of entries indexed */
+    unsigned int hashodd;          /* indexed short names with 8-bit chars */
+    bool         hashvalid;        /* index agrees with the cache */
+    struct buflib_callbacks hashops; /* buflib ops callbacks for index */
+#endif /* DIRCACHE_HASH */
     /* per-volume data */
     struct dircache_runinfo_volume
     {
         struct file_base_binding *resolved0; /* first resolved binding in list */
         struct file_base_binding *queued0;   /* first queued binding in list */
         struct sab               *sabp;      /* if building, struct sab in use */
+#ifdef DIRCACHE_VERIFY
+        bool                     verify;     /* loaded snapshot not verified */
+#endif
     } dcrivol[NUM_VOLUMES];
 } dircache_runinfo;
 
@@ -288,6 +322,7 @@ static struct dircache_runinfo
 
 #define DCRIVOL_i(i)             (&dircache_runinfo.dcrivol[i])
 #define DCRIVOL_infop(infop)     (&dircache_runinfo.dcrivol[BASEINFO_VOL(infop)])
+#define DCRIVOL_dirinfop(dirinfop) (&dircache_runinfo.dcrivol[BASEINFO_VOL(dirinfop)])
 #define DCRIVOL_bindp(bindp)     (&dircache_runinfo.dcrivol[BASEBINDING_VOL(bindp)])
 #define DCRIVOL(x)               DCRIVOL_##x(x)
 
@@ -295,7 +330,7 @@ static struct dircache_runinfo
 #define DIRCACHE_STUFFED(reserve_used) \
     ((reserve_used) > 3*DIRCACHE_RESERVE / 4)
 
-#ifdef HAVE_EEPROM_SETTINGS
+#ifdef DIRCACHE_SNAPSHOT
 /**
  * remove the snapshot file
  */
@@ -311,7 +346,7 @@ static int open_dircache_file(int oflag)
 {
     return open(DIRCACHE_FILE, oflag, 0666);
 }
-#endif /* HAVE_EEPROM_SETTINGS */
+#endif /* DIRCACHE_SNAPSHOT */
 
 #ifdef DIRCACHE_DUMPSTER
 /**
@@ -758,6 +793,24 @@ static void entry_name_copy(char *dst, const struct dircache_entry *ce)
     *dst = '\0';
 }
 
+#ifdef DIRCACHE_VERIFY
+/**
+ * compare the entry's name to a string without copying it
+ */
+static bool entry_name_equal(const struct dircache_entry *ce, const char *name)
+{
+    if (LIKELY(!ce->tinyname))
+    {
+        size_t size = CE_NAMESIZE(ce->namelen);
+        return !strncmp(name, (const char *)get_name(ce->name), size) &&
+               name[size] == '\0';
+    }
+
+    return !strncmp(name, (const char *)ce->namebuf, MAX_TINYNAME) &&
+           strlen(name) <= MAX_TINYNAME;
+}
+#endif /* DIRCACHE_VERIFY */
+
 /**
  * set the namesfree hint to a new position
  */
@@ -959,6 +1012,214 @@ static int entry_reassign_name(struct dircache_entry *ce,
     return entry_assign_name(ce, newname, newlen);
 }
 
+#ifdef DIRCACHE_HASH
+/**
+ * hash a name within its parent directory, ignoring case as strcasecmp() does
+ */
+static unsigned int hash_name(int up, const unsigned char *name, size_t len)
+{
+    uint32_t h = 2166136261u ^ (uint32_t)up; /* FNV-1a */
+
+    while (len--)
+    {
+        unsigned int c = *name++;
+        if (c - 'A' < 26)
+            c += 'a' - 'A';
+
+        h = (h ^ c) * 16777619u;
+    }
+
+    return h ^ (h >> 16);
+}
+
+/**
+ * return the entry's name and its length
+ */
+static const unsigned char * entry_name_len(const struct dircache_entry *ce,
+                                            size_t *lenp)
+{
+    if (LIKELY(!ce->tinyname))
+    {
+        *lenp = CE_NAMESIZE(ce->namelen);
+        return get_name(ce->name);
+    }
+
+    size_t len = 0;
+    while (len < MAX_TINYNAME && ce->namebuf[len])
+        len++;
+
+    *lenp = len;
+    return ce->namebuf;
+}
+
+/**
+ * hash the entry's name within its parent directory
+ */
+static unsigned int entry_hash(const struct dircache_entry *ce)
+{
+    size_t len;
+    const unsigned char *name = entry_name_len(ce, &len);
+    return hash_name(ce->up, name, len);
+}
+
+/**
+ * does the entry have a short name that gets decoded when read?
+ */
+static bool entry_name_odd(const struct dircache_entry *ce)
+{
+    if (ce->direntries != 1)
+        return false;
+
+    size_t len;
+    const unsigned char *name = entry_name_len(ce, &len);
+
+    while (len--)
+    {
+        if (*name++ >= 0x80)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * add the linked entry to the name index
+ */
+static void hash_insert_entry(int idx)
+{
+    struct dircache_runinfo *dcrip = &dircache_runinfo;
+    if (!dcrip->hashvalid)
+        return;
+
+    if (dcrip->hashcount >= dcrip->hashmask - dcrip->hashmask / 4)
+    {
+        /* too full; it will be rebuilt larger after the next build */
+        dcrip->hashvalid = false;
+        return;
+    }
+
+    struct dircache_entry *ce = get_entry(idx);
+    unsigned int i = entry_hash(ce) & dcrip->hashmask;
+
+    while (dcrip->phash[i])
+        i = (i + 1) & dcrip->hashmask;
+
+    dcrip->phash[i] = idx;
+    dcrip->hashcount++;
+
+    if (entry_name_odd(ce))
+        dcrip->hashodd++;
+}
+
+/**
+ * remove the entry from the name index before it is unlinked or renamed
+ */
+static void hash_remove_entry(int idx)
+{
+    struct dircache_runinfo *dcrip = &dircache_runinfo;
+    if (!dcrip->hashvalid)
+        return;
+
+    struct dircache_entry *ce = get_entry(idx);
+    unsigned int mask = dcrip->hashmask;
+    int *slots = dcrip->phash;
+    unsigned int i = entry_hash(ce) & mask;
+
+    while (slots[i] != idx)
+    {
+        if (!slots[i])
+            return; /* wasn't indexed */
+
+        i = (i + 1) & mask;
+    }
+
+    dcrip->hashcount--;
+
+    if (entry_name_odd(ce))
+        dcrip->hashodd--;
+
+    /* close the gap by shifting back any subsequent slot of the same run
+       that would not be found any more (no tombstones needed) */
+    unsigned int j = i;
+
+    while (1)
+    {
+        slots[i] = 0;
+
+        while (1)
+        {
+            j = (j + 1) & mask;
+
+            if (!slots[j])
+                return;
+
+            unsigned int k = entry_hash(get_entry(slots[j])) & mask;
+
+            /* does its home lie cyclically outside of (i, j]? */
+            if (i <= j ? (k <= i || k > j) : (k <= i && k > j))
+                break;
+        }
+
+        slots[i] = slots[j];
+        i = j;
+    }
+}
+
+/**
+ * find an entry by name in the directory 'up' with the index
+ */
+static int hash_find(int up, const char *name)
+{
+    struct dircache_runinfo *dcrip = &dircache_runinfo;
+    size_t namelen = strlen(name);
+    unsigned int i = hash_name(up, (const unsigned char *)name, namelen) &
+                     dcrip->hashmask;
+
+    while (1)
+    {
+        int idx = dcrip->phash[i];
+        if (!idx)
+            return 0;
+
+        struct dircache_entry *ce = get_entry(idx);
+
+        size_t len;
+        const unsigned char *cename = entry_name_len(ce, &len);
+
+        if (ce->up == up && len == namelen &&
+            !strncasecmp(name, (const char *)cename, len))
+            return idx;
+
+        i = (i + 1) & dcrip->hashmask;
+    }
+}
+
+/**
+ * empty the index so that it matches an empty cache
+ */
+static void hash_reset(void)
+{
+    struct dircache_runinfo *dcrip = &dircache_runinfo;
+    if (!dcrip->hashhandle)
+        return;
+
+    memset(dcrip->phash, 0, (dcrip->hashmask + 1) * sizeof (int));
+    dcrip->hashcount = 0;
+    dcrip->hashodd   = 0;
+    dcrip->hashvalid = true;
+}
+
+/**
+ * relocate the index when the buffer has moved
+ */
+static int hash_move_callback(int handle, void *current, void *new)
+{
+    dircache_runinfo.phash = new;
+    return BUFLIB_CB_OK;
+    (void)handle; (void)current;
+}
+#endif /* DIRCACHE_HASH */
+
 /**
  * allocate a dircache_entry from memory using freed ones if available
  */
@@ -1069,6 +1330,10 @@ static int create_entry(const char *basename,
 static void remove_entry(struct dircache_runinfo_volume *dcrivolp,
                          struct dircache_entry *ce, int *prevp)
 {
+#ifdef DIRCACHE_HASH
+    hash_remove_entry(*prevp);
+#endif
+
     /* unlink it from its list */
     *prevp = ce->next;
 
@@ -1247,6 +1512,59 @@ static void process_events(void)
 }
 
 #if defined (DIRCACHE_NATIVE)
+#ifdef DIRCACHE_VERIFY
+/**
+ * read the opened directory and compare it with its cached contents, resolving
+ * bindings along the way; returns true if both agree in every detail
+ */
+static bool sab_verify_sub(struct sab *sabp, struct sab_component *compp,
+                           long dircluster)
+{
+    struct fat_direntry *const fatentp = get_dir_fatent();
+    struct filestr_base *const streamp = &sabp->stream;
+    struct file_base_info *const infop = &sabp->info;
+
+    int idx = *compp->downp;
+
+    while (1)
+    {
+        int rc = uncached_readdir_internal(streamp, infop, fatentp);
+        if (rc <= 0)
+        {
+            if (rc < 0)
+                sabp->quit = true;
+
+            return rc == 0 && !idx; /* false if anything was removed */
+        }
+
+        if (!idx)
+            return false; /* something was added */
+
+        struct dircache_entry *ce = get_entry(idx);
+
+        if (ce->direntry     != infop->fatfile.e.entry   ||
+            ce->direntries   != infop->fatfile.e.entries ||
+            ce->attr         != fatentp->attr            ||
+            ce->firstcluster != fatentp->firstcluster    ||
+            ce->wrtdate      != fatentp->wrtdate         ||
+            ce->wrttime      != fatentp->wrttime         ||
+            (!(ce->attr & ATTR_DIRECTORY) &&
+                ce->filesize != fatentp->filesize)       ||
+            !entry_name_equal(ce, fatentp->name))
+            return false;
+
+        /* resolve queued user bindings */
+        infop->fatfile.firstcluster = fatentp->firstcluster;
+        infop->fatfile.dircluster   = dircluster;
+        infop->dcfile.idx           = idx;
+        infop->dcfile.serialnum     = ce->serialnum;
+        binding_resolve(infop);
+
+        idx = ce->next;
+    }
+}
+#endif /* DIRCACHE_VERIFY */
+
 /**
  * scan and build the contents of a subdirectory
  */
@@ -1275,9 +1593,29 @@ static void sab_process_sub(struct sab *sabp)
         uncached_rewinddir_internal(infop);
 
         const long dircluster = streamp->infop->fatfile.firstcluster;
+        bool verified = false;
+    #ifdef HAVE_EXFAT
+        compp->fatfile = streamp->infop->fatfile;
+    #endif
+
+    #ifdef DIRCACHE_VERIFY
+        if (sabp->verify && *downp)
+        {
+            /* keep what the snapshot has if it's still accurate, else drop
+               it and read the directory from scratch; the lock is held
+               throughout so that nothing can change in between */
+            verified = sab_verify_sub(sabp, compp, dircluster);
+            if (!verified && !sabp->quit)
+            {
+                free_subentries(DCRIVOL(infop), downp);
+                fat_rewind(&streamp->fatstr);
+                uncached_rewinddir_internal(infop);
+            }
+        }
+    #endif /* DIRCACHE_VERIFY */
 
         /* first pass: read directory */
-        while (1)
+        while (!verified)
         {
             if (sabp->stack + 1 < sabp->stackend)
             {
@@ -1353,6 +1691,10 @@ static void sab_process_sub(struct sab *sabp)
             ce->wrtdate      = fatentp->wrtdate;
             ce->wrttime      = fatentp->wrttime;
 
+        #ifdef DIRCACHE_HASH
+            hash_insert_entry(idx);
+        #endif
+
             /* resolve queued user bindings */
             infop->fatfile.firstcluster = fatentp->firstcluster;
             infop->fatfile.dircluster   = dircluster;
@@ -1381,6 +1723,13 @@ static void sab_process_sub(struct sab *sabp)
 
                 if (ce->frontier != FRONTIER_SETTLED)
                     break;
+
+            #ifdef DIRCACHE_VERIFY
+                /* every subdirectory of a snapshot must be looked at */
+                if (sabp->verify && (ce->attr & ATTR_DIRECTORY) &&
+                    !(ce->tinyname && is_dotdir_name((char *)ce->namebuf)))
+                    break;
+            #endif
             }
             else
             {
@@ -1398,10 +1747,19 @@ static void sab_process_sub(struct sab *sabp)
 
         /* set up info for next open
          * IF_MV: "volume" was set when scan began */
-        infop->fatfile.firstcluster = ce->firstcluster;
-        infop->fatfile.dircluster   = dircluster;
         infop->fatfile.e.entry      = ce->direntry;
         infop->fatfile.e.entries    = ce->direntries;
+    #ifdef HAVE_EXFAT
+        /* an exFAT directory's entry says if its clusters are chained */
+        if (fat_open(&compp->fatfile, ce->firstcluster, &infop->fatfile) < 0)
+        {
+            sabp->quit = true;
+            return;
+        }
+    #else
+        infop->fatfile.firstcluster = ce->firstcluster;
+        infop->fatfile.dircluster   = dircluster;
+    #endif
         infop->dcfile.idx           = idx;
         infop->dcfile.serialnum     = ce->serialnum;
     } /* end while */
@@ -1425,6 +1783,9 @@ static void sab_process_dir(struct file_base_info *infop, bool issab)
     struct sab *sabp = &dirsab.sab;
 
     sabp->quit     = false;
+#ifdef DIRCACHE_VERIFY
+    sabp->verify   = issab && DCRIVOL(infop)->verify;
+#endif
     sabp->stackend = &sabp->stack[ARRAYLEN(dirsab.stack)];
     sabp->top      = sabp->stackend;
     sabp->info     = *infop;
@@ -1468,6 +1829,81 @@ static void sab_process_volume(struct dircache_volume *dcvolp)
     sab_process_dir(&info, true);
 }
 
+#ifdef DIRCACHE_VERIFY
+/**
+ * check that the root directory of a volume loaded from a snapshot still
+ * agrees with the storage
+ */
+static bool sab_verify_root(struct dircache_volume *dcvolp)
+{
+    int volume = IF_MV_VOL(dcvolp - dircache.dcvol);
+
+    struct dirsab
+    {
+        struct sab           sab;
+        struct sab_component stack[1];
+    } dirsab;
+    struct sab *sabp = &dirsab.sab;
+    struct filestr_base *const streamp = &sabp->stream;
+    struct file_base_info *const infop = &sabp->info;
+
+    if (fat_open_rootdir(IF_MV(volume,) &infop->fatfile) < 0)
+        return false;
+
+    infop->dcfile.idx       = -volume - 1;
+    infop->dcfile.serialnum = dcvolp->serialnum;
+
+    sabp->quit     = false;
+    sabp->verify   = true;
+    sabp->stackend = &sabp->stack[ARRAYLEN(dirsab.stack)];
+    sabp->top      = sabp->stackend;
+
+    struct sab_component *compp = --sabp->top;
+    compp->idx   = infop->dcfile.idx;
+    compp->downp = &dcvolp->root_down;
+    compp->prevp = compp->downp;
+
+    filestr_base_init(streamp);
+    fileobj_fileop_open(streamp, infop, FO_DIRECTORY);
+    fat_rewind(&streamp->fatstr);
+    uncached_rewinddir_internal(infop);
+
+    bool verified = sab_verify_sub(sabp, compp,
+                                   streamp->infop->fatfile.firstcluster);
+
+    close_stream_internal(streamp);
+    return verified;
+}
+#endif /* DIRCACHE_VERIFY */
+
+/**
+ * fill in the internal scan information for an entry
+ */
+static int read_entry_internal(int idx, struct file_base_info *infop,
+                               struct fat_direntry *fatent)
+{
+    struct dircache_entry *ce = get_entry(idx);
+
+    /* FS entry information that we maintain */
+    entry_name_copy(fatent->name, ce);
+    fatent->shortname[0]     = '\0';
+    fatent->attr             = ce->attr;
+    /* file code file scanning does not need time information */
+    fatent->filesize         = (ce->attr & ATTR_DIRECTORY) ? 0 : ce->filesize;
+    fatent->firstcluster     = ce->firstcluster;
+
+    /* FS entry directory information */
+    infop->fatfile.e.entry   = ce->direntry;
+    infop->fatfile.e.entries = ce->direntries;
+
+    /* dircache file binding information */
+    infop->dcfile.idx        = idx;
+    infop->dcfile.serialnum  = ce->serialnum;
+
+    /* return whether this needs decoding */
+    return ce->direntries == 1 ? 2 : 1;
+}
+
 /**
  * this function is the back end to the public API's like readdir()
  */
@@ -1609,6 +2045,13 @@ int dircache_readdir_internal(struct filestr_base *stream,
 
     struct dircache_entry *ce = get_entry(idx);
 
+#ifdef DIRCACHE_VERIFY
+    /* the contents of a directory loaded from a snapshot may not agree with
+       the storage until the background pass has looked at it */
+    bool unverified = frontier != FRONTIER_SETTLED &&
+                      DCRIVOL(dirinfop)->verify;
+#endif
+
     if (frontier != FRONTIER_SETTLED && !(stream->flags & FF_CACHEONLY))
     {
         /* the directory being read is reported to be incompletely cached;
@@ -1619,6 +2062,11 @@ int dircache_readdir_internal(struct filestr_base *stream,
         if (rc <= 0 || !ce || ce->direntry > infop->fatfile.e.entry)
             return rc;
 
+    #ifdef DIRCACHE_VERIFY
+        if (unverified)
+            return rc; /* only what was just read can be trusted */
+    #endif
+
         /* entry matches next one to read */
     }
     else if (!ce)
@@ -1626,25 +2074,15 @@ int dircache_readdir_internal(struct filestr_base *stream,
         /* end of dir */
         goto read_eod;
     }
+#ifdef DIRCACHE_VERIFY
+    else if (unverified)
+    {
+        /* cache only: nothing here is known for sure */
+        goto read_eod;
+    }
+#endif
 
-    /* FS entry information that we maintain */
-    entry_name_copy(fatent->name, ce);
-    fatent->shortname[0]     = '\0';
-    fatent->attr             = ce->attr;
-    /* file code file scanning does not need time information */
-    fatent->filesize         = (ce->attr & ATTR_DIRECTORY) ? 0 : ce->filesize;
-    fatent->firstcluster     = ce->firstcluster;
-
-    /* FS entry directory information */
-    infop->fatfile.e.entry   = ce->direntry;
-    infop->fatfile.e.entries = ce->direntries;
-
-    /* dircache file binding information */
-    infop->dcfile.idx        = idx;
-    infop->dcfile.serialnum  = ce->serialnum;
-
-    /* return whether this needs decoding */
-    int rc = ce->direntries == 1 ? 2 : 1;
+    int rc = read_entry_internal(idx, infop, fatent);
 
     if (frontier == FRONTIER_SETTLED)
     {
@@ -1673,6 +2111,53 @@ void dircache_rewinddir_internal(struct file_base_info *infop)
     dircache_dcfile_init(&infop->dcfile);
 }
 
+#ifdef DIRCACHE_HASH
+/**
+ * find the named entry in a directory using the name index, filling in the
+ * same information that dircache_readdir_internal() would for it
+ *
+ * returns: > 0 if found (as dircache_readdir_internal())
+ *          0 if it certainly isn't there
+ *          < 0 if the directory has to be scanned to tell
+ */
+int dircache_lookup_internal(struct filestr_base *stream,
+                             struct file_base_info *infop,
+                             const char *name,
+                             struct fat_direntry *fatent)
+{
+    /* call with writer exclusion */
+    struct file_base_info *dirinfop = stream->infop;
+
+    if (!dircache_runinfo.hashvalid || !dirinfop->dcfile.serialnum)
+        return -1;
+
+    int diridx = dirinfop->dcfile.idx;
+    if (get_frontier(diridx) != FRONTIER_SETTLED)
+        return -1;
+
+    if (dircache_runinfo.hashodd)
+    {
+        /* an 8-bit short name may only compare after being decoded but it
+           can never decode to a 7-bit name */
+        for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+        {
+            if (*p >= 0x80)
+                return -1;
+        }
+    }
+
+    int idx = hash_find(diridx, name);
+    if (!idx)
+    {
+        fat_empty_fat_direntry(fatent);
+        infop->fatfile.e.entries = 0;
+        return 0;
+    }
+
+    return read_entry_internal(idx, infop, fatent);
+}
+#endif /* DIRCACHE_HASH */
+
 #else /* !DIRCACHE_NATIVE (for all others) */
 
 #####################
@@ -1818,6 +2303,9 @@ static void reset_volume(IF_MV_NONVOID(int volume))
         dcvolp->root_down   = 0;
         dcvolp->build_ticks = 0;
         dcvolp->serialnum   = 0;
+    #ifdef DIRCACHE_VERIFY
+        dcrivolp->verify    = false;
+    #endif
     }
 }
 
@@ -1847,6 +2335,9 @@ static void reset_cache(void)
     dircache.namesfree    = 0;
     dircache.nextnamefree = 0;
     *get_name(dircache.names - 1) = 0;
+#ifdef DIRCACHE_HASH
+    hash_reset();
+#endif
     /* dircache.last_serialnum stays */
     /* dircache.reserve_used stays */
     /* dircache.last_size stays */
@@ -1867,6 +2358,21 @@ static void build_volumes(void)
 
         struct dircache_volume *dcvolp = DCVOL(i);
 
+    #ifdef DIRCACHE_VERIFY
+        struct dircache_runinfo_volume *dcrivolp = DCRIVOL(i);
+        if (dcrivolp->verify)
+        {
+            /* the loaded snapshot stays in service while being verified */
+            sab_process_volume(dcvolp);
+
+            if (dircache_runinfo.suspended)
+                break;
+
+            dcrivolp->verify = false;
+            continue;
+        }
+    #endif /* DIRCACHE_VERIFY */
+
         /* can't already be "scanning" because that's us; doesn't retry
            "ready" volumes */
         if (dcvolp->status == DIRCACHE_READY)
@@ -2032,6 +2538,61 @@ static void compact_cache(void)
     dircache.reserve_used = 0;
 }
 
+#ifdef DIRCACHE_HASH
+/**
+ * (re)build the name index if it doesn't agree with the cache
+ */
+static void build_hash(void)
+{
+    /* called holding dircache lock */
+    struct dircache_runinfo *dcrip = &dircache_runinfo;
+
+    if (dcrip->suspended || dcrip->hashvalid || !dcrip->handle)
+        return;
+
+    /* size it for what may be added later and keep it at most 3/4 full */
+    unsigned int count = dircache.numentries + DIRCACHE_RESERVE / ENTRYSIZE;
+    unsigned int nslots = 256;
+    while (nslots - nslots / 4 <= count)
+        nslots *= 2;
+
+    int handle = dcrip->hashhandle;
+    dcrip->hashhandle = 0;
+
+    dircache_unlock();
+
+    if (handle > 0)
+        core_free(handle);
+
+    handle = core_alloc_ex("dircache index", nslots * sizeof (int),
+                           &dcrip->hashops);
+
+    dircache_lock();
+
+    if (dcrip->suspended && handle > 0)
+    {
+        /* if we got suspended, the cache is empty or going away */
+        dircache_unlock();
+        core_free(handle);
+        handle = 0;
+        dircache_lock();
+    }
+
+    if (handle <= 0)
+        return;
+
+    dcrip->hashhandle = handle;
+    dcrip->phash      = core_get_data(handle);
+    dcrip->hashmask   = nslots - 1;
+    hash_reset();
+
+    FOR_EACH_CACHE_ENTRY(ce)
+        hash_insert_entry(get_index(ce));
+
+    logf("dircache: indexed %u entries", dcrip->hashcount);
+}
+#endif /* DIRCACHE_HASH */
+
 /**
  * internal thread that controls cache building; exits when no more requests
  * are pending or the cache is suspended
@@ -2077,6 +2638,10 @@ static void dircache_thread(void)
         /* if it was reallocated, compact it */
         if (realloced)
             compact_cache();
+
+    #ifdef DIRCACHE_HASH
+        build_hash();
+    #endif
      }
 
      dircache_unlock();
@@ -2159,14 +2724,29 @@ static void dircache_suspend_internal(bool freeit)
 
     /* grab the buffer away into our control; the cache won't need it now */
     int handle = 0;
+#ifdef DIRCACHE_HASH
+    int hashhandle = 0;
+#endif
     if (freeit)
+    {
         handle = reset_buffer();
+    #ifdef DIRCACHE_HASH
+        hashhandle = dircache_runinfo.hashhandle;
+        dircache_runinfo.hashhandle = 0;
+        dircache_runinfo.hashvalid  = false;
+    #endif
+    }
 
     dircache_unlock();
 
     if (handle > 0)
         core_free(handle);
 
+#ifdef DIRCACHE_HASH
+    if (hashhandle > 0)
+        core_free(hashhandle);
+#endif
+
     thread_wait(thread_id);
 
     dircache_lock();
@@ -2378,6 +2958,10 @@ void dircache_fileop_create(struct file_base_info *dirinfop,
 
     insert_file_entry(dirinfop, ce);
 
+#ifdef DIRCACHE_HASH
+    hash_insert_entry(idx);
+#endif
+
     /* file binding will have been queued when it was opened; just resolve */
     infop->dcfile.idx       = idx;
     infop->dcfile.serialnum = ce->serialnum;
@@ -2459,6 +3043,10 @@ void dircache_fileop_rename(struct file_base_info *dirinfop,
         dc_serial_t serialnum = next_serialnum();
         ce->serialnum = serialnum;
         bindp->info.dcfile.serialnum = serialnum;
+
+    #ifdef DIRCACHE_HASH
+        hash_insert_entry(get_index(ce));
+    #endif
     }
     else
     {
@@ -3013,9 +3601,9 @@ void dircache_dcfile_init(struct dircache_file *dcfilep)
     dcfilep->serialnum = 0;
 }
 
-#ifdef HAVE_EEPROM_SETTINGS
+#ifdef DIRCACHE_SNAPSHOT
 
-#ifdef HAVE_HOTSWAP
+#if defined(HAVE_HOTSWAP) && !defined(DIRCACHE_VERIFY)
 /* NOTE: This is hazardous to the filesystem of any sort of removable
          storage unless it may be determined that the filesystem from save
          to load is identical. If it's not possible to do so in a timely
@@ -3024,17 +3612,71 @@ void dircache_dcfile_init(struct dircache_file *dcfilep)
 #endif
 
 /* dircache persistence file header magic */
-#define DIRCACHE_MAGIC  0x00d0c0a1
+#define DIRCACHE_MAGIC    0x00d0c0a1
+/* dircache persistence file format version */
+#define DIRCACHE_VERSION  1
+
+/* what a volume looked like when it was saved */
+struct dircache_volinfo
+{
+    uint32_t        volumeid;   /* filesystem serial number */
+    uint32_t        size;       /* size in KiB */
+    uint32_t        free;       /* free space in KiB */
+};
 
 /* dircache persistence file header */
 struct dircache_maindata
 {
     uint32_t        magic;      /* DIRCACHE_MAGIC */
+    uint32_t        version;    /* DIRCACHE_VERSION */
+    uint32_t        entrysize;  /* ENTRYSIZE */
+    struct dircache_volinfo volinfo[NUM_VOLUMES]; /* per-volume identity */
     struct dircache dircache;   /* metadata of the cache! */
     uint32_t        datacrc;    /* CRC32 of data */
     uint32_t        hdrcrc;     /* CRC32 of header through datacrc */
 } __attribute__((packed, aligned (4)));
 
+/**
+ * obtain the identity of a volume; returns false if it isn't mounted
+ */
+static bool get_volinfo(IF_MV(int volume,) struct dircache_volinfo *volinfop)
+{
+    unsigned long size = 0, free = 0;
+    bool mounted = fat_size(IF_MV(volume,) &size, &free);
+
+    volinfop->volumeid = fat_get_volume_id(IF_MV(volume));
+    volinfop->size     = size;
+    volinfop->free     = free;
+
+    return mounted;
+}
+
+/**
+ * check a volume loaded from a snapshot against the storage
+ */
+static bool volume_is_unchanged(int i, const struct dircache_volinfo *volinfop)
+{
+    struct dircache_volume *dcvolp = DCVOL(i);
+    struct dircache_volinfo volinfo;
+
+    if (dcvolp->status != DIRCACHE_READY ||
+        !get_volinfo(IF_MV(i,) &volinfo) ||
+        volinfo.volumeid != volinfop->volumeid ||
+        volinfo.size     != volinfop->size ||
+        volinfo.free     != volinfop->free)
+        return false;
+
+#ifdef DIRCACHE_VERIFY
+    if (!sab_verify_root(dcvolp))
+        return false;
+
+    /* the rest is looked at in the background */
+    DCRIVOL(i)->verify = true;
+#endif /* DIRCACHE_VERIFY */
+
+    return true;
+}
+
 /**
  * verify that the clean status is A-ok
  */
@@ -3082,6 +3724,13 @@ int dircache_load(void)
         goto error_nolock;
     }
 
+    if (maindata.version != DIRCACHE_VERSION ||
+        maindata.entrysize != ENTRYSIZE)
+    {
+        logf("dircache: incompatible version");
+        goto error_nolock;
+    }
+
     crc = crc_32(&maindata, offsetof(struct dircache_maindata, hdrcrc),
                  0xffffffff);
     if (crc != maindata.hdrcrc)
@@ -3116,6 +3765,9 @@ int dircache_load(void)
 
     /* from this point on, we're actually dealing with the cache in RAM */
     dircache = maindata.dircache;
+#ifdef DIRCACHE_HASH
+    dircache_runinfo.hashvalid = false; /* indexed after the next build */
+#endif
 
     set_buffer(handle, bufsize);
     hasbuffer = true;
@@ -3168,15 +3820,59 @@ int dircache_load(void)
 
     dircache.reserve_used = 0;
 
+    /* drop whatever is no longer on the storage as it was saved */
+    FOR_EACH_VOLUME(-1, i)
+    {
+        if (DCVOL(i)->status == DIRCACHE_IDLE ||
+            volume_is_unchanged(i, &maindata.volinfo[i]))
+            continue;
+
+        logf("dircache: volume %d changed", i);
+
+    #ifdef HAVE_MULTIVOLUME
+        if (i > 0)
+        {
+            /* build this one from scratch */
+            reset_volume(i);
+            continue;
+        }
+    #endif /* HAVE_MULTIVOLUME */
+
+        /* the snapshot itself lives on the first volume */
+        goto error;
+    }
+
+#ifdef DIRCACHE_VERIFY
+    /* only the roots have been compared with the storage so far; have every
+       lookup below them read through until the background pass gets to
+       each directory and settles it */
+    FOR_EACH_CACHE_ENTRY(ce)
+    {
+        if ((ce->attr & ATTR_DIRECTORY) &&
+            !(ce->tinyname && is_dotdir_name((char *)ce->namebuf)))
+            ce->frontier = FRONTIER_NEW;
+    }
+
+    /* keep the buffer from being reallocated by the verification pass */
+    dircache.last_size = MIN(dircache.last_size, dircache.size);
+
+    /* enable the cache and verify the remainder in the background */
+    dircache_enable_internal(false);
+    dircache_thread_post(NULL);
+#else
     /* enable the cache but do not try to build it */
     dircache_enable_internal(false);
+#endif /* DIRCACHE_VERIFY */
 
     /* cache successfully loaded */
     logf("Done, %ld KiB used", dircache.size / 1024);
     rc = 0;
 error:
     if (rc < 0 && hasbuffer)
+    {
+        reset_cache();
         reset_buffer();
+    }
 
     buffer_unlock();
     dircache_unlock();
@@ -3217,8 +3913,10 @@ int dircache_save(void)
     uint32_t crc;
     struct dircache_maindata maindata =
     {
-        .magic    = DIRCACHE_MAGIC,
-        .dircache = dircache,
+        .magic     = DIRCACHE_MAGIC,
+        .version   = DIRCACHE_VERSION,
+        .entrysize = ENTRYSIZE,
+        .dircache  = dircache,
     };
 
     /* store the size since it better detects an invalid header */
@@ -3260,6 +3958,14 @@ int dircache_save(void)
         goto error;
     }
 
+    /* the snapshot data has been allocated by now; record how the volumes
+       are left by it */
+    FOR_EACH_VOLUME(-1, i)
+    {
+        if (maindata.dircache.dcvol[i].status != DIRCACHE_IDLE)
+            get_volinfo(IF_MV(i,) &maindata.volinfo[i]);
+    }
+
     crc = crc_32(&maindata, offsetof(struct dircache_maindata, hdrcrc),
                  0xffffffff);
     maindata.hdrcrc = crc;
@@ -3283,7 +3989,7 @@ error:
     close(fd);
     return rc;
 }
-#endif /* HAVE_EEPROM_SETTINGS */
+#endif /* DIRCACHE_SNAPSHOT */
 
 /**
  * main one-time initialization function that must be called before any other
@@ -3299,4 +4005,7 @@ void dircache_init(size_t last_size)
     dcrip->suspended         = 1;
     dcrip->thread_done       = true;
     dcrip->ops.move_callback = move_callback;
+#ifdef DIRCACHE_HASH
+    dcrip->hashops.move_callback = hash_move_callback;
+#endif
 }
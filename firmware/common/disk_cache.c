@@ -25,6 +25,9 @@
 #include "disk_cache.h"
 #include "fs_defines.h"
 #include "bitarray.h"
+#if DC_EXT_ENTRIES
+#include "core_alloc.h"
+#endif
 
 /* Cache: LRU cache with separately-chained hashtable
  *
@@ -55,6 +58,12 @@
  *             001001 <- collision
  *             000000
  * volume map  111101 <- entry usage by the volume (OR of all map entries)
+ *
+ * Entries beyond DC_NUM_ENTRIES have their buffers in a single allocation
+ * from the core allocator, made at startup. They are never handed out by
+ * dc_get_buffer() so that the allocation may be moved or shrunk whenever
+ * the cache isn't locked. Since they are adjacent, runs of them can also be
+ * filled by one read when sectors are being read in sequence.
  */
 
 enum dce_flags /* flags for each cache entry */
@@ -72,9 +81,12 @@ struct disk_cache_entry
     unsigned char volume;   /* volume of sector */
 #endif
     unsigned long sector;   /* cached disk sector number */
+#if DC_EXT_ENTRIES
+    unsigned long stamp;    /* cache_clock when last used */
+#endif
 };
 
-BITARRAY_TYPE_DECLARE(cache_map_entry_t, cache_map, DC_NUM_ENTRIES)
+BITARRAY_TYPE_DECLARE(cache_map_entry_t, cache_map, DC_MAX_ENTRIES)
 
 static inline unsigned int map_sector(unsigned long sector)
 {
@@ -83,12 +95,22 @@ static inline unsigned int map_sector(unsigned long sector)
 }
 
 static struct lldc_head cache_lru; /* LRU cache list (head = LRU item) */
-static struct disk_cache_entry cache_entry[DC_NUM_ENTRIES];
+static struct disk_cache_entry cache_entry[DC_MAX_ENTRIES];
 static cache_map_entry_t cache_map_entry[NUM_VOLUMES][DC_MAP_NUM_ENTRIES];
 static cache_map_entry_t cache_vol_map[NUM_VOLUMES] IBSS_ATTR;
 static uint8_t cache_buffer[DC_NUM_ENTRIES][DC_CACHE_BUFSIZE] CACHEALIGN_ATTR;
+static struct dc_stats cache_stats;
 struct mutex disk_cache_mutex SHAREDBSS_ATTR;
 
+#if DC_EXT_ENTRIES
+static int cache_ext_handle;         /* buflib handle of runtime buffers */
+static uint8_t *cache_ext_buf;       /* current address of runtime buffers */
+static unsigned int cache_ext_count; /* number of runtime entries */
+static unsigned int cache_ext_next;  /* where to look for a read-ahead run */
+static unsigned int cache_bufs_out;  /* number taken by dc_get_buffer() */
+static unsigned long cache_clock;    /* incremented with each use */
+#endif /* DC_EXT_ENTRIES */
+
 #define CACHE_MAP_ENTRY(volume, mapnum) \
     cache_map_entry[IF_MV_VOL(volume)][mapnum]
 #define CACHE_VOL_MAP(volume) \
@@ -98,13 +120,44 @@ struct mutex disk_cache_mutex SHAREDBSS_ATTR;
 #define DCE_NEXT(fce)  ((struct disk_cache_entry *)(fce)->node.next)
 #define NODE_DCE(node) ((struct disk_cache_entry *)(node))
 
-/* get the cache index from a pointer to a buffer */
-#define DCIDX_FROM_BUF(buf) \
-    ((uint8_t (*)[DC_CACHE_BUFSIZE])(buf) - cache_buffer)
-
 #define DCIDX_FROM_DCE(dce) \
     ((dce) - cache_entry)
 
+/* get the buffer of a cache index */
+static inline void * cache_idx_buf(unsigned int index)
+{
+#if DC_EXT_ENTRIES
+    if (index >= DC_NUM_ENTRIES)
+        return cache_ext_buf + (index - DC_NUM_ENTRIES)*DC_CACHE_BUFSIZE;
+#endif
+    return cache_buffer[index];
+}
+
+/* get the cache index from a pointer to a buffer; returns DC_MAX_ENTRIES if
+   it isn't one of ours */
+static inline unsigned int cache_buf_idx(void *buf)
+{
+    unsigned long index = (uint8_t (*)[DC_CACHE_BUFSIZE])buf - cache_buffer;
+
+#if DC_EXT_ENTRIES
+    if (index >= DC_NUM_ENTRIES)
+    {
+        index = ((uint8_t *)buf - cache_ext_buf) / DC_CACHE_BUFSIZE;
+        index = index < cache_ext_count ?
+                    index + DC_NUM_ENTRIES : DC_MAX_ENTRIES;
+    }
+#endif
+    return index;
+}
+
+/* write an entry's buffer back to storage */
+static inline void cache_writeback(IF_MV(int volume,) unsigned long sector,
+                                   void *buf)
+{
+    cache_stats.writebacks++;
+    dc_writeback_callback(IF_MV(volume,) sector, buf);
+}
+
 /* set the in-use bit in the map */
 static inline void cache_bitmap_set_bit(int volume, unsigned int mapnum,
                                         unsigned int bitnum)
@@ -129,6 +182,10 @@ static inline void touch_cache_entry(struct disk_cache_entry *which)
     struct lldc_node *lru = cache_lru.head;
     struct lldc_node *node = &which->node;
 
+#if DC_EXT_ENTRIES
+    which->stamp = ++cache_clock;
+#endif
+
     if (node == lru->prev)  /* already MRU */
         ; /**/
     else if (node == lru)   /* is the LRU? just rotate list */
@@ -149,6 +206,17 @@ static struct disk_cache_entry * cache_remove_lru_entry(void)
     if (lru == lru->next)
         return NULL;
 
+#if DC_EXT_ENTRIES
+    /* runtime entries can go away, so that one must be a static one */
+    if (cache_bufs_out >= DC_NUM_ENTRIES - 1)
+        return NULL;
+
+    while (DCIDX_FROM_DCE(NODE_DCE(lru)) >= DC_NUM_ENTRIES)
+        lru = lru->next;
+
+    cache_bufs_out++;
+#endif /* DC_EXT_ENTRIES */
+
     /* remove it; next-LRU becomes the LRU */
     lldc_remove(&cache_lru, lru);
     return NODE_DCE(lru);
@@ -157,6 +225,9 @@ static struct disk_cache_entry * cache_remove_lru_entry(void)
 /* return entry to the cache list and set it LRU */
 static void cache_return_lru_entry(struct disk_cache_entry *fce)
 {
+#if DC_EXT_ENTRIES
+    cache_bufs_out--;
+#endif
     lldc_insert_first(&cache_lru, &fce->node);
 }
 
@@ -183,18 +254,24 @@ void * dc_cache_probe(IF_MV(int volume,) unsigned long sector,
 
         if (dce->sector == sector)
         {
+            cache_stats.hits++;
             *flagsp = DCE_INUSE;
             touch_cache_entry(dce);
-            return cache_buffer[index];
+            return cache_idx_buf(index);
         }
     }
 
+    cache_stats.misses++;
+
     /* sector not found so the LRU is the victim */
     struct disk_cache_entry *dce = DCE_LRU();
     cache_lru.head = dce->node.next;
+#if DC_EXT_ENTRIES
+    dce->stamp = ++cache_clock;
+#endif
 
     unsigned int index = DCIDX_FROM_DCE(dce);
-    void *buf = cache_buffer[index];
+    void *buf = cache_idx_buf(index);
     unsigned int old_flags = dce->flags;
 
     if (old_flags)
@@ -203,8 +280,10 @@ void * dc_cache_probe(IF_MV(int volume,) unsigned long sector,
         unsigned long sector = dce->sector;
         unsigned int old_mapnum = map_sector(sector);
 
+        cache_stats.evictions++;
+
         if (old_flags & DCE_DIRTY)
-            dc_writeback_callback(IF_MV(old_volume,) sector, buf);
+            cache_writeback(IF_MV(old_volume,) sector, buf);
 
         if (mapnum == old_mapnum IF_MV( && volume == old_volume ))
             goto finish_setup;
@@ -225,12 +304,117 @@ finish_setup:
     return buf;
 }
 
+#if DC_EXT_ENTRIES
+/* returns true if the sector is cached */
+static bool cache_sector_present(IF_MV(int volume,) unsigned long sector)
+{
+    unsigned int mapnum = map_sector(sector);
+
+    FOR_EACH_BITARRAY_SET_BIT(&CACHE_MAP_ENTRY(volume, mapnum), index)
+    {
+        if (cache_entry[index].sector == sector)
+            return true;
+    }
+
+    return false;
+}
+
+/* returns true if no entry in the run of runtime entries could still be in
+   use by a caller; those touched as recently as any static entry could
+   have been are left alone */
+static bool cache_run_is_stale(unsigned int index, unsigned int count)
+{
+    for (unsigned int i = index; i < index + count; i++)
+    {
+        struct disk_cache_entry *dce = &cache_entry[i];
+
+        if (dce->flags && cache_clock - dce->stamp < DC_NUM_ENTRIES)
+            return false;
+    }
+
+    return true;
+}
+
+/* reserve adjacent buffers for up to *countp sectors starting with the
+   specified one, none of which may be cached yet, so they can be filled with
+   a single read; returns the first buffer and sets *countp to the number
+   reserved, or returns NULL if no such run of two or more can be had */
+void * dc_cache_probe_run(IF_MV(int volume,) unsigned long sector,
+                          unsigned int *countp)
+{
+    unsigned int count = MIN(*countp, cache_ext_count);
+
+    /* stop short of the first sector that's already there */
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (cache_sector_present(IF_MV(volume,) sector + i))
+            count = i;
+    }
+
+    if (count < 2)
+        return NULL;
+
+    /* rotate through the runtime entries looking for a run to reuse */
+    unsigned int first = cache_ext_next;
+
+    for (unsigned int tries = cache_ext_count; ; first++)
+    {
+        if (first + count > cache_ext_count)
+            first = 0;
+
+        if (cache_run_is_stale(DC_NUM_ENTRIES + first, count))
+            break;
+
+        if (--tries == 0)
+            return NULL;
+    }
+
+    cache_ext_next = first + count;
+    first += DC_NUM_ENTRIES;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int index = first + i;
+        struct disk_cache_entry *dce = &cache_entry[index];
+        unsigned int old_flags = dce->flags;
+
+        if (old_flags)
+        {
+            cache_stats.evictions++;
+
+            if (old_flags & DCE_DIRTY)
+            {
+                cache_writeback(IF_MV(dce->volume,) dce->sector,
+                                cache_idx_buf(index));
+            }
+
+            cache_discard_entry(dce, index);
+        }
+
+        cache_bitmap_set_bit(IF_MV_VOL(volume), map_sector(sector + i),
+                             index);
+        dce->flags  = DCE_INUSE;
+#ifdef HAVE_MULTIVOLUME
+        dce->volume = volume;
+#endif
+        dce->sector = sector + i;
+        touch_cache_entry(dce);
+    }
+
+    cache_stats.misses++;
+    cache_stats.readaheads += count - 1;
+
+    *countp = count;
+    return cache_idx_buf(first);
+}
+#endif /* DC_EXT_ENTRIES */
+
 /* mark in-use cache entry as dirty by buffer */
 void dc_dirty_buf(void *buf)
 {
-    unsigned int index = DCIDX_FROM_BUF(buf);
+    unsigned int index = cache_buf_idx(buf);
 
-    if (index >= DC_NUM_ENTRIES)
+    if (index >= DC_MAX_ENTRIES)
         return;
 
     /* dirt remains, sticky until flushed */
@@ -242,9 +426,9 @@ void dc_dirty_buf(void *buf)
 /* discard in-use cache entry by buffer */
 void dc_discard_buf(void *buf)
 {
-    unsigned int index = DCIDX_FROM_BUF(buf);
+    unsigned int index = cache_buf_idx(buf);
 
-    if (index >= DC_NUM_ENTRIES)
+    if (index >= DC_MAX_ENTRIES)
         return;
 
     struct disk_cache_entry *dce = &cache_entry[index];
@@ -264,8 +448,8 @@ void dc_commit_all(IF_MV_NONVOID(int volume))
 
         if (flags & DCE_DIRTY)
         {
-            dc_writeback_callback(IF_MV(volume,) dce->sector,
-                                  cache_buffer[index]);
+            cache_writeback(IF_MV(volume,) dce->sector,
+                            cache_idx_buf(index));
             dce->flags = flags & ~DCE_DIRTY;
         }
     }
@@ -299,7 +483,7 @@ void * dc_get_buffer(void)
         {
             /* must first commit this sector if dirty */
             if (flags & DCE_DIRTY)
-                dc_writeback_callback(IF_MV(dce->volume,) dce->sector, buf);
+                cache_writeback(IF_MV(dce->volume,) dce->sector, buf);
 
             cache_discard_entry(dce, index);
         }
@@ -315,7 +499,8 @@ void * dc_get_buffer(void)
 /* return buffer to the cache by buffer */
 void dc_release_buffer(void *buf)
 {
-    unsigned int index = DCIDX_FROM_BUF(buf);
+    /* only static buffers are handed out */
+    unsigned int index = (uint8_t (*)[DC_CACHE_BUFSIZE])buf - cache_buffer;
 
     if (index >= DC_NUM_ENTRIES)
         return;
@@ -333,6 +518,128 @@ void dc_release_buffer(void *buf)
     dc_unlock_cache();
 }
 
+/* obtain the cache statistics */
+void dc_get_stats(struct dc_stats *stats)
+{
+    dc_lock_cache();
+
+    *stats = cache_stats;
+    stats->entries = DC_NUM_ENTRIES;
+#if DC_EXT_ENTRIES
+    stats->entries += cache_ext_count;
+#endif
+
+    dc_unlock_cache();
+}
+
+#if DC_EXT_ENTRIES
+/* drop runtime entries beyond the new count */
+static void cache_ext_truncate(unsigned int count)
+{
+    for (unsigned int i = count; i < cache_ext_count; i++)
+    {
+        unsigned int index = DC_NUM_ENTRIES + i;
+        struct disk_cache_entry *dce = &cache_entry[index];
+        unsigned int flags = dce->flags;
+
+        if (flags)
+        {
+            if (flags & DCE_DIRTY)
+            {
+                cache_writeback(IF_MV(dce->volume,) dce->sector,
+                                cache_idx_buf(index));
+            }
+
+            cache_discard_entry(dce, index);
+        }
+
+        lldc_remove(&cache_lru, &dce->node);
+    }
+
+    cache_ext_count = count;
+
+    if (cache_ext_next >= count)
+        cache_ext_next = 0;
+}
+
+/* buffers are only accessed with the cache locked */
+static void cache_ext_sync_cb(int handle, bool sync_on)
+{
+    if (sync_on)
+        dc_lock_cache();
+    else
+        dc_unlock_cache();
+
+    (void)handle;
+}
+
+static int cache_ext_move_cb(int handle, void *current, void *new)
+{
+    cache_ext_buf = new;
+    return BUFLIB_CB_OK;
+    (void)handle; (void)current;
+}
+
+/* give up entries from the end or, failing that, all of them */
+static int cache_ext_shrink_cb(int handle, unsigned hints, void *start,
+                               size_t old_size)
+{
+    size_t wanted = hints & BUFLIB_SHRINK_SIZE_MASK;
+    unsigned int count = cache_ext_count;
+    unsigned int drop = (wanted + DC_CACHE_BUFSIZE - 1) / DC_CACHE_BUFSIZE;
+
+    if (!(hints & BUFLIB_SHRINK_POS_BACK) || drop >= count)
+        drop = count;
+
+    dc_lock_cache();
+
+    cache_ext_truncate(count - drop);
+
+    if (cache_ext_count)
+    {
+        core_shrink(handle, start, cache_ext_count*DC_CACHE_BUFSIZE);
+    }
+    else
+    {
+        cache_ext_handle = core_free(handle);
+        cache_ext_buf = NULL;
+    }
+
+    dc_unlock_cache();
+
+    return BUFLIB_CB_OK;
+    (void)old_size;
+}
+
+static void cache_ext_init(void)
+{
+    static struct buflib_callbacks ops =
+    {
+        .move_callback   = cache_ext_move_cb,
+        .shrink_callback = cache_ext_shrink_cb,
+        .sync_callback   = cache_ext_sync_cb,
+    };
+
+    /* don't take more than a small fraction of what's there */
+    unsigned int count = core_allocatable() / (16*DC_CACHE_BUFSIZE);
+    count = MIN(count, DC_EXT_ENTRIES);
+    if (!count)
+        return;
+
+    int handle = core_alloc_ex("disk cache", count*DC_CACHE_BUFSIZE, &ops);
+    if (handle <= 0)
+        return;
+
+    cache_ext_handle = handle;
+    cache_ext_buf = core_get_data(handle);
+    cache_ext_count = count;
+
+    /* empty ones are used first */
+    for (unsigned int i = 0; i < count; i++)
+        lldc_insert_first(&cache_lru, &cache_entry[DC_NUM_ENTRIES + i].node);
+}
+#endif /* DC_EXT_ENTRIES */
+
 /* one-time init at startup */
 void dc_init(void)
 {
@@ -340,4 +647,8 @@ void dc_init(void)
     lldc_init(&cache_lru);
     for (unsigned int i = 0; i < DC_NUM_ENTRIES; i++)
         lldc_insert_last(&cache_lru, &cache_entry[i].node);
+
+#if DC_EXT_ENTRIES
+    cache_ext_init();
+#endif
 }
@@ -26,6 +26,15 @@ extern unsigned char *audiobufend;
 
 /* debug test alloc */
 static int test_alloc;
+
+/* set when a free or shrink left a hole that compaction steps may close,
+ * cleared when a step can't do anything more about it */
+static bool compact_step_pending;
+
+#ifdef HAVE_BUFLIB_TRACE
+static struct buflib_trace core_trace;
+#endif
+
 void core_allocator_init(void)
 {
     unsigned char *start = ALIGN_UP(audiobuffer, sizeof(intptr_t));
@@ -39,6 +48,9 @@ void core_allocator_init(void)
 #endif
 
     buflib_init(&core_ctx, start, audiobufend - start);
+#ifdef HAVE_BUFLIB_TRACE
+    buflib_trace_enable(&core_ctx, &core_trace);
+#endif
 
     test_alloc = core_alloc("test", 112);
 }
@@ -78,9 +90,23 @@ size_t core_allocatable(void)
     return buflib_allocatable(&core_ctx);
 }
 
+size_t core_compact_step(size_t max_bytes)
+{
+    if (!compact_step_pending)
+        return 0;
+
+    size_t moved = buflib_compact_step(&core_ctx, max_bytes);
+    if (!moved)
+        compact_step_pending = false;
+    return moved;
+}
+
 int core_free(int handle)
 {
-    return buflib_free(&core_ctx, handle);
+    int ret = buflib_free(&core_ctx, handle);
+    if (!core_ctx.compact)
+        compact_step_pending = true;
+    return ret;
 }
 
 int core_alloc_maximum(const char* name, size_t *size, struct buflib_callbacks *ops)
@@ -90,7 +116,10 @@ int core_alloc_maximum(const char* name, size_t *size, struct buflib_callbacks *
 
 bool core_shrink(int handle, void* new_start, size_t new_size)
 {
-    return buflib_shrink(&core_ctx, handle, new_start, new_size);
+    bool ret = buflib_shrink(&core_ctx, handle, new_start, new_size);
+    if (!core_ctx.compact)
+        compact_step_pending = true;
+    return ret;
 }
 
 const char* core_get_name(int handle)
@@ -99,6 +128,24 @@ const char* core_get_name(int handle)
     return name ?: "<anonymous>";
 }
 
+void core_get_frag_stats(struct buflib_frag_stats *stats)
+{
+    buflib_get_frag_stats(&core_ctx, stats);
+}
+
+#ifdef HAVE_BUFLIB_TRACE
+const struct buflib_trace* core_get_trace(void)
+{
+    return &core_trace;
+}
+
+size_t core_get_buffer_size(void)
+{
+    return (core_ctx.handle_table - core_ctx.buf_start)
+                * sizeof(union buflib_data);
+}
+#endif
+
 int core_get_num_blocks(void)
 {
     return buflib_get_num_blocks(&core_ctx);
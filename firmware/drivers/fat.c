@@ -29,6 +29,7 @@
 #include "fs_attr.h"
 #include "pathfuncs.h"
 #include "disk_cache.h"
+#include "bitarray.h"
 #include "file_internal.h" /* for struct filestr_cache */
 #include "storage.h"
 #include "timefuncs.h"
@@ -101,6 +102,18 @@
 
 #define BPB_LAST_WORD       510
 
+/* exfat */
+#define EXFAT_VOLLENGTH     72
+#define EXFAT_FATOFFSET     80
+#define EXFAT_FATLENGTH     84
+#define EXFAT_HEAPOFFSET    88
+#define EXFAT_CLUSTERCOUNT  92
+#define EXFAT_ROOTCLUSTER   96
+#define EXFAT_VOLSERIAL     100
+#define EXFAT_BYTSPERSECSH  108
+#define EXFAT_SECPERCLUSSH  109
+#define EXFAT_NUMFATS       110
+
 /* Short and long name directory entry template */
 union raw_dirent
 {
@@ -132,6 +145,45 @@ union raw_dirent
         uint8_t  ldir_name3[4];     /* 28 */
                                     /* 32 */
     };
+#ifdef HAVE_EXFAT
+    struct /* exFAT file entry */
+    {
+        uint8_t  xf_type;           /*  0 */
+        uint8_t  xf_seccount;       /*  1 */
+        uint16_t xf_chksum;         /*  2 */
+        uint16_t xf_attr;           /*  4 */
+        uint16_t xf_rsvd1;          /*  6 */
+        uint32_t xf_crtts;          /*  8 */
+        uint32_t xf_wrtts;          /* 12 */
+        uint32_t xf_accts;          /* 16 */
+        uint8_t  xf_crt10ms;        /* 20 */
+        uint8_t  xf_wrt10ms;        /* 21 */
+        uint8_t  xf_utcofs[3];      /* 22 */
+        uint8_t  xf_rsvd2[7];       /* 25 */
+                                    /* 32 */
+    };
+    struct /* exFAT stream extension, bitmap and up-case table entries */
+    {
+        uint8_t  xs_type;           /*  0 */
+        uint8_t  xs_flags;          /*  1 */
+        uint8_t  xs_rsvd1;          /*  2 */
+        uint8_t  xs_namelen;        /*  3 */
+        uint16_t xs_namehash;       /*  4 */
+        uint16_t xs_rsvd2;          /*  6 */
+        uint32_t xs_validlen[2];    /*  8 */
+        uint32_t xs_rsvd3;          /* 16 */
+        uint32_t xs_fstclus;        /* 20 */
+        uint32_t xs_datalen[2];     /* 24 */
+                                    /* 32 */
+    };
+    struct /* exFAT file name entry */
+    {
+        uint8_t  xn_type;           /*  0 */
+        uint8_t  xn_flags;          /*  1 */
+        uint16_t xn_name[15];       /*  2 */
+                                    /* 32 */
+    };
+#endif /* HAVE_EXFAT */
     struct /* raw byte array */
     {
         uint8_t  data[32];          /*  0 */
@@ -171,6 +223,25 @@ union raw_dirent
 #define FAT16_BAD_MARK              0xfff7
 #define FAT16_EOF_MARK              0xfff8
 
+/* exFAT directory entry types; bit 7 is cleared when the entry is freed */
+#define EXFAT_ENT_INUSE             0x80
+#define EXFAT_ENT_BITMAP            0x81
+#define EXFAT_ENT_UPCASE            0x82
+#define EXFAT_ENT_FILE              0x85
+#define EXFAT_ENT_SECONDARY         0x40
+#define EXFAT_ENT_STREAM            0xc0
+#define EXFAT_ENT_NAME              0xc1
+#define EXFAT_STREAM_ALLOC          0x01 /* FirstCluster is valid */
+#define EXFAT_STREAM_NOFATCHAIN     0x02 /* clusters are one run */
+#define EXFAT_NAME_CHARS            15
+#define EXFAT_MAX_SECONDARIES       18
+#define EXFAT_UPCASE_CACHED         0x180 /* Basic Latin to Latin Ext.-A */
+#define EXFAT_ATTR_MASK             (ATTR_READ_ONLY | ATTR_HIDDEN | \
+                                     ATTR_SYSTEM | ATTR_DIRECTORY | \
+                                     ATTR_ARCHIVE)
+#define EXFAT_EOF_MARK              0xfffffff7 /* and up, incl. bad mark */
+#define CLUSTERS_PER_BITMAP_SECTOR  (SECTOR_SIZE * 8)
+
 struct fsinfo
 {
     unsigned long freecount; /* last known free cluster count */
@@ -184,9 +255,14 @@ struct fsinfo
 
 #define FSINFO_SIGNATURE_VAL 0x41615252
 
-#ifdef HAVE_FAT16SUPPORT
+#if defined(HAVE_FAT16SUPPORT) || defined(HAVE_EXFAT)
+#define HAVE_FAT_TYPE_FNS
+#endif
+
+#ifdef HAVE_FAT_TYPE_FNS
 #define BPB_FN_SET16(bpb, fn)      (bpb)->fn##__ = fn##16
 #define BPB_FN_SET32(bpb, fn)      (bpb)->fn##__ = fn##32
+#define BPB_FN_SETEX(bpb, fn)      (bpb)->fn##__ = fn##_ex
 #define BPB_FN_DECL(fn, args...)   (*fn##__)(struct bpb *bpb , ##args)
 #define BPB_CALL(fn, bpb, args...) ((bpb)->fn##__(bpb , ##args))
 
@@ -198,14 +274,23 @@ struct fsinfo
     BPB_CALL(update_fat_entry, (bpb), (entry), (value))
 #define fat_recalc_free_internal(bpb) \
     BPB_CALL(fat_recalc_free_internal, (bpb))
-#else  /* !HAVE_FAT16SUPPORT */
+#else  /* !HAVE_FAT_TYPE_FNS */
 #define get_next_cluster            get_next_cluster32
 #define find_free_cluster           find_free_cluster32
 #define update_fat_entry            update_fat_entry32
 #define fat_recalc_free_internal    fat_recalc_free_internal32
-#endif /* HAVE_FAT16SUPPORT */
+#endif /* HAVE_FAT_TYPE_FNS */
 struct bpb;
+
+/* a set bit means the group of FAT sectors may contain free clusters */
+BITARRAY_TYPE_DECLARE(fat_freemap_t, fat_freemap, FAT_FREEMAP_GROUPS)
+
 static void update_fsinfo32(struct bpb *fat_bpb);
+#ifdef HAVE_EXFAT
+static int exfat_update_entry(struct bpb *fat_bpb, struct fat_file *file,
+                              uint32_t size, struct fat_direntry *fatent,
+                              bool settime);
+#endif
 
 /* Note: This struct doesn't hold the raw values after mounting if
  * bpb_bytspersec isn't 512. All sector counts are normalized to 512 byte
@@ -228,6 +313,8 @@ static struct bpb
     unsigned long bpb_fatsz32;
     unsigned long bpb_fsinfo;
 
+    uint32_t      bs_volid;       /* Volume serial number */
+
     /* variables for internal use */
     unsigned long fatsize;
     unsigned long totalsectors;
@@ -238,17 +325,35 @@ static struct bpb
     unsigned long fatrgnstart;
     unsigned long fatrgnend;
     struct fsinfo fsinfo;
+    unsigned int  freemap_shift;  /* log2 of FAT (or bitmap) sectors per
+                                     freemap group */
+    fat_freemap_t freemap;        /* groups that may have free clusters */
+#if DC_EXT_ENTRIES
+    unsigned long lastfill;       /* last sector read into the cache */
+#endif
 #ifdef HAVE_FAT16SUPPORT
     unsigned int bpb_rootentcnt;    /* Number of dir entries in the root */
     /* internals for FAT16 support */
     unsigned long rootdirsectornum; /* sector offset of root dir relative to start
                                      * of first pseudo cluster */
 #endif /* HAVE_FAT16SUPPORT */
+#ifdef HAVE_EXFAT
+    /* exFAT keeps cluster allocation in a bitmap; both it and the up-case
+       table must be contiguous */
+    unsigned long bitmapsector;   /* first sector of the allocation bitmap */
+    unsigned long bitmapsize;     /* number of sectors in the bitmap */
+    unsigned long upcasesector;   /* first sector of the up-case table */
+    unsigned long upcasesize;     /* number of bytes in the up-case table */
+    uint16_t upcase[EXFAT_UPCASE_CACHED]; /* decoded start of the table */
+#endif /* HAVE_EXFAT */
 
     /** Additional information kept for each volume **/
 #ifdef HAVE_FAT16SUPPORT
     uint8_t is_fat16; /* true if we mounted a FAT16 partition, false if FAT32 */
 #endif
+#ifdef HAVE_EXFAT
+    uint8_t is_exfat; /* true if we mounted an exFAT partition */
+#endif
 #ifdef HAVE_MULTIDRIVE
     uint8_t drive;    /* on which physical device is this located */
 #endif
@@ -256,13 +361,13 @@ static struct bpb
     uint8_t volume;   /* on which volume is this located (shortcut) */
 #endif
     uint8_t mounted;  /* true if volume is mounted, false otherwise */
-#ifdef HAVE_FAT16SUPPORT
+#ifdef HAVE_FAT_TYPE_FNS
     /* some functions are different for different FAT types */
     long BPB_FN_DECL(get_next_cluster, long);
     long BPB_FN_DECL(find_free_cluster, long);
     int  BPB_FN_DECL(update_fat_entry, unsigned long, unsigned long);
     void BPB_FN_DECL(fat_recalc_free_internal);
-#endif /* HAVE_FAT16SUPPORT */
+#endif /* HAVE_FAT_TYPE_FNS */
 
 } fat_bpbs[NUM_VOLUMES]; /* mounted partition info */
 
@@ -303,11 +408,26 @@ struct fatlong_parse_state
     uint8_t chksum;
 };
 
+#ifdef HAVE_EXFAT
+struct exfat_parse_state
+{
+    unsigned int secondaries; /* secondary entries still to come */
+    unsigned int entries;     /* entries in the whole set */
+    unsigned int namelen;     /* characters in the name */
+    unsigned int namechars;   /* characters gathered so far */
+    uint16_t     chksum;      /* checksum of the entries so far */
+    uint16_t     setchksum;   /* checksum the file entry has */
+};
+#endif /* HAVE_EXFAT */
+
 static void cache_commit(struct bpb *fat_bpb)
 {
     dc_lock_cache();
 #ifdef HAVE_FAT16SUPPORT
     if (!fat_bpb->is_fat16)
+#endif
+#ifdef HAVE_EXFAT
+    if (!fat_bpb->is_exfat)
 #endif
         update_fsinfo32(fat_bpb);
     dc_commit_all(IF_MV(fat_bpb->volume));
@@ -321,23 +441,70 @@ static void cache_discard(IF_MV_NONVOID(struct bpb *fat_bpb))
     dc_unlock_cache();
 }
 
+#if DC_EXT_ENTRIES
+/* returns the number of sectors to read ahead from secnum, staying within
+   the FAT or within the data cluster (directory streams read through their
+   own buffer, so in the data area this serves the exFAT bitmap and up-case
+   table) */
+static unsigned int cache_readahead_count(struct bpb *fat_bpb,
+                                          unsigned long secnum)
+{
+    unsigned long end;
+
+    if (IS_FAT_SECTOR(fat_bpb, secnum))
+        end = fat_bpb->fatrgnend;
+    else if (secnum >= fat_bpb->firstdatasector)
+        end = secnum + fat_bpb->bpb_secperclus -
+              (secnum - fat_bpb->firstdatasector) % fat_bpb->bpb_secperclus;
+    else
+        return 1;
+
+    return MIN(end - secnum, DC_READAHEAD_SECTORS);
+}
+#endif /* DC_EXT_ENTRIES */
+
 /* caches a FAT or data area sector */
 static void * cache_sector(struct bpb *fat_bpb, unsigned long secnum)
 {
-    unsigned int flags;
-    void *buf = dc_cache_probe(IF_MV(fat_bpb->volume,) secnum, &flags);
+    unsigned int flags = 0;
+    unsigned int count = 1;
+    void *buf = NULL;
+
+#if DC_EXT_ENTRIES
+    /* when misses come in sequence, fill the following sectors as well */
+    if (secnum == fat_bpb->lastfill + 1)
+    {
+        count = cache_readahead_count(fat_bpb, secnum);
+        if (count > 1)
+            buf = dc_cache_probe_run(IF_MV(fat_bpb->volume,) secnum, &count);
+    }
+
+    if (!buf)
+#endif /* DC_EXT_ENTRIES */
+    {
+        count = 1;
+        buf = dc_cache_probe(IF_MV(fat_bpb->volume,) secnum, &flags);
+    }
 
     if (!flags)
     {
         int rc = storage_read_sectors(IF_MD(fat_bpb->drive,)
-                                      secnum + fat_bpb->startsector, 1, buf);
+                                      secnum + fat_bpb->startsector, count,
+                                      buf);
         if (UNLIKELY(rc < 0))
         {
             DEBUGF("%s() - Could not read sector %ld"
                    " (error %d)\n", __func__, secnum, rc);
-            dc_discard_buf(buf);
+
+            for (unsigned int i = 0; i < count; i++)
+                dc_discard_buf((uint8_t *)buf + i*DC_CACHE_BUFSIZE);
+
             return NULL;
         }
+
+#if DC_EXT_ENTRIES
+        fat_bpb->lastfill = secnum + count - 1;
+#endif
     }
 
     return buf;
@@ -998,10 +1165,26 @@ static long find_free_cluster32(struct bpb *fat_bpb, long startcluster)
     unsigned long entry = startcluster;
     unsigned long sector = entry / CLUSTERS_PER_FAT_SECTOR;
     unsigned long offset = entry % CLUSTERS_PER_FAT_SECTOR;
+    unsigned long groupmask = (1ul << fat_bpb->freemap_shift) - 1;
+    bool wholegroup = false;
 
     for (unsigned long i = 0; i < fat_bpb->fatsize; i++)
     {
         unsigned long nr = (i + sector) % fat_bpb->fatsize;
+        unsigned long last = MIN(nr | groupmask, fat_bpb->fatsize - 1);
+        unsigned int group = nr >> fat_bpb->freemap_shift;
+
+        if (!fat_freemap_test_bit(&fat_bpb->freemap, group))
+        {
+            /* known to be full; resume with the next group */
+            i += last - nr;
+            offset = 0;
+            continue;
+        }
+
+        if (!(nr & groupmask))
+            wholegroup = !offset;
+
         uint32_t *sec = cache_sector(fat_bpb, nr + fat_bpb->fatrgnstart);
         if (!sec)
             break;
@@ -1025,6 +1208,10 @@ static long find_free_cluster32(struct bpb *fat_bpb, long startcluster)
             }
         }
 
+        /* remember groups that were scanned from start to end in vain */
+        if (wholegroup && nr == last)
+            fat_freemap_clear_bit(&fat_bpb->freemap, group);
+
         offset = 0;
     }
 
@@ -1069,6 +1256,9 @@ static int update_fat_entry32(struct bpb *fat_bpb, unsigned long entry,
         /* being freed */
         if (curval & 0x0fffffff)
             fat_bpb->fsinfo.freecount++;
+
+        fat_freemap_set_bit(&fat_bpb->freemap,
+                            sector >> fat_bpb->freemap_shift);
     }
 
     DEBUGF("%lu free clusters\n", (unsigned long)fat_bpb->fsinfo.freecount);
@@ -1085,11 +1275,21 @@ static void fat_recalc_free_internal32(struct bpb *fat_bpb)
 {
     unsigned long free = 0;
 
+    /* groups are marked as free clusters turn up in them; if a sector can't
+       be read, the rest are left for find_free_cluster() to look at */
+    fat_freemap_clear(&fat_bpb->freemap);
+
     for (unsigned long i = 0; i < fat_bpb->fatsize; i++)
     {
+        unsigned int group = i >> fat_bpb->freemap_shift;
         uint32_t *sec = cache_sector(fat_bpb, i + fat_bpb->fatrgnstart);
         if (!sec)
+        {
+            for (; i < fat_bpb->fatsize; i++)
+                fat_freemap_set_bit(&fat_bpb->freemap,
+                                    i >> fat_bpb->freemap_shift);
             break;
+        }
 
         for (unsigned long j = 0; j < CLUSTERS_PER_FAT_SECTOR; j++)
         {
@@ -1104,6 +1304,8 @@ static void fat_recalc_free_internal32(struct bpb *fat_bpb)
             free++;
             if (fat_bpb->fsinfo.nextfree == 0xffffffff)
                 fat_bpb->fsinfo.nextfree = c;
+
+            fat_freemap_set_bit(&fat_bpb->freemap, group);
         }
     }
 
@@ -1111,6 +1313,320 @@ static void fat_recalc_free_internal32(struct bpb *fat_bpb)
     update_fsinfo32(fat_bpb);
 }
 
+#ifdef HAVE_EXFAT
+static long get_next_cluster_ex(struct bpb *fat_bpb, long startcluster)
+{
+    unsigned long entry = startcluster;
+    unsigned long sector = entry / CLUSTERS_PER_FAT_SECTOR;
+    unsigned long offset = entry % CLUSTERS_PER_FAT_SECTOR;
+
+    dc_lock_cache();
+
+    uint32_t *sec = cache_sector(fat_bpb, sector + fat_bpb->fatrgnstart);
+    if (!sec)
+    {
+        dc_unlock_cache();
+        DEBUGF("%s: Could not cache sector %lu\n", __func__, sector);
+        return -1;
+    }
+
+    unsigned long next = letoh32(sec[offset]);
+
+    /* is this last cluster in chain? (all 32 bits are used) */
+    if (next < 2 || next > fat_bpb->dataclusters + 1)
+        next = 0;
+
+    dc_unlock_cache();
+    return next;
+}
+
+/* returns the cluster's bit in the allocation bitmap, -1 if it can't be
+   read; 'sector' receives the cached bitmap sector if not NULL */
+static int test_bitmap_ex(struct bpb *fat_bpb, unsigned long cluster,
+                          uint8_t **sector)
+{
+    unsigned long bit = cluster - 2;
+    uint8_t *sec = cache_sector(fat_bpb, bit / CLUSTERS_PER_BITMAP_SECTOR
+                                    + fat_bpb->bitmapsector);
+    if (sector)
+        *sector = sec;
+
+    if (!sec)
+        return -1;
+
+    bit %= CLUSTERS_PER_BITMAP_SECTOR;
+    return (sec[bit / 8] >> (bit % 8)) & 1;
+}
+
+static int update_bitmap_ex(struct bpb *fat_bpb, unsigned long cluster,
+                            bool used)
+{
+    unsigned long bit = cluster - 2;
+    uint8_t *sec;
+
+    dc_lock_cache();
+
+    int isused = test_bitmap_ex(fat_bpb, cluster, &sec);
+    if (isused < 0)
+    {
+        dc_unlock_cache();
+        DEBUGF("Could not cache bitmap of cluster %lu\n", cluster);
+        return -1;
+    }
+
+    uint8_t mask = 1 << (bit % 8);
+    bit %= CLUSTERS_PER_BITMAP_SECTOR;
+
+    if (used)
+    {
+        /* being allocated */
+        if (!isused && fat_bpb->fsinfo.freecount > 0)
+            fat_bpb->fsinfo.freecount--;
+
+        sec[bit / 8] |= mask;
+    }
+    else
+    {
+        /* being freed */
+        if (isused)
+            fat_bpb->fsinfo.freecount++;
+
+        sec[bit / 8] &= ~mask;
+        fat_freemap_set_bit(&fat_bpb->freemap,
+            (cluster - 2) / CLUSTERS_PER_BITMAP_SECTOR
+                >> fat_bpb->freemap_shift);
+    }
+
+    dc_dirty_buf(sec);
+    dc_unlock_cache();
+    return 0;
+}
+
+static long find_free_cluster_ex(struct bpb *fat_bpb, long startcluster)
+{
+    unsigned long entry = startcluster;
+    if (entry < 2 || entry > fat_bpb->dataclusters + 1)
+        entry = 2;
+
+    unsigned long sector = (entry - 2) / CLUSTERS_PER_BITMAP_SECTOR;
+    unsigned long offset = (entry - 2) % CLUSTERS_PER_BITMAP_SECTOR;
+    unsigned long groupmask = (1ul << fat_bpb->freemap_shift) - 1;
+    bool wholegroup = false;
+
+    for (unsigned long i = 0; i < fat_bpb->bitmapsize; i++)
+    {
+        unsigned long nr = (i + sector) % fat_bpb->bitmapsize;
+        unsigned long last = MIN(nr | groupmask, fat_bpb->bitmapsize - 1);
+        unsigned int group = nr >> fat_bpb->freemap_shift;
+
+        if (!fat_freemap_test_bit(&fat_bpb->freemap, group))
+        {
+            /* known to be full; resume with the next group */
+            i += last - nr;
+            offset = 0;
+            continue;
+        }
+
+        if (!(nr & groupmask))
+            wholegroup = !offset;
+
+        uint8_t *sec = cache_sector(fat_bpb, nr + fat_bpb->bitmapsector);
+        if (!sec)
+            break;
+
+        for (unsigned long j = 0; j < CLUSTERS_PER_BITMAP_SECTOR; j++)
+        {
+            unsigned long k = (j + offset) % CLUSTERS_PER_BITMAP_SECTOR;
+
+            if (!(k % 8) && sec[k / 8] == 0xff)
+            {
+                j += 7; /* whole byte is used */
+                continue;
+            }
+
+            if (sec[k / 8] & (1 << (k % 8)))
+                continue;
+
+            unsigned long c = nr * CLUSTERS_PER_BITMAP_SECTOR + k + 2;
+            /* the bitmap's last byte may have bits beyond the heap */
+            if (c > fat_bpb->dataclusters + 1)
+                continue;
+
+            DEBUGF("%s(%lx) == %lx\n", __func__, startcluster, c);
+
+            fat_bpb->fsinfo.nextfree = c;
+            return c;
+        }
+
+        /* remember groups that were scanned from start to end in vain */
+        if (wholegroup && nr == last)
+            fat_freemap_clear_bit(&fat_bpb->freemap, group);
+
+        offset = 0;
+    }
+
+    DEBUGF("%s(%lx) == 0\n", __func__, startcluster);
+    return 0; /* 0 is an illegal cluster number */
+}
+
+/* the bitmap holds the allocation state; the FAT is only written for links
+   since an unallocated cluster's entry has no meaning */
+static int update_fat_entry_ex(struct bpb *fat_bpb, unsigned long entry,
+                               unsigned long val)
+{
+    unsigned long sector = entry / CLUSTERS_PER_FAT_SECTOR;
+    unsigned long offset = entry % CLUSTERS_PER_FAT_SECTOR;
+
+    DEBUGF("%s(entry:%lx,val:%lx)\n", __func__, entry, val);
+
+    if (entry == val)
+        panicf("Creating exFAT loop: %lx,%lx\n", entry, val);
+
+    if (entry < 2)
+        panicf("Updating reserved exFAT entry %lu\n", entry);
+
+    int rc = update_bitmap_ex(fat_bpb, entry, val != 0);
+    if (rc < 0 || !val)
+        return rc;
+
+    dc_lock_cache();
+
+    uint32_t *sec = cache_sector(fat_bpb, sector + fat_bpb->fatrgnstart);
+    if (!sec)
+    {
+        dc_unlock_cache();
+        DEBUGF("Could not cache sector %lu\n", sector);
+        return -1;
+    }
+
+    sec[offset] = htole32(val >= FAT_EOF_MARK ? 0xffffffff : val);
+    dc_dirty_buf(sec);
+
+    dc_unlock_cache();
+    return 0;
+}
+
+static void fat_recalc_free_internal_ex(struct bpb *fat_bpb)
+{
+    unsigned long free = 0;
+
+    /* groups are marked as free clusters turn up in them; if a sector can't
+       be read, the rest are left for find_free_cluster() to look at */
+    fat_freemap_clear(&fat_bpb->freemap);
+
+    for (unsigned long i = 0; i < fat_bpb->bitmapsize; i++)
+    {
+        unsigned int group = i >> fat_bpb->freemap_shift;
+        uint8_t *sec = cache_sector(fat_bpb, i + fat_bpb->bitmapsector);
+        if (!sec)
+        {
+            for (; i < fat_bpb->bitmapsize; i++)
+                fat_freemap_set_bit(&fat_bpb->freemap,
+                                    i >> fat_bpb->freemap_shift);
+            break;
+        }
+
+        for (unsigned long j = 0; j < CLUSTERS_PER_BITMAP_SECTOR; j++)
+        {
+            unsigned long c = i * CLUSTERS_PER_BITMAP_SECTOR + j + 2;
+
+            if (c > fat_bpb->dataclusters + 1)
+                break;
+
+            if (!(j % 8) && sec[j / 8] == 0xff)
+            {
+                j += 7;
+                continue;
+            }
+
+            if (sec[j / 8] & (1 << (j % 8)))
+                continue;
+
+            free++;
+            if (fat_bpb->fsinfo.nextfree == 0xffffffff)
+                fat_bpb->fsinfo.nextfree = c;
+
+            fat_freemap_set_bit(&fat_bpb->freemap, group);
+        }
+    }
+
+    fat_bpb->fsinfo.freecount = free;
+}
+
+static int exfat_mount_internal(struct bpb *fat_bpb, const uint8_t *buf)
+{
+    unsigned int secshift  = buf[EXFAT_BYTSPERSECSH];
+    unsigned int clusshift = buf[EXFAT_SECPERCLUSSH];
+
+    if (secshift < 9 || secshift > 12 || secshift + clusshift > 25)
+    {
+        DEBUGF("%s() - Bad sector/cluster shift (%u/%u)\n", __func__,
+               secshift, clusshift);
+        return -1;
+    }
+
+    fat_bpb->bpb_bytspersec = 1ul << secshift;
+    unsigned long secmult = fat_bpb->bpb_bytspersec / SECTOR_SIZE;
+
+    if (!secmult)
+        return -2;
+
+    fat_bpb->bpb_secperclus  = secmult << clusshift;
+    fat_bpb->bpb_numfats     = buf[EXFAT_NUMFATS];
+    fat_bpb->bpb_media       = 0xf8;
+    fat_bpb->last_word       = BYTES2INT16(buf, BPB_LAST_WORD);
+    fat_bpb->fatrgnstart     = secmult * BYTES2INT32(buf, EXFAT_FATOFFSET);
+    fat_bpb->fatsize         = secmult * BYTES2INT32(buf, EXFAT_FATLENGTH);
+    fat_bpb->fatrgnend       = fat_bpb->fatrgnstart + fat_bpb->fatsize;
+    fat_bpb->firstdatasector = secmult * BYTES2INT32(buf, EXFAT_HEAPOFFSET);
+    fat_bpb->dataclusters    = BYTES2INT32(buf, EXFAT_CLUSTERCOUNT);
+    fat_bpb->bpb_rootclus    = BYTES2INT32(buf, EXFAT_ROOTCLUSTER);
+    fat_bpb->bs_volid        = BYTES2INT32(buf, EXFAT_VOLSERIAL);
+
+    /* a second FAT and bitmap means TexFAT which isn't supported */
+    if (fat_bpb->bpb_numfats != 1)
+    {
+        DEBUGF("%s() - NumberOfFats is not 1 (%u)\n", __func__,
+               fat_bpb->bpb_numfats);
+        return -3;
+    }
+
+    /* cluster numbers must stay clear of the FAT32 marks used internally
+       and all of the heap must be addressable */
+    uint64_t heapend = (uint64_t)fat_bpb->dataclusters *
+                       fat_bpb->bpb_secperclus + fat_bpb->firstdatasector;
+
+    if (fat_bpb->dataclusters + 2 >= FAT_BAD_MARK ||
+        fat_bpb->fatsize * CLUSTERS_PER_FAT_SECTOR <
+            fat_bpb->dataclusters + 2 ||
+        heapend > 0xffffffffull ||
+        fat_bpb->bpb_rootclus < 2 ||
+        (unsigned long)fat_bpb->bpb_rootclus > fat_bpb->dataclusters + 1)
+    {
+        DEBUGF("%s() - Bad volume geometry\n", __func__);
+        return -4;
+    }
+
+    fat_bpb->totalsectors  = heapend;
+    fat_bpb->rootdirsector = cluster2sec(fat_bpb, fat_bpb->bpb_rootclus);
+
+    fat_bpb->fsinfo.freecount = 0; /* counted once the bitmap is found */
+    fat_bpb->fsinfo.nextfree  = 0xffffffff;
+
+#ifdef HAVE_FAT16SUPPORT
+    fat_bpb->is_fat16 = false;
+#endif
+    fat_bpb->is_exfat = true;
+
+    BPB_FN_SETEX(fat_bpb, get_next_cluster);
+    BPB_FN_SETEX(fat_bpb, find_free_cluster);
+    BPB_FN_SETEX(fat_bpb, update_fat_entry);
+    BPB_FN_SETEX(fat_bpb, fat_recalc_free_internal);
+
+    return bpb_is_sane(fat_bpb);
+}
+#endif /* HAVE_EXFAT */
+
 static int fat_mount_internal(struct bpb *fat_bpb)
 {
     int rc;
@@ -1130,6 +1646,19 @@ static int fat_mount_internal(struct bpb *fat_bpb)
         FAT_ERROR(rc * 10 - 2);
     }
 
+#ifdef HAVE_EXFAT
+    fat_bpb->is_exfat = false;
+
+    if (!memcmp(&buf[BS_OEMNAME], "EXFAT   ", 8))
+    {
+        rc = exfat_mount_internal(fat_bpb, buf);
+        if (rc < 0)
+            FAT_ERROR(rc * 10 - 1);
+
+        FAT_ERROR(RC); /* the rest is FAT12/16/32 */
+    }
+#endif /* HAVE_EXFAT */
+
     fat_bpb->bpb_bytspersec = BYTES2INT16(buf, BPB_BYTSPERSEC);
     unsigned long secmult = fat_bpb->bpb_bytspersec / SECTOR_SIZE;
     /* Sanity check is performed later */
@@ -1217,6 +1746,7 @@ static int fat_mount_internal(struct bpb *fat_bpb)
         fat_bpb->bpb_rootclus = 0 - dirclusters; /* backwards, before the data */
         fat_bpb->rootdirsectornum = dirclusters * fat_bpb->bpb_secperclus
             - rootdirsectors;
+        fat_bpb->bs_volid = BYTES2INT32(buf, BS_VOLID);
     }
     else
 #endif /* HAVE_FAT16SUPPORT */
@@ -1225,6 +1755,7 @@ static int fat_mount_internal(struct bpb *fat_bpb)
         fat_bpb->bpb_rootclus  = BYTES2INT32(buf, BPB_ROOTCLUS);
         fat_bpb->bpb_fsinfo    = secmult * BYTES2INT16(buf, BPB_FSINFO);
         fat_bpb->rootdirsector = cluster2sec(fat_bpb, fat_bpb->bpb_rootclus);
+        fat_bpb->bs_volid      = BYTES2INT32(buf, BS_32_VOLID);
     }
 
     rc = bpb_is_sane(fat_bpb);
@@ -1266,8 +1797,9 @@ static int fat_mount_internal(struct bpb *fat_bpb)
         fat_bpb->fsinfo.nextfree = BYTES2INT32(buf, FSINFO_NEXTFREE);
     }
 
-#ifdef HAVE_FAT16SUPPORT
+#ifdef HAVE_FAT_TYPE_FNS
     /* Fix up calls that change per FAT type */
+#ifdef HAVE_FAT16SUPPORT
     if (fat_bpb->is_fat16)
     {
         BPB_FN_SET16(fat_bpb, get_next_cluster);
@@ -1276,13 +1808,14 @@ static int fat_mount_internal(struct bpb *fat_bpb)
         BPB_FN_SET16(fat_bpb, fat_recalc_free_internal);
     }
     else
+#endif /* HAVE_FAT16SUPPORT */
     {
         BPB_FN_SET32(fat_bpb, get_next_cluster);
         BPB_FN_SET32(fat_bpb, find_free_cluster);
         BPB_FN_SET32(fat_bpb, update_fat_entry);
         BPB_FN_SET32(fat_bpb, fat_recalc_free_internal);
     }
-#endif /* HAVE_FAT16SUPPORT */
+#endif /* HAVE_FAT_TYPE_FNS */
 
     rc = 0;
 fat_error:
@@ -1328,41 +1861,151 @@ static union raw_dirent * cache_direntry(struct bpb *fat_bpb,
     return ent;
 }
 
-static long next_write_cluster(struct bpb *fat_bpb, long oldcluster)
+/* get the cluster following 'cluster' in the file */
+static long file_next_cluster(struct bpb *fat_bpb,
+                              const struct fat_file *file, long cluster)
 {
-    DEBUGF("%s(old:%lx)\n", __func__, oldcluster);
-
-    long cluster = 0;
+#ifdef HAVE_EXFAT
+    /* the FAT means nothing for a file that is a single run */
+    if (file->contig)
+    {
+        return (unsigned long)(cluster - file->firstcluster + 1) <
+                    file->contig ? cluster + 1 : 0;
+    }
+#else
+    (void)file;
+#endif /* HAVE_EXFAT */
 
-    /* cluster already allocated? */
-    if (oldcluster)
-        cluster = get_next_cluster(fat_bpb, oldcluster);
+    return get_next_cluster(fat_bpb, cluster);
+}
 
-    if (!cluster)
+#ifdef HAVE_EXFAT
+/* free a run of clusters that has no FAT chain */
+static int free_cluster_run(struct bpb *fat_bpb, long startcluster,
+                            unsigned long count)
+{
+    for (unsigned long i = 0; i < count; i++)
     {
-        /* passed end of existing entries and now need to append */
-    #ifdef HAVE_FAT16SUPPORT
-        if (UNLIKELY(oldcluster < 0))
+        if (update_bitmap_ex(fat_bpb, startcluster + i, false) < 0)
+            return i ? 0 : -1;
+    }
+
+    return 1;
+}
+
+/* give a file that is a single run a FAT chain so it can grow elsewhere */
+static int exfat_chain_file(struct bpb *fat_bpb, struct fat_file *file)
+{
+    long cluster = file->firstcluster;
+
+    for (unsigned long i = 1; i <= file->contig; i++, cluster++)
+    {
+        int rc = update_fat_entry(fat_bpb, cluster,
+                    i < file->contig ? cluster + 1 : FAT_EOF_MARK);
+        if (rc < 0)
+            return rc;
+    }
+
+    file->contig = 0;
+    return 0;
+}
+
+/* allocate the cluster after 'oldcluster'; a new file starts out as a run
+   without a FAT chain and stays that way for as long as the cluster right
+   after its end is free */
+static long next_write_cluster_ex(struct bpb *fat_bpb, struct fat_file *file,
+                                  long oldcluster)
+{
+    long cluster;
+
+    if (!oldcluster)
+    {
+        cluster = find_free_cluster(fat_bpb, fat_bpb->fsinfo.nextfree);
+        if (cluster && update_bitmap_ex(fat_bpb, cluster, true) >= 0)
+        {
+            file->contig = 1;
+            return cluster;
+        }
+
+        return 0;
+    }
+
+    if (file->contig)
+    {
+        cluster = oldcluster + 1;
+        if ((unsigned long)cluster <= fat_bpb->dataclusters + 1 &&
+            test_bitmap_ex(fat_bpb, cluster, NULL) == 0)
+        {
+            if (update_bitmap_ex(fat_bpb, cluster, true) < 0)
+                return 0;
+
+            file->contig++;
+            fat_bpb->fsinfo.nextfree = cluster + 1;
+            return cluster;
+        }
+
+        if (exfat_chain_file(fat_bpb, file) < 0)
+            return 0;
+    }
+
+    cluster = find_free_cluster(fat_bpb, oldcluster + 1);
+    if (cluster)
+    {
+        /* create the cluster chain */
+        update_fat_entry(fat_bpb, oldcluster, cluster);
+        update_fat_entry(fat_bpb, cluster, FAT_EOF_MARK);
+    }
+
+    return cluster;
+}
+#endif /* HAVE_EXFAT */
+
+static long next_write_cluster(struct bpb *fat_bpb, struct fat_file *file,
+                               long oldcluster)
+{
+    DEBUGF("%s(old:%lx)\n", __func__, oldcluster);
+
+    long cluster = 0;
+
+    /* cluster already allocated? */
+    if (oldcluster)
+        cluster = file_next_cluster(fat_bpb, file, oldcluster);
+
+    if (!cluster)
+    {
+        /* passed end of existing entries and now need to append */
+    #ifdef HAVE_FAT16SUPPORT
+        if (UNLIKELY(oldcluster < 0))
             return 0; /* negative, pseudo-cluster of the root dir */
                       /* impossible to append something to the root */
     #endif /* HAVE_FAT16SUPPORT */
 
         dc_lock_cache();
 
-        long findstart = oldcluster > 0 ?
-            oldcluster + 1 : (long)fat_bpb->fsinfo.nextfree;
+    #ifdef HAVE_EXFAT
+        if (fat_bpb->is_exfat)
+        {
+            cluster = next_write_cluster_ex(fat_bpb, file, oldcluster);
+        }
+        else
+    #endif /* HAVE_EXFAT */
+        {
+            long findstart = oldcluster > 0 ?
+                oldcluster + 1 : (long)fat_bpb->fsinfo.nextfree;
 
-        cluster = find_free_cluster(fat_bpb, findstart);
+            cluster = find_free_cluster(fat_bpb, findstart);
 
-        if (cluster)
-        {
-            /* create the cluster chain */
-            if (oldcluster)
-                update_fat_entry(fat_bpb, oldcluster, cluster);
+            if (cluster)
+            {
+                /* create the cluster chain */
+                if (oldcluster)
+                    update_fat_entry(fat_bpb, oldcluster, cluster);
 
-            update_fat_entry(fat_bpb, cluster, FAT_EOF_MARK);
+                update_fat_entry(fat_bpb, cluster, FAT_EOF_MARK);
+            }
         }
-        else
+
+        if (!cluster)
         {
         #ifdef TEST_FAT
             if (fat_bpb->fsinfo.freecount > 0)
@@ -1387,7 +2030,7 @@ static int fat_extend_dir(struct bpb *fat_bpb, struct fat_filestr *dirstr)
     int rc;
 
     long cluster    = dirstr->lastcluster;
-    long newcluster = next_write_cluster(fat_bpb, cluster);
+    long newcluster = next_write_cluster(fat_bpb, dirstr->fatfilep, cluster);
 
     if (!newcluster)
     {
@@ -1430,6 +2073,19 @@ static int fat_extend_dir(struct bpb *fat_bpb, struct fat_filestr *dirstr)
     dirstr->sectornum   = sector - startsector;
     dirstr->eof         = false;
 
+#ifdef HAVE_EXFAT
+    /* an exFAT directory's size and chain type are in its entry */
+    if (fat_bpb->is_exfat && dirstr->fatfilep->dircluster)
+    {
+        rc = exfat_update_entry(fat_bpb, dirstr->fatfilep,
+                                (dirstr->clusternum + 1) *
+                                    fat_bpb->bpb_secperclus * SECTOR_SIZE,
+                                NULL, false);
+        if (rc < 0)
+            FAT_ERROR(rc * 10 - 3);
+    }
+#endif /* HAVE_EXFAT */
+
     rc = 0;
 fat_error:
     return rc;
@@ -1445,6 +2101,11 @@ static void fat_open_internal(IF_MV(int volume,) long startcluster,
     file->dircluster   = 0;
     file->e.entry      = 0;
     file->e.entries    = 0;
+    file->chainver     = 0;
+#ifdef HAVE_EXFAT
+    file->contig       = 0;
+    file->dircontig    = 0;
+#endif
 }
 
 #if CONFIG_RTC
@@ -1805,36 +2466,647 @@ static int add_dir_entry(struct bpb *fat_bpb, struct fat_filestr *parentstr,
             DEBUGF("Directory would be too large.\n");
             FAT_ERROR(-4);
         }
-
-        while (entries_found < entries_needed)
+
+        while (entries_found < entries_needed)
+        {
+            rc = fat_extend_dir(fat_bpb, parentstr);
+            if (rc == FAT_RC_ENOSPC)
+                FAT_ERROR(RC);
+            else if (rc < 0)
+                FAT_ERROR(rc * 10 - 5);
+
+            entries_found += entperclus;
+            entry += entperclus;
+        }
+
+        firstentry = entry - entries_found;
+    }
+
+    /* remember the parent directory entry information */
+#ifdef HAVE_MULTIVOLUME
+    file->volume     = parentstr->fatfilep->volume;
+#endif
+    file->dircluster = parentstr->fatfilep->firstcluster;
+    file->e.entry    = firstentry + entries_needed - 1;
+    file->e.entries  = entries_needed;
+
+    /* step 3: add entry */
+    DEBUGF("Adding longname to entry %d\n", firstentry);
+    rc = write_longname(fat_bpb, parentstr, file, name, ucslen,
+                        shortname, srcent, attr, flags);
+    if (rc < 0)
+        FAT_ERROR(rc * 10 - 6);
+
+    DEBUGF("Added new dir entry %u; using %u entries\n",
+           file->e.entry, file->e.entries);
+
+    rc = 0;
+fat_error:
+    return rc;
+}
+
+/* open the directory that holds the file's entries */
+static void fat_open_parent(const struct fat_file *file,
+                            struct fat_file *parent)
+{
+    fat_open_internal(IF_MV(file->volume,) file->dircluster, parent);
+#ifdef HAVE_EXFAT
+    parent->contig = file->dircontig;
+#endif
+}
+
+#ifdef HAVE_EXFAT
+/* add one entry to the checksum of an entry set; the checksum field itself
+   in the first (primary) entry isn't included */
+static uint16_t exfat_entry_checksum(uint16_t chksum,
+                                     const union raw_dirent *ent,
+                                     bool primary)
+{
+    for (unsigned int i = 0; i < DIR_ENTRY_SIZE; i++)
+    {
+        if (primary && (i == 2 || i == 3))
+            continue;
+
+        chksum = ((chksum & 1) ? 0x8000 : 0) + (chksum >> 1) + ent->data[i];
+    }
+
+    return chksum;
+}
+
+/* decode the start of the volume's up-case table, which covers the names
+   seen in practice, so that those characters don't need a walk through it;
+   the table is compressed with runs of unchanged characters coded as 0xffff,
+   length */
+static void exfat_load_upcase(struct bpb *fat_bpb)
+{
+    const unsigned int entpersec = SECTOR_SIZE / 2;
+    uint16_t *sec = NULL;
+    unsigned long index = 0; /* character the next value is for */
+    bool run = false;
+
+    for (unsigned int c = 0; c < EXFAT_UPCASE_CACHED; c++)
+        fat_bpb->upcase[c] = c;
+
+    dc_lock_cache();
+
+    for (unsigned long i = 0;
+         i < fat_bpb->upcasesize / 2 && index < EXFAT_UPCASE_CACHED; i++)
+    {
+        if (!(i % entpersec))
+        {
+            sec = cache_sector(fat_bpb, fat_bpb->upcasesector + i / entpersec);
+            if (!sec)
+                break;
+        }
+
+        uint16_t val = letoh16(sec[i % entpersec]);
+
+        if (run)
+        {
+            index += val;
+            run = false;
+        }
+        else if (val == 0xffff)
+        {
+            run = true;
+        }
+        else
+        {
+            fat_bpb->upcase[index++] = val;
+        }
+    }
+
+    dc_unlock_cache();
+}
+
+/* map a character to upper case with the volume's up-case table */
+static uint16_t exfat_upcase(struct bpb *fat_bpb, uint16_t ucs)
+{
+    if (ucs < EXFAT_UPCASE_CACHED)
+        return fat_bpb->upcase[ucs];
+
+    /* beyond the decoded part; walk the table */
+    const unsigned int entpersec = SECTOR_SIZE / 2;
+    uint16_t *sec = NULL;
+    unsigned long index = 0; /* character the next value is for */
+    bool run = false;
+
+    for (unsigned long i = 0; i < fat_bpb->upcasesize / 2; i++)
+    {
+        if (!sec || !(i % entpersec))
+        {
+            sec = cache_sector(fat_bpb, fat_bpb->upcasesector + i / entpersec);
+            if (!sec)
+                break;
+        }
+
+        uint16_t val = letoh16(sec[i % entpersec]);
+
+        if (run)
+        {
+            index += val;
+            run = false;
+        }
+        else if (val == 0xffff)
+        {
+            run = true;
+        }
+        else if (index++ == ucs)
+        {
+            return val;
+        }
+
+        if (index > ucs)
+            break; /* inside a run of unchanged characters */
+    }
+
+    return ucs;
+}
+
+/* the name hash lets lookups skip sets without comparing the name */
+static uint16_t exfat_name_hash(struct bpb *fat_bpb, const uint16_t *ucsname,
+                                unsigned long ucslen)
+{
+    uint16_t hash = 0;
+
+    dc_lock_cache();
+
+    for (unsigned long i = 0; i < ucslen; i++)
+    {
+        uint16_t ucs = exfat_upcase(fat_bpb, ucsname[i]);
+        hash = ((hash & 1) ? 0x8000 : 0) + (hash >> 1) + (ucs & 0xff);
+        hash = ((hash & 1) ? 0x8000 : 0) + (hash >> 1) + (ucs >> 8);
+    }
+
+    dc_unlock_cache();
+    return hash;
+}
+
+/* return the length in clusters of the run described by a stream extension
+   entry or 0 if it has a FAT chain */
+static unsigned long exfat_stream_contig(struct bpb *fat_bpb,
+                                         const union raw_dirent *ent)
+{
+    if (!(ent->xs_flags & EXFAT_STREAM_NOFATCHAIN) || !ent->xs_fstclus)
+        return 0;
+
+    unsigned int shift = find_first_set_bit(fat_bpb->bpb_secperclus *
+                                            SECTOR_SIZE);
+    uint32_t hi = letoh32(ent->xs_datalen[1]);
+    uint32_t lo = letoh32(ent->xs_datalen[0]);
+    unsigned long count = (hi << (32 - shift)) | (lo >> shift);
+
+    if (lo & ((1ul << shift) - 1))
+        count++;
+
+    /* a run has at least the cluster that it starts with */
+    return count ? count : 1;
+}
+
+static void exfat_parse_file(const union raw_dirent *ent,
+                             struct fat_direntry *fatent)
+{
+    uint32_t crtts = letoh32(ent->xf_crtts);
+    uint32_t wrtts = letoh32(ent->xf_wrtts);
+
+    fatent->shortname[0] = '\0';
+    fatent->attr         = letoh16(ent->xf_attr) & EXFAT_ATTR_MASK;
+    fatent->crttimetenth = ent->xf_crt10ms;
+    fatent->crttime      = crtts & 0xffff;
+    fatent->crtdate      = crtts >> 16;
+    fatent->lstaccdate   = letoh32(ent->xf_accts) >> 16;
+    fatent->wrttime      = wrtts & 0xffff;
+    fatent->wrtdate      = wrtts >> 16;
+}
+
+static void exfat_parse_stream(const union raw_dirent *ent,
+                               struct fat_direntry *fatent)
+{
+    fatent->firstcluster = letoh32(ent->xs_fstclus);
+
+    if (fatent->attr & ATTR_DIRECTORY)
+        fatent->filesize = 0;
+    else if (ent->xs_datalen[1])
+        fatent->filesize = FAT_MAX_FILE_SIZE; /* what we can reach of it */
+    else
+        fatent->filesize = letoh32(ent->xs_datalen[0]);
+}
+
+/* gather an entry set while reading a directory; returns true once the
+   set is complete and good and the name converted to UTF-8 */
+static bool exfat_parse_entry(struct exfat_parse_state *xparse,
+                              const union raw_dirent *ent,
+                              struct fat_direntry *fatent)
+{
+    uint8_t type = ent->data[0];
+
+    if (!(type & EXFAT_ENT_SECONDARY))
+    {
+        /* primary entry; only a file entry is of interest */
+        xparse->secondaries = 0;
+
+        if (type != EXFAT_ENT_FILE || ent->xf_seccount < 2 ||
+            ent->xf_seccount > EXFAT_MAX_SECONDARIES)
+            return false;
+
+        xparse->secondaries = ent->xf_seccount;
+        xparse->entries     = ent->xf_seccount + 1;
+        xparse->setchksum   = letoh16(ent->xf_chksum);
+        xparse->chksum      = exfat_entry_checksum(0, ent, true);
+        xparse->namelen     = 0;
+        exfat_parse_file(ent, fatent);
+        return false;
+    }
+
+    if (!xparse->secondaries)
+        return false; /* not part of a file's set */
+
+    xparse->chksum = exfat_entry_checksum(xparse->chksum, ent, false);
+
+    uint16_t *ucsp = fatent->ucssegs[5];
+
+    if (xparse->secondaries == xparse->entries - 1)
+    {
+        /* the stream extension must come first */
+        if (type != EXFAT_ENT_STREAM || !ent->xs_namelen)
+        {
+            xparse->secondaries = 0;
+            return false;
+        }
+
+        xparse->namelen   = ent->xs_namelen;
+        xparse->namechars = 0;
+        exfat_parse_stream(ent, fatent);
+    }
+    else if (type == EXFAT_ENT_NAME)
+    {
+        for (unsigned int i = 0; i < EXFAT_NAME_CHARS &&
+                xparse->namechars < xparse->namelen; i++)
+        {
+            ucsp[xparse->namechars++] = letoh16(ent->xn_name[i]);
+        }
+    }
+    /* else some other secondary that only counts for the checksum */
+
+    if (--xparse->secondaries)
+        return false;
+
+    if (xparse->chksum != xparse->setchksum ||
+        xparse->namechars != xparse->namelen)
+    {
+        DEBUGF("%s() - Bad entry set\n", __func__);
+        return false;
+    }
+
+    /* set is good so convert the name to UTF-8 */
+    unsigned char * const name = fatent->name;
+    unsigned char *p = name;
+
+    ucsp[xparse->namelen] = 0x0000;
+
+    for (uint16_t ucc = *ucsp; ucc; ucc = *++ucsp)
+    {
+        if ((p = utf8encode(ucc, p)) - name > FAT_DIRENTRY_NAME_MAX)
+            return false; /* won't fit */
+    }
+
+    *p = '\0';
+    return true;
+}
+
+/* write the size, first cluster and chain type of the file into its entry
+   set and, if asked, the time of writing too */
+static int exfat_update_entry(struct bpb *fat_bpb, struct fat_file *file,
+                              uint32_t size, struct fat_direntry *fatent,
+                              bool settime)
+{
+    DEBUGF("%s(cluster:%lx entry:%d size:%ld)\n",
+           __func__, file->firstcluster, file->e.entry, size);
+
+    int rc;
+    union raw_dirent *ent;
+
+    struct fat_file parent;
+    fat_open_parent(file, &parent);
+
+    struct fat_filestr parentstr;
+    fat_filestr_init(&parentstr, &parent);
+
+    const unsigned int firstentry = file->e.entry - file->e.entries + 1;
+
+    dc_lock_cache();
+
+    /* stream extension first; it decides if this may be done at all */
+    ent = cache_direntry(fat_bpb, &parentstr, firstentry + 1);
+    if (!ent)
+        FAT_ERROR(-1);
+
+    if (ent->xs_type != EXFAT_ENT_STREAM)
+        panicf("Updating size on bad dir entry %d\n", firstentry + 1);
+
+    if (ent->xs_datalen[1])
+    {
+        DEBUGF("File of 4GiB or more is read-only\n");
+        FAT_ERROR(-2);
+    }
+
+    ent->xs_flags = EXFAT_STREAM_ALLOC |
+                    (file->contig ? EXFAT_STREAM_NOFATCHAIN : 0);
+    ent->xs_fstclus     = htole32(file->firstcluster);
+    ent->xs_validlen[0] = htole32(size);
+    ent->xs_validlen[1] = 0;
+    ent->xs_datalen[0]  = htole32(size);
+    ent->xs_datalen[1]  = 0;
+
+    dc_dirty_buf(ent);
+
+    ent = cache_direntry(fat_bpb, &parentstr, firstentry);
+    if (!ent)
+        FAT_ERROR(-3);
+
+    if (ent->xf_type != EXFAT_ENT_FILE)
+        panicf("Updating size on bad dir entry %d\n", firstentry);
+
+    if (settime)
+    {
+        uint32_t ts = letoh32(ent->xf_wrtts);
+        uint16_t date = ts >> 16, time = ts;
+        fat_time(&date, &time, NULL);
+        ts = htole32(((uint32_t)date << 16) | time);
+
+        ent->xf_wrtts    = ts;
+        ent->xf_accts    = ts;
+        ent->xf_wrt10ms  = 0;
+    }
+
+    if (fatent)
+    {
+        fatent->name[0] = '\0'; /* not gonna bother here */
+        exfat_parse_file(ent, fatent);
+    }
+
+    uint16_t chksum = exfat_entry_checksum(0, ent, true);
+
+    for (unsigned int i = 1; i < file->e.entries; i++)
+    {
+        ent = cache_direntry(fat_bpb, &parentstr, firstentry + i);
+        if (!ent)
+            FAT_ERROR(-4);
+
+        if (i == 1 && fatent)
+            exfat_parse_stream(ent, fatent);
+
+        chksum = exfat_entry_checksum(chksum, ent, false);
+    }
+
+    ent = cache_direntry(fat_bpb, &parentstr, firstentry);
+    if (!ent)
+        FAT_ERROR(-5);
+
+    ent->xf_chksum = htole16(chksum);
+    dc_dirty_buf(ent);
+
+    rc = 0;
+fat_error:
+    dc_unlock_cache();
+    return rc;
+}
+
+/* add an exFAT entry set; 'tmpl' holds the file and stream extension entries
+   to copy with DIRENT_TEMPL_* and receives the new ones with DIRENT_RETURN */
+static int add_dir_entry_ex(struct bpb *fat_bpb, struct fat_filestr *parentstr,
+                            struct fat_file *file, const char *name,
+                            union raw_dirent *tmpl, uint8_t attr,
+                            unsigned int flags)
+{
+    DEBUGF("%s(name:\"%s\",first:%lx)\n", __func__, name,
+           file->firstcluster);
+
+    int rc;
+    union raw_dirent *ent;
+
+    rc = check_longname(name);
+    if (rc < 0)
+        FAT_ERROR(rc * 10 - 1); /* filename is invalid */
+
+    unsigned long ucslen = utf8length(name);
+    if (ucslen > 255)
+        FAT_ERROR(-2); /* name is too long */
+
+    uint16_t ucsname[255];
+    for (unsigned long i = 0; i < ucslen; i++)
+        name = utf8decode(name, &ucsname[i]);
+
+    /* file, stream extension and one name entry for every 15 characters */
+    const int entries_needed = (ucslen + EXFAT_NAME_CHARS - 1)
+                                    / EXFAT_NAME_CHARS + 2;
+
+    int entry = 0, entries_found = 0, firstentry = -1;
+    const int entperclus = DIR_ENTRIES_PER_SECTOR*fat_bpb->bpb_secperclus;
+
+    /* step 1: search for a sufficiently-long run of free entries */
+    dc_lock_cache();
+
+    while (firstentry < 0)
+    {
+        ent = cache_direntry(fat_bpb, parentstr, entry);
+
+        if (!ent)
+        {
+            if (parentstr->eof)
+            {
+                DEBUGF("End of dir (entry %d)\n", entry);
+                break;
+            }
+
+            DEBUGF("Couldn't read dir (entry %d)\n", entry);
+            dc_unlock_cache();
+            FAT_ERROR(-3);
+        }
+
+        uint8_t type = ent->data[0];
+
+        if (type & EXFAT_ENT_INUSE)
+        {
+            entries_found = 0;
+            entry++;
+            continue;
+        }
+
+        if (type == 0)
+        {
+            /* all remaining entries in cluster are free */
+            int found = entperclus - (entry % entperclus);
+            entries_found += found;
+            entry += found;
+        }
+        else
+        {
+            entries_found++;
+            entry++;
+        }
+
+        if (entries_found >= entries_needed)
+            firstentry = entry - entries_found;
+        else if (type == 0)
+            break;
+    }
+
+    dc_unlock_cache();
+
+    /* step 2: extend the dir if necessary */
+    if (firstentry < 0)
+    {
+        DEBUGF("Adding new cluster(s) to dir\n");
+
+        if (entry + entries_needed - entries_found > MAX_DIRENTRIES)
+        {
+            DEBUGF("Directory would be too large.\n");
+            FAT_ERROR(-4);
+        }
+
+        while (entries_found < entries_needed)
+        {
+            rc = fat_extend_dir(fat_bpb, parentstr);
+            if (rc == FAT_RC_ENOSPC)
+                FAT_ERROR(RC);
+            else if (rc < 0)
+                FAT_ERROR(rc * 10 - 5);
+
+            entries_found += entperclus;
+            entry += entperclus;
+        }
+
+        firstentry = entry - entries_found;
+    }
+
+    /* remember the parent directory entry information */
+#ifdef HAVE_MULTIVOLUME
+    file->volume     = parentstr->fatfilep->volume;
+#endif
+    file->dircluster = parentstr->fatfilep->firstcluster;
+    file->dircontig  = parentstr->fatfilep->contig;
+    file->e.entry    = firstentry + entries_needed - 1;
+    file->e.entries  = entries_needed;
+
+    /* step 3: build the file and stream extension entries */
+    union raw_dirent fileent, streament;
+    uint16_t namehash = exfat_name_hash(fat_bpb, ucsname, ucslen);
+    const bool usetmpl = tmpl && (flags & DIRENT_TEMPL);
+
+    uint16_t date = 0, time = 0;
+    int16_t tenth = 0;
+    fat_time(&date, &time, &tenth);
+    uint32_t ts = htole32(((uint32_t)date << 16) | time);
+
+    if (usetmpl)
+    {
+        fileent   = tmpl[0];
+        streament = tmpl[1];
+    }
+    else
+    {
+        memset(&fileent, 0, sizeof (fileent));
+        memset(&streament, 0, sizeof (streament));
+        fileent.xf_attr = htole16(attr & EXFAT_ATTR_MASK);
+
+        /* a new directory already has its first cluster */
+        unsigned long size = file->contig * fat_bpb->bpb_secperclus *
+                             SECTOR_SIZE;
+        streament.xs_validlen[0] = htole32(size);
+        streament.xs_datalen[0]  = htole32(size);
+        streament.xs_flags = EXFAT_STREAM_ALLOC |
+                             (file->contig ? EXFAT_STREAM_NOFATCHAIN : 0);
+    }
+
+    fileent.xf_type     = EXFAT_ENT_FILE;
+    fileent.xf_seccount = entries_needed - 1;
+
+    if (!usetmpl || !(flags & DIRENT_TEMPL_CRT))
+    {
+        fileent.xf_crtts   = ts;
+        fileent.xf_crt10ms = tenth;
+    }
+
+    if (!usetmpl || !(flags & DIRENT_TEMPL_WRT))
+    {
+        fileent.xf_wrtts   = ts;
+        fileent.xf_wrt10ms = tenth;
+    }
+
+    if (!usetmpl || !(flags & DIRENT_TEMPL_ACC))
+        fileent.xf_accts = ts;
+
+    streament.xs_type     = EXFAT_ENT_STREAM;
+    streament.xs_namelen  = ucslen;
+    streament.xs_namehash = htole16(namehash);
+    streament.xs_fstclus  = htole32(file->firstcluster);
+
+    uint16_t chksum = exfat_entry_checksum(0, &fileent, true);
+    chksum = exfat_entry_checksum(chksum, &streament, false);
+
+    /* step 4: write the secondary entries, then the file entry that makes
+       the set valid */
+    dc_lock_cache();
+
+    for (int i = 1; i < entries_needed; i++)
+    {
+        ent = cache_direntry(fat_bpb, parentstr, firstentry + i);
+        if (!ent)
+        {
+            dc_unlock_cache();
+            FAT_ERROR(-6);
+        }
+
+        if (ent->data[0] & EXFAT_ENT_INUSE)
+        {
+            panicf("Dir entry %d in sector %x is not free! "
+                   "%02x %02x %02x %02x",
+                   firstentry + i, (unsigned)parentstr->lastsector,
+                   (unsigned)ent->data[0], (unsigned)ent->data[1],
+                   (unsigned)ent->data[2], (unsigned)ent->data[3]);
+        }
+
+        if (i == 1)
+        {
+            *ent = streament;
+        }
+        else
         {
-            rc = fat_extend_dir(fat_bpb, parentstr);
-            if (rc == FAT_RC_ENOSPC)
-                FAT_ERROR(RC);
-            else if (rc < 0)
-                FAT_ERROR(rc * 10 - 5);
+            memset(ent->data, 0, DIR_ENTRY_SIZE);
+            ent->xn_type = EXFAT_ENT_NAME;
 
-            entries_found += entperclus;
-            entry += entperclus;
+            unsigned long c = (i - 2) * EXFAT_NAME_CHARS;
+            for (unsigned int j = 0; j < EXFAT_NAME_CHARS && c < ucslen;
+                 j++, c++)
+            {
+                ent->xn_name[j] = htole16(ucsname[c]);
+            }
+
+            chksum = exfat_entry_checksum(chksum, ent, false);
         }
 
-        firstentry = entry - entries_found;
+        dc_dirty_buf(ent);
     }
 
-    /* remember the parent directory entry information */
-#ifdef HAVE_MULTIVOLUME
-    file->volume     = parentstr->fatfilep->volume;
-#endif
-    file->dircluster = parentstr->fatfilep->firstcluster;
-    file->e.entry    = firstentry + entries_needed - 1;
-    file->e.entries  = entries_needed;
+    ent = cache_direntry(fat_bpb, parentstr, firstentry);
+    if (!ent)
+    {
+        dc_unlock_cache();
+        FAT_ERROR(-7);
+    }
 
-    /* step 3: add entry */
-    DEBUGF("Adding longname to entry %d\n", firstentry);
-    rc = write_longname(fat_bpb, parentstr, file, name, ucslen,
-                        shortname, srcent, attr, flags);
-    if (rc < 0)
-        FAT_ERROR(rc * 10 - 6);
+    fileent.xf_chksum = htole16(chksum);
+    *ent = fileent;
+    dc_dirty_buf(ent);
+    dc_unlock_cache();
+
+    if (tmpl && (flags & DIRENT_RETURN))
+    {
+        /* caller wants */
+        tmpl[0] = fileent;
+        tmpl[1] = streament;
+    }
 
     DEBUGF("Added new dir entry %u; using %u entries\n",
            file->e.entry, file->e.entries);
@@ -1843,6 +3115,7 @@ static int add_dir_entry(struct bpb *fat_bpb, struct fat_filestr *parentstr,
 fat_error:
     return rc;
 }
+#endif /* HAVE_EXFAT */
 
 static int update_short_entry(struct bpb *fat_bpb, struct fat_file *file,
                               uint32_t size, struct fat_direntry *fatent)
@@ -1866,7 +3139,7 @@ static int update_short_entry(struct bpb *fat_bpb, struct fat_file *file,
 
     /* open the parent directory */
     struct fat_file parent;
-    fat_open_internal(IF_MV(file->volume,) file->dircluster, &parent);
+    fat_open_parent(file, &parent);
 
     struct fat_filestr parentstr;
     fat_filestr_init(&parentstr, &parent);
@@ -1907,7 +3180,7 @@ static int free_direntries(struct bpb *fat_bpb, struct fat_file *file)
 {
     /* open the parent directory */
     struct fat_file parent;
-    fat_open_internal(IF_MV(file->volume,) file->dircluster, &parent);
+    fat_open_parent(file, &parent);
 
     struct fat_filestr parentstr;
     fat_filestr_init(&parentstr, &parent);
@@ -1935,7 +3208,12 @@ static int free_direntries(struct bpb *fat_bpb, struct fat_file *file)
             return 0;
         }
 
-        ent->data[0] = 0xe5;
+    #ifdef HAVE_EXFAT
+        if (fat_bpb->is_exfat)
+            ent->data[0] &= ~EXFAT_ENT_INUSE;
+        else
+    #endif
+            ent->data[0] = 0xe5;
 
         dc_dirty_buf(ent);
         dc_unlock_cache();
@@ -1988,6 +3266,43 @@ int fat_create_file(struct fat_file *parent, const char *name,
 
     const bool isdir = attr & ATTR_DIRECTORY;
     unsigned int addflags = fatent ? DIRENT_RETURN : 0;
+
+#ifdef HAVE_EXFAT
+    if (fat_bpb->is_exfat)
+    {
+        union raw_dirent newents[2];
+
+        if (isdir)
+        {
+            /* no dot entries; the first cluster is simply empty */
+            struct fat_filestr dirstr;
+            fat_filestr_init(&dirstr, file);
+
+            rc = fat_extend_dir(fat_bpb, &dirstr);
+            if (rc == FAT_RC_ENOSPC)
+                FAT_ERROR(RC);
+            else if (rc < 0)
+                FAT_ERROR(rc * 10 - 2);
+        }
+
+        rc = add_dir_entry_ex(fat_bpb, &parentstr, file, name, newents,
+                              attr, addflags);
+        if (rc == FAT_RC_ENOSPC)
+            FAT_ERROR(RC);
+        else if (rc < 0)
+            FAT_ERROR(rc * 10 - 5);
+
+        if (fatent)
+        {
+            strcpy(fatent->name, name);
+            exfat_parse_file(&newents[0], fatent);
+            exfat_parse_stream(&newents[1], fatent);
+        }
+
+        FAT_ERROR(RC); /* rc == 0 */
+    }
+#endif /* HAVE_EXFAT */
+
     union raw_dirent *newentp = (isdir || fatent) ?
                                 alloca(sizeof (union raw_dirent)) : NULL;
 
@@ -2045,7 +3360,14 @@ int fat_create_file(struct fat_file *parent, const char *name,
     rc = 0;
 fat_error:
     if (rc < 0)
-        free_cluster_chain(fat_bpb, file->firstcluster);
+    {
+    #ifdef HAVE_EXFAT
+        if (file->contig)
+            free_cluster_run(fat_bpb, file->firstcluster, file->contig);
+        else
+    #endif
+            free_cluster_chain(fat_bpb, file->firstcluster);
+    }
 
     cache_commit(fat_bpb);
     return rc;
@@ -2093,6 +3415,33 @@ int fat_open(const struct fat_file *parent, long startcluster,
     file->firstcluster = startcluster;
     file->dircluster   = parent->firstcluster;
 
+#ifdef HAVE_EXFAT
+    file->contig       = 0;
+    file->dircontig    = parent->contig;
+
+    /* whether the clusters are a single run is kept in the stream extension
+       entry that follows the file entry */
+    if (fat_bpb->is_exfat && startcluster && file->e.entries >= 2)
+    {
+        struct fat_file dir = *parent;
+        struct fat_filestr dirstr;
+        fat_filestr_init(&dirstr, &dir);
+
+        dc_lock_cache();
+
+        union raw_dirent *ent = cache_direntry(fat_bpb, &dirstr,
+                                    file->e.entry - file->e.entries + 2);
+        if (ent && ent->xs_type == EXFAT_ENT_STREAM &&
+            letoh32(ent->xs_fstclus) == (uint32_t)startcluster)
+            file->contig = exfat_stream_contig(fat_bpb, ent);
+
+        dc_unlock_cache();
+
+        if (!ent)
+            return -3;
+    }
+#endif /* HAVE_EXFAT */
+
     return 0;
 }
 
@@ -2134,12 +3483,21 @@ int fat_remove(struct fat_file *file, enum fat_remove_op what)
     {
         /* mark all clusters in the chain as free */
         DEBUGF("Removing cluster chain: %lX\n", file->firstcluster);
-        rc = free_cluster_chain(fat_bpb, file->firstcluster);
+    #ifdef HAVE_EXFAT
+        if (file->contig)
+            rc = free_cluster_run(fat_bpb, file->firstcluster, file->contig);
+        else
+    #endif
+            rc = free_cluster_chain(fat_bpb, file->firstcluster);
         if (rc < 0)
             FAT_ERROR(rc * 10 - 4);
 
         /* at least the first cluster was freed */
         file->firstcluster = 0;
+        file->chainver++;
+    #ifdef HAVE_EXFAT
+        file->contig = 0;
+    #endif
 
         if (rc == 0)
             FAT_ERROR(-5);
@@ -2189,67 +3547,114 @@ int fat_rename(struct fat_file *parent, struct fat_file *file,
     struct fat_file dir;
     struct fat_filestr dirstr;
 
-    /* open old parent */
-    fat_open_internal(IF_MV(file->volume,) file->dircluster, &dir);
-    fat_filestr_init(&dirstr, &dir);
+#ifdef HAVE_EXFAT
+    if (fat_bpb->is_exfat)
+    {
+        /* open old parent */
+        fat_open_parent(file, &dir);
+        fat_filestr_init(&dirstr, &dir);
 
-    /* fetch a copy of the existing short entry */
-    dc_lock_cache();
+        /* fetch copies of the file and stream extension entries */
+        union raw_dirent rawents[2];
+        unsigned int firstentry = file->e.entry - file->e.entries + 1;
 
-    union raw_dirent *ent = cache_direntry(fat_bpb, &dirstr, file->e.entry);
-    if (!ent)
-    {
-        dc_unlock_cache();
-        FAT_ERROR(-5);
-    }
+        dc_lock_cache();
 
-    union raw_dirent rawent = *ent;
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            union raw_dirent *ent = cache_direntry(fat_bpb, &dirstr,
+                                                   firstentry + i);
+            if (!ent)
+            {
+                dc_unlock_cache();
+                FAT_ERROR(-5);
+            }
 
-    dc_unlock_cache();
+            rawents[i] = *ent;
+        }
 
-    /* create new name in new parent directory */
-    fat_filestr_init(&dirstr, parent);
-    rc = add_dir_entry(fat_bpb, &dirstr, &newfile, newname, &rawent,
-                       0, DIRENT_TEMPL_CRT | DIRENT_TEMPL_WRT);
-    if (rc == FAT_RC_ENOSPC)
-        FAT_ERROR(RC);
-    else if (rc < 0)
-        FAT_ERROR(rc * 10 - 6);
+        dc_unlock_cache();
 
-    /* if renaming a directory and it was a move, update the '..' entry to
-       keep it pointing to its parent directory */
-    if ((rawent.attr & ATTR_DIRECTORY) && newfile.dircluster != file->dircluster)
+        /* create new name in new parent directory; there is no ".." entry
+           to keep pointing to the parent */
+        fat_filestr_init(&dirstr, parent);
+        rc = add_dir_entry_ex(fat_bpb, &dirstr, &newfile, newname, rawents,
+                              0, DIRENT_TEMPL_CRT | DIRENT_TEMPL_WRT);
+        if (rc == FAT_RC_ENOSPC)
+            FAT_ERROR(RC);
+        else if (rc < 0)
+            FAT_ERROR(rc * 10 - 6);
+    }
+    else
+#endif /* HAVE_EXFAT */
     {
-        /* open the dir that was renamed */
-        fat_open_internal(IF_MV(newfile.volume,) newfile.firstcluster, &dir);
+        /* open old parent */
+        fat_open_parent(file, &dir);
         fat_filestr_init(&dirstr, &dir);
 
-        /* obtain dot-dot directory entry */
+        /* fetch a copy of the existing short entry */
         dc_lock_cache();
-        ent = cache_direntry(fat_bpb, &dirstr, 1);
+
+        union raw_dirent *ent = cache_direntry(fat_bpb, &dirstr,
+                                               file->e.entry);
         if (!ent)
         {
             dc_unlock_cache();
-            FAT_ERROR(-7);
+            FAT_ERROR(-5);
         }
 
-        if (strncmp("..         ", ent->name, 11))
+        union raw_dirent rawent = *ent;
+
+        dc_unlock_cache();
+
+        /* create new name in new parent directory */
+        fat_filestr_init(&dirstr, parent);
+        rc = add_dir_entry(fat_bpb, &dirstr, &newfile, newname, &rawent,
+                           0, DIRENT_TEMPL_CRT | DIRENT_TEMPL_WRT);
+        if (rc == FAT_RC_ENOSPC)
+            FAT_ERROR(RC);
+        else if (rc < 0)
+            FAT_ERROR(rc * 10 - 6);
+
+        /* if renaming a directory and it was a move, update the '..' entry
+           to keep it pointing to its parent directory */
+        if ((rawent.attr & ATTR_DIRECTORY) &&
+            newfile.dircluster != file->dircluster)
         {
-            /* .. entry must be second entry according to FAT spec (p.29) */
-            DEBUGF("Second dir entry is not double-dot!\n");
-            dc_unlock_cache();
-            FAT_ERROR(-8);
-        }
+            /* open the dir that was renamed */
+            fat_open_internal(IF_MV(newfile.volume,) newfile.firstcluster,
+                              &dir);
+            fat_filestr_init(&dirstr, &dir);
+
+            /* obtain dot-dot directory entry */
+            dc_lock_cache();
+            ent = cache_direntry(fat_bpb, &dirstr, 1);
+            if (!ent)
+            {
+                dc_unlock_cache();
+                FAT_ERROR(-7);
+            }
 
-        /* parent cluster is 0 if parent dir is the root - FAT spec (p.29) */
-        long parentcluster = 0;
-        if (parent->firstcluster != fat_bpb->bpb_rootclus)
-            parentcluster = parent->firstcluster;
+            if (strncmp("..         ", ent->name, 11))
+            {
+                /* .. entry must be second entry according to FAT spec
+                   (p.29) */
+                DEBUGF("Second dir entry is not double-dot!\n");
+                dc_unlock_cache();
+                FAT_ERROR(-8);
+            }
 
-        raw_dirent_set_fstclus(ent, parentcluster);
+            /* parent cluster is 0 if parent dir is the root
+               - FAT spec (p.29) */
+            long parentcluster = 0;
+            if (parent->firstcluster != fat_bpb->bpb_rootclus)
+                parentcluster = parent->firstcluster;
 
-        dc_dirty_buf(ent);
-        dc_unlock_cache();
+            raw_dirent_set_fstclus(ent, parentcluster);
+
+            dc_dirty_buf(ent);
+            dc_unlock_cache();
+        }
     }
 
     /* remove old name */
@@ -2291,9 +3696,41 @@ int fat_closewrite(struct fat_filestr *filestr, uint32_t size,
             FAT_ERROR(rc * 10 - 2);
 
         file->firstcluster = 0;
+        file->chainver++;
+    #ifdef HAVE_EXFAT
+        file->contig = 0;
+    #endif
         fat_rewind(filestr);
     }
 
+#ifdef HAVE_EXFAT
+    if (fat_bpb->is_exfat)
+    {
+        /* a run must be exactly as long as the data says */
+        unsigned long clusbytes = fat_bpb->bpb_secperclus * SECTOR_SIZE;
+        unsigned long need = size / clusbytes + (size % clusbytes ? 1 : 0);
+
+        if (file->contig > need)
+        {
+            free_cluster_run(fat_bpb, file->firstcluster + need,
+                             file->contig - need);
+            file->contig = need;
+            file->chainver++;
+        }
+
+        if (file->dircluster)
+        {
+            rc = exfat_update_entry(fat_bpb, file, size, fatentp, true);
+            if (rc < 0)
+                FAT_ERROR(rc * 10 - 3);
+        }
+        else if (fatentp)
+        {
+            fat_empty_fat_direntry(fatentp);
+        }
+    }
+    else
+#endif /* HAVE_EXFAT */
     if (file->dircluster)
     {
         rc = update_short_entry(fat_bpb, file, size, fatentp);
@@ -2310,7 +3747,7 @@ int fat_closewrite(struct fat_filestr *filestr, uint32_t size,
     {
         unsigned long count = 0;
         for (long next = file->firstcluster; next;
-             next = get_next_cluster(fat_bpb, next))
+             next = file_next_cluster(fat_bpb, file, next))
         {
             DEBUGF("cluster %ld: %lx\n", count, next);
             count++;
@@ -2350,6 +3787,84 @@ unsigned long fat_query_sectornum(const struct fat_filestr *filestr)
     return fat_bpb->bpb_secperclus*filestr->clusternum + filestr->sectornum + 1;
 }
 
+/* get the stream's extent map, starting it over if the chain was cut since it
+   was built */
+static struct fat_extmap * extmap_get(struct fat_filestr *filestr)
+{
+    struct fat_extmap *map = &filestr->extmap;
+    const struct fat_file *file = filestr->fatfilep;
+
+    if (map->chainver != file->chainver)
+    {
+        map->chainver    = file->chainver;
+        map->count       = 0;
+        map->numclusters = 0;
+    }
+
+    if (!map->count && file->firstcluster > 0)
+    {
+        /* the first cluster is always known */
+        map->ext[0].clusternum = 0;
+        map->ext[0].cluster    = file->firstcluster;
+        map->count       = 1;
+        map->numclusters = 1;
+    #ifdef HAVE_EXFAT
+        /* a file without a FAT chain is mapped by its first run alone */
+        if (file->contig)
+            map->numclusters = file->contig;
+    #endif
+    }
+
+    return map;
+}
+
+/* return cluster 'clusternum' of the file if it is mapped, else 0 */
+static long extmap_lookup(struct fat_filestr *filestr, long clusternum)
+{
+    struct fat_extmap *map = extmap_get(filestr);
+
+    if (clusternum < 0 || clusternum >= map->numclusters)
+        return 0;
+
+    /* find the last extent starting at or before clusternum */
+    unsigned int lo = 0, hi = map->count;
+    while (hi - lo > 1)
+    {
+        unsigned int mid = (lo + hi) / 2;
+        if (map->ext[mid].clusternum <= clusternum)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return map->ext[lo].cluster + clusternum - map->ext[lo].clusternum;
+}
+
+/* note that cluster 'clusternum' of the file is 'cluster'; only the cluster
+   right after the mapped ones extends the map */
+static void extmap_add(struct fat_filestr *filestr, long clusternum,
+                       long cluster)
+{
+    struct fat_extmap *map = extmap_get(filestr);
+
+    if (cluster <= 0 || !map->count || clusternum != map->numclusters)
+        return;
+
+    struct fat_extent *ext = &map->ext[map->count - 1];
+    if (ext->cluster + clusternum - ext->clusternum != cluster)
+    {
+        if (map->count >= FAT_MAX_EXTENTS)
+            return; /* full; the rest must be walked */
+
+        ext++;
+        ext->clusternum = clusternum;
+        ext->cluster    = cluster;
+        map->count++;
+    }
+
+    map->numclusters++;
+}
+
 /* helper for fat_readwrite */
 static long transfer(struct bpb *fat_bpb, unsigned long start, long count,
                      char *buf, bool write)
@@ -2435,7 +3950,7 @@ long fat_readwrite(struct fat_filestr *filestr, unsigned long sectorcount,
         if (write && !newcluster)
         {
             /* file is empty; try to allocate its first cluster */
-            newcluster = next_write_cluster(fat_bpb, 0);
+            newcluster = next_write_cluster(fat_bpb, file, 0);
             file->firstcluster = newcluster;
         }
 
@@ -2469,8 +3984,15 @@ long fat_readwrite(struct fat_filestr *filestr, unsigned long sectorcount,
         if (++sectornum >= fat_bpb->bpb_secperclus)
         {
             /* out of sectors in this cluster; get the next cluster */
-            long newcluster = write ? next_write_cluster(fat_bpb, cluster) :
-                                      get_next_cluster(fat_bpb, cluster);
+            long newcluster = extmap_lookup(filestr, clusternum + 1);
+            if (!newcluster)
+            {
+                newcluster = write ?
+                    next_write_cluster(fat_bpb, file, cluster) :
+                    file_next_cluster(fat_bpb, file, cluster);
+                extmap_add(filestr, clusternum + 1, newcluster);
+            }
+
             if (newcluster)
             {
                 cluster = newcluster;
@@ -2539,6 +4061,9 @@ void fat_rewind(struct fat_filestr *filestr)
     filestr->clusternum   = 0;
     filestr->sectornum    = FAT_FILE_RW_VAL;
     filestr->eof          = false;
+    filestr->extmap.chainver = filestr->fatfilep->chainver;
+    filestr->extmap.count    = 0;
+    filestr->extmap.numclusters = 0;
 }
 
 void fat_seek_to_stream(struct fat_filestr *filestr,
@@ -2586,18 +4111,31 @@ int fat_seek(struct fat_filestr *filestr, unsigned long seeksector)
         clusternum = seeksector / fat_bpb->bpb_secperclus;
         sectornum = seeksector % fat_bpb->bpb_secperclus;
 
-        long numclusters = clusternum;
+        long i = 0;
+        long mapped = extmap_lookup(filestr, clusternum);
 
-        if (filestr->clusternum && clusternum >= filestr->clusternum)
+        if (mapped)
+        {
+            cluster = mapped;
+            i = clusternum;
+        }
+        else if (filestr->extmap.numclusters > 1)
+        {
+            /* walk on from the last mapped cluster */
+            i = filestr->extmap.numclusters - 1;
+            cluster = extmap_lookup(filestr, i);
+        }
+
+        if (filestr->clusternum > i && clusternum >= filestr->clusternum)
         {
             /* seek forward from current position */
             cluster = filestr->lastcluster;
-            numclusters -= filestr->clusternum;
+            i = filestr->clusternum;
         }
 
-        for (long i = 0; i < numclusters; i++)
+        while (i < clusternum)
         {
-            cluster = get_next_cluster(fat_bpb, cluster);
+            cluster = file_next_cluster(fat_bpb, file, cluster);
 
             if (!cluster)
             {
@@ -2605,6 +4143,8 @@ int fat_seek(struct fat_filestr *filestr, unsigned long seeksector)
                        "(sector %lu, cluster %ld)\n", seeksector, i);
                 FAT_ERROR(FAT_SEEK_EOF);
             }
+
+            extmap_add(filestr, ++i, cluster);
         }
 
         sector = cluster2sec(fat_bpb, cluster) + sectornum;
@@ -2636,6 +4176,27 @@ int fat_truncate(const struct fat_filestr *filestr)
     long last = filestr->lastcluster;
     long next = 0;
 
+#ifdef HAVE_EXFAT
+    struct fat_file * const file = filestr->fatfilep;
+    if (file->contig)
+    {
+        /* the run just gets shorter */
+        unsigned long keep = last ? last - file->firstcluster + 1 : 0;
+
+        if (keep < file->contig)
+        {
+            int rc2 = free_cluster_run(fat_bpb, file->firstcluster + keep,
+                                       file->contig - keep);
+            file->contig = keep;
+            if (rc2 <= 0)
+                rc = 0;
+        }
+
+        file->chainver++;
+        return rc;
+    }
+#endif /* HAVE_EXFAT */
+
     /* truncate trailing clusters after the current position */
     if (last)
     {
@@ -2645,6 +4206,9 @@ int fat_truncate(const struct fat_filestr *filestr)
             FAT_ERROR(rc2 * 10 - 2);
     }
 
+    /* every stream's map may now reach past the end */
+    filestr->fatfilep->chainver++;
+
     int rc2 = free_cluster_chain(fat_bpb, next);
     if (rc2 <= 0)
     {
@@ -2670,6 +4234,13 @@ int fat_readdir(struct fat_filestr *dirstr, struct fat_dirscan_info *scan,
     struct fatlong_parse_state lnparse;
     fatlong_parse_start(&lnparse);
 
+#ifdef HAVE_EXFAT
+    /* exFAT entry sets hold names of up to 255 UTF-16 characters */
+    const bool exfat = FAT_BPB(dirstr->fatfilep->volume) &&
+                       FAT_BPB(dirstr->fatfilep->volume)->is_exfat;
+    struct exfat_parse_state xparse = { .secondaries = 0 };
+#endif /* HAVE_EXFAT */
+
     scan->entries = 0;
 
     while (1)
@@ -2712,6 +4283,26 @@ int fat_readdir(struct fat_filestr *dirstr, struct fat_dirscan_info *scan,
         if (ent->name[0] == 0)
             break;    /* last entry */
 
+    #ifdef HAVE_EXFAT
+        if (exfat)
+        {
+            if (!(ent->data[0] & EXFAT_ENT_INUSE))
+            {
+                xparse.secondaries = 0;
+                continue; /* free entry */
+            }
+
+            if (exfat_parse_entry(&xparse, ent, entry))
+            {
+                scan->entries = xparse.entries;
+                rc = 1;
+                break;
+            }
+
+            continue;
+        }
+    #endif /* HAVE_EXFAT */
+
         if (ent->name[0] == 0xe5)
         {
             scan->entries = 0;
@@ -2799,6 +4390,101 @@ bool fat_ismounted(IF_MV_NONVOID(int volume))
     return !!FAT_BPB(volume);
 }
 
+#ifdef HAVE_EXFAT
+/* returns the first sector of an allocation bitmap or up-case table if its
+   clusters are one run (chained or not), else 0 */
+static unsigned long exfat_table_sector(struct bpb *fat_bpb,
+                                        unsigned long cluster,
+                                        unsigned long bytes)
+{
+    unsigned long clusbytes = fat_bpb->bpb_secperclus * SECTOR_SIZE;
+    unsigned long count = (bytes + clusbytes - 1) / clusbytes;
+
+    if (!bytes || cluster < 2 || count > fat_bpb->dataclusters + 2 - cluster)
+        return 0;
+
+    /* a chain, if there is one, may not lead elsewhere */
+    for (unsigned long c = cluster; --count; c++)
+    {
+        long next = get_next_cluster_ex(fat_bpb, c);
+        if (!next)
+            break; /* not chained */
+
+        if ((unsigned long)next != c + 1)
+            return 0;
+    }
+
+    return cluster2sec(fat_bpb, cluster);
+}
+
+/* locate the allocation bitmap and up-case table in the root directory */
+static int exfat_find_tables(struct bpb *fat_bpb)
+{
+    struct fat_file dir;
+    struct fat_filestr dirstr;
+
+    fat_open_rootdir(IF_MV(fat_bpb->volume,) &dir);
+    fat_filestr_init(&dirstr, &dir);
+
+    fat_bpb->bitmapsector = 0;
+    fat_bpb->upcasesector = 0;
+
+    for (unsigned int i = 0;
+         !fat_bpb->bitmapsector || !fat_bpb->upcasesector; i++)
+    {
+        uint8_t type = 0, flags = 0;
+        unsigned long cluster = 0, bytes = 0;
+
+        dc_lock_cache();
+
+        union raw_dirent *ent = cache_direntry(fat_bpb, &dirstr, i);
+        if (ent)
+        {
+            type    = ent->xs_type;
+            flags   = ent->xs_flags;
+            cluster = letoh32(ent->xs_fstclus);
+            bytes   = ent->xs_datalen[1] ? 0 : letoh32(ent->xs_datalen[0]);
+        }
+
+        dc_unlock_cache();
+
+        if (type == 0)
+            break; /* end of dir or unreadable */
+
+        if (type == EXFAT_ENT_BITMAP && !(flags & 0x01) &&
+            !fat_bpb->bitmapsector)
+        {
+            /* first (and, without TexFAT, only) bitmap */
+            if (bytes < (fat_bpb->dataclusters + 7) / 8)
+                return -1;
+
+            fat_bpb->bitmapsector = exfat_table_sector(fat_bpb, cluster,
+                                                       bytes);
+            fat_bpb->bitmapsize   = (bytes + SECTOR_SIZE - 1) / SECTOR_SIZE;
+            if (!fat_bpb->bitmapsector)
+                return -2;
+        }
+        else if (type == EXFAT_ENT_UPCASE && !fat_bpb->upcasesector)
+        {
+            fat_bpb->upcasesector = exfat_table_sector(fat_bpb, cluster,
+                                                       bytes);
+            fat_bpb->upcasesize   = bytes & ~1ul;
+            if (!fat_bpb->upcasesector)
+                return -3;
+        }
+    }
+
+    if (!fat_bpb->bitmapsector || !fat_bpb->upcasesector)
+    {
+        DEBUGF("%s() - Missing bitmap or up-case table\n", __func__);
+        return -4;
+    }
+
+    exfat_load_upcase(fat_bpb);
+    return 0;
+}
+#endif /* HAVE_EXFAT */
+
 int fat_mount(IF_MV(int volume,) IF_MD(int drive,) unsigned long startsector)
 {
     int rc;
@@ -2823,6 +4509,32 @@ int fat_mount(IF_MV(int volume,) IF_MD(int drive,) unsigned long startsector)
     /* it worked */
     fat_bpb->mounted = true;
 
+    unsigned long mapsectors = fat_bpb->fatsize;
+
+#ifdef HAVE_EXFAT
+    if (fat_bpb->is_exfat)
+    {
+        rc = exfat_find_tables(fat_bpb);
+        if (rc < 0)
+        {
+            cache_discard(IF_MV(fat_bpb));
+            fat_bpb->mounted = false;
+            FAT_ERROR(rc * 10 - 3);
+        }
+
+        /* free clusters are tracked per bitmap sector instead */
+        mapsectors = fat_bpb->bitmapsize;
+        fat_bpb->fsinfo.freecount = 0xffffffff;
+    }
+#endif /* HAVE_EXFAT */
+
+    /* until the FAT has been looked at, any group may have free clusters */
+    fat_bpb->freemap_shift = 0;
+    while ((mapsectors - 1) >> fat_bpb->freemap_shift >= FAT_FREEMAP_GROUPS)
+        fat_bpb->freemap_shift++;
+
+    fat_freemap_set(&fat_bpb->freemap);
+
     /* calculate freecount if unset */
     if (fat_bpb->fsinfo.freecount == 0xffffffff)
         fat_recalc_free(IF_MV(fat_bpb->volume));
@@ -2878,6 +4590,17 @@ unsigned int fat_get_cluster_size(IF_MV_NONVOID(int volume))
     return size;
 }
 
+uint32_t fat_get_volume_id(IF_MV_NONVOID(int volume))
+{
+    uint32_t volid = 0;
+
+    struct bpb * const fat_bpb = FAT_BPB(volume);
+    if (fat_bpb)
+        volid = fat_bpb->bs_volid;
+
+    return volid;
+}
+
 void fat_recalc_free(IF_MV_NONVOID(int volume))
 {
     struct bpb * const fat_bpb = FAT_BPB(volume);
@@ -68,6 +68,7 @@ struct mp3entry* audio_next_track(void);
 bool audio_peek_track(struct mp3entry* id3, int offset);
 #ifdef HAVE_DISK_STORAGE
 void audio_set_buffer_margin(int seconds);
+void audio_set_prefetch_interval(int seconds);
 #endif
 void audio_error_clear(void);
 int audio_get_file_pos(void);
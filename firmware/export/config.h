@@ -908,6 +908,14 @@ Lyre prototype 1 */
 #define HAVE_PICTUREFLOW_INTEGRATION
 #endif
 
+/* SDXC cards come formatted exFAT. It costs about 9KB of code, which the
+ * 2MB players can't spare; bootloaders only need to read FAT. "make
+ * fat-check" in a simulator build tests it against disk images. */
+#if (CONFIG_STORAGE & STORAGE_SD) && (MEMORYSIZE >= 8) \
+    && !defined(BOOTLOADER) && !defined(__PCTOOL__) && !defined(APPLICATION)
+#define HAVE_EXFAT
+#endif
+
 #ifdef BOOTLOADER
 
 #ifdef HAVE_BOOTLOADER_USB_MODE
@@ -930,6 +938,14 @@ Lyre prototype 1 */
 #define HAVE_EXTENDED_MESSAGING_AND_NAME
 #define HAVE_WAKEUP_EXT_CB
 
+/* Trace of recent core buffer allocation events and fragmentation
+   figures, shown and exported from the debug menu; it records every alloc,
+   free, move and shrink, so only debug and profiling builds get it */
+#if (MEMORYSIZE >= 8) && (defined(DEBUG) || defined(RB_PROFILE)) && \
+    !defined(__PCTOOL__)
+#define HAVE_BUFLIB_TRACE
+#endif
+
 
 #if defined(ASSEMBLER_THREADS) \
     || defined(HAVE_WIN32_FIBER_THREADS) \
@@ -940,6 +956,12 @@ Lyre prototype 1 */
 #if (CONFIG_PLATFORM & PLATFORM_NATIVE)
 #define HAVE_PRIORITY_SCHEDULING
 #define HAVE_SCHEDULER_BOOSTCTRL
+/* Per-thread CPU time, wakeup latency and switch counts plus a trace of
+   recent scheduler events, shown in the debug menu; it adds bookkeeping to
+   every thread switch, so only debug and profiling builds get it */
+#if defined(DEBUG) || defined(RB_PROFILE)
+#define HAVE_THREAD_ACCOUNTING
+#endif
 #endif /* PLATFORM_NATIVE */
 
 
@@ -48,6 +48,19 @@
 #define FAT_MAX_TRANSFER_SIZE 256
 #endif
 
+/* number of runs of contiguous clusters each open stream remembers so that
+ * seeking needn't walk the FAT; a file with more fragments than this is
+ * mapped up to the last run that fits and walked beyond it */
+#ifndef FAT_MAX_EXTENTS
+#define FAT_MAX_EXTENTS 4
+#endif
+
+/* number of groups of FAT sectors per volume whose free state is tracked so
+ * free cluster searches can skip the full ones; each costs one bit */
+#ifndef FAT_FREEMAP_GROUPS
+#define FAT_FREEMAP_GROUPS 2048
+#endif
+
 /**
  ****************************************************************************/
 
@@ -108,6 +121,29 @@ struct fat_file
     long   firstcluster;        /* first cluster in file */
     long   dircluster;          /* first cluster of parent directory */
     struct fat_dirscan_info e;  /* entry information */
+    unsigned int chainver;      /* changes whenever the chain is cut */
+#ifdef HAVE_EXFAT
+    unsigned long contig;       /* exFAT: number of clusters if they are one
+                                   run without a FAT chain, else 0 */
+    unsigned long dircontig;    /* exFAT: the same for the parent dir */
+#endif
+};
+
+/* a run of contiguous clusters in a file's cluster chain; its length is
+   implied by where the next one starts */
+struct fat_extent
+{
+    long clusternum;            /* cluster number within the file */
+    long cluster;               /* first cluster of the run */
+};
+
+/* the file's cluster chain from its start, as far as it has been walked */
+struct fat_extmap
+{
+    unsigned int chainver;      /* fat_file chainver this is valid for */
+    unsigned int count;         /* number of extents used */
+    long numclusters;           /* number of clusters mapped */
+    struct fat_extent ext[FAT_MAX_EXTENTS];
 };
 
 /* this stores what was last accessed when read or writing a file's data */
@@ -119,6 +155,7 @@ struct fat_filestr
     long          clusternum;   /* cluster number of last access */
     unsigned long sectornum;    /* sector number within current cluster */
     bool          eof;          /* end-of-file reached */
+    struct fat_extmap extmap;   /* known extents of the cluster chain */
 };
 
 /** File entity functions **/
@@ -170,6 +207,7 @@ int fat_unmount(IF_MV_NONVOID(int volume));
 int fat_get_bytes_per_sector(IF_MV_NONVOID(int volume));
 #endif /* MAX_LOG_SECTOR_SIZE */
 unsigned int fat_get_cluster_size(IF_MV_NONVOID(int volume));
+uint32_t fat_get_volume_id(IF_MV_NONVOID(int volume));
 void fat_recalc_free(IF_MV_NONVOID(int volume));
 bool fat_size(IF_MV(int volume,) unsigned long *size, unsigned long *free);
 
@@ -30,6 +30,10 @@ extern void *lc_open(const char *filename, unsigned char *buf, size_t buf_size);
 #if (CONFIG_PLATFORM & PLATFORM_NATIVE)
 #include "system.h"
 
+/* like lc_open(), and size receives the number of bytes read from the file */
+extern void *lc_open_ex(const char *filename, unsigned char *buf,
+                        size_t buf_size, size_t *size);
+
 /* header is always at the beginning of the blob, and handle actually points
  * to the start of the blob (the header is there) */
 static inline void *lc_open_from_mem(void* addr, size_t blob_size)
@@ -118,5 +118,6 @@
 #define PLAYLIST_CONTROL_FILE   ROCKBOX_DIR "/.playlist_control"
 #define NVRAM_FILE              ROCKBOX_DIR "/nvram.bin"
 #define GLYPH_CACHE_FILE        ROCKBOX_DIR "/.glyphcache"
+#define ALBUMART_CACHE_DIR      ROCKBOX_DIR "/.albumart"
 
 #endif /* __PATHS_H__ */
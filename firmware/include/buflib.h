@@ -29,6 +29,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include "config.h"
 
 /* enable single block debugging */
 #define BUFLIB_DEBUG_BLOCK_SINGLE
@@ -46,6 +47,9 @@ union buflib_data
     uint32_t crc;                 /* checksum of this data to detect corruption */
 };
 
+/* Number of size classes of the free block index */
+#define BUFLIB_NUM_FREE_LISTS 16
+
 struct buflib_context
 {
     union buflib_data *handle_table;
@@ -53,6 +57,9 @@ struct buflib_context
     union buflib_data *last_handle;
     union buflib_data *buf_start;
     union buflib_data *alloc_end;
+    /* heads of the size-segregated free block lists, as offsets from
+     * buf_start (-1 if empty) so that they survive buffer shifts */
+    intptr_t free_lists[BUFLIB_NUM_FREE_LISTS];
     bool compact;
 };
 
@@ -175,6 +182,87 @@ size_t buflib_available(struct buflib_context *ctx);
  */
 size_t buflib_allocatable(struct buflib_context *ctx);
 
+/**
+ * Does a bounded part of a compaction: moves allocations towards the start
+ * of the pool, but never more than max_bytes in one call. Allocations larger
+ * than that are left for later steps or for the full compaction that runs
+ * when an allocation doesn't fit. The pool is consistent after each step,
+ * so the steps can be spread out, e.g. over the idle time of a thread.
+ *
+ * Note that the move callbacks are called as with any compaction.
+ *
+ * Returns: The number of bytes moved; 0 if nothing more can be done within
+ * the budget, and straight away if the pool has no holes.
+ */
+size_t buflib_compact_step(struct buflib_context *ctx, size_t max_bytes);
+
+/**
+ * Fragmentation of the free space of a context.
+ *
+ * The free space at the end of allocation counts as one free block.
+ */
+struct buflib_frag_stats
+{
+    size_t total_free;    /* bytes in all free blocks */
+    size_t largest_free;  /* bytes in the largest of them */
+    int    free_blocks;   /* number of free blocks */
+};
+
+void buflib_get_frag_stats(struct buflib_context *ctx,
+                           struct buflib_frag_stats *stats);
+
+#ifdef HAVE_BUFLIB_TRACE
+/**
+ * Allocation tracing: every alloc, free, move and shrink in the traced
+ * context is recorded into a ring of events and counted.
+ */
+#define BUFLIB_TRACE_SIZE     256 /* events; must be a power of 2 */
+#define BUFLIB_TRACE_NAME_LEN 12
+
+enum buflib_trace_type
+{
+    BUFLIB_TRACE_ALLOC = 0, /* offset/size of the new block */
+    BUFLIB_TRACE_FREE,      /* offset/size of the freed block */
+    BUFLIB_TRACE_MOVE,      /* new offset, from: old offset */
+    BUFLIB_TRACE_SHRINK,    /* new offset/size */
+    BUFLIB_TRACE_FAIL,      /* size that could not be allocated */
+    BUFLIB_TRACE_COMPACT,   /* size: bytes gained by a full compaction */
+};
+
+struct buflib_trace_event
+{
+    uint32_t time;          /* current_tick */
+    int32_t  offset;        /* bytes from the start of the buffer */
+    int32_t  size;          /* block size in bytes, metadata included */
+    int32_t  from;          /* type specific */
+    int16_t  handle;
+    uint8_t  type;          /* BUFLIB_TRACE_* */
+    char     name[BUFLIB_TRACE_NAME_LEN + 1]; /* may be truncated */
+};
+
+struct buflib_trace
+{
+    unsigned int pos;       /* next event position (wraps) */
+    uint32_t allocs, frees, moves, shrinks, fails, compactions;
+    uint32_t move_bytes;
+    struct buflib_trace_event events[BUFLIB_TRACE_SIZE];
+};
+
+/**
+ * Starts recording the events of ctx into trace, or stops tracing if trace
+ * is NULL. Only one context is traced at a time.
+ */
+void buflib_trace_enable(struct buflib_context *ctx,
+                         struct buflib_trace *trace);
+
+/**
+ * Copies up to count of the latest events, oldest first.
+ *
+ * Returns: The number of events copied
+ */
+int buflib_get_trace(struct buflib_trace_event *events, int count);
+#endif /* HAVE_BUFLIB_TRACE */
+
 /**
  * Relocates the fields in *ctx to the new buffer position pointed to by buf.
  * This does _not_ move any data but updates the pointers. The data has
@@ -17,6 +17,13 @@ bool core_shrink(int handle, void* new_start, size_t new_size);
 int core_free(int handle);
 size_t core_available(void);
 size_t core_allocatable(void);
+size_t core_compact_step(size_t max_bytes);
+void core_get_frag_stats(struct buflib_frag_stats *stats);
+#ifdef HAVE_BUFLIB_TRACE
+/* counters of the core context; its events are read with buflib_get_trace() */
+const struct buflib_trace* core_get_trace(void);
+size_t core_get_buffer_size(void);
+#endif
 const char* core_get_name(int handle);
 #ifdef DEBUG
 void core_check_valid(void);
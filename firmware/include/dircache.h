@@ -44,7 +44,19 @@
    the limiting factor is the scanning thread stack size, not the
    implementation -- tune the two together */
 #define DIRCACHE_MAX_DEPTH  15
+#ifdef HAVE_EXFAT
+/* each level keeps its directory's file info as well */
+#define DIRCACHE_STACK_SIZE (DEFAULT_STACK_SIZE + 0x300)
+#else
 #define DIRCACHE_STACK_SIZE (DEFAULT_STACK_SIZE + 0x100)
+#endif
+
+/* index the cached names so that opening a path needn't walk every entry of
+   each directory along the way; the index is a separate allocation of about
+   six bytes per entry */
+#if MEMORYSIZE >= 16
+#define DIRCACHE_HASH
+#endif
 
 /* memory buffer constants that control allocation */
 #define DIRCACHE_RESERVE (1024*64)     /* 64 KB - new entry slack */
@@ -75,6 +87,14 @@ typedef uint32_t dc_serial_t;
 #if CONFIG_PLATFORM & PLATFORM_NATIVE
 /* native dircache is lower-level than on a hosted target */
 #define DIRCACHE_NATIVE
+#else
+/* path lookups are only done by the native file code */
+#undef DIRCACHE_HASH
+#endif
+
+#if defined(HAVE_EEPROM_SETTINGS) || defined(DIRCACHE_NATIVE)
+/* the cache may be saved to storage and loaded again on the next boot */
+#define DIRCACHE_SNAPSHOT
 #endif
 
 struct dircache_file
@@ -124,6 +144,12 @@ int dircache_readdir_internal(struct filestr_base *stream,
                               struct file_base_info *infop,
                               struct fat_direntry *fatent);
 void dircache_rewinddir_internal(struct file_base_info *info);
+#ifdef DIRCACHE_HASH
+int dircache_lookup_internal(struct filestr_base *stream,
+                             struct file_base_info *infop,
+                             const char *name,
+                             struct fat_direntry *fatent);
+#endif /* DIRCACHE_HASH */
 #endif /* DIRCACHE_NATIVE */
 
 
@@ -201,10 +227,10 @@ void dircache_dump(void);
 /** Misc. stuff **/
 void dircache_dcfile_init(struct dircache_file *dcfilep);
 
-#ifdef HAVE_EEPROM_SETTINGS
+#ifdef DIRCACHE_SNAPSHOT
 int dircache_load(void);
 int dircache_save(void);
-#endif /* HAVE_EEPROM_SETTINGS */
+#endif /* DIRCACHE_SNAPSHOT */
 
 void dircache_init(size_t last_size) INIT_ATTR;
 
@@ -190,6 +190,21 @@ static inline void rewinddir_internal(struct file_base_info *infop)
 #endif
 }
 
+/* find a name in a directory without scanning it; returns < 0 if the
+   directory must be scanned instead */
+static inline int lookup_internal(struct filestr_base *stream,
+                                  struct file_base_info *infop,
+                                  const char *name,
+                                  struct fat_direntry *fatent)
+{
+#ifdef DIRCACHE_HASH
+    return dircache_lookup_internal(stream, infop, name, fatent);
+#else
+    return -1;
+    (void)stream; (void)infop; (void)name; (void)fatent;
+#endif
+}
+
 
 /** Misc. stuff **/
 
@@ -38,6 +38,8 @@ static inline void dc_unlock_cache(void)
 
 void * dc_cache_probe(IF_MV(int volume,) unsigned long secnum,
                       unsigned int *flags);
+void * dc_cache_probe_run(IF_MV(int volume,) unsigned long secnum,
+                          unsigned int *countp);
 void dc_dirty_buf(void *buf);
 void dc_discard_buf(void *buf);
 void dc_commit_all(IF_MV_NONVOID(int volume));
@@ -52,6 +54,18 @@ extern void dc_writeback_callback(IF_MV(int volume, ) unsigned long sector,
 
 /** These synchronize and can be called by anyone **/
 
+struct dc_stats
+{
+    unsigned int  entries;    /* number of entries now available */
+    unsigned long hits;       /* probes finding their sector */
+    unsigned long misses;     /* probes that had to be filled */
+    unsigned long evictions;  /* valid sectors pushed out */
+    unsigned long writebacks; /* dirty sectors written */
+    unsigned long readaheads; /* sectors read before being asked for */
+};
+
+void dc_get_stats(struct dc_stats *stats);
+
 /* expropriate a buffer from the cache of DC_CACHE_BUFSIZE bytes */
 void * dc_get_buffer(void);
 /* return buffer to the cache by buffer */
@@ -97,11 +97,27 @@
 #elif MEMORYSIZE <= 32
 #define DC_NUM_ENTRIES      48
 #define DC_MAP_NUM_ENTRIES  128
-#else /* MEMORYSIZE > 32 */
+#elif MEMORYSIZE < 64 || defined(BOOTLOADER)
 #define DC_NUM_ENTRIES      64
 #define DC_MAP_NUM_ENTRIES  256
+#else /* MEMORYSIZE >= 64 */
+#define DC_NUM_ENTRIES      64
+#define DC_MAP_NUM_ENTRIES  512
+#define DC_EXT_ENTRIES      192
 #endif /* MEMORYSIZE */
 
+/* DC_EXT_ENTRIES is the most that may be added to the static ones from the
+ * core allocator at runtime. These are only used for caching and are given
+ * back when memory gets tight, so they may not be relied upon for buffers. */
+#ifndef DC_EXT_ENTRIES
+#define DC_EXT_ENTRIES      0
+#endif
+#define DC_MAX_ENTRIES      (DC_NUM_ENTRIES + DC_EXT_ENTRIES)
+
+/* maximum number of sectors read at once when sequential misses are seen;
+   only done with runtime entries */
+#define DC_READAHEAD_SECTORS 8
+
 /* this _could_ be larger than a sector if that would ever be useful */
 #define DC_CACHE_BUFSIZE    SECTOR_SIZE
 
@@ -205,8 +205,49 @@ struct thread_debug_info
     int          base_priority;
     int          current_priority;
 #endif
+#ifdef HAVE_THREAD_ACCOUNTING
+    uint32_t     runtime;       /* CPU time used (us, wraps) */
+    uint32_t     pip_runtime;   /* ...of that, with inherited priority */
+    uint32_t     switches;      /* times switched in */
+    uint32_t     wakeups;       /* times made runnable */
+    uint32_t     latency_total; /* sum of wakeup latencies (us, wraps) */
+    uint32_t     latency_max;   /* longest wakeup latency (us) */
+    uint32_t     inherits;      /* times priority was raised by inheritance */
+#endif
 };
 int thread_get_debug_info(unsigned int thread_id,
                           struct thread_debug_info *infop);
 
+#ifdef HAVE_THREAD_ACCOUNTING
+/* Scheduler trace - each core keeps its most recent events */
+#define THREAD_TRACE_SIZE 128 /* events per core (power of 2) */
+
+enum thread_trace_type
+{
+    THREAD_TRACE_SWITCH = 0,   /* switched in; arg: slot switched out */
+    THREAD_TRACE_READY,        /* put on the run queue */
+    THREAD_TRACE_BLOCK,        /* taken off the run queue */
+    THREAD_TRACE_PRIORITY,     /* priority changed; arg: old priority */
+};
+
+#define THREAD_TRACE_NO_SLOT 0xff /* SWITCH: no thread was running */
+
+struct thread_trace_event
+{
+    uint32_t time;             /* microseconds (wraps) */
+    uint8_t  type;             /* THREAD_TRACE_* */
+    uint8_t  slot;             /* thread slot */
+    uint8_t  arg;              /* type-specific */
+    uint8_t  priority;         /* thread's priority after the event */
+};
+
+/* Copies up to 'count' of the core's latest events, oldest first, and
+   returns the number copied */
+int thread_get_trace(unsigned int core, struct thread_trace_event *events,
+                     int count);
+
+/* Number of times the core has woken from idle sleep (wraps) */
+uint32_t thread_get_idle_wakeups(unsigned int core);
+#endif /* HAVE_THREAD_ACCOUNTING */
+
 #endif /* THREAD_H */
@@ -44,6 +44,11 @@ struct core_entry __cores[NUM_CORES] IBSS_ATTR;
 static struct thread_entry __thread_entries[MAXTHREADS] IBSS_ATTR;
 struct thread_entry *__threads[MAXTHREADS] IBSS_ATTR;
 
+#ifdef HAVE_THREAD_ACCOUNTING
+struct thread_acct __thread_accts[MAXTHREADS] SHAREDBSS_ATTR;
+struct core_acct __core_accts[NUM_CORES] SHAREDBSS_ATTR;
+#endif
+
 
 /** Internal functions **/
 
@@ -314,6 +319,16 @@ int thread_get_debug_info(unsigned int thread_id,
         infop->base_priority = thread->base_priority;
         infop->current_priority = thread->priority;
 #endif
+#ifdef HAVE_THREAD_ACCOUNTING
+        struct thread_acct *tap = __thread_acct_entry(slotnum);
+        infop->runtime       = tap->runtime;
+        infop->pip_runtime   = tap->pip_runtime;
+        infop->switches      = tap->switches;
+        infop->wakeups       = tap->wakeups;
+        infop->latency_total = tap->latency_total;
+        infop->latency_max   = tap->latency_max;
+        infop->inherits      = tap->inherits;
+#endif
 
         snprintf(infop->statusstr, sizeof (infop->statusstr), "%c%c",
                  cpu_boost ? '+' : (state == STATE_RUNNING ? '*' : ' '),
@@ -329,3 +344,37 @@ int thread_get_debug_info(unsigned int thread_id,
 
     return ret;
 }
+
+#ifdef HAVE_THREAD_ACCOUNTING
+int thread_get_trace(unsigned int core, struct thread_trace_event *events,
+                     int count)
+{
+    if (core >= NUM_CORES || !events || count <= 0)
+        return -1;
+
+    struct core_entry *corep = __core_id_entry(core);
+    struct core_acct *cap = __core_acct_entry(core);
+
+    int oldlevel = disable_irq_save();
+    corelock_lock(&corep->rtr_cl);
+
+    unsigned int pos = cap->tracepos;
+    unsigned int avail = MIN(pos, THREAD_TRACE_SIZE);
+    if ((unsigned int)count > avail)
+        count = avail;
+
+    for (int i = 0; i < count; i++)
+        events[i] = cap->trace[(pos - count + i) % THREAD_TRACE_SIZE];
+
+    corelock_unlock(&corep->rtr_cl);
+    restore_irq(oldlevel);
+
+    return count;
+    (void)corep;
+}
+
+uint32_t thread_get_idle_wakeups(unsigned int core)
+{
+    return core < NUM_CORES ? __core_acct_entry(core)->idle_wakeups : 0;
+}
+#endif /* HAVE_THREAD_ACCOUNTING */
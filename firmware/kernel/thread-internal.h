@@ -164,6 +164,46 @@ struct core_entry
 #endif /* NUM_CORES */
 };
 
+#ifdef HAVE_THREAD_ACCOUNTING
+/* Accounting kept for each thread slot; outside of the thread slot itself
+   since it needn't be in IRAM */
+struct thread_acct
+{
+    uint32_t runtime;          /* CPU time used (us) */
+    uint32_t pip_runtime;      /* ...of that, with inherited priority */
+    uint32_t switches;         /* times switched in */
+    uint32_t wakeups;          /* times made runnable */
+    uint32_t latency_total;    /* sum of wakeup latencies (us) */
+    uint32_t latency_max;      /* longest wakeup latency (us) */
+    uint32_t inherits;         /* times priority was raised by inheritance */
+    uint32_t readystamp;       /* when last made runnable */
+    bool     ready;            /* readystamp is pending a switch in */
+};
+
+/* Accounting kept for each core */
+struct core_acct
+{
+    uint32_t stamp;            /* when the running thread was switched in */
+    uint32_t idle_wakeups;     /* times the idle loop woke from core_sleep */
+    unsigned int tracepos;     /* next trace position (wraps) */
+    struct thread_trace_event trace[THREAD_TRACE_SIZE];
+};
+
+static FORCE_INLINE
+    struct thread_acct * __thread_acct_entry(unsigned int slotnum)
+{
+    extern struct thread_acct __thread_accts[MAXTHREADS];
+    return &__thread_accts[slotnum];
+}
+
+static FORCE_INLINE
+    struct core_acct * __core_acct_entry(unsigned int core)
+{
+    extern struct core_acct __core_accts[NUM_CORES];
+    return &__core_accts[core];
+}
+#endif /* HAVE_THREAD_ACCOUNTING */
+
 /* Hide a few scheduler details from itself to make allocation more flexible */
 #define __main_thread_name \
     ({ extern const char __main_thread_name_str[]; \
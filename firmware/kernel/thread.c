@@ -254,6 +254,165 @@ static NO_INLINE void thread_stkov(struct thread_entry *thread)
     do {} while (0)
 #endif /* HAVE_PRIORITY_SCHEDULING */
 
+#ifdef HAVE_THREAD_ACCOUNTING
+/* A free-running microsecond counter if the target has one; otherwise time
+   moves only by whole ticks and whichever thread is running when one passes
+   is charged for all of it, which amounts to sampling at HZ */
+#ifdef USEC_TIMER
+#define acct_clock() \
+    ((uint32_t)USEC_TIMER)
+#else
+#define acct_clock() \
+    ((uint32_t)current_tick * (1000000 / HZ))
+#endif
+
+/*---------------------------------------------------------------------------
+ * Add an event to the core's trace. The core's rtr lock must be held.
+ *---------------------------------------------------------------------------
+ */
+static inline void acct_trace(unsigned int core, uint32_t time,
+                              unsigned int type,
+                              const struct thread_entry *thread,
+                              unsigned int arg)
+{
+    struct core_acct *cap = __core_acct_entry(core);
+    struct thread_trace_event *ev =
+        &cap->trace[cap->tracepos++ % THREAD_TRACE_SIZE];
+
+    ev->time     = time;
+    ev->type     = type;
+    ev->slot     = THREAD_ID_SLOT(thread->id);
+    ev->arg      = arg;
+#ifdef HAVE_PRIORITY_SCHEDULING
+    ev->priority = thread->priority;
+#else
+    ev->priority = 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------
+ * The thread was put on the run queue; its wakeup latency starts counting.
+ * The core's rtr lock must be held.
+ *---------------------------------------------------------------------------
+ */
+static inline void acct_ready(unsigned int core, struct thread_entry *thread)
+{
+    struct thread_acct *tap = __thread_acct_entry(THREAD_ID_SLOT(thread->id));
+    uint32_t now = acct_clock();
+
+    tap->readystamp = now;
+    tap->ready      = true;
+    tap->wakeups++;
+
+    acct_trace(core, now, THREAD_TRACE_READY, thread, 0);
+}
+
+/*---------------------------------------------------------------------------
+ * The thread was taken off the run queue. The core's rtr lock must be held.
+ *---------------------------------------------------------------------------
+ */
+static inline void acct_block(unsigned int core, struct thread_entry *thread)
+{
+    acct_trace(core, acct_clock(), THREAD_TRACE_BLOCK, thread, 0);
+}
+
+/*---------------------------------------------------------------------------
+ * Charge the outgoing thread for the time since it was switched in
+ *---------------------------------------------------------------------------
+ */
+static inline void acct_switch_out(unsigned int core,
+                                   struct thread_entry *thread)
+{
+    struct thread_acct *tap = __thread_acct_entry(THREAD_ID_SLOT(thread->id));
+    uint32_t ran = acct_clock() - __core_acct_entry(core)->stamp;
+
+    tap->runtime += ran;
+#ifdef HAVE_PRIORITY_SCHEDULING
+    /* running on a priority inherited from threads it blocks */
+    if (thread->priority < thread->base_priority)
+        tap->pip_runtime += ran;
+#endif
+}
+
+/*---------------------------------------------------------------------------
+ * Start the incoming thread's time and note how long it waited to run. The
+ * core's rtr lock must be held.
+ *---------------------------------------------------------------------------
+ */
+static inline void acct_switch_in(unsigned int core,
+                                  struct thread_entry *thread,
+                                  struct thread_entry *old)
+{
+    struct thread_acct *tap = __thread_acct_entry(THREAD_ID_SLOT(thread->id));
+    uint32_t now = acct_clock();
+
+    __core_acct_entry(core)->stamp = now;
+
+    if (tap->ready)
+    {
+        uint32_t latency = now - tap->readystamp;
+        tap->latency_total += latency;
+        if (latency > tap->latency_max)
+            tap->latency_max = latency;
+
+        tap->ready = false;
+    }
+
+    if (thread != old)
+    {
+        tap->switches++;
+        acct_trace(core, now, THREAD_TRACE_SWITCH, thread,
+                   old ? THREAD_ID_SLOT(old->id) : THREAD_TRACE_NO_SLOT);
+    }
+}
+
+#ifdef HAVE_PRIORITY_SCHEDULING
+/*---------------------------------------------------------------------------
+ * The thread's running priority changed from 'oldpr'. Takes the rtr lock of
+ * the thread's core.
+ *---------------------------------------------------------------------------
+ */
+static void acct_priority(struct thread_entry *thread, int oldpr)
+{
+    const unsigned int core = IF_COP_CORE(thread->core);
+    struct core_entry *corep = __core_id_entry(core);
+    int newpr = thread->priority;
+
+    if (newpr < thread->base_priority && oldpr >= thread->base_priority)
+        __thread_acct_entry(THREAD_ID_SLOT(thread->id))->inherits++;
+
+    RTR_LOCK(corep);
+    acct_trace(core, acct_clock(), THREAD_TRACE_PRIORITY, thread, oldpr);
+    RTR_UNLOCK(corep);
+    (void)corep;
+}
+#endif /* HAVE_PRIORITY_SCHEDULING */
+
+/*---------------------------------------------------------------------------
+ * The core was woken from sleep in the idle loop by an interrupt or by the
+ * other core.
+ *---------------------------------------------------------------------------
+ */
+static inline void acct_idle_wakeup(unsigned int core)
+{
+    __core_acct_entry(core)->idle_wakeups++;
+}
+
+#else /* !HAVE_THREAD_ACCOUNTING */
+#define acct_ready(core, thread) \
+    do {} while (0)
+#define acct_block(core, thread) \
+    do {} while (0)
+#define acct_switch_out(core, thread) \
+    do {} while (0)
+#define acct_switch_in(core, thread, old) \
+    do {} while (0)
+#define acct_priority(thread, oldpr) \
+    do { (void)(thread); (void)(oldpr); } while (0)
+#define acct_idle_wakeup(core) \
+    do {} while (0)
+#endif /* HAVE_THREAD_ACCOUNTING */
+
 static FORCE_INLINE void thread_store_context(struct thread_entry *thread)
 {
     store_context(&thread->context);
@@ -370,6 +529,10 @@ static void new_thread_base_init(struct thread_entry *thread,
 #ifdef HAVE_SCHEDULER_BOOSTCTRL
     thread->cpu_boost = 0;
 #endif
+#ifdef HAVE_THREAD_ACCOUNTING
+    memset(__thread_acct_entry(THREAD_ID_SLOT(thread->id)), 0,
+           sizeof (struct thread_acct));
+#endif
 }
 
 /*---------------------------------------------------------------------------
@@ -386,6 +549,7 @@ static inline void core_rtr_add(struct core_entry *corep,
     thread->skip_count = thread->base_priority;
 #endif
     thread->state = STATE_RUNNING;
+    acct_ready(IF_COP_CORE(thread->core), thread);
     RTR_UNLOCK(corep);
 }
 
@@ -400,6 +564,7 @@ static inline void core_rtr_remove(struct core_entry *corep,
     rtr_queue_remove(&corep->rtr, thread);
     rtr_subtract_entry(corep, thread->priority);
     /* Does not demote state */
+    acct_block(IF_COP_CORE(thread->core), thread);
     RTR_UNLOCK(corep);
 }
 
@@ -485,10 +650,12 @@ static inline void set_rtr_thread_priority(
 {
     const unsigned int core = IF_COP_CORE(thread->core);
     struct core_entry *corep = __core_id_entry(core);
+    int oldpr = thread->priority;
     RTR_LOCK(corep);
-    rtr_move_entry(corep, thread->priority, priority);
+    rtr_move_entry(corep, oldpr, priority);
     thread->priority = priority;
     RTR_UNLOCK(corep);
+    acct_priority(thread, oldpr);
 }
 
 /*---------------------------------------------------------------------------
@@ -578,6 +745,7 @@ static void inherit_priority(
 
         /* Blocker is blocked */
         blt->priority = newpr;
+        acct_priority(blt, oldpr);
 
         bl = blt->blocker;
         if (LIKELY(bl == NULL))
@@ -615,7 +783,11 @@ static void priority_inherit_internal_inner(struct thread_entry *thread,
                                             int blpr)
 {
     if (prio_add_entry(&thread->pdist, blpr) == 1 && blpr < thread->priority)
+    {
+        int oldpr = thread->priority;
         thread->priority = blpr;
+        acct_priority(thread, oldpr);
+    }
 }
 
 static inline void priority_inherit_internal(struct thread_entry *thread,
@@ -1013,12 +1185,16 @@ void switch_thread(void)
     const unsigned int core = CURRENT_CORE;
     struct core_entry *corep = __core_id_entry(core);
     struct thread_entry *thread = corep->running;
+#ifdef HAVE_THREAD_ACCOUNTING
+    struct thread_entry *old = thread;
+#endif
 
     if (thread)
     {
 #ifdef RB_PROFILE
         profile_thread_stopped(THREAD_ID_SLOT(thread->id));
 #endif
+        acct_switch_out(core, thread);
 #ifdef DEBUG
         /* Check core_ctx buflib integrity */
         core_check_valid();
@@ -1050,6 +1226,7 @@ void switch_thread(void)
         core_sleep(IF_COP(core));
 
         /* Awakened by interrupt or other CPU */
+        acct_idle_wakeup(core);
     }
 
     thread = (thread && thread->state == STATE_RUNNING) ?
@@ -1095,6 +1272,7 @@ void switch_thread(void)
 
     rtr_queue_make_first(&corep->rtr, thread);
     corep->running = thread;
+    acct_switch_in(core, thread, old);
 
     RTR_UNLOCK(corep);
     enable_irq();
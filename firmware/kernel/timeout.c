@@ -13,6 +13,8 @@
 
 /* list of active timeout events */
 static struct timeout *tmo_list[MAX_NUM_TIMEOUTS+1];
+/* earliest expiration in the list; ticks before it need no walk */
+static long tmo_next_expires;
 
 /* timeout tick task - calls event handlers when they expire
  * Event handlers may alter expiration, callback and data during operation.
@@ -23,6 +25,9 @@ static void timeout_tick(void)
     struct timeout **p = tmo_list;
     struct timeout *curr;
 
+    if(TIME_BEFORE(tick, tmo_next_expires))
+        return;
+
     for(curr = *p; curr != NULL; curr = *(++p))
     {
         int ticks;
@@ -41,6 +46,17 @@ static void timeout_tick(void)
             timeout_cancel(curr); /* cancel */
         }
     }
+
+    /* handlers may have reloaded, registered or cancelled any of them */
+    long next = tick + 60*HZ; /* minimum duration: once/minute */
+
+    for(p = tmo_list, curr = *p; curr != NULL; curr = *(++p))
+    {
+        if(TIME_BEFORE(curr->expires, next))
+            next = curr->expires;
+    }
+
+    tmo_next_expires = next;
 }
 
 /* Cancels a timeout callback - can be called from the ISR */
@@ -91,6 +107,13 @@ void timeout_register(struct timeout *tmo, timeout_cb_type callback,
         tmo->callback = callback;
         tmo->data = data;
         tmo->expires = current_tick + ticks;
+
+        /* an earlier one gets noticed at once; a later one only leaves an
+           early walk behind */
+        if(*tmo_list == tmo && tmo_list[1] == NULL)
+            tmo_next_expires = tmo->expires;
+        else if(TIME_BEFORE(tmo->expires, tmo_next_expires))
+            tmo_next_expires = tmo->expires;
     }
 
     restore_irq(oldlevel);
@@ -27,7 +27,8 @@
 #include "load_code.h"
 
 /* load binary blob from disk to memory, returning a handle */
-void * lc_open(const char *filename, unsigned char *buf, size_t buf_size)
+void * lc_open_ex(const char *filename, unsigned char *buf, size_t buf_size,
+                  size_t *size)
 {
     int fd = open(filename, O_RDONLY);
     ssize_t read_size;
@@ -86,6 +87,9 @@ void * lc_open(const char *filename, unsigned char *buf, size_t buf_size)
         goto error;
     }
 
+    if (size)
+        *size = read_size;
+
     /* commit dcache and discard icache */
     commit_discard_idcache();
     /* return a pointer the header, reused by lc_get_header() */
@@ -96,3 +100,8 @@ error_fd:
 error:
     return NULL;
 }
+
+void * lc_open(const char *filename, unsigned char *buf, size_t buf_size)
+{
+    return lc_open_ex(filename, buf, buf_size, NULL);
+}
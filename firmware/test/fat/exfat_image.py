@@ -0,0 +1,403 @@
+#!/usr/bin/python3
+#             __________               __   ___.
+#   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+#   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+#   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+#   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+#                     \/            \/     \/    \/            \/
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+# KIND, either express or implied.
+#
+# exFAT images for the fat test (see fattest.make).
+#
+# Usage: exfat_image.py gen IMAGE
+#        exfat_image.py check IMAGE
+#
+# "gen" writes a 16MB volume holding the cases fat.c has to handle: files
+# with and without a FAT chain, a fragmented chain, an empty file, and a
+# directory of two clusters without a chain whose entries cross the cluster
+# boundary, with long and non-ASCII names. Byte i of every file is
+# pattern(seed, i) for the seed listed with it, which exfat_test.c checks.
+#
+# "check" is a small fsck: it walks the whole tree and verifies the entry
+# set checksums, name hashes, cluster chains and the allocation bitmap, and
+# exits with status 1 on any error.
+
+import struct
+import sys
+
+SECTOR = 512
+SEC_PER_CLUS_SHIFT = 3
+CLUSTER = SECTOR << SEC_PER_CLUS_SHIFT
+CLUSTERS = 4000
+FAT_OFFSET = 128
+FAT_LENGTH = (4 * (CLUSTERS + 2) + SECTOR - 1) // SECTOR
+HEAP_OFFSET = 256
+
+ATTR_DIRECTORY = 0x10
+ATTR_ARCHIVE = 0x20
+
+# entry types
+LABEL = 0x83
+BITMAP = 0x81
+UPCASE = 0x82
+FILE = 0x85
+STREAM = 0xc0
+NAME = 0xc1
+
+# stream extension flags
+ALLOC_POSSIBLE = 0x01
+NO_FAT_CHAIN = 0x02
+
+
+def pattern(seed, size):
+    """Contents of a test file; must match pattern() in exfat_test.c"""
+    return bytes((i * 31 + i // SECTOR * 7 + seed) & 0xff
+                 for i in range(size))
+
+
+def upcase_map():
+    """The part of the up-case table the test names use: ASCII, Latin-1
+    and Greek lower case letters"""
+    m = list(range(0x10000))
+    for c in range(ord("a"), ord("z") + 1):
+        m[c] = c - 32
+    for c in range(0xe0, 0xff):
+        if c != 0xf7:
+            m[c] = c - 32
+    for c in range(0x3b1, 0x3ca):
+        if c != 0x3c2:
+            m[c] = c - 32
+    return m
+
+
+UPCASE_MAP = upcase_map()
+
+
+def upcase_table():
+    """The table compressed the way Windows writes it: runs of identity
+    mappings become 0xffff followed by the run length"""
+    out = []
+    c = 0
+    while c < 0x10000:
+        if UPCASE_MAP[c] == c:
+            n = c
+            while n < 0x10000 and UPCASE_MAP[n] == n:
+                n += 1
+            if n - c > 2:
+                out += [0xffff, n - c]
+                c = n
+                continue
+        out.append(UPCASE_MAP[c])
+        c += 1
+    return struct.pack("<%dH" % len(out), *out)
+
+
+def table_checksum(data):
+    s = 0
+    for b in data:
+        s = (((s >> 1) | ((s & 1) << 31)) + b) & 0xffffffff
+    return s
+
+
+def set_checksum(entries):
+    s = 0
+    for i, e in enumerate(entries):
+        for j, b in enumerate(e):
+            if i == 0 and j in (2, 3):
+                continue
+            s = (((s >> 1) | ((s & 1) << 15)) + b) & 0xffff
+    return s
+
+
+def name_hash(name16):
+    s = 0
+    for c in name16:
+        u = UPCASE_MAP[c]
+        for b in (u & 0xff, u >> 8):
+            s = (((s >> 1) | ((s & 1) << 15)) + b) & 0xffff
+    return s
+
+
+def utf16(name):
+    b = name.encode("utf-16-le")
+    return list(struct.unpack("<%dH" % (len(b) // 2), b))
+
+
+def entry_set(name, attr, first, size, nofat):
+    name16 = utf16(name)
+    names = (len(name16) + 14) // 15
+    f = bytearray(32)
+    f[0] = FILE
+    f[1] = 1 + names
+    struct.pack_into("<H", f, 4, attr)
+    stamp = (46 << 25) | (1 << 21) | (1 << 16)      # 2026-01-01
+    struct.pack_into("<III", f, 8, stamp, stamp, stamp)
+    s = bytearray(32)
+    s[0] = STREAM
+    s[1] = ALLOC_POSSIBLE | (NO_FAT_CHAIN if nofat else 0)
+    s[3] = len(name16)
+    struct.pack_into("<H", s, 4, name_hash(name16))
+    struct.pack_into("<QxxxxIQ", s, 8, size, first, size)
+    entries = [f, s]
+    for i in range(names):
+        e = bytearray(32)
+        e[0] = NAME
+        part = name16[i * 15:(i + 1) * 15]
+        struct.pack_into("<%dH" % len(part), e, 2, *part)
+        entries.append(e)
+    struct.pack_into("<H", f, 2, set_checksum(entries))
+    return b"".join(entries)
+
+
+class Image:
+    def __init__(self):
+        self.data = bytearray((HEAP_OFFSET + (CLUSTERS << SEC_PER_CLUS_SHIFT))
+                              * SECTOR)
+        self.fat = [0] * (CLUSTERS + 2)
+        self.fat[0] = 0xfffffff8
+        self.fat[1] = 0xffffffff
+        self.used = set()
+        self.next = 2
+
+    def offset(self, cluster):
+        return (HEAP_OFFSET + ((cluster - 2) << SEC_PER_CLUS_SHIFT)) * SECTOR
+
+    def alloc(self, clusters, chain=True):
+        for c in clusters:
+            assert c not in self.used
+            self.used.add(c)
+        if chain:
+            for a, b in zip(clusters, clusters[1:]):
+                self.fat[a] = b
+            self.fat[clusters[-1]] = 0xffffffff
+        return clusters
+
+    def run(self, count, chain=True):
+        """Allocates the next 'count' clusters"""
+        clusters = list(range(self.next, self.next + count))
+        self.next += count
+        return self.alloc(clusters, chain)
+
+    def write(self, clusters, data):
+        for i, c in enumerate(clusters):
+            chunk = data[i * CLUSTER:(i + 1) * CLUSTER]
+            self.data[self.offset(c):self.offset(c) + len(chunk)] = chunk
+
+    def finish(self):
+        bs = bytearray(SECTOR)
+        bs[0:3] = b"\xeb\x76\x90"
+        bs[3:11] = b"EXFAT   "
+        struct.pack_into("<QQIIIIII", bs, 64, 0, len(self.data) // SECTOR,
+                         FAT_OFFSET, FAT_LENGTH, HEAP_OFFSET, CLUSTERS,
+                         4, 0x1234abcd)
+        struct.pack_into("<HH", bs, 104, 0x100, 0)
+        bs[108] = 9
+        bs[109] = SEC_PER_CLUS_SHIFT
+        bs[110] = 1
+        bs[111] = 0x80
+        bs[510:512] = b"\x55\xaa"
+        self.data[0:SECTOR] = bs
+        struct.pack_into("<%dI" % len(self.fat), self.data,
+                         FAT_OFFSET * SECTOR, *self.fat)
+        bitmap = bytearray(CLUSTER)
+        for c in self.used:
+            bitmap[(c - 2) // 8] |= 1 << ((c - 2) % 8)
+        self.write([2], bitmap)
+
+
+def generate(path):
+    img = Image()
+    img.run(1)                                   # allocation bitmap
+    up = upcase_table()
+    upcase = img.run((len(up) + CLUSTER - 1) // CLUSTER)
+    img.write(upcase, up)
+    root = img.run(1)
+
+    ents = bytearray(32)
+    ents[0] = LABEL
+    ents[1] = 4
+    struct.pack_into("<4H", ents, 2, *utf16("TEST"))
+    e = bytearray(32)
+    e[0] = BITMAP
+    struct.pack_into("<IQ", e, 20, 2, (CLUSTERS + 7) // 8)
+    ents += e
+    e = bytearray(32)
+    e[0] = UPCASE
+    struct.pack_into("<I", e, 4, table_checksum(up))
+    struct.pack_into("<IQ", e, 20, upcase[0], len(up))
+    ents += e
+
+    # one run of clusters without a FAT chain
+    size = 300 * CLUSTER - 100
+    cont = img.run(300, False)
+    img.write(cont, pattern(1, size))
+    ents += entry_set("CONT.BIN", ATTR_ARCHIVE, cont[0], size, True)
+
+    # a chain broken into two cluster pieces with another file in the gaps
+    frag, gap = [], []
+    for i in range(100):
+        frag += [img.next, img.next + 1]
+        gap.append(img.next + 2)
+        img.next += 3
+    img.alloc(frag)
+    img.alloc(gap)
+    size = 200 * CLUSTER - 7
+    img.write(frag, pattern(2, size))
+    ents += entry_set("FRAG.BIN", ATTR_ARCHIVE, frag[0], size, False)
+    size = 100 * CLUSTER
+    img.write(gap, pattern(3, size))
+    ents += entry_set("GAP.BIN", ATTR_ARCHIVE, gap[0], size, False)
+
+    ents += entry_set("EMPTY.TXT", ATTR_ARCHIVE, 0, 0, False)
+
+    # 46 entry sets need more than one cluster
+    sub = img.run(2, False)
+    subents = bytearray()
+    for i in range(45):
+        cl = img.run(1, False)
+        img.write(cl, pattern(10 + i, 1000 + i))
+        subents += entry_set("file number %02d with a rather long name.txt"
+                             % i, ATTR_ARCHIVE, cl[0], 1000 + i, True)
+    cl = img.run(1, False)
+    img.write(cl, pattern(4, 333))
+    subents += entry_set("Ünïcödé αβγ name.txt", ATTR_ARCHIVE, cl[0], 333,
+                         True)
+    assert CLUSTER < len(subents) <= 2 * CLUSTER
+    img.write(sub, subents)
+    ents += entry_set("Sub Dir", ATTR_DIRECTORY, sub[0], 2 * CLUSTER, True)
+
+    img.write(root, ents)
+    img.finish()
+    with open(path, "wb") as f:
+        f.write(img.data)
+
+
+def check(path):
+    with open(path, "rb") as f:
+        img = f.read()
+    fatoff, _, heapoff, clusters, rootcl = struct.unpack_from("<IIIII", img, 80)
+    spc = 1 << img[109]
+    clus = spc * SECTOR
+    fat = struct.unpack_from("<%dI" % (clusters + 2), img, fatoff * SECTOR)
+    errors = []
+    owner = {}
+    bitmap = None
+
+    def offset(c):
+        return (heapoff + (c - 2) * spc) * SECTOR
+
+    def read(chain, size):
+        return b"".join(img[offset(c):offset(c) + clus] for c in chain)[:size]
+
+    def claim(chain, who):
+        for c in chain:
+            if c < 2 or c > clusters + 1:
+                errors.append("%s: bad cluster %d" % (who, c))
+            elif c in owner:
+                errors.append("%s: cluster %d also in %s" % (who, c, owner[c]))
+            else:
+                owner[c] = who
+
+    def follow(first, who):
+        chain = []
+        c = first
+        while 2 <= c <= clusters + 1 and len(chain) <= clusters:
+            chain.append(c)
+            c = fat[c]
+        if c != 0xffffffff:
+            errors.append("%s: chain ends with %x" % (who, c))
+        return chain
+
+    def walk(chain, prefix):
+        nonlocal bitmap
+        data = read(chain, len(chain) * clus)
+        ents = [data[i:i + 32] for i in range(0, len(data), 32)]
+        i = 0
+        while i < len(ents) and ents[i][0]:
+            t = ents[i][0]
+            if t in (BITMAP, UPCASE):
+                first, size = struct.unpack_from("<IQ", ents[i], 20)
+                c = follow(first, prefix + hex(t))
+                claim(c, prefix + hex(t))
+                if t == BITMAP:
+                    bitmap = read(c, size)
+            if t != FILE:
+                i += 1
+                continue
+            es = ents[i:i + 1 + ents[i][1]]
+            i += len(es)
+            if set_checksum(es) != struct.unpack_from("<H", es[0], 2)[0]:
+                errors.append("%s: bad set checksum at %d" % (prefix, i))
+            if es[1][0] != STREAM:
+                errors.append("%s: no stream extension at %d" % (prefix, i))
+                continue
+            length = es[1][3]
+            name16 = []
+            for e in es[2:]:
+                if e[0] == NAME:
+                    name16 += struct.unpack_from("<15H", e, 2)
+            name16 = name16[:length]
+            name = prefix + struct.pack("<%dH" % length,
+                                        *name16).decode("utf-16-le")
+            if len(es) - 2 != (length + 14) // 15:
+                errors.append(name + ": wrong number of name entries")
+            if name_hash(name16) != struct.unpack_from("<H", es[1], 4)[0]:
+                errors.append(name + ": bad name hash")
+            flags = es[1][1]
+            valid, first, size = struct.unpack_from("<QxxxxIQ", es[1], 8)
+            if valid != size:
+                errors.append("%s: valid size %d, size %d" % (name, valid, size))
+            if first == 0 or not flags & ALLOC_POSSIBLE:
+                if size:
+                    errors.append(name + ": data without clusters")
+                chain = []
+            elif flags & NO_FAT_CHAIN:
+                chain = list(range(first, first + (size + clus - 1) // clus))
+            else:
+                chain = follow(first, name)
+                if len(chain) != (size + clus - 1) // clus:
+                    errors.append("%s: %d clusters for %d bytes"
+                                  % (name, len(chain), size))
+            claim(chain, name)
+            if struct.unpack_from("<H", es[0], 4)[0] & ATTR_DIRECTORY:
+                walk(chain, name + "/")
+
+    root = follow(rootcl, "/")
+    claim(root, "/")
+    walk(root, "/")
+    if bitmap is None:
+        errors.append("no allocation bitmap")
+    else:
+        for c in range(2, clusters + 2):
+            bit = (bitmap[(c - 2) // 8] >> ((c - 2) % 8)) & 1
+            if bit and c not in owner:
+                errors.append("cluster %d is allocated but unused" % c)
+            elif not bit and c in owner:
+                errors.append("cluster %d of %s is free in the bitmap"
+                              % (c, owner[c]))
+    return errors, clusters - len(owner)
+
+
+def main():
+    if len(sys.argv) != 3 or sys.argv[1] not in ("gen", "check"):
+        print("Usage: %s gen|check IMAGE" % sys.argv[0])
+        sys.exit(1)
+    if sys.argv[1] == "gen":
+        generate(sys.argv[2])
+        return
+    errors, free = check(sys.argv[2])
+    for e in errors:
+        print(e)
+    print("%s: %d free clusters, %d errors" % (sys.argv[2], free, len(errors)))
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,414 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+/* Runs fat.c against an image written by "exfat_image.py gen": reads back
+ * everything on it, then creates, grows, truncates, renames and removes
+ * files and directories, fills the volume and remounts. The image is saved
+ * afterwards so "exfat_image.py check" can look for damage.
+ *
+ * Usage: exfat_test IMAGE [-v] */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fat.h"
+#include "fs_attr.h"
+#include "disk_cache.h"
+#include "file_internal.h"
+#include "core_alloc.h"
+#include "testdisk.h"
+
+#define SECTOR_SIZE 512
+#define MAX_SECTORS 2400            /* largest file this reads at once */
+
+static int failures;
+
+#define CHECK(cond, ...)                                          \
+    do {                                                          \
+        if (!(cond))                                              \
+        {                                                         \
+            printf("%s:%d: ", __FILE__, __LINE__);                \
+            printf(__VA_ARGS__);                                  \
+            printf("\n");                                         \
+            failures++;                                           \
+        }                                                         \
+    } while (0)
+
+static unsigned char buffer[MAX_SECTORS * SECTOR_SIZE];
+
+/* must match pattern() in exfat_image.py */
+static unsigned char pattern(int seed, unsigned long i)
+{
+    return i * 31 + i / SECTOR_SIZE * 7 + seed;
+}
+
+static void fill(int seed, unsigned long start, unsigned long size)
+{
+    for (unsigned long i = 0; i < size; i++)
+        buffer[i] = pattern(seed, start + i);
+}
+
+/* opens 'name' in 'dir'; returns its entry or NULL if there isn't one */
+static struct fat_direntry * lookup(struct fat_file *dir, const char *name,
+                                    struct fat_file *file)
+{
+    static unsigned char cachebuf[SECTOR_SIZE];
+    static struct fat_direntry entry;
+    struct filestr_cache cache = { cachebuf, INVALID_SECNUM, 0 };
+    struct fat_filestr dirstr;
+    struct fat_dirscan_info scan;
+
+    fat_filestr_init(&dirstr, dir);
+    fat_rewinddir(&scan);
+
+    while (fat_readdir(&dirstr, &scan, &cache, &entry) > 0)
+    {
+        if (strcmp((char *)entry.name, name))
+            continue;
+
+        if (file)
+        {
+            file->e = scan;
+            if (fat_open(dir, entry.firstcluster, file) < 0)
+                return NULL;
+        }
+
+        return &entry;
+    }
+
+    return NULL;
+}
+
+static int count_entries(struct fat_file *dir)
+{
+    unsigned char cachebuf[SECTOR_SIZE];
+    struct filestr_cache cache = { cachebuf, INVALID_SECNUM, 0 };
+    struct fat_filestr dirstr;
+    struct fat_dirscan_info scan;
+    struct fat_direntry entry;
+    int count = 0;
+
+    fat_filestr_init(&dirstr, dir);
+    fat_rewinddir(&scan);
+
+    while (fat_readdir(&dirstr, &scan, &cache, &entry) > 0)
+        count++;
+
+    return count;
+}
+
+/* true if 'name' holds 'size' bytes of pattern 'seed' */
+static bool verify(struct fat_file *dir, const char *name, int seed,
+                   unsigned long size)
+{
+    struct fat_file file;
+    struct fat_direntry *entry = lookup(dir, name, &file);
+
+    if (!entry)
+    {
+        printf("%s: not found\n", name);
+        return false;
+    }
+
+    if (entry->filesize != size)
+    {
+        printf("%s: size %lu, expected %lu\n", name,
+               (unsigned long)entry->filesize, size);
+        return false;
+    }
+
+    struct fat_filestr str;
+    unsigned long sectors = (size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+    fat_filestr_init(&str, &file);
+
+    /* like file.c, only ask for what the size covers */
+    long rc = fat_readwrite(&str, sectors, buffer, false);
+    if (rc != (long)sectors)
+    {
+        printf("%s: read %ld sectors, expected %lu\n", name, rc, sectors);
+        return false;
+    }
+
+    for (unsigned long i = 0; i < size; i++)
+    {
+        if (buffer[i] != pattern(seed, i))
+        {
+            printf("%s: wrong data at %lu\n", name, i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int write_file(struct fat_file *dir, const char *name, int seed,
+                      unsigned long size, struct fat_file *file)
+{
+    struct fat_direntry entry;
+    struct fat_filestr str;
+    unsigned long sectors = (size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+    int rc = fat_create_file(dir, name, ATTR_ARCHIVE, file, &entry);
+    if (rc < 0)
+        return rc;
+
+    fat_filestr_init(&str, file);
+    fill(seed, 0, sectors * SECTOR_SIZE);
+    if (sectors && fat_readwrite(&str, sectors, buffer, true) != (long)sectors)
+        return -1;
+
+    return fat_closewrite(&str, size, &entry);
+}
+
+static void test_read(struct fat_file *root)
+{
+    struct fat_file sub, file;
+    struct fat_direntry *entry;
+    char name[64];
+
+    /* the label, bitmap and up-case entries aren't listed */
+    CHECK(count_entries(root) == 5, "root has %d entries", count_entries(root));
+
+    entry = lookup(root, "CONT.BIN", &file);
+    CHECK(entry && file.contig == 300, "CONT.BIN not one run");
+    CHECK(verify(root, "CONT.BIN", 1, 300 * 4096 - 100), "CONT.BIN");
+
+    entry = lookup(root, "FRAG.BIN", &file);
+    CHECK(entry && file.contig == 0, "FRAG.BIN not a chain");
+    CHECK(verify(root, "FRAG.BIN", 2, 200 * 4096 - 7), "FRAG.BIN");
+    CHECK(verify(root, "GAP.BIN", 3, 100 * 4096), "GAP.BIN");
+    CHECK(verify(root, "EMPTY.TXT", 0, 0), "EMPTY.TXT");
+
+    entry = lookup(root, "Sub Dir", &sub);
+    CHECK(entry && (entry->attr & ATTR_DIRECTORY) && sub.contig == 2,
+          "Sub Dir");
+    if (!entry)
+        return;
+
+    CHECK(count_entries(&sub) == 46, "Sub Dir has %d entries",
+          count_entries(&sub));
+    for (int i = 0; i < 45; i++)
+    {
+        snprintf(name, sizeof (name),
+                 "file number %02d with a rather long name.txt", i);
+        CHECK(verify(&sub, name, 10 + i, 1000 + i), "%s", name);
+    }
+
+    /* "Ünïcödé αβγ name.txt" */
+    CHECK(verify(&sub, "\xc3\x9cn\xc3\xaf" "c\xc3\xb6" "d\xc3\xa9 "
+                 "\xce\xb1\xce\xb2\xce\xb3 name.txt", 4, 333),
+          "non-ASCII name");
+}
+
+static void test_write(struct fat_file *root)
+{
+    static const char contname[] = "a contiguous file that grows.dat";
+    struct fat_file a, b;
+    struct fat_direntry ea, eb;
+    struct fat_filestr sa, sb;
+
+    /* a new file stays one run while nothing else allocates */
+    CHECK(write_file(root, contname, 5, 100000, &a) == 0, "write");
+    CHECK(a.contig == 25, "new file not one run: %lu", a.contig);
+    CHECK(verify(root, contname, 5, 100000), "%s", contname);
+
+    /* files growing in turn get a FAT chain */
+    CHECK(fat_create_file(root, "interleaved A", ATTR_ARCHIVE, &a, &ea) == 0,
+          "create A");
+    CHECK(fat_create_file(root, "interleaved B", ATTR_ARCHIVE, &b, &eb) == 0,
+          "create B");
+    fat_filestr_init(&sa, &a);
+    fat_filestr_init(&sb, &b);
+
+    for (int i = 0; i < 3; i++)
+    {
+        fill(6, i * 4096, 4096);
+        CHECK(fat_readwrite(&sa, 8, buffer, true) == 8, "write A");
+        fill(7, i * 4096, 4096);
+        CHECK(fat_readwrite(&sb, 8, buffer, true) == 8, "write B");
+    }
+
+    CHECK(a.contig == 0 && b.contig == 0, "no chains: %lu %lu",
+          a.contig, b.contig);
+    CHECK(fat_closewrite(&sa, 3 * 4096, &ea) == 0, "close A");
+    CHECK(fat_closewrite(&sb, 3 * 4096 - 10, &eb) == 0, "close B");
+    CHECK(verify(root, "interleaved A", 6, 3 * 4096), "interleaved A");
+    CHECK(verify(root, "interleaved B", 7, 3 * 4096 - 10), "interleaved B");
+
+    /* truncating keeps the run */
+    struct fat_direntry *entry = lookup(root, contname, &a);
+    CHECK(entry, "%s", contname);
+    if (entry)
+    {
+        ea = *entry;
+        fat_filestr_init(&sa, &a);
+        CHECK(fat_seek(&sa, 100) == 0 && fat_truncate(&sa) == 1, "truncate");
+        CHECK(fat_closewrite(&sa, 100 * SECTOR_SIZE - 3, &ea) == 0,
+              "close truncated");
+        CHECK(a.contig == 13, "truncated file not one run: %lu", a.contig);
+        CHECK(verify(root, contname, 5, 100 * SECTOR_SIZE - 3),
+              "truncated %s", contname);
+    }
+}
+
+static void test_directories(struct fat_file *root)
+{
+    struct fat_file dir, file;
+    struct fat_direntry entry;
+    char name[64];
+
+    /* 60 entry sets need the new directory extended twice */
+    CHECK(fat_create_file(root, "New Directory", ATTR_DIRECTORY, &dir,
+                          &entry) == 0, "mkdir");
+    CHECK(lookup(root, "New Directory", &dir), "New Directory");
+
+    for (int i = 0; i < 60; i++)
+    {
+        snprintf(name, sizeof (name), "entry %02d in the new directory.bin", i);
+        CHECK(write_file(&dir, name, 20 + i, 500 + i * 37, &file) == 0,
+              "write %s", name);
+    }
+
+    CHECK(count_entries(&dir) == 60, "New Directory has %d entries",
+          count_entries(&dir));
+    for (int i = 0; i < 60; i++)
+    {
+        snprintf(name, sizeof (name), "entry %02d in the new directory.bin", i);
+        CHECK(verify(&dir, name, 20 + i, 500 + i * 37), "%s", name);
+    }
+
+    /* renaming to a name needing more entries moves the set */
+    static const char longname[] =
+        "a much longer name for the contiguous file.bin";
+    CHECK(lookup(root, "CONT.BIN", &file), "CONT.BIN");
+    CHECK(fat_rename(root, &file, (const unsigned char *)longname) == 0,
+          "rename");
+    CHECK(!lookup(root, "CONT.BIN", NULL), "CONT.BIN still there");
+    CHECK(lookup(root, longname, &file) && file.contig == 300,
+          "renamed file not one run");
+    CHECK(verify(root, longname, 1, 300 * 4096 - 100), "renamed file");
+
+    /* and to another directory */
+    CHECK(lookup(root, "interleaved B", &file), "interleaved B");
+    CHECK(fat_rename(&dir, &file, (const unsigned char *)"interleaved B") == 0,
+          "move");
+    CHECK(!lookup(root, "interleaved B", NULL), "interleaved B not moved");
+    CHECK(verify(&dir, "interleaved B", 7, 3 * 4096 - 10), "moved file");
+
+    CHECK(lookup(root, "FRAG.BIN", &file) &&
+          fat_remove(&file, FAT_RM_ALL) == 0, "remove FRAG.BIN");
+    CHECK(lookup(root, "Sub Dir", &dir), "Sub Dir");
+    CHECK(lookup(&dir, "file number 07 with a rather long name.txt", &file) &&
+          fat_remove(&file, FAT_RM_ALL) == 0, "remove from Sub Dir");
+    CHECK(count_entries(&dir) == 45, "Sub Dir has %d entries",
+          count_entries(&dir));
+    CHECK(verify(root, "GAP.BIN", 3, 100 * 4096), "GAP.BIN");
+}
+
+static void test_full(struct fat_file *root)
+{
+    unsigned long size, before, free, recalc, total = 0;
+    struct fat_file file;
+    struct fat_direntry entry;
+    struct fat_filestr str;
+    long rc;
+
+    fat_size(IF_MV(0,) &size, &before);
+    CHECK(fat_create_file(root, "filler", ATTR_ARCHIVE, &file, &entry) == 0,
+          "create filler");
+    fat_filestr_init(&str, &file);
+
+    fill(8, 0, 64 * SECTOR_SIZE);
+    while ((rc = fat_readwrite(&str, 64, buffer, true)) == 64)
+        total += 64;
+    if (rc > 0)
+        total += rc;
+
+    fat_size(IF_MV(0,) &size, &free);
+    CHECK(free == 0, "%lu free after filling", free);
+    CHECK(fat_closewrite(&str, total * SECTOR_SIZE, &entry) == 0,
+          "close filler");
+
+    fat_recalc_free(IF_MV(0));
+    fat_size(IF_MV(0,) &size, &recalc);
+    CHECK(recalc == free, "%lu free after recalc, was %lu", recalc, free);
+
+    CHECK(fat_remove(&file, FAT_RM_ALL) == 0, "remove filler");
+    fat_size(IF_MV(0,) &size, &free);
+    fat_recalc_free(IF_MV(0));
+    fat_size(IF_MV(0,) &size, &recalc);
+    CHECK(free == before && recalc == before,
+          "%lu free after removing, %lu after recalc, was %lu",
+          free, recalc, before);
+}
+
+int main(int argc, char *argv[])
+{
+    struct fat_file root, dir;
+
+    if (argc < 2)
+    {
+        printf("Usage: %s IMAGE [-v]\n", argv[0]);
+        return 1;
+    }
+
+    testdisk_verbose = argc > 2 && !strcmp(argv[2], "-v");
+    if (!testdisk_load(argv[1]))
+    {
+        printf("%s: can't read\n", argv[1]);
+        return 1;
+    }
+
+    core_allocator_init();
+    dc_init();
+    fat_init();
+
+    if (fat_mount(IF_MV(0,) IF_MD(0,) 0) < 0)
+    {
+        printf("%s: mount failed\n", argv[1]);
+        return 1;
+    }
+
+    fat_open_rootdir(IF_MV(0,) &root);
+    test_read(&root);
+    test_write(&root);
+    test_directories(&root);
+    test_full(&root);
+
+    /* everything has to be on the disk, not just in the cache */
+    dc_commit_all(IF_MV(0));
+    fat_unmount(IF_MV(0));
+    CHECK(fat_mount(IF_MV(0,) IF_MD(0,) 0) == 0, "remount");
+    fat_open_rootdir(IF_MV(0,) &root);
+    CHECK(lookup(&root, "New Directory", &dir), "New Directory");
+    CHECK(verify(&dir, "entry 59 in the new directory.bin", 79, 500 + 59 * 37),
+          "after remount");
+    CHECK(verify(&dir, "interleaved B", 7, 3 * 4096 - 10), "after remount");
+    dc_commit_all(IF_MV(0));
+
+    if (!testdisk_save(argv[1]))
+    {
+        printf("%s: can't write\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s: %d failures\n", argv[1], failures);
+    return failures ? 1 : 0;
+}
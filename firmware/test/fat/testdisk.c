@@ -0,0 +1,189 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+/* Host side of the fat test: a disk image held in RAM stands in for the
+ * storage driver, plus the few other firmware functions that fat.c and the
+ * disk cache use. The test runs single threaded, so the mutexes do
+ * nothing. */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "storage.h"
+#include "mutex.h"
+#include "rbunicode.h"
+#include "timefuncs.h"
+#include "debug.h"
+#include "panic.h"
+#include "testdisk.h"
+
+#define SECTOR_SIZE 512
+
+static unsigned char *disk;
+static unsigned long disk_sectors;
+
+bool testdisk_verbose;
+
+bool testdisk_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+
+    disk = malloc(size);
+    disk_sectors = size / SECTOR_SIZE;
+    bool ok = disk && fread(disk, SECTOR_SIZE, disk_sectors, f) == disk_sectors;
+    fclose(f);
+    return ok;
+}
+
+bool testdisk_save(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+
+    bool ok = fwrite(disk, SECTOR_SIZE, disk_sectors, f) == disk_sectors;
+    return fclose(f) == 0 && ok;
+}
+
+int storage_read_sectors(IF_MD(int drive,) unsigned long start, int count,
+                         void* buf)
+{
+    IF_MD((void)drive;)
+    if (start + count > disk_sectors)
+        return -1;
+
+    memcpy(buf, disk + start * SECTOR_SIZE, count * SECTOR_SIZE);
+    return 0;
+}
+
+int storage_write_sectors(IF_MD(int drive,) unsigned long start, int count,
+                          const void* buf)
+{
+    IF_MD((void)drive;)
+    if (start + count > disk_sectors)
+        return -1;
+
+    memcpy(disk + start * SECTOR_SIZE, buf, count * SECTOR_SIZE);
+    return 0;
+}
+
+void mutex_init(struct mutex *m)
+{
+    (void)m;
+}
+
+void mutex_lock(struct mutex *m)
+{
+    (void)m;
+}
+
+void mutex_unlock(struct mutex *m)
+{
+    (void)m;
+}
+
+struct tm *get_time(void)
+{
+    static struct tm tm;
+    time_t t = 1767225600; /* 2026-01-01 */
+    gmtime_r(&t, &tm);
+    return &tm;
+}
+
+void debugf(const char *fmt, ...)
+{
+    if (!testdisk_verbose)
+        return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+void panicf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    abort();
+}
+
+/* the UCS-2 subset of firmware/common/unicode.c, which needs the file
+   system and codepages itself */
+unsigned char* utf8encode(unsigned long ucs, unsigned char *utf8)
+{
+    if (ucs < 0x80)
+        *utf8++ = ucs;
+    else if (ucs < 0x800)
+    {
+        *utf8++ = 0xc0 | (ucs >> 6);
+        *utf8++ = 0x80 | (ucs & 0x3f);
+    }
+    else
+    {
+        *utf8++ = 0xe0 | (ucs >> 12);
+        *utf8++ = 0x80 | ((ucs >> 6) & 0x3f);
+        *utf8++ = 0x80 | (ucs & 0x3f);
+    }
+
+    return utf8;
+}
+
+const unsigned char* utf8decode(const unsigned char *utf8, unsigned short *ucs)
+{
+    unsigned int c = *utf8++;
+
+    if (c < 0x80)
+        *ucs = c;
+    else if (c < 0xe0)
+        *ucs = ((c & 0x1f) << 6) | (*utf8++ & 0x3f);
+    else
+    {
+        *ucs = (c & 0x0f) << 12;
+        *ucs |= (*utf8++ & 0x3f) << 6;
+        *ucs |= *utf8++ & 0x3f;
+    }
+
+    return utf8;
+}
+
+unsigned long utf8length(const unsigned char *utf8)
+{
+    unsigned long l = 0;
+
+    for (; *utf8; utf8++)
+    {
+        if ((*utf8 & 0xc0) != 0x80)
+            l++;
+    }
+
+    return l;
+}
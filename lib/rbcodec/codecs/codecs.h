@@ -275,10 +275,30 @@ void codec_get_full_path(char *path, const char *codec_root_fn);
 void *codec_get_buffer_callback(size_t *size);
 
 /* defined by the codec loader (codec.c) */
-int codec_load_buf(int hid, struct codec_api *api);
+int codec_load_buf(int hid, const char *codec, struct codec_api *api);
 int codec_load_file(const char* codec, struct codec_api *api);
 int codec_run_proc(void);
 int codec_close(void);
+
+/* Images of recently loaded codecs are kept in memory set aside by playback
+   so that switching between a few formats doesn't load them again */
+#define CODEC_CACHE_ENTRIES 3
+
+struct codec_cache_stats
+{
+    unsigned int hits;          /* loads served from the cache */
+    unsigned int misses;        /* loads from the file buffer or disk */
+    unsigned int evictions;     /* images dropped to make room */
+    size_t size;                /* bytes set aside for images */
+    size_t used;                /* bytes of resident images */
+    const char *names[CODEC_CACHE_ENTRIES]; /* resident codecs, or NULL */
+    size_t sizes[CODEC_CACHE_ENTRIES];
+};
+
+size_t codec_cache_size(void);
+void codec_cache_init(void *buf, size_t size);
+int codec_load_cached(const char *codec, struct codec_api *api);
+void codec_cache_get_stats(struct codec_cache_stats *stats);
 #if defined(HAVE_RECORDING)
 enc_callback_t codec_get_enc_callback(void);
 #endif
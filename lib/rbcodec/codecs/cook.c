@@ -40,10 +40,11 @@ static void init_rm(RMContext *rmctx)
 static int request_packet(int size)
 {
     int consumed = 0;
+    size_t n;
     while (1)
     {
-        uint8_t *buffer = ci->request_buffer((size_t *)(&consumed), size);
-        if (!consumed)
+        uint8_t *buffer = ci->request_buffer(&n, size);
+        if (!n)
             break;
         consumed = rm_get_packet(&buffer, &rmctx, &pkt);
         if (consumed < 0 || consumed == size)
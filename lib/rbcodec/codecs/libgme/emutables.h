@@ -204,7 +204,7 @@ static const e_uint16 ar_adjust_coeff[] = {
 	  4,    4,    4,    4,    3,    3,    3, 
 	  3,    2,    2,    2,    2,    1,    1, 
 	  1,    1,    1,    0,    0,    0,    0, 
-	  0, 
+	  0,    0, 
 };
 
 #endif
@@ -133,6 +133,10 @@ static OPUS_INLINE opus_int16 SAT16(opus_int32 x) {
 #include "cf/fixed_cf.h"
 #endif
 
+#ifdef OPUS_ARM_INLINE_NEON
+#include "arm/fixed_neon.h"
+#endif
+
 #endif
 
 #else /* FIXED_POINT */
@@ -0,0 +1,73 @@
+/* Copyright (C) 2013 Xiph.Org Foundation and contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FIXED_NEON_H
+#define FIXED_NEON_H
+
+#include <arm_neon.h>
+
+/* Postfilter comb filter, four outputs per iteration. Like the scalar code
+   the taps are doubled with a wrapping shift first; vqdmulh with the gain
+   pre-shifted by 15 then gives floor(g*x/65536), which is MULT16_32_Q16.
+   It can only saturate for a gain of -65536, so the output matches the
+   scalar version bit for bit, overflow included.
+
+   PVQ decoding has no kernel here: decode_pulses() is a serial
+   combinatorial decode and exp_rotation1() updates each coefficient from
+   the one before it, so neither maps onto vector lanes. */
+#define OVERRIDE_COMB_FILTER_CONST
+static OPUS_INLINE void comb_filter_const(opus_val32 *y, opus_val32 *x, int T,
+      int N, opus_val16 g10, opus_val16 g11, opus_val16 g12)
+{
+   int32x4_t vg10 = vdupq_n_s32((opus_int32)g10 << 15);
+   int32x4_t vg11 = vdupq_n_s32((opus_int32)g11 << 15);
+   int32x4_t vg12 = vdupq_n_s32((opus_int32)g12 << 15);
+   const opus_val32 *xt = x - T;
+   int i;
+   for (i=0;i<N-3;i+=4)
+   {
+      int32x4_t x0 = vshlq_n_s32(vld1q_s32(&xt[i+2]), 1);
+      int32x4_t x1 = vshlq_n_s32(vld1q_s32(&xt[i+1]), 1);
+      int32x4_t x2 = vshlq_n_s32(vld1q_s32(&xt[i]), 1);
+      int32x4_t x3 = vshlq_n_s32(vld1q_s32(&xt[i-1]), 1);
+      int32x4_t x4 = vshlq_n_s32(vld1q_s32(&xt[i-2]), 1);
+      int32x4_t t;
+      t = vaddq_s32(vld1q_s32(&x[i]), vqdmulhq_s32(vg10, x2));
+      t = vaddq_s32(t, vqdmulhq_s32(vg11, vaddq_s32(x1, x3)));
+      t = vaddq_s32(t, vqdmulhq_s32(vg12, vaddq_s32(x0, x4)));
+      vst1q_s32(&y[i], t);
+   }
+   for (;i<N;i++)
+   {
+      opus_val32 t;
+      t = MAC16_32_Q16(x[i], g10, SHL32(xt[i], 1));
+      t = MAC16_32_Q16(t, g11, ADD32(SHL32(xt[i+1], 1), SHL32(xt[i-1], 1)));
+      t = MAC16_32_Q16(t, g12, ADD32(SHL32(xt[i+2], 1), SHL32(xt[i-2], 1)));
+      y[i] = t;
+   }
+}
+
+#endif /* FIXED_NEON_H */
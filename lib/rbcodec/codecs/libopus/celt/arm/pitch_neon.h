@@ -0,0 +1,86 @@
+/* Copyright (C) 2013 Xiph.Org Foundation and contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PITCH_NEON_H
+#define PITCH_NEON_H
+
+#include <arm_neon.h>
+
+/* Sums of 16x16 products, eight lanes at a time. The accumulation wraps the
+   same way the scalar MAC16_16 loop does, so results are identical. */
+#define OVERRIDE_CELT_INNER_PROD
+static OPUS_INLINE opus_val32 celt_inner_prod(const opus_val16 *x,
+      const opus_val16 *y, int N)
+{
+   int32x4_t acc = vdupq_n_s32(0);
+   int32x2_t sum;
+   opus_val32 xy;
+   int i;
+   for (i=0;i<N-7;i+=8)
+   {
+      int16x8_t vx = vld1q_s16(&x[i]);
+      int16x8_t vy = vld1q_s16(&y[i]);
+      acc = vmlal_s16(acc, vget_low_s16(vx), vget_low_s16(vy));
+      acc = vmlal_s16(acc, vget_high_s16(vx), vget_high_s16(vy));
+   }
+   sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+   xy = vget_lane_s32(vpadd_s32(sum, sum), 0);
+   for (;i<N;i++)
+      xy = MAC16_16(xy, x[i], y[i]);
+   return xy;
+}
+
+#define OVERRIDE_DUAL_INNER_PROD
+static OPUS_INLINE void dual_inner_prod(const opus_val16 *x,
+      const opus_val16 *y01, const opus_val16 *y02, int N,
+      opus_val32 *xy1, opus_val32 *xy2)
+{
+   int32x4_t acc1 = vdupq_n_s32(0);
+   int32x4_t acc2 = vdupq_n_s32(0);
+   int32x2_t sum1, sum2;
+   opus_val32 xy01, xy02;
+   int i;
+   for (i=0;i<N-3;i+=4)
+   {
+      int16x4_t vx = vld1_s16(&x[i]);
+      acc1 = vmlal_s16(acc1, vx, vld1_s16(&y01[i]));
+      acc2 = vmlal_s16(acc2, vx, vld1_s16(&y02[i]));
+   }
+   sum1 = vadd_s32(vget_low_s32(acc1), vget_high_s32(acc1));
+   sum2 = vadd_s32(vget_low_s32(acc2), vget_high_s32(acc2));
+   sum1 = vpadd_s32(sum1, sum2);
+   xy01 = vget_lane_s32(sum1, 0);
+   xy02 = vget_lane_s32(sum1, 1);
+   for (;i<N;i++)
+   {
+      xy01 = MAC16_16(xy01, x[i], y01[i]);
+      xy02 = MAC16_16(xy02, x[i], y02[i]);
+   }
+   *xy1 = xy01;
+   *xy2 = xy02;
+}
+
+#endif /* PITCH_NEON_H */
@@ -47,6 +47,9 @@
 #elif ARM_ARCH > 4
 #define OPUS_ARM_INLINE_EDSP
 #endif
+#if ARM_ARCH >= 7 && defined(__ARM_NEON__)
+#define OPUS_ARM_INLINE_NEON
+#endif
 #endif
 
 #if defined(CPU_COLDFIRE)
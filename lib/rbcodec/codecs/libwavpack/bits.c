@@ -122,7 +122,7 @@ void little_endian_to_native (void *data, char *format)
     while (*format) {
         switch (*format) {
             case 'L':
-                *(long *)cp = letoh32(*(long *)cp);
+                *(int32_t *)cp = letoh32(*(int32_t *)cp);
                 cp += 4;
                 break;
 
@@ -149,7 +149,7 @@ void native_to_little_endian (void *data, char *format)
     while (*format) {
         switch (*format) {
             case 'L':
-                *(long *)cp = htole32(*(long *)cp);
+                *(int32_t *)cp = htole32(*(int32_t *)cp);
                 cp += 4;
                 break;
 
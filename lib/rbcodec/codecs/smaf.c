@@ -113,6 +113,7 @@ static unsigned int search_chunk(const unsigned char *name, int nlen, off_t *pos
 {
     const unsigned char *buf;
     unsigned int chunksize;
+    bool found;
     size_t size;
 
     while (true)
@@ -122,9 +123,10 @@ static unsigned int search_chunk(const unsigned char *name, int nlen, off_t *pos
             break;
 
         chunksize = get_be32(buf + 4);
+        found = memcmp(buf, name, nlen) == 0;
         ci->advance_buffer(8);
         *pos += 8;
-        if (memcmp(buf, name, nlen) == 0)
+        if (found)
             return chunksize;
 
         ci->advance_buffer(chunksize);
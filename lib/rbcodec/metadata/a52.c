@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include "metadata.h"
 #include "logf.h"
+#include "metadata_common.h"
 #include "metadata_parsers.h"
 #include "platform.h"
 
@@ -50,7 +51,7 @@ bool get_a52_metadata(int fd, struct mp3entry *id3)
     unsigned long totalsamples;
     int i;
 
-    if ((lseek(fd, 0, SEEK_SET) < 0) || (read(fd, buf, 5) < 5))
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) || (meta_read(fd, buf, 5) < 5))
     {
         return false;
     }
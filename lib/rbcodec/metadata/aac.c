@@ -63,7 +63,7 @@ bool get_aac_metadata(int fd, struct mp3entry *entry)
     if (entry->id3v2len)
         setid3v2title(fd, entry);
 
-    if (-1 == lseek(fd, entry->first_frame_offset, SEEK_SET))
+    if (-1 == meta_lseek(fd, entry->first_frame_offset, SEEK_SET))
         return false;
 
     if (check_adts_syncword(fd))
@@ -71,7 +71,7 @@ bool get_aac_metadata(int fd, struct mp3entry *entry)
         int frames;
         int stat_length;
         uint64_t total;
-        if (read(fd, buf, 5) != 5)
+        if (meta_read(fd, buf, 5) != 5)
             return false;
         entry->frequency = sample_rates[(buf[0] >> 2) & 0x0F];
         entry->vbr = ((buf[3] & 0x1F) == 0x1F)
@@ -85,11 +85,11 @@ bool get_aac_metadata(int fd, struct mp3entry *entry)
             total += frame_length;
             if (frame_length < 7)
                 break;
-            if (-1 == lseek(fd, frame_length - 7, SEEK_CUR))
+            if (-1 == meta_lseek(fd, frame_length - 7, SEEK_CUR))
                 break;
             if (!check_adts_syncword(fd))
                 break;
-            if (read(fd, buf, 5) != 5)
+            if (meta_read(fd, buf, 5) != 5)
                 break;
         }
         entry->bitrate = (unsigned int)((total * entry->frequency / frames + 64000) / 128000);
@@ -102,13 +102,13 @@ bool get_aac_metadata(int fd, struct mp3entry *entry)
     else
     {
         uint32_t bitrate;
-        if (-1 == lseek(fd, entry->first_frame_offset, SEEK_SET))
+        if (-1 == meta_lseek(fd, entry->first_frame_offset, SEEK_SET))
             return false;
-        if (read(fd, buf, 5) != 5)
+        if (meta_read(fd, buf, 5) != 5)
             return false;
         if (memcmp(buf, "ADIF", 4))
             return false;
-        if (-1 == lseek(fd, (buf[4] & 0x80) ? (entry->first_frame_offset + 9) : entry->first_frame_offset, SEEK_SET))
+        if (-1 == meta_lseek(fd, (buf[4] & 0x80) ? (entry->first_frame_offset + 9) : entry->first_frame_offset, SEEK_SET))
             return false;
         read_uint32be(fd, &bitrate);
         entry->vbr = (bitrate & 0x10000000) != 0;
@@ -38,8 +38,8 @@ bool get_adx_metadata(int fd, struct mp3entry* id3)
     int looping = 0, start_adr = 0, end_adr = 0;
     
     /* try to get the basic header */
-    if ((lseek(fd, 0, SEEK_SET) < 0)
-        || (read(fd, buf, 0x38) < 0x38))
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0)
+        || (meta_read(fd, buf, 0x38) < 0x38))
     {
         DEBUGF("lseek or read failed\n");
         return false;
@@ -111,8 +111,8 @@ bool get_adx_metadata(int fd, struct mp3entry* id3)
     }
         
     /* try to get the channel header */
-    if ((lseek(fd, chanstart-6, SEEK_SET) < 0)
-        || (read(fd, buf, 6) < 6))
+    if ((meta_lseek(fd, chanstart-6, SEEK_SET) < 0)
+        || (meta_read(fd, buf, 6) < 6))
     {
         return false;
     }
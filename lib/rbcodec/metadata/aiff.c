@@ -52,7 +52,7 @@ bool get_aiff_metadata(int fd, struct mp3entry* id3)
     char *p=id3->id3v2buf;
 
 
-    if ((lseek(fd, 0, SEEK_SET) < 0) || (read(fd, &buf[0], 12) < 12) ||
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) || (meta_read(fd, &buf[0], 12) < 12) ||
         (memcmp(&buf[0], "FORM", 4) != 0) || (memcmp(&buf[8], "AIF", 3) != 0) ||
         (!(is_aifc = (buf[11] == 'C')) && buf[11] != 'F'))
     {
@@ -60,7 +60,7 @@ bool get_aiff_metadata(int fd, struct mp3entry* id3)
     }
 
 
-    while (read(fd, &buf[0], 8) == 8)
+    while (meta_read(fd, &buf[0], 8) == 8)
     {
         size_t size = get_long_be(&buf[4]); /* chunkSize */
 
@@ -69,16 +69,16 @@ bool get_aiff_metadata(int fd, struct mp3entry* id3)
             numbytes = size - 8;
 
             /* check for ID3 tag */
-            offset=lseek(fd, 0, SEEK_CUR);
-            lseek(fd, size, SEEK_CUR);
-            if ((read(fd, &buf[0], 8) == 8) &&  (memcmp(&buf[0], "ID3", 3) == 0))
+            offset=meta_lseek(fd, 0, SEEK_CUR);
+            meta_lseek(fd, size, SEEK_CUR);
+            if ((meta_read(fd, &buf[0], 8) == 8) &&  (memcmp(&buf[0], "ID3", 3) == 0))
             {
                 id3->id3v2len = get_long_be(&buf[4]);
                 read_id3_tags(fd, id3);
             }
             else
                 DEBUGF("ID3 tag not present immediately after sound data");
-            lseek(fd, offset, SEEK_SET);
+            meta_lseek(fd, offset, SEEK_SET);
             break;  /* assume COMM was already read */
         }
 
@@ -121,7 +121,7 @@ bool get_aiff_metadata(int fd, struct mp3entry* id3)
 
         else if (memcmp(&buf[0], "COMM", 4) == 0)
         {
-            if (size > sizeof(buf) || read(fd, &buf[0], size) != (ssize_t)size)
+            if (size > sizeof(buf) || meta_read(fd, &buf[0], size) != (ssize_t)size)
                 return false;
 
             numChannels = ((buf[0]<<8)|buf[1]);
@@ -150,7 +150,7 @@ bool get_aiff_metadata(int fd, struct mp3entry* id3)
         else
         {
             /* skip chunk */
-            if (lseek(fd, size, SEEK_CUR) < 0)
+            if (meta_lseek(fd, size, SEEK_CUR) < 0)
                 return false;
         }
     }
@@ -57,14 +57,16 @@ bool read_ape_tags(int fd, struct mp3entry* id3)
 {
     struct apetag_header header;
 
-    if ((lseek(fd, -APETAG_HEADER_LENGTH, SEEK_END) < 0)
-        || (ecread(fd, &header, 1, APETAG_HEADER_FORMAT, IS_BIG_ENDIAN)
+    if ((meta_lseek(fd, -APETAG_HEADER_LENGTH, SEEK_END) < 0)
+        || (meta_read(fd, &header, APETAG_HEADER_LENGTH)
             != APETAG_HEADER_LENGTH)
         || (memcmp(header.id, "APETAGEX", sizeof(header.id))))
     {
         return false;
     }
 
+    structec_convert(&header, APETAG_HEADER_FORMAT, 1, IS_BIG_ENDIAN);
+
     if ((header.version == 2000) && (header.item_count > 0)
         && (header.length > APETAG_HEADER_LENGTH)) 
     {
@@ -74,7 +76,7 @@ bool read_ape_tags(int fd, struct mp3entry* id3)
         unsigned int tag_remaining = header.length - APETAG_HEADER_LENGTH;
         unsigned int i;
 
-        if (lseek(fd, -((int)header.length), SEEK_END) < 0)
+        if (meta_lseek(fd, -((int)header.length), SEEK_END) < 0)
         {
             return false;
         }
@@ -91,11 +93,13 @@ bool read_ape_tags(int fd, struct mp3entry* id3)
                 break;
             }
             
-            if (ecread(fd, &item, 1, APETAG_ITEM_HEADER_FORMAT, IS_BIG_ENDIAN)
-                < (long) sizeof(item))
+            if (meta_read(fd, &item, sizeof(item)) < (long) sizeof(item))
             {
                 return false;
             }
+
+            structec_convert(&item, APETAG_ITEM_HEADER_FORMAT, 1,
+                             IS_BIG_ENDIAN);
             
             tag_remaining -= sizeof(item);
             r = read_string(fd, name, sizeof(name), 0, tag_remaining);
@@ -120,7 +124,7 @@ bool read_ape_tags(int fd, struct mp3entry* id3)
                 if (strcasecmp(name, "cuesheet") == 0)
                 {
                     id3->has_embedded_cuesheet = true;
-                    id3->embedded_cuesheet.pos = lseek(fd, 0, SEEK_CUR)-item.length;
+                    id3->embedded_cuesheet.pos = meta_lseek(fd, 0, SEEK_CUR)-item.length;
                     id3->embedded_cuesheet.size = item.length;
                     id3->embedded_cuesheet.encoding = CHAR_ENC_UTF_8;
                 }
@@ -164,20 +168,20 @@ bool read_ape_tags(int fd, struct mp3entry* id3)
                     /* Set the album art size and position. */
                     if (id3->albumart.type != AA_TYPE_UNKNOWN)
                     {
-                        id3->albumart.pos  = lseek(fd, - 4, SEEK_CUR);
+                        id3->albumart.pos  = meta_lseek(fd, - 4, SEEK_CUR);
                         id3->albumart.size = item.length - r;
                         id3->has_embedded_albumart = true;
                     }
                     
                     /* Seek back to this APE items begin. */
-                    if (lseek(fd, -r, SEEK_CUR) < 0)
+                    if (meta_lseek(fd, -r, SEEK_CUR) < 0)
                     {
                         return false;
                     }
                 }
 #endif
                 /* Seek to the next APE item. */
-                if (lseek(fd, item.length, SEEK_CUR) < 0)
+                if (meta_lseek(fd, item.length, SEEK_CUR) < 0)
                 {
                     return false;
                 }
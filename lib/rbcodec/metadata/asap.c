@@ -152,7 +152,7 @@ static bool parse_sap_header(int fd, struct mp3entry* id3, int file_len)
         if (module_index + 8 >= file_len)
             return false;
         /* read a char */
-        read(fd,&cur_char,1);
+        meta_read(fd,&cur_char,1);
         /* end of header */
         if (cur_char == 0xff)
             break;
@@ -165,12 +165,12 @@ static bool parse_sap_header(int fd, struct mp3entry* id3, int file_len)
             if (module_index >= file_len || (unsigned)i >= sizeof(line) - 1)
                 return false;
             /* read a char */
-            read(fd,&cur_char,1);
+            meta_read(fd,&cur_char,1);
         }
         if (++module_index >= file_len )
             return false;
         /* read a char */
-        read(fd,&cur_char,1);
+        meta_read(fd,&cur_char,1);
         if ( cur_char != 0x0a)    
             return false;    
             
@@ -227,7 +227,7 @@ static bool parse_sap_header(int fd, struct mp3entry* id3, int file_len)
         length = 180 * 1000;
     id3->length = length;
     
-    lseek(fd, 0, SEEK_SET);
+    meta_lseek(fd, 0, SEEK_SET);
     return true;
 }
 
@@ -107,7 +107,7 @@ static void asf_readGUID(int fd, guid_t* guid)
     read_uint32le(fd, &guid->v1);
     read_uint16le(fd, &guid->v2);
     read_uint16le(fd, &guid->v3);
-    read(fd, guid->v4, 8);
+    meta_read(fd, guid->v4, 8);
 }
 
 static void asf_read_object_header(asf_object_t *obj, int fd)
@@ -128,15 +128,15 @@ static int asf_intdecode(int fd, int type, int length)
 
     if (type == 3) {
         read_uint32le(fd, &tmp32);
-        lseek(fd,length - 4,SEEK_CUR);
+        meta_lseek(fd,length - 4,SEEK_CUR);
         return (int)tmp32;
     } else if (type == 4) {
         read_uint64le(fd, &tmp64);
-        lseek(fd,length - 8,SEEK_CUR);
+        meta_lseek(fd,length - 8,SEEK_CUR);
         return (int)tmp64;
     } else if (type == 5) {
         read_uint16le(fd, &tmp16);
-        lseek(fd,length - 2,SEEK_CUR);
+        meta_lseek(fd,length - 2,SEEK_CUR);
         return (int)tmp16;
     }
 
@@ -159,7 +159,7 @@ static void asf_utf16LEdecode(int fd,
     unsigned char* utf16 = utf16buf;
     unsigned char* newutf8;
 
-    n = read(fd, utf16buf, MIN(sizeof(utf16buf), utf16bytes));
+    n = meta_read(fd, utf16buf, MIN(sizeof(utf16buf), utf16bytes));
     utf16bytes -= n;
 
     while (n > 0) {
@@ -170,7 +170,7 @@ static void asf_utf16LEdecode(int fd,
                 utf16buf[0] = utf16[0];
                 utf16buf[1] = utf16[1];
 
-                n = read(fd, utf16buf + 2, MIN(sizeof(utf16buf)-2, utf16bytes));
+                n = meta_read(fd, utf16buf + 2, MIN(sizeof(utf16buf)-2, utf16bytes));
                 utf16 = utf16buf;
                 utf16bytes -= n;
                 n += 2;
@@ -198,7 +198,7 @@ static void asf_utf16LEdecode(int fd,
 
         /* We have run out of utf16 bytes, read more if available */
         if ((n == 0) && (utf16bytes > 0)) {
-            n = read(fd, utf16buf, MIN(sizeof(utf16buf), utf16bytes));
+            n = meta_read(fd, utf16buf, MIN(sizeof(utf16buf), utf16bytes));
             utf16 = utf16buf;
             utf16bytes -= n;
         }
@@ -209,7 +209,7 @@ static void asf_utf16LEdecode(int fd,
 
     if (utf16bytes > 0) {
         /* Skip any remaining bytes */
-        lseek(fd, utf16bytes, SEEK_CUR);
+        meta_lseek(fd, utf16bytes, SEEK_CUR);
     }
     return;
 }
@@ -240,7 +240,7 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
     read_uint32le(fd, &subobjects);
 
     /* Two reserved bytes - do we need to read them? */
-    lseek(fd, 2, SEEK_CUR);
+    meta_lseek(fd, 2, SEEK_CUR);
 
     //DEBUGF("Read header - size=%d, subobjects=%d\n",(int)header.size, (int)subobjects);
 
@@ -277,7 +277,7 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                     
                     /* Get the number of logical packets - uint64_t at offset 32
                      * (little endian byte order) */
-                    lseek(fd, 32, SEEK_CUR);
+                    meta_lseek(fd, 32, SEEK_CUR);
                     read_uint64le(fd, &wfx->numpackets);
                     /*DEBUGF("read packets:  %llx %lld\n", wfx->numpackets, wfx->numpackets);*/
                     
@@ -287,11 +287,11 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                     /*DEBUGF("****** length = %lums\n", id3->length);*/
 
                     /* Read the packet size - uint32_t at offset 68 */
-                    lseek(fd, 20, SEEK_CUR);
+                    meta_lseek(fd, 20, SEEK_CUR);
                     read_uint32le(fd, &wfx->packet_size);
 
                     /* Skip bytes remaining in object */
-                    lseek(fd, current.size - 24 - 72, SEEK_CUR);
+                    meta_lseek(fd, current.size - 24 - 72, SEEK_CUR);
             } else if (asf_guid_match(&current.guid, &asf_guid_stream_properties)) {
                     guid_t guid;
                     uint32_t propdatalen;
@@ -307,16 +307,16 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
 
                     asf_readGUID(fd, &guid);
 
-                    lseek(fd, 24, SEEK_CUR);
+                    meta_lseek(fd, 24, SEEK_CUR);
                     read_uint32le(fd, &propdatalen);
-                    lseek(fd, 4, SEEK_CUR);
+                    meta_lseek(fd, 4, SEEK_CUR);
                     read_uint16le(fd, &flags);
 
                     if (!asf_guid_match(&guid, &asf_guid_stream_type_audio)) {
                         //DEBUGF("Found stream properties for non audio stream, skipping\n");
-                        lseek(fd,current.size - 24 - 50,SEEK_CUR);
+                        meta_lseek(fd,current.size - 24 - 50,SEEK_CUR);
                     } else if (wfx->audiostream == -1) {
-                        lseek(fd, 4, SEEK_CUR);
+                        meta_lseek(fd, 4, SEEK_CUR);
                         //DEBUGF("Found stream properties for audio stream %d\n",flags&0x7f);
 
                         if (propdatalen < 18) {
@@ -356,28 +356,28 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                         id3->frequency = wfx->rate;
 
                         if (wfx->codec_id == ASF_CODEC_ID_WMAV1) {
-                            read(fd, wfx->data, 4);
-                            lseek(fd,current.size - 24 - 72 - 4,SEEK_CUR);
+                            meta_read(fd, wfx->data, 4);
+                            meta_lseek(fd,current.size - 24 - 72 - 4,SEEK_CUR);
                             wfx->audiostream = flags&0x7f;
                         } else if (wfx->codec_id == ASF_CODEC_ID_WMAV2) {
-                            read(fd, wfx->data, 6);
-                            lseek(fd,current.size - 24 - 72 - 6,SEEK_CUR);
+                            meta_read(fd, wfx->data, 6);
+                            meta_lseek(fd,current.size - 24 - 72 - 6,SEEK_CUR);
                             wfx->audiostream = flags&0x7f;
                         } else if (wfx->codec_id == ASF_CODEC_ID_WMAPRO) {
                             /* wma pro decoder needs the extra-data */
-                            read(fd, wfx->data, wfx->datalen);
-                            lseek(fd,current.size - 24 - 72 - wfx->datalen,SEEK_CUR);
+                            meta_read(fd, wfx->data, wfx->datalen);
+                            meta_lseek(fd,current.size - 24 - 72 - wfx->datalen,SEEK_CUR);
                             wfx->audiostream = flags&0x7f;
                             /* Correct codectype to redirect playback to the proper .codec */
                             id3->codectype = AFMT_WMAPRO;
                         } else if (wfx->codec_id == ASF_CODEC_ID_WMAVOICE) {
-                            read(fd, wfx->data, wfx->datalen);
-                            lseek(fd,current.size - 24 - 72 - wfx->datalen,SEEK_CUR);
+                            meta_read(fd, wfx->data, wfx->datalen);
+                            meta_lseek(fd,current.size - 24 - 72 - wfx->datalen,SEEK_CUR);
                             wfx->audiostream = flags&0x7f;
                             id3->codectype = AFMT_WMAVOICE;
                         } else {
                             DEBUGF("Unsupported WMA codec (Lossless, Voice, etc)\n");
-                            lseek(fd,current.size - 24 - 72,SEEK_CUR);
+                            meta_lseek(fd,current.size - 24 - 72,SEEK_CUR);
                         }
 
                     }
@@ -406,14 +406,14 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                         asf_utf16LEdecode(fd, strlength[1], &id3buf, &id3buf_remaining);
                     }
 
-                    lseek(fd, strlength[2], SEEK_CUR); /* 2 - copyright */
+                    meta_lseek(fd, strlength[2], SEEK_CUR); /* 2 - copyright */
 
                     if (strlength[3] > 0) {  /* 3 - description */
                         id3->comment = id3buf;
                         asf_utf16LEdecode(fd, strlength[3], &id3buf, &id3buf_remaining);
                     }
 
-                    lseek(fd, strlength[4], SEEK_CUR); /* 4 - rating */
+                    meta_lseek(fd, strlength[4], SEEK_CUR); /* 4 - rating */
             } else if (asf_guid_match(&current.guid, &asf_guid_extended_content_description)) {
                     uint16_t count;
                     int i;
@@ -444,7 +444,7 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                             } else if ((type >=2) && (type <= 5)) {
                                 id3->tracknum = asf_intdecode(fd, type, length);
                             } else {
-                                lseek(fd, length, SEEK_CUR);
+                                meta_lseek(fd, length, SEEK_CUR);
                             }
                         } else if ((!strcmp("WM/Genre", utf8buf)) && (type == 0)) {
                             id3->genre_string = id3buf;
@@ -466,7 +466,7 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                             } else if ((type >=2) && (type <= 5)) {
                                 id3->year = asf_intdecode(fd, type, length);
                             } else {
-                                lseek(fd, length, SEEK_CUR);
+                                meta_lseek(fd, length, SEEK_CUR);
                             }
                         } else if (!strncmp("replaygain_", utf8buf, 11)) {
                             char *value = id3buf;
@@ -482,11 +482,11 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                              * "03 yy yy yy yy". xx is the size of the WM/Picture 
                              * container in bytes. yy equals the raw data length of 
                              * the embedded image. */
-                            lseek(fd, -4, SEEK_CUR);
-                            read(fd, &type, 1);
+                            meta_lseek(fd, -4, SEEK_CUR);
+                            meta_read(fd, &type, 1);
                             if (type == 1) {
-                                lseek(fd, 3, SEEK_CUR);
-                                read(fd, &type, 1);
+                                meta_lseek(fd, 3, SEEK_CUR);
+                                meta_read(fd, &type, 1);
                                 /* In case the parsing will fail in the next step we 
                                  * might at least be able to skip the whole section. */
                                 datalength = length - 1;
@@ -503,7 +503,7 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
                                  * double zero-termination. */
                                 asf_utf16LEdecode(fd, 32, &utf8, &utf8length);
                                 strlength = (strlen(utf8buf) + 2) * 2;
-                                lseek(fd, strlength-32, SEEK_CUR);
+                                meta_lseek(fd, strlength-32, SEEK_CUR);
                                 if (!strcmp("image/jpeg", utf8buf)) {
                                     id3->albumart.type = AA_TYPE_JPG;
                                 } else if (!strcmp("image/jpg", utf8buf)) {
@@ -518,28 +518,28 @@ static int asf_parse_header(int fd, struct mp3entry* id3,
 
                                 /* Set the album art size and position. */
                                 if (id3->albumart.type != AA_TYPE_UNKNOWN) {
-                                    id3->albumart.pos  = lseek(fd, 0, SEEK_CUR);
+                                    id3->albumart.pos  = meta_lseek(fd, 0, SEEK_CUR);
                                     id3->albumart.size = datalength;
                                     id3->has_embedded_albumart = true;
                                 }
                             }
                             
-                            lseek(fd, datalength, SEEK_CUR);
+                            meta_lseek(fd, datalength, SEEK_CUR);
 #endif
                         } else {
-                            lseek(fd, length, SEEK_CUR);
+                            meta_lseek(fd, length, SEEK_CUR);
                         }
                         bytesleft -= 4 + length;
                     }
 
-                    lseek(fd, bytesleft, SEEK_CUR);
+                    meta_lseek(fd, bytesleft, SEEK_CUR);
             } else if (asf_guid_match(&current.guid, &asf_guid_content_encryption)
                 || asf_guid_match(&current.guid, &asf_guid_extended_content_encryption)) {
                 //DEBUGF("File is encrypted\n");
                 return ASF_ERROR_ENCRYPTED;
             } else {
                 //DEBUGF("Skipping %d bytes of object\n",(int)(current.size - 24));
-                lseek(fd,current.size - 24,SEEK_CUR);
+                meta_lseek(fd,current.size - 24,SEEK_CUR);
             }
 
             //DEBUGF("Parsed object - size = %d\n",(int)current.size);
@@ -598,7 +598,7 @@ bool get_asf_metadata(int fd, struct mp3entry* id3)
        again in the codec.  The +26 skips the rest of the data object
        header.
      */
-    id3->first_frame_offset = lseek(fd, 0, SEEK_CUR) + 26;
+    id3->first_frame_offset = meta_lseek(fd, 0, SEEK_CUR) + 26;
     id3->filesize = filesize(fd);
     /* We copy the wfx struct to the MP3 TOC field in the id3 struct so
        the codec doesn't need to parse the header object again */
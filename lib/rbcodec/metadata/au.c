@@ -62,8 +62,8 @@ bool get_au_metadata(int fd, struct mp3entry* id3)
     id3->filesize = filesize(fd);
     id3->length   = 0;
 
-    lseek(fd, 0, SEEK_SET);
-    if ((read(fd, buf, 24) < 24) || (memcmp(buf, ".snd", 4) != 0))
+    meta_lseek(fd, 0, SEEK_SET);
+    if ((meta_read(fd, buf, 24) < 24) || (memcmp(buf, ".snd", 4) != 0))
     {
         /*
          * no header
@@ -115,8 +115,8 @@ static bool parse_ay_header(int fd, struct mp3entry *id3)
     struct file_t file;
     int read_bytes;
 
-    lseek(fd, 0, SEEK_SET);
-    if ((read_bytes = read(fd, buf, ID3V2_BUF_SIZE)) < header_size)
+    meta_lseek(fd, 0, SEEK_SET);
+    if ((read_bytes = meta_read(fd, buf, ID3V2_BUF_SIZE)) < header_size)
         return false;
 
     buf [ID3V2_BUF_SIZE] = '\0';
@@ -130,8 +130,8 @@ static bool parse_ay_header(int fd, struct mp3entry *id3)
 bool get_ay_metadata(int fd, struct mp3entry* id3)
 {
     char ay_type[8];
-    if ((lseek(fd, 0, SEEK_SET) < 0) ||
-         read(fd, ay_type, 8) < 8)
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) ||
+         meta_read(fd, ay_type, 8) < 8)
         return false;
 
     id3->vbr = false;
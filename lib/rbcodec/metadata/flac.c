@@ -44,7 +44,7 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
     bool last_metadata = false;
     bool rc = false;
 
-    if (!skip_id3v2(fd, id3) || (read(fd, buf, 4) < 4))
+    if (!skip_id3v2(fd, id3) || (meta_read(fd, buf, 4) < 4))
     {
         return rc;
     }
@@ -59,7 +59,7 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
         unsigned long i;
         int type;
 
-        if (read(fd, buf, 4) != 4)
+        if (meta_read(fd, buf, 4) != 4)
         {
             return rc;
         }
@@ -73,7 +73,7 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
         {
             unsigned long totalsamples;
 
-            if (i >= sizeof(id3->path) || read(fd, buf, i) != (int)i)
+            if (i >= sizeof(id3->path) || meta_read(fd, buf, i) != (int)i)
             {
                 return rc;
             }
@@ -122,9 +122,9 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
                 int picframe_pos = 4; /* skip picture type */
                 int mime_length, description_length;
 
-                id3->albumart.pos = lseek(fd, 0, SEEK_CUR);
+                id3->albumart.pos = meta_lseek(fd, 0, SEEK_CUR);
 
-                int bytes_read = read(fd, buf, buf_size);
+                int bytes_read = meta_read(fd, buf, buf_size);
                 i -= bytes_read;
 
                 mime_length = get_long_be(&buf[picframe_pos]);
@@ -157,7 +157,7 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
                 }
             }
 
-            if (lseek(fd, i, SEEK_CUR) < 0)
+            if (meta_lseek(fd, i, SEEK_CUR) < 0)
             {
                 return rc;
             }
@@ -166,7 +166,7 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
         else if (!last_metadata)
         {
             /* Skip to next metadata block */
-            if (lseek(fd, i, SEEK_CUR) < 0)
+            if (meta_lseek(fd, i, SEEK_CUR) < 0)
             {
                 return rc;
             }
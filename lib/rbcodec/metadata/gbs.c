@@ -14,8 +14,8 @@ static bool parse_gbs_header(int fd, struct mp3entry* id3)
 {
     /* Use the trackname part of the id3 structure as a temporary buffer */
     unsigned char* buf = (unsigned char *)id3->path;
-    lseek(fd, 0, SEEK_SET);
-    if (read(fd, buf, 112) < 112)
+    meta_lseek(fd, 0, SEEK_SET);
+    if (meta_read(fd, buf, 112) < 112)
         return false;
 
     /* Calculate track length with number of subtracks */
@@ -47,8 +47,8 @@ static bool parse_gbs_header(int fd, struct mp3entry* id3)
 bool get_gbs_metadata(int fd, struct mp3entry* id3)
 {
     char gbs_type[3];
-    if ((lseek(fd, 0, SEEK_SET) < 0) ||
-         (read(fd, gbs_type, 3) < 3))
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) ||
+         (meta_read(fd, gbs_type, 3) < 3))
         return false;
 
     id3->vbr = false;
@@ -17,8 +17,8 @@ bool get_hes_metadata(int fd, struct mp3entry* id3)
     unsigned char* buf = (unsigned char *)id3->id3v2buf;
     int read_bytes;
 
-    if ((lseek(fd, 0, SEEK_SET) < 0) 
-         || ((read_bytes = read(fd, buf, 4)) < 4))
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) 
+         || ((read_bytes = meta_read(fd, buf, 4)) < 4))
         return false;
 
     /* Verify this is a HES file */
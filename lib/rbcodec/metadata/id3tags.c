@@ -208,7 +208,7 @@ static int read_unsynched(int fd, void *buf, int len)
 
     while(remaining) {
         rp = wp;
-        rc = read(fd, rp, remaining);
+        rc = meta_read(fd, rp, remaining);
         if(rc <= 0)
             return rc;
 
@@ -229,7 +229,7 @@ static int skip_unsynched(int fd, int len)
 
     while(remaining) {
         rlen = MIN(sizeof(buf), (unsigned int)remaining);
-        rc = read(fd, buf, rlen);
+        rc = meta_read(fd, buf, rlen);
         if(rc <= 0)
             return rc;
 
@@ -291,21 +291,29 @@ static int parsegenre( struct mp3entry* entry, char* tag, int bufferpos )
 }
 
 #ifdef HAVE_ALBUMART
-/* parse embed albumart */
+/* parse embed albumart - only the location of the picture data is recorded,
+ * the image itself is never read here */
 static int parsealbumart( struct mp3entry* entry, char* tag, int bufferpos )
 {
+    /* the frame data was only needed to find the picture; give the space
+       in id3v2buf back */
+    int start_pos = tag - entry->id3v2buf;
+    /* the frame data that was read ends at the added nil */
+    const char *end = entry->id3v2buf + bufferpos - 1;
+
     /* don't parse albumart if already one found. This callback function is
      * called unconditionally. */
     if(entry->has_embedded_albumart)
-        return bufferpos;
+        return start_pos;
 
     /* we currently don't support unsynchronizing albumart */
     if (entry->albumart.type == AA_TYPE_UNSYNC)
-        return bufferpos;
+        return start_pos;
 
     entry->albumart.type = AA_TYPE_UNKNOWN;
 
     char *start = tag;
+    char encoding = *tag;
     /* skip text encoding */
     tag += 1;
 
@@ -345,16 +353,37 @@ static int parsealbumart( struct mp3entry* entry, char* tag, int bufferpos )
     {
         /* skip picture type */
         tag += 1;
-        /* skip description */
-        tag = strchr(tag, '\0') + 1;
+
+        /* skip description; UTF-16 strings end with a double nil */
+        if (encoding == 0x01 || encoding == 0x02)
+        {
+            while (tag + 1 < end && (tag[0] | tag[1]) != 0)
+                tag += 2;
+            tag += 2;
+        }
+        else
+        {
+            while (tag < end && *tag != '\0')
+                tag++;
+            tag += 1;
+        }
+
+        if (tag > end)
+        {
+            /* description longer than what was read - the picture offset
+               can't be known */
+            entry->albumart.type = AA_TYPE_UNKNOWN;
+            return start_pos;
+        }
+
         /* fixup offset&size for image data */
         entry->albumart.pos  += tag - start;
         entry->albumart.size -= tag - start;
         /* check for malformed tag with no picture data */
-        entry->has_embedded_albumart = (entry->albumart.size != 0);
+        entry->has_embedded_albumart = (entry->albumart.size > 0);
     }
-    /* return bufferpos as we didn't store anything in id3v2buf */
-    return bufferpos;
+
+    return start_pos;
 }
 #endif
 
@@ -629,10 +658,10 @@ bool setid3v1title(int fd, struct mp3entry *entry)
     int i, j;
     unsigned char* utf8;
 
-    if (-1 == lseek(fd, -128, SEEK_END))
+    if (-1 == meta_lseek(fd, -128, SEEK_END))
         return false;
 
-    if (read(fd, buffer, sizeof buffer) != sizeof buffer)
+    if (meta_read(fd, buffer, sizeof buffer) != sizeof buffer)
         return false;
 
     if (strncmp((char *)buffer, "TAG", 3))
@@ -742,7 +771,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
 
     /* Read the ID3 tag version from the header.
        Assumes fd is already at the begining of the header */
-    if(10 != read(fd, header, 10))
+    if(10 != meta_read(fd, header, 10))
         return;
 
     /* Get the total ID3 tag size */
@@ -778,7 +807,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
     /* Skip the extended header if it is present */
     if(global_flags & 0x40) {
         if(version == ID3_VER_2_3) {
-            if(10 != read(fd, header, 10))
+            if(10 != meta_read(fd, header, 10))
                 return;
             /* The 2.3 extended header size doesn't include the header size
                field itself. Also, it is not unsynched. */
@@ -786,11 +815,11 @@ void setid3v2title(int fd, struct mp3entry *entry)
                 bytes2int(header[0], header[1], header[2], header[3]) + 4;
 
             /* Skip the rest of the header */
-            lseek(fd, framelen - 10, SEEK_CUR);
+            meta_lseek(fd, framelen - 10, SEEK_CUR);
         }
 
         if(version >= ID3_VER_2_4) {
-            if(4 != read(fd, header, 4))
+            if(4 != meta_read(fd, header, 4))
                 return;
 
             /* The 2.4 extended header size does include the entire header,
@@ -798,7 +827,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
             framelen = unsync(header[0], header[1],
                               header[2], header[3]);
 
-            lseek(fd, framelen - 4, SEEK_CUR);
+            meta_lseek(fd, framelen - 4, SEEK_CUR);
         }
     }
 
@@ -819,7 +848,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
             if(global_unsynch && version <= ID3_VER_2_3)
                 rc = read_unsynched(fd, header, 10);
             else
-                rc = read(fd, header, 10);
+                rc = meta_read(fd, header, 10);
             if(rc != 10)
                 return;
             /* Adjust for the 10 bytes we read */
@@ -837,7 +866,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
                                      header[6], header[7]);
             }
         } else {
-            if(6 != read(fd, header, 6))
+            if(6 != meta_read(fd, header, 6))
                 return;
             /* Adjust for the 6 bytes we read */
             size -= 6;
@@ -859,12 +888,12 @@ void setid3v2title(int fd, struct mp3entry *entry)
         {
             if (version >= ID3_VER_2_4) {
                 if(flags & 0x0040) { /* Grouping identity */
-                    lseek(fd, 1, SEEK_CUR); /* Skip 1 byte */
+                    meta_lseek(fd, 1, SEEK_CUR); /* Skip 1 byte */
                     framelen--;
                 }
             } else {
                 if(flags & 0x0020) { /* Grouping identity */
-                    lseek(fd, 1, SEEK_CUR); /* Skip 1 byte */
+                    meta_lseek(fd, 1, SEEK_CUR); /* Skip 1 byte */
                     framelen--;
                 }
             }
@@ -873,7 +902,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
             {
                 /* Skip it */
                 size -= framelen;
-                lseek(fd, framelen, SEEK_CUR);
+                meta_lseek(fd, framelen, SEEK_CUR);
                 continue;
             }
 
@@ -882,7 +911,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
 
             if (version >= ID3_VER_2_4) {
                 if(flags & 0x0001) { /* Data length indicator */
-                    if(4 != read(fd, tmp, 4))
+                    if(4 != meta_read(fd, tmp, 4))
                         return;
 
                     /* We don't need the data length */
@@ -946,13 +975,19 @@ void setid3v2title(int fd, struct mp3entry *entry)
 
             if( !memcmp( header, tr->tag, tr->tag_length ) ) {
 
+#ifdef HAVE_ALBUMART
+                /* only the first picture is used - skip the others without
+                   reading any of the image data */
+                if (tr->ppFunc == &parsealbumart && entry->has_embedded_albumart)
+                    continue;
+#endif
                 /* found a tag matching one in tagList, and not yet filled */
                 tag = buffer + bufferpos;
 
                 if(global_unsynch && version <= ID3_VER_2_3)
                     bytesread = read_unsynched(fd, tag, framelen);
                 else
-                    bytesread = read(fd, tag, framelen);
+                    bytesread = meta_read(fd, tag, framelen);
 
                 if( bytesread != framelen )
                     return;
@@ -1031,7 +1066,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
                         }
                         if (char_enc > 0) {
                             entry->has_embedded_cuesheet = true;
-                            entry->embedded_cuesheet.pos = lseek(fd, 0, SEEK_CUR)
+                            entry->embedded_cuesheet.pos = meta_lseek(fd, 0, SEEK_CUR)
                                 - framelen + cuesheet_offset;
                             entry->embedded_cuesheet.size = totframelen
                                 - cuesheet_offset;
@@ -1082,7 +1117,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
                         entry->albumart.type = AA_TYPE_UNSYNC;
                     else
                     {
-                        entry->albumart.pos = lseek(fd, 0, SEEK_CUR) - framelen;
+                        entry->albumart.pos = meta_lseek(fd, 0, SEEK_CUR) - framelen;
                         entry->albumart.size = totframelen;
                         entry->albumart.type = AA_TYPE_UNKNOWN;
                     }
@@ -1102,7 +1137,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
                 size -= skip_unsynched(fd, totframelen);
             } else {
                 size -= totframelen;
-                if( lseek(fd, totframelen, SEEK_CUR) == -1 )
+                if( meta_lseek(fd, totframelen, SEEK_CUR) == -1 )
                     return;
             }
         } else {
@@ -1112,7 +1147,7 @@ void setid3v2title(int fd, struct mp3entry *entry)
                     size -= skip_unsynched(fd, totframelen - framelen);
                 }
                 else {
-                    lseek(fd, totframelen - framelen, SEEK_CUR);
+                    meta_lseek(fd, totframelen - framelen, SEEK_CUR);
                     size -= totframelen - framelen;
                 }
             }
@@ -1131,10 +1166,10 @@ int getid3v1len(int fd)
 {
     char buf[4];
 
-    if (-1 == lseek(fd, -128, SEEK_END))
+    if (-1 == meta_lseek(fd, -128, SEEK_END))
         return 0;
 
-    if (read(fd, buf, 3) != 3)
+    if (meta_read(fd, buf, 3) != 3)
         return 0;
 
     if (strncmp(buf, "TAG", 3))
@@ -1156,22 +1191,22 @@ int getid3v2len(int fd)
     int offset;
 
     /* Make sure file has a ID3 tag */
-    if((-1 == lseek(fd, 0, SEEK_SET)) ||
-       (read(fd, buf, 6) != 6) ||
+    if((-1 == meta_lseek(fd, 0, SEEK_SET)) ||
+       (meta_read(fd, buf, 6) != 6) ||
        (strncmp(buf, "ID3", strlen("ID3")) != 0))
         offset = 0;
 
     /* Now check what the ID3v2 size field says */
     else
     {
-        if(read(fd, buf, 4) != 4)
+        if(meta_read(fd, buf, 4) != 4)
             offset = 0;
         else
             offset = unsync(buf[0], buf[1], buf[2], buf[3]) + 10;
     }
 
     logf("ID3V2 Length: 0x%x", offset);
-    lseek(fd, -10, SEEK_CUR);
+    meta_lseek(fd, -10, SEEK_CUR);
     return offset;
 }
 
@@ -15,8 +15,8 @@ static bool parse_kss_header(int fd, struct mp3entry* id3)
     /* Use the trackname part of the id3 structure as a temporary buffer */
     unsigned char* buf = (unsigned char *)id3->path;
 
-     lseek(fd, 0, SEEK_SET);
-     if (read(fd, buf, 0x20) < 0x20)
+     meta_lseek(fd, 0, SEEK_SET);
+     if (meta_read(fd, buf, 0x20) < 0x20)
         return false;
 
     /* calculate track length with number of tracks */
@@ -35,7 +35,7 @@ static bool parse_kss_header(int fd, struct mp3entry* id3)
 bool get_kss_metadata(int fd, struct mp3entry* id3)
 {
    uint32_t kss_type;
-    if ((lseek(fd, 0, SEEK_SET) < 0) ||
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) ||
          read_uint32be(fd, &kss_type) != (int)sizeof(kss_type))
         return false;
 
@@ -446,7 +446,12 @@ bool get_metadata(struct mp3entry* id3, int fd, const char* trackname)
         return false;
     }
 
-    if (!entry->parse_func(fd, id3))
+    bool buffered = meta_readahead_begin(fd);
+    bool parsed = entry->parse_func(fd, id3);
+    if (buffered)
+        meta_readahead_end(fd);
+
+    if (!parsed)
     {
         DEBUGF("parsing %s failed (format: %s)\n", trackname, entry->label);
         return false;
@@ -531,6 +536,122 @@ void copy_mp3entry(struct mp3entry *dest, const struct mp3entry *orig)
     adjust_mp3entry(dest, dest, orig);
 }
 
+/* The parts of struct mp3entry between the string buffers, stored as is */
+#define PACKED_A_START  offsetof(struct mp3entry, title)
+#define PACKED_A_END    offsetof(struct mp3entry, id3v2buf)
+#define PACKED_B_START  (offsetof(struct mp3entry, id3v1buf) + \
+                         sizeof (((struct mp3entry *)0)->id3v1buf))
+#define PACKED_B_END    sizeof (struct mp3entry)
+
+/* Bytes of the buffer at base that hold s, or 0 if s isn't in it */
+static size_t string_end(const char *base, size_t size, const char *s)
+{
+    if (s < base || s >= base + size)
+        return 0;
+
+    const char *end = memchr(s, '\0', base + size - s);
+    return (end ? end + 1 : base + size) - base;
+}
+
+/* Used bytes of the buffer at base: up to the end of the last string in it */
+static size_t buffer_used(const struct mp3entry *entry, const char *base,
+                          size_t size)
+{
+    const char * const strings[] =
+    {
+        entry->title, entry->artist, entry->album, entry->genre_string,
+        entry->disc_string, entry->track_string, entry->year_string,
+        entry->composer, entry->comment, entry->albumartist,
+        entry->grouping, entry->mb_track_id,
+    };
+
+    size_t used = 0;
+    for (size_t i = 0; i < ARRAYLEN(strings); i++)
+        used = MAX(used, string_end(base, size, strings[i]));
+
+    return used;
+}
+
+static void packed_lengths(const struct mp3entry *entry,
+                           struct mp3entry_packed *hdr)
+{
+    hdr->orig = (uintptr_t)entry;
+    hdr->path_len = MAX(string_end(entry->path, sizeof (entry->path),
+                                   entry->path),
+                        buffer_used(entry, entry->path,
+                                    sizeof (entry->path)));
+    hdr->id3v2_len = buffer_used(entry, entry->id3v2buf,
+                                 sizeof (entry->id3v2buf));
+    hdr->id3v1_len = buffer_used(entry, entry->id3v1buf[0],
+                                 sizeof (entry->id3v1buf));
+    hdr->size = sizeof (struct mp3entry_packed) + hdr->path_len +
+                (PACKED_A_END - PACKED_A_START) + hdr->id3v2_len +
+                hdr->id3v1_len + (PACKED_B_END - PACKED_B_START);
+}
+
+size_t mp3entry_packed_size(const struct mp3entry *entry)
+{
+    struct mp3entry_packed hdr;
+    packed_lengths(entry, &hdr);
+    return hdr.size;
+}
+
+size_t pack_mp3entry(void *dest, const struct mp3entry *entry)
+{
+    struct mp3entry_packed hdr;
+    packed_lengths(entry, &hdr);
+
+    /* every part moves down or stays, so memmove allows packing in place */
+    const char *src = (const char *)entry;
+    char *p = (char *)dest + sizeof (hdr);
+
+    memmove(p, entry->path, hdr.path_len);
+    p += hdr.path_len;
+    memmove(p, src + PACKED_A_START, PACKED_A_END - PACKED_A_START);
+    p += PACKED_A_END - PACKED_A_START;
+    memmove(p, entry->id3v2buf, hdr.id3v2_len);
+    p += hdr.id3v2_len;
+    memmove(p, entry->id3v1buf, hdr.id3v1_len);
+    p += hdr.id3v1_len;
+    memmove(p, src + PACKED_B_START, PACKED_B_END - PACKED_B_START);
+
+    memcpy(dest, &hdr, sizeof (hdr));
+    return hdr.size;
+}
+
+bool unpack_mp3entry(struct mp3entry *dest, const void *packed, size_t size)
+{
+    struct mp3entry_packed hdr;
+
+    if (size < sizeof (hdr))
+        return false;
+
+    memcpy(&hdr, packed, sizeof (hdr));
+    if (hdr.size != size || hdr.path_len > sizeof (dest->path) ||
+        hdr.id3v2_len > sizeof (dest->id3v2buf) ||
+        hdr.id3v1_len > sizeof (dest->id3v1buf))
+        return false;
+
+    char *d = (char *)dest;
+    const char *p = (const char *)packed + sizeof (hdr);
+
+    memcpy(dest->path, p, hdr.path_len);
+    p += hdr.path_len;
+    memcpy(d + PACKED_A_START, p, PACKED_A_END - PACKED_A_START);
+    p += PACKED_A_END - PACKED_A_START;
+    memcpy(dest->id3v2buf, p, hdr.id3v2_len);
+    p += hdr.id3v2_len;
+    memcpy(dest->id3v1buf, p, hdr.id3v1_len);
+    p += hdr.id3v1_len;
+    memcpy(d + PACKED_B_START, p, PACKED_B_END - PACKED_B_START);
+
+    if (hdr.path_len == 0)
+        dest->path[0] = '\0';
+
+    adjust_mp3entry(dest, dest, (const void *)hdr.orig);
+    return true;
+}
+
 /* A shortcut to simplify the common task of clearing the struct */
 void wipe_mp3entry(struct mp3entry *id3)
 {
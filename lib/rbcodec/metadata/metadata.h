@@ -318,6 +318,29 @@ struct mp3entry {
     char* mb_track_id;
 };
 
+/* Packed, variable-length form of struct mp3entry for keeping many of them
+ * around: only the used parts of path, id3v2buf and id3v1buf are stored after
+ * the rest of the entry's fields. The string pointers remain relative to the
+ * entry the record was packed from and are adjusted when unpacking. */
+struct mp3entry_packed
+{
+    uintptr_t orig;         /* address of the entry at packing time */
+    uint16_t  size;         /* bytes in the record, this header included */
+    uint16_t  path_len;     /* bytes kept of path, */
+    uint16_t  id3v2_len;    /* id3v2buf */
+    uint16_t  id3v1_len;    /* and id3v1buf */
+} __attribute__((aligned(8)));
+
+/* Largest possible record */
+#define MP3ENTRY_PACKED_MAX \
+    (sizeof (struct mp3entry_packed) + sizeof (struct mp3entry))
+
+size_t mp3entry_packed_size(const struct mp3entry *entry);
+/* entry may be at dest + sizeof (struct mp3entry_packed) for packing in
+   place; returns the record's size */
+size_t pack_mp3entry(void *dest, const struct mp3entry *entry);
+bool unpack_mp3entry(struct mp3entry *dest, const void *packed, size_t size);
+
 unsigned int probe_file_format(const char *filename);
 bool get_metadata(struct mp3entry* id3, int fd, const char* trackname);
 bool mp3info(struct mp3entry *entry, const char *filename);
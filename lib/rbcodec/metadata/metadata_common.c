@@ -30,6 +30,176 @@
 #include "metadata_parsers.h"
 #include "replaygain.h"
 
+#if METADATA_READAHEAD_SIZE > 0
+/* Read-ahead window shared by the parsers while get_metadata() runs. Tag
+ * parsing issues many tiny reads and short seeks; serving them from one
+ * larger window keeps the number of file system calls per file low.
+ * Only one file is buffered at a time - any other fd, or a parse that
+ * starts while the window is in use, goes straight to the file. */
+static struct
+{
+    int fd;           /* file being buffered or -1 if idle */
+    off_t size;       /* size of the file */
+    off_t pos;        /* logical file position seen by the parsers */
+    off_t fpos;       /* actual position of the underlying fd */
+    off_t start;      /* file offset of buf[0] */
+    size_t len;       /* number of valid bytes in buf */
+    unsigned char buf[METADATA_READAHEAD_SIZE];
+} meta_ra = { .fd = -1 };
+
+bool meta_readahead_begin(int fd)
+{
+    if (meta_ra.fd >= 0 || fd < 0)
+        return false;
+
+    /* claim the window before anything that can yield; get_metadata() is
+       called from several threads */
+    meta_ra.fd = fd;
+
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0)
+    {
+        meta_ra.fd = -1;
+        return false;
+    }
+
+    meta_ra.size = filesize(fd);
+    meta_ra.pos = pos;
+    meta_ra.fpos = pos;
+    meta_ra.start = 0;
+    meta_ra.len = 0;
+    return true;
+}
+
+void meta_readahead_end(int fd)
+{
+    if (meta_ra.fd != fd)
+        return;
+
+    /* leave the fd where the parser thinks it is */
+    if (meta_ra.fpos != meta_ra.pos)
+        lseek(fd, meta_ra.pos, SEEK_SET);
+
+    meta_ra.fd = -1;
+}
+
+ssize_t meta_read(int fd, void *buf, size_t count)
+{
+    if (fd != meta_ra.fd)
+        return read(fd, buf, count);
+
+    unsigned char *p = buf;
+    ssize_t done = 0;
+
+    while (count > 0)
+    {
+        if (meta_ra.pos >= meta_ra.start &&
+            meta_ra.pos < meta_ra.start + (off_t)meta_ra.len)
+        {
+            size_t offs = meta_ra.pos - meta_ra.start;
+            size_t n = MIN(count, meta_ra.len - offs);
+            memcpy(p, &meta_ra.buf[offs], n);
+            p += n;
+            count -= n;
+            done += n;
+            meta_ra.pos += n;
+            continue;
+        }
+
+        if (meta_ra.fpos != meta_ra.pos)
+        {
+            if (lseek(fd, meta_ra.pos, SEEK_SET) < 0)
+                return done ? done : -1;
+
+            meta_ra.fpos = meta_ra.pos;
+        }
+
+        ssize_t rc;
+
+        if (count >= sizeof (meta_ra.buf))
+        {
+            /* large reads bypass the window */
+            rc = read(fd, p, count);
+            if (rc > 0)
+            {
+                meta_ra.fpos += rc;
+                meta_ra.pos += rc;
+                done += rc;
+            }
+
+            break;
+        }
+
+        rc = read(fd, meta_ra.buf, sizeof (meta_ra.buf));
+        if (rc <= 0)
+        {
+            meta_ra.len = 0;
+            if (rc < 0 && done == 0)
+                return rc;
+
+            break;
+        }
+
+        meta_ra.start = meta_ra.pos;
+        meta_ra.len = rc;
+        meta_ra.fpos += rc;
+    }
+
+    return done;
+}
+
+off_t meta_lseek(int fd, off_t offset, int whence)
+{
+    if (fd != meta_ra.fd)
+        return lseek(fd, offset, whence);
+
+    off_t pos;
+
+    switch (whence)
+    {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = meta_ra.pos + offset;
+        break;
+    case SEEK_END:
+        pos = meta_ra.size + offset;
+        break;
+    default:
+        return -1;
+    }
+
+    /* same limits as the file system; the real seek happens on next read */
+    if (pos < 0 || pos > meta_ra.size)
+        return -1;
+
+    meta_ra.pos = pos;
+    return pos;
+}
+#else /* METADATA_READAHEAD_SIZE == 0 */
+bool meta_readahead_begin(int fd)
+{
+    (void)fd;
+    return false;
+}
+
+void meta_readahead_end(int fd)
+{
+    (void)fd;
+}
+
+ssize_t meta_read(int fd, void *buf, size_t count)
+{
+    return read(fd, buf, count);
+}
+
+off_t meta_lseek(int fd, off_t offset, int whence)
+{
+    return lseek(fd, offset, whence);
+}
+#endif /* METADATA_READAHEAD_SIZE */
+
 /* Read a string from the file. Read up to size bytes, or, if eos != -1, 
  * until the eos character is found (eos is not stored in buf, unless it is
  * nil). Writes up to buf_size chars to buf, always terminating with a nil.
@@ -42,7 +212,7 @@ long read_string(int fd, char* buf, long buf_size, int eos, long size)
     
     while (size != 0)
     {
-        if (read(fd, &c, 1) != 1)
+        if (meta_read(fd, &c, 1) != 1)
         {
             read_bytes = -1;
             break;
@@ -71,7 +241,7 @@ int read_uint8(int fd, uint8_t* buf)
 {
   size_t n;
 
-  n = read(fd, (char*) buf, 1);
+  n = meta_read(fd, (char*) buf, 1);
   return n;
 }
 
@@ -81,7 +251,7 @@ int read_uint16be(int fd, uint16_t* buf)
 {
   size_t n;
 
-  n = read(fd, (char*) buf, 2);
+  n = meta_read(fd, (char*) buf, 2);
   *buf = betoh16(*buf);
   return n;
 }
@@ -90,7 +260,7 @@ int read_uint32be(int fd, uint32_t* buf)
 {
   size_t n;
 
-  n = read(fd, (char*) buf, 4);
+  n = meta_read(fd, (char*) buf, 4);
   *buf = betoh32(*buf);
   return n;
 }
@@ -101,7 +271,7 @@ int read_uint64be(int fd, uint64_t* buf)
   uint8_t data[8];
   int i;
 
-  n = read(fd, data, 8);
+  n = meta_read(fd, data, 8);
 
   for (i=0, *buf=0; i<=7; i++) {
        *buf <<= 8;
@@ -115,7 +285,7 @@ int read_uint16le(int fd, uint16_t* buf)
 {
   size_t n;
 
-  n = read(fd, (char*) buf, 2);
+  n = meta_read(fd, (char*) buf, 2);
   *buf = letoh16(*buf);
   return n;
 }
@@ -123,7 +293,7 @@ int read_uint32le(int fd, uint32_t* buf)
 {
   size_t n;
 
-  n = read(fd, (char*) buf, 4);
+  n = meta_read(fd, (char*) buf, 4);
   *buf = letoh32(*buf);
   return n;
 }
@@ -133,7 +303,7 @@ int read_uint64le(int fd, uint64_t* buf)
   uint8_t data[8];
   int i;
 
-  n = read(fd, data, 8);
+  n = meta_read(fd, data, 8);
 
   for (i=7, *buf=0; i>=0; i--) {
        *buf <<= 8;
@@ -235,7 +405,7 @@ bool skip_id3v2(int fd, struct mp3entry *id3)
 {
     char buf[4];
 
-    read(fd, buf, 4);
+    meta_read(fd, buf, 4);
     if (memcmp(buf, "ID3", 3) == 0)
     {
         /* We have found an ID3v2 tag at the start of the file - find its
@@ -243,12 +413,12 @@ bool skip_id3v2(int fd, struct mp3entry *id3)
         if ((id3->first_frame_offset = getid3v2len(fd)) == 0)
             return false;
 
-        if ((lseek(fd, id3->first_frame_offset, SEEK_SET) < 0)) 
+        if ((meta_lseek(fd, id3->first_frame_offset, SEEK_SET) < 0)) 
             return false;
         
         return true;
     } else {
-        lseek(fd, 0, SEEK_SET);
+        meta_lseek(fd, 0, SEEK_SET);
         id3->first_frame_offset = 0;
         return true;
     }
@@ -34,6 +34,24 @@
 
 enum tagtype { TAGTYPE_APE = 1, TAGTYPE_VORBIS };
 
+#ifndef METADATA_READAHEAD_SIZE
+#if (CONFIG_PLATFORM & PLATFORM_NATIVE)
+#if MEMORYSIZE >= 8
+#define METADATA_READAHEAD_SIZE     (8*1024)
+#else
+#define METADATA_READAHEAD_SIZE     0   /* parsers read the file directly */
+#endif
+#else
+#define METADATA_READAHEAD_SIZE     (64*1024)
+#endif
+#endif
+
+/* Buffered replacements for read() and lseek() used by all the parsers */
+bool meta_readahead_begin(int fd);
+void meta_readahead_end(int fd);
+ssize_t meta_read(int fd, void *buf, size_t count);
+off_t meta_lseek(int fd, off_t offset, int whence);
+
 bool read_ape_tags(int fd, struct mp3entry* id3);
 long read_vorbis_tags(int fd, struct mp3entry *id3,
     long tag_remaining);
@@ -43,9 +61,9 @@ long read_string(int fd, char* buf, long buf_size, int eos, long size);
 
 int read_uint8(int fd, uint8_t* buf);
 #ifdef ROCKBOX_BIG_ENDIAN
-#define read_uint16be(fd,buf) read((fd), (buf), 2)
-#define read_uint32be(fd,buf) read((fd), (buf), 4)
-#define read_uint64be(fd,buf) read((fd), (buf), 8)
+#define read_uint16be(fd,buf) meta_read((fd), (buf), 2)
+#define read_uint32be(fd,buf) meta_read((fd), (buf), 4)
+#define read_uint64be(fd,buf) meta_read((fd), (buf), 8)
 int read_uint16le(int fd, uint16_t* buf);
 int read_uint32le(int fd, uint32_t* buf);
 int read_uint64le(int fd, uint64_t* buf);
@@ -53,9 +71,9 @@ int read_uint64le(int fd, uint64_t* buf);
 int read_uint16be(int fd, uint16_t* buf);
 int read_uint32be(int fd, uint32_t* buf);
 int read_uint64be(int fd, uint64_t* buf);
-#define read_uint16le(fd,buf) read((fd), (buf), 2)
-#define read_uint32le(fd,buf) read((fd), (buf), 4)
-#define read_uint64le(fd,buf) read((fd), (buf), 8)
+#define read_uint16le(fd,buf) meta_read((fd), (buf), 2)
+#define read_uint32le(fd,buf) meta_read((fd), (buf), 4)
+#define read_uint64le(fd,buf) meta_read((fd), (buf), 8)
 #endif
 
 uint64_t get_uint64_le(void* buf);
@@ -40,16 +40,16 @@ bool get_mod_metadata(int fd, struct mp3entry* id3)
     bool is_mod_file = false;
 
     /* Seek to file begin */
-    if (lseek(fd, 0, SEEK_SET) < 0)
+    if (meta_lseek(fd, 0, SEEK_SET) < 0)
         return false;
     /* Use id3v2buf as buffer for the track name */
-    if (read(fd, buf, sizeof(id3->id3v2buf)) < (ssize_t)sizeof(id3->id3v2buf))
+    if (meta_read(fd, buf, sizeof(id3->id3v2buf)) < (ssize_t)sizeof(id3->id3v2buf))
         return false;
     /* Seek to MOD ID position */
-    if (lseek(fd, MODULEHEADERSIZE, SEEK_SET) < 0)
+    if (meta_lseek(fd, MODULEHEADERSIZE, SEEK_SET) < 0)
         return false;
     /* Read MOD ID */
-    if (read(fd, id, sizeof(id)) < (ssize_t)sizeof(id))
+    if (meta_read(fd, id, sizeof(id)) < (ssize_t)sizeof(id))
         return false;
 
     /* Mod type checking based on MikMod */
@@ -40,9 +40,9 @@ bool get_monkeys_metadata(int fd, struct mp3entry* id3)
     uint32_t blocksperframe, finalframeblocks, totalframes;
     int fileversion;
 
-    lseek(fd, 0, SEEK_SET);
+    meta_lseek(fd, 0, SEEK_SET);
 
-    if (read(fd, buf, 4) < 4)
+    if (meta_read(fd, buf, 4) < 4)
     {
         return rc;
     }
@@ -52,7 +52,7 @@ bool get_monkeys_metadata(int fd, struct mp3entry* id3)
         return rc;
     }
 
-    read(fd, buf + 4, MAX_PATH - 4);
+    meta_read(fd, buf + 4, MAX_PATH - 4);
 
     fileversion = get_short_le(buf+4);
     if (fileversion < 3970)
@@ -60,7 +60,7 @@ static int getsonglength(int fd, struct mp3entry *entry)
     long bytecount;
 
     /* Start searching after ID3v2 header */
-    if(-1 == lseek(fd, entry->id3v2len, SEEK_SET))
+    if(-1 == meta_lseek(fd, entry->id3v2len, SEEK_SET))
         return 0;
 
     bytecount = get_mp3file_info(fd, &info);
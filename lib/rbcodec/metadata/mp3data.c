@@ -40,6 +40,7 @@
 #include "platform.h"
 
 #include "metadata.h"
+#include "metadata/metadata_common.h"
 #include "metadata/metadata_parsers.h"
 
 //#define DEBUG_VERBOSE
@@ -216,9 +217,9 @@ static bool headers_have_same_type(unsigned long header1,
 static void read_uint32be_mp3data(int fd, unsigned long *data)
 {
 #ifdef ROCKBOX_BIG_ENDIAN
-    (void)read(fd, (char*)data, 4);
+    (void)meta_read(fd, (char*)data, 4);
 #else
-    (void)read(fd, (char*)data, 4);
+    (void)meta_read(fd, (char*)data, 4);
     *data = betoh32(*data);
 #endif
 }
@@ -264,14 +265,14 @@ static unsigned long __find_next_frame(int fd, long *offset, long max_offset,
                 /* Gather frame size from given header and seek to next
                  * frame header. */
                 mp3headerinfo(&info, header);
-                lseek(fd, info.frame_size-4, SEEK_CUR);
+                meta_lseek(fd, info.frame_size-4, SEEK_CUR);
                 
                 /* Read possible next frame header and seek back to last frame
                  * headers byte position. */
                 reference_header = 0;
                 read_uint32be_mp3data(fd, &reference_header);
                 //
-                lseek(fd, -info.frame_size, SEEK_CUR);
+                meta_lseek(fd, -info.frame_size, SEEK_CUR);
                 
                 /* If the current header is of the same type as the previous 
                  * header we are finished. */
@@ -292,7 +293,7 @@ static unsigned long __find_next_frame(int fd, long *offset, long max_offset,
 
 static int fileread(int fd, unsigned char *c)
 {    
-    return read(fd, c, 1);
+    return meta_read(fd, c, 1);
 }
 
 unsigned long find_next_frame(int fd, 
@@ -318,7 +319,7 @@ static int buf_getbyte(int fd, unsigned char *c)
     }
     else
     {
-        fnf_buf_len = read(fd, fnf_buf, fnf_buf_len);
+        fnf_buf_len = meta_read(fd, fnf_buf, fnf_buf_len);
         if(fnf_buf_len < 0)
             return -1;
 
@@ -342,7 +343,7 @@ static int buf_seek(int fd, int len)
     {
         len = fnf_read_index - fnf_buf_len;
         
-        fnf_buf_len = read(fd, fnf_buf, fnf_buf_len);
+        fnf_buf_len = meta_read(fd, fnf_buf, fnf_buf_len);
         if(fnf_buf_len < 0)
             return -1;
 
@@ -547,9 +548,9 @@ int get_mp3file_info(int fd, struct mp3info *info)
     /* Read the amount of frame data to the buffer that is required for the 
      * vbr tag parsing. Skip the rest. */
     buf_size = MIN(info->frame_size-4, (int)sizeof(frame));
-    if(read(fd, frame, buf_size) < 0)
+    if(meta_read(fd, frame, buf_size) < 0)
         return -3;
-    lseek(fd, info->frame_size - 4 - buf_size, SEEK_CUR);
+    meta_lseek(fd, info->frame_size - 4 - buf_size, SEEK_CUR);
 
     /* Calculate position of a possible VBR header */
     if (info->version == MPEG_VERSION1) {
@@ -600,7 +601,7 @@ int get_mp3file_info(int fd, struct mp3info *info)
         
         /* There was no VBR header found. So, we seek back to beginning and
          * search for the first MPEG frame header of the mp3 stream. */
-        offset = lseek(fd, -info->frame_size, SEEK_CUR);
+        offset = meta_lseek(fd, -info->frame_size, SEEK_CUR);
         result = get_next_header_info(fd, &bytecount, info, false);
         if(result)
             return result;
@@ -635,7 +636,7 @@ int count_mp3_frames(int fd,  int startpos,  int filesize,
     int last_bitrate = 0;
     int header_template = 0;
 
-    if(lseek(fd, startpos, SEEK_SET) < 0)
+    if(meta_lseek(fd, startpos, SEEK_SET) < 0)
         return -1;
 
     buf_init(buf, buflen);
@@ -706,7 +707,7 @@ int create_xing_header(int fd, long startpos, long filesize,
 
     if(generate_toc)
     {
-        lseek(fd, startpos, SEEK_SET);
+        meta_lseek(fd, startpos, SEEK_SET);
         buf_init(tempbuf, tempbuflen);
 
         /* Generate filepos table */
@@ -89,23 +89,23 @@ static unsigned long read_mp4_tag(int fd, unsigned int size_left, char* buffer,
     
     if (buffer_left == 0)
     {
-        lseek(fd, size_left, SEEK_CUR);     /* Skip everything */
+        meta_lseek(fd, size_left, SEEK_CUR);     /* Skip everything */
     } 
     else 
     {
         /* Skip the data tag header - maybe we should parse it properly? */
-        lseek(fd, 16, SEEK_CUR); 
+        meta_lseek(fd, 16, SEEK_CUR); 
         size_left -= 16;
 
         if (size_left > buffer_left)
         {
-            read(fd, buffer, buffer_left);
-            lseek(fd, size_left - buffer_left, SEEK_CUR);
+            meta_read(fd, buffer, buffer_left);
+            meta_lseek(fd, size_left - buffer_left, SEEK_CUR);
             bytes_read = buffer_left;
         } 
         else
         {
-            read(fd, buffer, size_left);
+            meta_read(fd, buffer, size_left);
             bytes_read = size_left;
         }
     }
@@ -192,7 +192,7 @@ static unsigned int read_mp4_length(int fd, uint32_t* size)
 
     do
     {
-        read(fd, &c, 1);
+        meta_read(fd, &c, 1);
         bytes++;
         (*size)--;
         length = (length << 7) | (c & 0x7F);
@@ -207,8 +207,8 @@ static bool read_mp4_esds(int fd, struct mp3entry* id3, uint32_t* size)
     unsigned char buf[8];
     bool sbr = false;
 
-    lseek(fd, 4, SEEK_CUR);     /* Version and flags. */
-    read(fd, buf, 1);           /* Verify ES_DescrTag. */
+    meta_lseek(fd, 4, SEEK_CUR);     /* Version and flags. */
+    meta_read(fd, buf, 1);           /* Verify ES_DescrTag. */
     *size -= 5;
 
     if (*buf == 3)
@@ -219,16 +219,16 @@ static bool read_mp4_esds(int fd, struct mp3entry* id3, uint32_t* size)
             return sbr;
         }
 
-        lseek(fd, 3, SEEK_CUR);
+        meta_lseek(fd, 3, SEEK_CUR);
         *size -= 3;
     } 
     else
     {
-        lseek(fd, 2, SEEK_CUR);
+        meta_lseek(fd, 2, SEEK_CUR);
         *size -= 2;
     }
 
-    read(fd, buf, 1);           /* Verify DecoderConfigDescrTab. */
+    meta_read(fd, buf, 1);           /* Verify DecoderConfigDescrTab. */
     *size -= 1;
 
     if (*buf != 4)
@@ -241,8 +241,8 @@ static bool read_mp4_esds(int fd, struct mp3entry* id3, uint32_t* size)
         return sbr;
     }
     
-    lseek(fd, 13, SEEK_CUR);    /* Skip audio type, bit rates, etc. */
-    read(fd, buf, 1);
+    meta_lseek(fd, 13, SEEK_CUR);    /* Skip audio type, bit rates, etc. */
+    meta_read(fd, buf, 1);
     *size -= 14;
     
     if (*buf != 5)              /* Verify DecSpecificInfoTag. */
@@ -266,7 +266,7 @@ static bool read_mp4_esds(int fd, struct mp3entry* id3, uint32_t* size)
         length = MIN(length, *size);
         length = MIN(length, sizeof(buf));
         memset(buf, 0, sizeof(buf));
-        read(fd, buf, length);
+        meta_read(fd, buf, length);
         *size -= length;
         
         /* Maybe time to write a simple read_bits function... */
@@ -470,8 +470,16 @@ static bool read_mp4_tags(int fd, struct mp3entry* id3,
 #ifdef HAVE_ALBUMART
         case MP4_covr:
             {
-                int pos = lseek(fd, 0, SEEK_CUR) + 16;
-                
+                int pos = meta_lseek(fd, 0, SEEK_CUR) + 16;
+                uint32_t data_size = 0;
+
+                /* The image is the payload of the first 'data' atom; the
+                   atom may hold several pictures, so don't use all of it */
+                read_uint32be(fd, &data_size);
+                meta_lseek(fd, -4, SEEK_CUR);
+                if (data_size < 16 || data_size > size)
+                    data_size = size;
+
                 read_mp4_tag(fd, size, buffer, 8);
                 id3->albumart.type = AA_TYPE_UNKNOWN;
                 if (memcmp(buffer, "\xff\xd8\xff\xe0", 4) == 0)
@@ -486,7 +494,7 @@ static bool read_mp4_tags(int fd, struct mp3entry* id3,
                 if (id3->albumart.type != AA_TYPE_UNKNOWN)
                 {
                     id3->albumart.pos  = pos;
-                    id3->albumart.size = size - 16;
+                    id3->albumart.size = data_size - 16;
                     id3->has_embedded_albumart = true;
                 }
             }
@@ -501,22 +509,22 @@ static bool read_mp4_tags(int fd, struct mp3entry* id3,
                 /* "mean" atom */
                 read_uint32be(fd, &sub_size);
                 size -= sub_size;
-                lseek(fd, sub_size - 4, SEEK_CUR);
+                meta_lseek(fd, sub_size - 4, SEEK_CUR);
                 /* "name" atom */
                 read_uint32be(fd, &sub_size);
                 size -= sub_size;
-                lseek(fd, 8, SEEK_CUR);
+                meta_lseek(fd, 8, SEEK_CUR);
                 sub_size -= 12;
                 
                 if (sub_size > sizeof(tag_name) - 1)
                 {
-                    read(fd, tag_name, sizeof(tag_name) - 1);
-                    lseek(fd, sub_size - (sizeof(tag_name) - 1), SEEK_CUR);
+                    meta_read(fd, tag_name, sizeof(tag_name) - 1);
+                    meta_lseek(fd, sub_size - (sizeof(tag_name) - 1), SEEK_CUR);
                     tag_name[sizeof(tag_name) - 1] = 0;
                 }
                 else
                 {
-                    read(fd, tag_name, sub_size);
+                    meta_read(fd, tag_name, sub_size);
                     tag_name[sub_size] = 0;
                 }
                 
@@ -567,7 +575,7 @@ static bool read_mp4_tags(int fd, struct mp3entry* id3,
             break;
         
         default:
-            lseek(fd, size, SEEK_CUR);
+            meta_lseek(fd, size, SEEK_CUR);
             break;
         }
     }
@@ -616,7 +624,7 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
             break;
 
         case MP4_meta:
-            lseek(fd, 4, SEEK_CUR);  /* Skip version */
+            meta_lseek(fd, 4, SEEK_CUR);  /* Skip version */
             size -= 4;
             /* Fall through */
 
@@ -647,14 +655,14 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
             break;
         
         case MP4_stsd:
-            lseek(fd, 8, SEEK_CUR);
+            meta_lseek(fd, 8, SEEK_CUR);
             size -= 8;
             rc = read_mp4_container(fd, id3, size);
             size = 0;
             break;
         
         case MP4_hdlr:
-            lseek(fd, 8, SEEK_CUR);
+            meta_lseek(fd, 8, SEEK_CUR);
             read_uint32be(fd, &handler);
             size -= 12;
             /* DEBUGF("    Handler '%c%c%c%c'\n", handler >> 24 & 0xff, 
@@ -669,7 +677,7 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
                 /* Reset to false. */
                 id3->needs_upsampling_correction = false;
 
-                lseek(fd, 4, SEEK_CUR);
+                meta_lseek(fd, 4, SEEK_CUR);
                 read_uint32be(fd, &entries);
                 id3->samples = 0;
 
@@ -707,7 +715,7 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
                 uint32_t subtype;
 
                 /* Move to the next expected mp4 atom. */
-                lseek(fd, 28, SEEK_CUR);
+                meta_lseek(fd, 28, SEEK_CUR);
                 read_mp4_atom(fd, &subsize, &subtype, size);
                 size -= 36;
 
@@ -729,14 +737,14 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
                 uint32_t subtype;
 
                 /* Move to the next expected mp4 atom. */
-                lseek(fd, 28, SEEK_CUR);
+                meta_lseek(fd, 28, SEEK_CUR);
                 read_mp4_atom(fd, &subsize, &subtype, size);
                 size -= 36;
 #if 0
                 /* We might need to parse for the alac metadata atom. */
                 while (!((subsize==28) && (subtype==MP4_alac)) && (size>0))
                 {
-                    lseek(fd, -7, SEEK_CUR);
+                    meta_lseek(fd, -7, SEEK_CUR);
                     read_mp4_atom(fd, &subsize, &subtype, size);
                     size -= 1;
                     errno = 0; /* will most likely be set while parsing */
@@ -744,7 +752,7 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
 #endif
                 if (subtype == MP4_alac)
                 {
-                    lseek(fd, 24, SEEK_CUR);
+                    meta_lseek(fd, 24, SEEK_CUR);
                     read_uint32be(fd, &frequency);
                     size -= 28;
                     id3->frequency = frequency;
@@ -772,7 +780,7 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
                 uint8_t chapters;
                 uint64_t timestamp;
 
-                lseek(fd, 8, SEEK_CUR);
+                meta_lseek(fd, 8, SEEK_CUR);
                 read_uint8(fd, &chapters);
                 size -= 9;
 
@@ -792,7 +800,7 @@ static bool read_mp4_container(int fd, struct mp3entry* id3,
         /* Skip final seek. */
         if (!done)
         {
-            lseek(fd, size, SEEK_CUR);
+            meta_lseek(fd, size, SEEK_CUR);
         }
     } while (rc && (size_left > 0) && (errno == 0) && !done);
     
@@ -101,7 +101,7 @@ bool get_musepack_metadata(int fd, struct mp3entry *id3)
     
     if (!skip_id3v2(fd, id3))
         return false;
-    if (read(fd, header, 4*8) != 4*8) return false;
+    if (meta_read(fd, header, 4*8) != 4*8) return false;
     /* Musepack files are little endian, might need swapping */
     for (i = 1; i < 8; i++) 
        header[i] = letoh32(header[i]); 
@@ -131,8 +131,8 @@ bool get_musepack_metadata(int fd, struct mp3entry *id3)
     } else if (!memcmp(header, "MPCK", 4)) { /* Compare to sig "MPCK" */
         uint8_t sv8_header[32];
         /* 4 bytes 'MPCK' */
-        lseek(fd, 4, SEEK_SET);
-        if (read(fd, sv8_header, 2) != 2) return false; /* read frame ID */
+        meta_lseek(fd, 4, SEEK_SET);
+        if (meta_read(fd, sv8_header, 2) != 2) return false; /* read frame ID */
         if (!memcmp(sv8_header, "SH", 2)) { /* Stream Header ID */
             int32_t k = 0;
             uint32_t streamversion;
@@ -140,8 +140,8 @@ bool get_musepack_metadata(int fd, struct mp3entry *id3)
             uint64_t dummy = 0; /* used to dummy read data from header */
 
             /* 4 bytes 'MPCK' +  2 'SH' */
-            lseek(fd, 6, SEEK_SET);
-            if (read(fd, sv8_header, 32) != 32) return false;
+            meta_lseek(fd, 6, SEEK_SET);
+            if (meta_read(fd, sv8_header, 32) != 32) return false;
             
             /* Read the size of 'SH'-tag */
             k = sv8_get_size(sv8_header, k, &size);
@@ -99,7 +99,7 @@ static bool parse_nsfe(int fd, struct mp3entry *id3)
 
             ssize_t size = MIN(sizeof(struct NSFE_INFOCHUNK), chunk_size);
 
-            if (read(fd, &info, size) != size)
+            if (meta_read(fd, &info, size) != size)
                 return false;
 
             if (size >= 9)
@@ -207,7 +207,7 @@ static bool parse_nsfe(int fd, struct mp3entry *id3)
             }
         } /* end switch */
 
-        lseek(fd, chunk_size, SEEK_CUR);
+        meta_lseek(fd, chunk_size, SEEK_CUR);
     } /* end while */
 
     if (track_count | playlist_count)
@@ -232,8 +232,8 @@ static bool parse_nesm(int fd, struct mp3entry *id3)
     struct NESM_HEADER hdr;
     char *p = id3->id3v2buf;
 
-    lseek(fd, 0, SEEK_SET);
-    if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+    meta_lseek(fd, 0, SEEK_SET);
+    if (meta_read(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
         return false;
 
     /* Length */
@@ -257,7 +257,7 @@ static bool parse_nesm(int fd, struct mp3entry *id3)
 bool get_nsf_metadata(int fd, struct mp3entry* id3)
 {
     uint32_t nsf_type;
-    if (lseek(fd, 0, SEEK_SET) < 0 ||
+    if (meta_lseek(fd, 0, SEEK_SET) < 0 ||
         read_uint32be(fd, &nsf_type) != (int)sizeof(nsf_type))
         return false;
 
@@ -64,7 +64,7 @@ bool get_ogg_metadata(int fd, struct mp3entry* id3)
     bool eof = false;
 
     /* 92 bytes is enough for both Vorbis and Speex headers */
-    if ((lseek(fd, 0, SEEK_SET) < 0) || (read(fd, buf, 92) < 92))
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) || (meta_read(fd, buf, 92) < 92))
     {
         return false;
     }
@@ -83,7 +83,7 @@ bool get_ogg_metadata(int fd, struct mp3entry* id3)
         id3->vbr = true;
 
         /* Comments are in second Ogg page (byte 58 onwards for Vorbis) */
-        if (lseek(fd, 58, SEEK_SET) < 0)
+        if (meta_lseek(fd, 58, SEEK_SET) < 0)
         {
             return false;
         }
@@ -97,7 +97,7 @@ bool get_ogg_metadata(int fd, struct mp3entry* id3)
         header_size = get_long_le(&buf[60]);
 
         /* Comments are in second Ogg page (byte 108 onwards for Speex) */
-        if (lseek(fd, 28 + header_size, SEEK_SET) < 0)
+        if (meta_lseek(fd, 28 + header_size, SEEK_SET) < 0)
         {
             return false;
         }
@@ -110,7 +110,7 @@ bool get_ogg_metadata(int fd, struct mp3entry* id3)
 
 // FIXME handle an actual channel mapping table
         /* Comments are in second Ogg page (byte 108 onwards for Speex) */
-        if (lseek(fd, 47, SEEK_SET) < 0)
+        if (meta_lseek(fd, 47, SEEK_SET) < 0)
         {
             DEBUGF("Couldnotseektoogg");
             return false;
@@ -136,7 +136,7 @@ bool get_ogg_metadata(int fd, struct mp3entry* id3)
      */
 
     /* A page is always < 64 kB */
-    if (lseek(fd, -(MIN(64 * 1024, id3->filesize)), SEEK_END) < 0)
+    if (meta_lseek(fd, -(MIN(64 * 1024, id3->filesize)), SEEK_END) < 0)
     {
         return false;
     }
@@ -145,7 +145,7 @@ bool get_ogg_metadata(int fd, struct mp3entry* id3)
 
     while (!eof) 
     {
-        r = read(fd, &buf[remaining], MAX_PATH - remaining);
+        r = meta_read(fd, &buf[remaining], MAX_PATH - remaining);
         
         if (r <= 0) 
         {
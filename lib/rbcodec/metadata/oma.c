@@ -48,6 +48,7 @@
 #include <string.h>
 #include "platform.h"
 #include "metadata.h"
+#include "metadata_common.h"
 #include "metadata_parsers.h"
 
 #define EA3_HEADER_SIZE 96
@@ -107,7 +108,7 @@ static int oma_read_header(int fd, struct mp3entry* id3)
     int16_t eid;
     uint8_t buf[EA3_HEADER_SIZE];
 
-    ret = read(fd, buf, 10);
+    ret = meta_read(fd, buf, 10);
     if (ret != 10)
         return -1;
 
@@ -117,8 +118,8 @@ static int oma_read_header(int fd, struct mp3entry* id3)
     if (buf[5] & 0x10)
         EA3_pos += 10;
 
-    lseek(fd, EA3_pos, SEEK_SET);
-    ret = read(fd, buf, EA3_HEADER_SIZE);
+    meta_lseek(fd, EA3_pos, SEEK_SET);
+    ret = meta_read(fd, buf, EA3_HEADER_SIZE);
     if (ret != EA3_HEADER_SIZE)
         return -1;
 
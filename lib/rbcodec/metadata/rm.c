@@ -122,21 +122,21 @@ static int real_read_audio_stream_info(int fd, RMContext *rmctx)
        read_uint16be(fd, &flavor);
        read_uint32be(fd, &coded_framesize);
 #else
-       lseek(fd, 20, SEEK_CUR);
+       meta_lseek(fd, 20, SEEK_CUR);
 #endif
-       lseek(fd, 12, SEEK_CUR); /* unknown */
+       meta_lseek(fd, 12, SEEK_CUR); /* unknown */
        read_uint16be(fd, &rmctx->sub_packet_h);
        read_uint16be(fd, &rmctx->block_align);
        read_uint16be(fd, &rmctx->sub_packet_size);
-       lseek(fd, 2, SEEK_CUR); /* unknown */
+       meta_lseek(fd, 2, SEEK_CUR); /* unknown */
        skipped += 40;
        if (((version >> 16) & 0xff) == 5)
        {
-           lseek(fd, 6, SEEK_CUR); /* unknown */
+           meta_lseek(fd, 6, SEEK_CUR); /* unknown */
            skipped += 6;
        }
        read_uint16be(fd, &rmctx->sample_rate);
-       lseek(fd, 4, SEEK_CUR); /* unknown */
+       meta_lseek(fd, 4, SEEK_CUR); /* unknown */
        read_uint16be(fd, &rmctx->nb_channels);
        skipped += 8;
        if (((version >> 16) & 0xff) == 4)
@@ -146,7 +146,7 @@ static int real_read_audio_stream_info(int fd, RMContext *rmctx)
            read_uint32be(fd, &interleaver_id);
            read_uint8(fd, &fourcc_length);
 #else
-           lseek(fd, 6, SEEK_CUR);
+           meta_lseek(fd, 6, SEEK_CUR);
 #endif
            read_uint32be(fd, &fourcc);
            skipped += 10;
@@ -157,11 +157,11 @@ static int real_read_audio_stream_info(int fd, RMContext *rmctx)
            read_uint32be(fd, &fourcc);
            skipped += 8;
        }
-       lseek(fd, 3, SEEK_CUR); /* unknown */
+       meta_lseek(fd, 3, SEEK_CUR); /* unknown */
        skipped += 3;
        if (((version >> 16) & 0xff) == 5)
        {
-           lseek(fd, 1, SEEK_CUR); /* unknown */
+           meta_lseek(fd, 1, SEEK_CUR); /* unknown */
            skipped += 1;
        }
   
@@ -170,7 +170,7 @@ static int real_read_audio_stream_info(int fd, RMContext *rmctx)
                rmctx->codec_type = CODEC_COOK;
                read_uint32be(fd, &rmctx->extradata_size);
                skipped += 4;
-               read(fd, rmctx->codec_extradata, rmctx->extradata_size);
+               meta_read(fd, rmctx->codec_extradata, rmctx->extradata_size);
                skipped += rmctx->extradata_size;
                break;
 
@@ -179,7 +179,7 @@ static int real_read_audio_stream_info(int fd, RMContext *rmctx)
                rmctx->codec_type = CODEC_AAC;
                read_uint32be(fd, &rmctx->extradata_size);
                skipped += 4;
-               read(fd, rmctx->codec_extradata, rmctx->extradata_size);
+               meta_read(fd, rmctx->codec_extradata, rmctx->extradata_size);
                skipped += rmctx->extradata_size;
                break;
 
@@ -191,7 +191,7 @@ static int real_read_audio_stream_info(int fd, RMContext *rmctx)
                rmctx->codec_type = CODEC_ATRAC;
                read_uint32be(fd, &rmctx->extradata_size);
                skipped += 4;
-               read(fd, rmctx->codec_extradata, rmctx->extradata_size);
+               meta_read(fd, rmctx->codec_extradata, rmctx->extradata_size);
                skipped += rmctx->extradata_size;
                break;
 
@@ -247,12 +247,12 @@ static inline int rm_parse_header(int fd, RMContext *rmctx, struct mp3entry *id3
     uint8_t  header_end;
 
     memset(&obj,0,sizeof(obj));
-    curpos = lseek(fd, 0, SEEK_SET);    
+    curpos = meta_lseek(fd, 0, SEEK_SET);    
     res = real_read_object_header(fd, &obj);
 
     if (obj.fourcc == FOURCC('.','r','a',0xfd))
     {
-        lseek(fd, 4, SEEK_SET);
+        meta_lseek(fd, 4, SEEK_SET);
         skipped = real_read_audio_stream_info(fd, rmctx);
         if (skipped > 0 && rmctx->codec_type == CODEC_AC3)
         {
@@ -289,7 +289,7 @@ static inline int rm_parse_header(int fd, RMContext *rmctx, struct mp3entry *id3
         return -1;
     }
 
-    lseek(fd, 8, SEEK_CUR); /* unknown */
+    meta_lseek(fd, 8, SEEK_CUR); /* unknown */
 
     DEBUGF("Object: %s, size: %d bytes, version: 0x%04x, pos: %d\n",fourcc2str(obj.fourcc),(int)obj.size,obj.version,(int)curpos);
 
@@ -311,14 +311,14 @@ static inline int rm_parse_header(int fd, RMContext *rmctx, struct mp3entry *id3
                 read_uint32be(fd, &avg_packet_size);
                 read_uint32be(fd, &packet_count);
 #else
-                lseek(fd, 3*sizeof(uint32_t), SEEK_CUR);
+                meta_lseek(fd, 3*sizeof(uint32_t), SEEK_CUR);
 #endif
                 read_uint32be(fd, &rmctx->duration);
 #ifdef SIMULATOR
                 read_uint32be(fd, &preroll);
                 read_uint32be(fd, &index_offset);
 #else
-                lseek(fd, 2*sizeof(uint32_t), SEEK_CUR);
+                meta_lseek(fd, 2*sizeof(uint32_t), SEEK_CUR);
 #endif
                 read_uint32be(fd, &rmctx->data_offset);
                 read_uint16be(fd, &num_streams);
@@ -369,20 +369,20 @@ static inline int rm_parse_header(int fd, RMContext *rmctx, struct mp3entry *id3
                 read_uint32be(fd,&preroll);
                 read_uint32be(fd,&duration);
 #else
-                lseek(fd, 30, SEEK_CUR);
+                meta_lseek(fd, 30, SEEK_CUR);
 #endif
                 skipped += 30;
                 read_uint8(fd,&len);
                 skipped += 1;
-                lseek(fd, len, SEEK_CUR); /* desc */
+                meta_lseek(fd, len, SEEK_CUR); /* desc */
                 skipped += len;
                 read_uint8(fd,&len);
                 skipped += 1;
 #ifdef SIMULATOR
-                lseek(fd, len, SEEK_CUR); /* mimetype */
+                meta_lseek(fd, len, SEEK_CUR); /* mimetype */
                 read_uint32be(fd,&codec_data_size);
 #else
-                lseek(fd, len + 4, SEEK_CUR);
+                meta_lseek(fd, len + 4, SEEK_CUR);
 #endif
                 skipped += len + 4;
                 read_uint32be(fd,&v);
@@ -461,7 +461,7 @@ static inline int rm_parse_header(int fd, RMContext *rmctx, struct mp3entry *id3
                 break; 
         }
         if(header_end) break;
-        curpos = lseek(fd, obj.size - skipped, SEEK_CUR);
+        curpos = meta_lseek(fd, obj.size - skipped, SEEK_CUR);
         res = real_read_object_header(fd, &obj);
     }
 
@@ -15,8 +15,8 @@ static bool parse_sgc_header(int fd, struct mp3entry* id3)
     /* Use the trackname part of the id3 structure as a temporary buffer */
     unsigned char* buf = (unsigned char *)id3->path;
 
-     lseek(fd, 0, SEEK_SET);
-     if (read(fd, buf, 0xA0) < 0xA0)
+     meta_lseek(fd, 0, SEEK_SET);
+     if (meta_read(fd, buf, 0xA0) < 0xA0)
         return false;
 
     /* calculate track length with number of tracks */
@@ -49,7 +49,7 @@ static bool parse_sgc_header(int fd, struct mp3entry* id3)
 bool get_sgc_metadata(int fd, struct mp3entry* id3)
 {
    uint32_t sgc_type;
-    if ((lseek(fd, 0, SEEK_SET) < 0) ||
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) ||
          read_uint32be(fd, &sgc_type) != (int)sizeof(sgc_type))
         return false;
 
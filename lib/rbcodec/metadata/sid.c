@@ -39,8 +39,8 @@ bool get_sid_metadata(int fd, struct mp3entry* id3)
     char *p;
     
 
-    if ((lseek(fd, 0, SEEK_SET) < 0) 
-         || (read(fd, buf, 0x80) < 0x80))
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) 
+         || (meta_read(fd, buf, 0x80) < 0x80))
     {
         return false;
     }
@@ -146,7 +146,7 @@ static int read_audio_track_contets(int fd, int codepage, unsigned char **dst,
     unsigned char *q = buf;
     int datasize;
 
-    read(fd, buf, 256);
+    meta_read(fd, buf, 256);
 
     while (p - buf < 256 && *p != ',')
     {
@@ -178,7 +178,7 @@ static int read_audio_track_contets(int fd, int codepage, unsigned char **dst,
             *q++ = *p++;
     }
     datasize =  p - buf + 1;
-    lseek(fd, datasize - 256, SEEK_CUR);
+    meta_lseek(fd, datasize - 256, SEEK_CUR);
 
     if (dst != NULL)
         decode2utf8(buf, dst, q - buf, dstsize, codepage);
@@ -191,7 +191,7 @@ static void read_score_track_contets(int fd, int codepage, int datasize,
 {
     unsigned char buf[datasize];
 
-    read(fd, buf, datasize);
+    meta_read(fd, buf, datasize);
     decode2utf8(buf, dst, datasize, dstsize, codepage);
 }
 
@@ -202,13 +202,13 @@ static unsigned int search_chunk(int fd, const unsigned char *name, int nlen)
     unsigned char buf[8];
     unsigned int chunksize;
 
-    while (read(fd, buf, 8) > 0)
+    while (meta_read(fd, buf, 8) > 0)
     {
         chunksize = get_long_be(buf + 4);
         if (memcmp(buf, name, nlen) == 0)
             return chunksize;
 
-        lseek(fd, chunksize, SEEK_CUR);
+        meta_lseek(fd, chunksize, SEEK_CUR);
     }
     DEBUGF("metadata error: missing '%s' chunk\n", name);
     return 0;
@@ -228,7 +228,7 @@ static bool parse_smaf_audio_track(int fd, struct mp3entry *id3, unsigned int da
     int codepage;
 
     /* parse contents info */
-    read(fd, tmp, 5);
+    meta_read(fd, tmp, 5);
     codepage = convert_smaf_codetype(tmp[2]);
     if (codepage < 0)
     {
@@ -240,7 +240,7 @@ static bool parse_smaf_audio_track(int fd, struct mp3entry *id3, unsigned int da
     while ((id3->title == NULL || id3->artist == NULL || id3->composer == NULL)
            && (datasize > 0 && bufsize > 0))
     {
-        if (read(fd, tmp, 3) <= 0)
+        if (meta_read(fd, tmp, 3) <= 0)
             return false;
 
         if (tmp[2] != ':')
@@ -270,7 +270,7 @@ static bool parse_smaf_audio_track(int fd, struct mp3entry *id3, unsigned int da
     }
 
     /* search PCM Audio Track Chunk */
-    lseek(fd, 16 + chunksize, SEEK_SET);
+    meta_lseek(fd, 16 + chunksize, SEEK_SET);
 
     chunksize = search_chunk(fd, "ATR", 3);
     if (chunksize == 0)
@@ -292,7 +292,7 @@ static bool parse_smaf_audio_track(int fd, struct mp3entry *id3, unsigned int da
      * Note: If PCM Audio Track does not include Sequence Data Chunk,
      *       tmp+6 is the start position of Wave Data Chunk.
      */
-    read(fd, tmp, 6);
+    meta_read(fd, tmp, 6);
 
     /* search Wave Data Chunk */
     chunksize = search_chunk(fd, "Awa", 3);
@@ -324,7 +324,7 @@ static bool parse_smaf_score_track(int fd, struct mp3entry *id3)
     int codepage;
 
     /* parse Optional Data Chunk */
-    read(fd, tmp, 21);
+    meta_read(fd, tmp, 21);
     if (memcmp(tmp + 5, "OPDA", 4) != 0)
     {
         DEBUGF("metadata error: missing Optional Data Chunk\n");
@@ -353,7 +353,7 @@ static bool parse_smaf_score_track(int fd, struct mp3entry *id3)
     while ((id3->title == NULL || id3->artist == NULL || id3->composer == NULL)
            && (datasize > 0 && bufsize > 0))
     {
-        if (read(fd, tmp, 4) <= 0)
+        if (meta_read(fd, tmp, 4) <= 0)
             return false;
 
         valsize = (tmp[2] << 8) | tmp[3];
@@ -373,13 +373,13 @@ static bool parse_smaf_score_track(int fd, struct mp3entry *id3)
                 read_score_track_contets(fd, codepage, valsize, &buf, &bufsize);
                 break;
             default:
-                lseek(fd, valsize, SEEK_CUR);
+                meta_lseek(fd, valsize, SEEK_CUR);
                 break;
         }
     }
 
     /* search Score Track Chunk */
-    lseek(fd, 29 + chunksize, SEEK_SET);
+    meta_lseek(fd, 29 + chunksize, SEEK_SET);
 
     if (search_chunk(fd, "MTR", 3) == 0)
     {
@@ -392,7 +392,7 @@ static bool parse_smaf_score_track(int fd, struct mp3entry *id3)
      * usually, next chunk ('M***') found within 40 bytes.
      */
     chunksize = 40;
-    read(fd, tmp, chunksize);
+    meta_read(fd, tmp, chunksize);
 
     tmp[chunksize] = 'M'; /* stopper */
     while (*p != 'M')
@@ -406,7 +406,7 @@ static bool parse_smaf_score_track(int fd, struct mp3entry *id3)
     }
 
     /* search Score Track Stream PCM Data Chunk */
-    lseek(fd, -chunksize, SEEK_CUR);
+    meta_lseek(fd, -chunksize, SEEK_CUR);
     if (search_chunk(fd, "Mtsp", 4) == 0)
     {
         DEBUGF("metadata error: missing Score Track Stream PCM Data Chunk\n");
@@ -421,7 +421,7 @@ static bool parse_smaf_score_track(int fd, struct mp3entry *id3)
      *    +9:   frequency (MSB)
      *    +10:  frequency (LSB)
      */
-    read(fd, tmp, 11);
+    meta_read(fd, tmp, 11);
     if (memcmp(tmp, "Mwa", 3) != 0)
     {
         DEBUGF("metadata error: missing Score Track Stream Wave Data Chunk\n");
@@ -448,8 +448,8 @@ bool get_smaf_metadata(int fd, struct mp3entry* id3)
     id3->filesize = filesize(fd);
 
     /* check File Chunk and Contents Info Chunk */
-    lseek(fd, 0, SEEK_SET);
-    read(fd, tmp, 16);
+    meta_lseek(fd, 0, SEEK_SET);
+    meta_read(fd, tmp, 16);
     if ((memcmp(tmp, "MMMD", 4) != 0) || (memcmp(tmp + 8, "CNTI", 4) != 0))
     {
         DEBUGF("metadata error: does not smaf format\n");
@@ -43,8 +43,8 @@ bool get_spc_metadata(int fd, struct mp3entry* id3)
     int i;
     
     /* try to get the ID666 tag */
-    if ((lseek(fd, 0x2e, SEEK_SET) < 0)
-        || (read(fd, buf, 0xD2) < 0xD2))
+    if ((meta_lseek(fd, 0x2e, SEEK_SET) < 0)
+        || (meta_read(fd, buf, 0xD2) < 0xD2))
     {
         DEBUGF("lseek or read failed\n");
         return false;
@@ -77,14 +77,14 @@ bool get_tta_metadata(int fd, struct mp3entry* id3)
     unsigned int origsize;
     int bps;
 
-    lseek(fd, 0, SEEK_SET);
+    meta_lseek(fd, 0, SEEK_SET);
 
     /* read id3 tags */
     read_id3_tags(fd, id3);
-    lseek(fd, id3->id3v2len, SEEK_SET);
+    meta_lseek(fd, id3->id3v2len, SEEK_SET);
 
     /* read TTA header */
-    if (read(fd, ttahdr, TTA_HEADER_SIZE) < 0)
+    if (meta_read(fd, ttahdr, TTA_HEADER_SIZE) < 0)
         return false;
 
     /* check for TTA3 signature */
@@ -146,8 +146,8 @@ bool get_vgm_metadata(int fd, struct mp3entry* id3)
     int read_bytes;
 
     memset(buf, 0, ID3V2_BUF_SIZE);
-    if ((lseek(fd, 0, SEEK_SET) < 0) 
-         || ((read_bytes = read(fd, buf, header_size)) < header_size))
+    if ((meta_lseek(fd, 0, SEEK_SET) < 0) 
+         || ((read_bytes = meta_read(fd, buf, header_size)) < header_size))
     {
         return false;
     }
@@ -180,8 +180,8 @@ bool get_vgm_metadata(int fd, struct mp3entry* id3)
     /*  Seek to gd3 offset and read as 
          many bytes posible */
     gd3_offset = id3->filesize - (header_size + gd3_offset);
-    if ((lseek(fd, -gd3_offset, SEEK_END) < 0) 
-         || ((read_bytes = read(fd, buf, ID3V2_BUF_SIZE)) <= 0))
+    if ((meta_lseek(fd, -gd3_offset, SEEK_END) < 0) 
+         || ((read_bytes = meta_read(fd, buf, ID3V2_BUF_SIZE)) <= 0))
         return true;
 
     byte* gd3 = buf;
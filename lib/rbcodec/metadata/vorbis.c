@@ -52,7 +52,7 @@ static bool file_read_page_header(struct file* file)
     ssize_t table_left;
 
     /* Size of page header without segment table */
-    if (read(file->fd, buffer, 27) != 27)
+    if (meta_read(file->fd, buffer, 27) != 27)
     {
         return false;
     }
@@ -74,7 +74,7 @@ static bool file_read_page_header(struct file* file)
         ssize_t count = MIN(sizeof(buffer), (size_t) table_left);
         int i;
 
-        if (read(file->fd, buffer, count) < count)
+        if (meta_read(file->fd, buffer, count) < count)
         {
             return false;
         }
@@ -90,7 +90,7 @@ static bool file_read_page_header(struct file* file)
                 file->packet_ended = true;
                 
                 /* Skip remainder of the table */
-                if (lseek(file->fd, table_left, SEEK_CUR) < 0)
+                if (meta_lseek(file->fd, table_left, SEEK_CUR) < 0)
                 {
                     return false;
                 }
@@ -136,11 +136,11 @@ static ssize_t file_read(struct file* file, void* buffer, size_t buffer_size)
 
         if (buffer)
         {
-            count = read(file->fd, buffer, count);
+            count = meta_read(file->fd, buffer, count);
         }
         else
         {
-            if (lseek(file->fd, count, SEEK_CUR) < 0)
+            if (meta_lseek(file->fd, count, SEEK_CUR) < 0)
             {
                 count = -1;
             }
@@ -369,7 +369,7 @@ long read_vorbis_tags(int fd, struct mp3entry *id3,
         if (!strcasecmp(name, "CUESHEET"))
         {
             id3->has_embedded_cuesheet = true;
-            id3->embedded_cuesheet.pos = lseek(file.fd, 0, SEEK_CUR) - read_len;
+            id3->embedded_cuesheet.pos = meta_lseek(file.fd, 0, SEEK_CUR) - read_len;
             id3->embedded_cuesheet.size = len;
             id3->embedded_cuesheet.encoding = CHAR_ENC_UTF_8;
         }
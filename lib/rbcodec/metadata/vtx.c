@@ -52,19 +52,19 @@ typedef struct {
 
 static uint Reader_ReadByte(int fd) {
     unsigned char c;
-    read(fd, &c, sizeof(c));
+    meta_read(fd, &c, sizeof(c));
     return c;
 }
 
 static uint Reader_ReadWord(int fd) {
     unsigned short s;
-    read(fd, &s, sizeof(s));
+    meta_read(fd, &s, sizeof(s));
     return letoh16(s);
 }
 
 static uint Reader_ReadDWord(int fd) {
     unsigned int i;
-    read(fd, &i, sizeof(i));
+    meta_read(fd, &i, sizeof(i));
     return letoh32(i);
 }
 
@@ -77,7 +77,7 @@ static char* Reader_ReadString(int fd, char *str) {
         *str = 0;
 
     while (i < VTX_STRING_MAX && c) {
-        read(fd, &c, sizeof(c));
+        meta_read(fd, &c, sizeof(c));
 	if (str)
             *str++ = c;
 	i++;
@@ -97,7 +97,7 @@ bool get_vtx_metadata(int fd, struct mp3entry* id3)
     char *p = id3->id3v2buf;
     char buf[VTX_STRING_MAX+1];
 
-    if (lseek(fd, 0, SEEK_SET) < 0)
+    if (meta_lseek(fd, 0, SEEK_SET) < 0)
         goto exit_bad;
 
     if (filesize(fd) < 20)
@@ -254,14 +254,14 @@ static void parse_list_chunk(int fd, struct mp3entry* id3, int chunksize, bool i
     int i;
 
     if (is_64)
-        lseek(fd, 4, SEEK_CUR);
-    else if (read(fd, bp, 4) < 4 || memcmp(bp, "INFO", 4))
+        meta_lseek(fd, 4, SEEK_CUR);
+    else if (meta_read(fd, bp, 4) < 4 || memcmp(bp, "INFO", 4))
         return;
 
     /* decrease skip bytes */
     chunksize -= 4;
 
-    infosize = read(fd, bp, (ID3V2_BUF_SIZE > chunksize)? chunksize : ID3V2_BUF_SIZE);
+    infosize = meta_read(fd, bp, (ID3V2_BUF_SIZE > chunksize)? chunksize : ID3V2_BUF_SIZE);
     if (infosize <= 8)
         return;
 
@@ -311,8 +311,8 @@ static bool read_header(int fd, struct mp3entry* id3, const unsigned char *chunk
     id3->filesize = filesize(fd);
 
     /* get RIFF chunk header */
-    lseek(fd, 0, SEEK_SET);
-    read(fd, buf, offset);
+    meta_lseek(fd, 0, SEEK_SET);
+    meta_read(fd, buf, offset);
 
     if ((memcmp(buf,       chunknames + RIFF_CHUNK * namelen, namelen) != 0) ||
         (memcmp(buf + len, chunknames + WAVE_CHUNK * namelen, namelen) != 0))
@@ -322,7 +322,7 @@ static bool read_header(int fd, struct mp3entry* id3, const unsigned char *chunk
     }
 
     /* iterate over WAVE chunks until 'data' chunk */
-    while (read(fd, buf, len) > 0)
+    while (meta_read(fd, buf, len) > 0)
     {
         offset += len;
 
@@ -344,7 +344,7 @@ static bool read_header(int fd, struct mp3entry* id3, const unsigned char *chunk
             /* get and parse format */
             read_data = (chunksize > 25)? 26 : chunksize;
 
-            read(fd, buf, read_data);
+            meta_read(fd, buf, read_data);
             parse_riff_format(buf, read_data, &fmt, id3);
         }
         else if (memcmp(buf, chunknames + FACT_CHUNK * namelen, namelen) == 0)
@@ -356,7 +356,7 @@ static bool read_header(int fd, struct mp3entry* id3, const unsigned char *chunk
             {
                 /* get totalsamples */
                 read_data = sizelen;
-                read(fd, buf, read_data);
+                meta_read(fd, buf, read_data);
                 fmt.totalsamples = (is_64)? get_uint64_le(buf) : get_long_le(buf);
             }
         }
@@ -371,7 +371,7 @@ static bool read_header(int fd, struct mp3entry* id3, const unsigned char *chunk
         {
             DEBUGF("find 'LIST' chunk\n");
             parse_list_chunk(fd, id3, chunksize, is_64);
-            lseek(fd, offset, SEEK_SET);
+            meta_lseek(fd, offset, SEEK_SET);
         }
 
         /* padded to next chunk */
@@ -381,7 +381,7 @@ static bool read_header(int fd, struct mp3entry* id3, const unsigned char *chunk
         if (offset >= id3->filesize)
             break;
 
-        lseek(fd, chunksize - read_data, SEEK_CUR);
+        meta_lseek(fd, chunksize - read_data, SEEK_CUR);
     }
 
     if (fmt.numbytes == 0)
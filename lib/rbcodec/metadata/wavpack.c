@@ -63,7 +63,7 @@ bool get_wavpack_metadata(int fd, struct mp3entry* id3)
 
         /* at every 256 bytes into file, try to read a WavPack header */
 
-        if ((lseek(fd, i * 256, SEEK_SET) < 0) || (read(fd, buf, 32) < 32))
+        if ((meta_lseek(fd, i * 256, SEEK_SET) < 0) || (meta_read(fd, buf, 32) < 32))
             return false;
 
         /* if valid WavPack 4 header version, break */
@@ -102,11 +102,11 @@ bool get_wavpack_metadata(int fd, struct mp3entry* id3)
                 id3->frequency = 44100;
 
                 while (meta_bytes >= 6) {
-                    if (read(fd, buf, 2) < 2)
+                    if (meta_read(fd, buf, 2) < 2)
                         break;
 
                     if (buf [0] & ID_LARGE) {
-                        if (read(fd, buf + 2, 2) < 2)
+                        if (meta_read(fd, buf + 2, 2) < 2)
                             break;
 
                         meta_size = (buf [1] << 1) + (buf [2] << 9) + (buf [3] << 17);
@@ -117,14 +117,14 @@ bool get_wavpack_metadata(int fd, struct mp3entry* id3)
                         meta_bytes -= meta_size + 2;
 
                         if ((buf [0] & ID_UNIQUE) == ID_SAMPLE_RATE) {
-                            if (meta_size == 4 && read(fd, buf + 2, 4) == 4)
+                            if (meta_size == 4 && meta_read(fd, buf + 2, 4) == 4)
                                 id3->frequency = buf [2] + (buf [3] << 8) + (buf [4] << 16);
 
                             break;
                         }
                     }
 
-                    if (meta_size > 0 && lseek(fd, meta_size, SEEK_CUR) < 0)
+                    if (meta_size > 0 && meta_lseek(fd, meta_size, SEEK_CUR) < 0)
                         break;
                 }
             }
@@ -150,8 +150,8 @@ bool get_wavpack_metadata(int fd, struct mp3entry* id3)
             return true;
         }
         else {   /* block did not contain audio, so seek to the end and see if there's another */
-            if ((meta_bytes > 0 && lseek(fd, meta_bytes, SEEK_CUR) < 0) ||
-                read(fd, buf, 32) < 32 || memcmp (buf, "wvpk", 4) != 0)
+            if ((meta_bytes > 0 && meta_lseek(fd, meta_bytes, SEEK_CUR) < 0) ||
+                meta_read(fd, buf, 32) < 32 || memcmp (buf, "wvpk", 4) != 0)
                     break;
         }
     }
@@ -1,2 +1,5 @@
+/* warble is built against the sdlapp target config. Take it first, so
+ * HAVE_FPU and HAVE_TAGCACHE are seen in every file: they change the format
+ * enum and struct mp3entry in metadata.h. */
+#include "../../../firmware/export/config.h"
 #include "../rbcodecconfig-example.h"
-
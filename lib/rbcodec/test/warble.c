@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #include "buffering.h" /* TYPE_PACKET_AUDIO */
 #include "kernel.h"
@@ -41,6 +42,7 @@
 #include "sound.h"
 #include "tdspeed.h"
 #include "platform.h"
+#include "crc32.h"
 
 /***************** EXPORTED *****************/
 
@@ -97,7 +99,7 @@ off_t filesize(int fd)
 
 /***************** INTERNAL *****************/
 
-static enum { MODE_PLAY, MODE_WRITE } mode;
+static enum { MODE_PLAY, MODE_WRITE, MODE_CHECK } mode;
 static bool use_dsp = true;
 static bool enable_loop = false;
 static const char *config = "";
@@ -242,6 +244,60 @@ static void write_pcm_raw(int32_t *pcm, int count)
     }
 }
 
+/***** MODE_CHECK *****/
+
+/* MODE_CHECK discards the output but keeps a CRC32 of it, so a codec change can
+ * be checked for bit-exactness against a known good value. Samples are hashed
+ * little-endian so the value does not depend on the host. The decode is also
+ * timed, which gives a rough speed figure for the same run. */
+
+static uint32_t check_crc = 0xffffffff;
+static const char *check_expect = NULL;
+static clock_t check_clock;
+
+static void check_init(const char *expect)
+{
+    mode = MODE_CHECK;
+    check_expect = expect;
+}
+
+static void check_pcm(int16_t *pcm, int count)
+{
+    int i;
+    for (i = 0; i < 2 * count; i++)
+        pcm[i] = htole16(pcm[i]);
+    check_crc = crc_32(pcm, 4 * count, check_crc);
+}
+
+static void check_pcm_raw(int32_t *pcm, int count)
+{
+    int i;
+    for (i = 0; i < count; i++)
+        pcm[i] = htole32(pcm[i]);
+    check_crc = crc_32(pcm, count * sizeof(*pcm), check_crc);
+}
+
+static int check_quit(void)
+{
+    double secs = (double)check_clock / CLOCKS_PER_SEC;
+    double audio_secs = format.freq ?
+        (double)num_output_samples / format.freq : 0;
+
+    fprintf(stderr, "Output samples: %lu\n", num_output_samples);
+    fprintf(stderr, "Decode time: %.3f s\n", secs);
+    if (audio_secs > 0 && secs > 0)
+        fprintf(stderr, "Decode speed: %.2fx realtime (%.0f us per s of audio)\n",
+                audio_secs / secs, secs * 1000000 / audio_secs);
+    printf("%08x\n", (unsigned)check_crc);
+
+    if (check_expect && strtoul(check_expect, NULL, 16) != check_crc) {
+        fprintf(stderr, "error: checksum mismatch, expected %s\n",
+                check_expect);
+        return 2;
+    }
+    return 0;
+}
+
 /***** MODE_PLAY *****/
 
 /* MODE_PLAY uses a double buffer: one half is read by the playback thread and
@@ -462,6 +518,8 @@ static void ci_pcmbuf_insert(const void *ch1, const void *ch2, int count)
                     write_pcm(buf, dst.remcount);
                 else if (mode == MODE_PLAY)
                     playback_pcm(buf, dst.remcount);
+                else if (mode == MODE_CHECK)
+                    check_pcm(buf, dst.remcount);
             } else if (src.remcount <= 0) {
                 break;
             }
@@ -495,6 +553,8 @@ static void ci_pcmbuf_insert(const void *ch1, const void *ch2, int count)
 
         if (mode == MODE_WRITE)
             write_pcm_raw(buf, count);
+        else if (mode == MODE_CHECK)
+            check_pcm_raw(buf, count);
     }
 
     perform_config();
@@ -591,13 +651,14 @@ static void ci_set_offset(size_t value)
 
 static void ci_configure(int setting, intptr_t value)
 {
+    /* The codec's rate is needed for the decode speed in either mode */
+    if (setting == DSP_SET_FREQUENCY)
+        format.freq = value;
+
     if (use_dsp) {
         dsp_configure(ci.dsp, setting, value);
     } else {
-        if (setting == DSP_SET_FREQUENCY
-                || setting == DSP_SET_FREQUENCY)
-            format.freq = value;
-        else if (setting == DSP_SET_SAMPLE_DEPTH)
+        if (setting == DSP_SET_SAMPLE_DEPTH)
             format.depth = value;
         else if (setting == DSP_SET_STEREO_MODE) {
             format.stereo_mode = value;
@@ -824,9 +885,11 @@ static void decode_file(const char *input_fn)
         fprintf(stderr, "error: codec returned error from codec_main\n");
         exit(1);
     }
+    clock_t start = clock();
     if (c_hdr->run_proc() != CODEC_OK) {
         fprintf(stderr, "error: codec error\n");
     }
+    check_clock = clock() - start;
     c_hdr->entry_point(CODEC_UNLOAD);
 
     /* Close */
@@ -840,6 +903,7 @@ static void print_help(const char *progname)
     fprintf(stderr, "Usage:\n"
                     "        Play: %s [options] INPUTFILE\n"
                     "Write to WAV: %s [options] INPUTFILE OUTPUTFILE\n"
+                    "    Checksum: %s [options] -s INPUTFILE\n"
                     "\n"
                     "general options:\n"
                     "  -c a=1:b=2    Configuration (see below)\n"
@@ -849,6 +913,13 @@ static void print_help(const char *progname)
                     "  -f            Write raw codec output converted to 64-bit float\n"
                     "  -r            Write raw 32-bit codec output without WAV header\n"
                     "\n"
+                    "checksum options:\n"
+                    "  -s            Print the CRC32 of the output and the decode time\n"
+                    "  -x <crc>      Like -s, but exit with status 2 unless the CRC32\n"
+                    "                matches <crc>\n"
+                    "  -r            Checksum raw 32-bit codec output instead of\n"
+                    "                the DSP output\n"
+                    "\n"
                     "configuration:\n"
                     "  dither=<0|1>  Enable/disable dithering [0]\n"
                     "  halt=<0|1>    Stop decoding if 1 [0]\n"
@@ -866,13 +937,18 @@ static void print_help(const char *progname)
                     "  %s in.adx -c loop=1:wait=44100:halt=1\n"
                     "  # Lower pitch 1 octave and write to out.wav\n"
                     "  %s in.ogg -c rate=0.5:tempo=2 out.wav\n"
-                    , progname, progname, progname, progname);
+                    "  # Print the CRC32 of the raw codec output of in.flac\n"
+                    "  %s -r -s in.flac\n"
+                    , progname, progname, progname, progname, progname, progname);
 }
 
 int main(int argc, char **argv)
 {
     int opt;
-    while ((opt = getopt(argc, argv, "c:fhr")) != -1) {
+    int ret = 0;
+    bool check = false;
+    const char *expect = NULL;
+    while ((opt = getopt(argc, argv, "c:fhrsx:")) != -1) {
         switch (opt) {
         case 'c':
             config = optarg;
@@ -884,6 +960,12 @@ int main(int argc, char **argv)
             use_dsp = false;
             write_raw = true;
             break;
+        case 'x':
+            expect = optarg;
+            /* fallthrough */
+        case 's':
+            check = true;
+            break;
         case 'h': /* fallthrough */
         default:
             print_help(argv[0]);
@@ -891,7 +973,14 @@ int main(int argc, char **argv)
         }
     }
 
-    if (argc == optind + 2) {
+    if (check) {
+        if (argc != optind + 1) {
+            fprintf(stderr, "error: wrong number of arguments\n");
+            print_help(argv[0]);
+            exit(1);
+        }
+        check_init(expect);
+    } else if (argc == optind + 2) {
         write_init(argv[optind + 1]);
     } else if (argc == optind + 1) {
         if (!use_dsp) {
@@ -914,6 +1003,8 @@ int main(int argc, char **argv)
         write_quit();
     else if (mode == MODE_PLAY)
         playback_quit();
+    else if (mode == MODE_CHECK)
+        ret = check_quit();
 
-    return 0;
+    return ret;
 }
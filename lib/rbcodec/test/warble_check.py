@@ -0,0 +1,118 @@
+#!/usr/bin/python3
+#             __________               __   ___.
+#   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+#   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+#   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+#   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+#                     \/            \/     \/    \/            \/
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+# KIND, either express or implied.
+#
+# Codec regression check: writes the test files from warble_corpus.py (at
+# least one for every codec warble builds), decodes each one with
+# "warble -s -r" and compares the CRC32 of the raw codec output with the
+# value in warble_checksums.txt. The corpus is generated rather than checked
+# in; it only depends on warble_corpus.py, so the checksums stay valid until
+# a decoder's output changes.
+#
+# Usage: warble_check.py [-u] WARBLE [CORPUSDIR]
+#   -u  write the current checksums to warble_checksums.txt instead of
+#       comparing (after a deliberate change in decoder output)
+#
+# Exits with status 1 if any checksum differs or a file fails to decode or
+# decodes to nothing.
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from warble_corpus import corpus
+
+CHECKSUMS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                         "warble_checksums.txt")
+
+
+def load_checksums():
+    sums = {}
+    with open(CHECKSUMS) as f:
+        for line in f:
+            line = line.split("#", 1)[0].split()
+            if len(line) == 2:
+                sums[line[0]] = line[1]
+    return sums
+
+
+def main():
+    args = sys.argv[1:]
+    update = "-u" in args
+    args = [a for a in args if a != "-u"]
+    if not args:
+        print("Usage: %s [-u] WARBLE [CORPUSDIR]" % sys.argv[0])
+        sys.exit(1)
+
+    warble = os.path.abspath(args[0])
+    keep = len(args) > 1
+    outdir = args[1] if keep else tempfile.mkdtemp(prefix="warble")
+    os.makedirs(outdir, exist_ok=True)
+
+    expected = {} if update else load_checksums()
+    results = []
+    failed = 0
+
+    for entry in corpus():
+        name, data = entry[:2]
+        path = os.path.join(outdir, name)
+        with open(path, "wb") as f:
+            f.write(data)
+
+        cmd = [warble, "-s", "-r"]
+        if len(entry) > 2:
+            cmd += ["-c", entry[2]]
+        run = subprocess.run(cmd + [path],
+                             stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                             universal_newlines=True)
+        crc = run.stdout.strip()
+        if (run.returncode != 0 or not crc
+                or "Output samples: 0\n" in run.stderr):
+            print("%-24s FAILED to decode" % name)
+            sys.stderr.write(run.stderr)
+            failed += 1
+            continue
+
+        results.append((name, crc))
+        if update:
+            print("%-24s %s" % (name, crc))
+        elif name not in expected:
+            print("%-24s %s (no checksum on record)" % (name, crc))
+            failed += 1
+        elif expected[name] != crc:
+            print("%-24s %s MISMATCH, expected %s" % (name, crc,
+                                                       expected[name]))
+            failed += 1
+        else:
+            print("%-24s %s ok" % (name, crc))
+
+    if update and not failed:
+        with open(CHECKSUMS, "w") as f:
+            f.write("# CRC32 of the raw codec output (warble -s -r) for the\n"
+                    "# files written by warble_check.py; update with -u\n")
+            for name, crc in results:
+                f.write("%s %s\n" % (name, crc))
+        print("wrote %s" % CHECKSUMS)
+
+    if not keep:
+        shutil.rmtree(outdir)
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
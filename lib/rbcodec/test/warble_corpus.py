@@ -0,0 +1,3118 @@
+#             __________               __   ___.
+#   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+#   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+#   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+#   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+#                     \/            \/     \/    \/            \/
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+# KIND, either express or implied.
+#
+# Test file generators for warble_check.py.
+#
+# Where a format is simple to encode (PCM, ADPCM, FLAC, ...) the generator
+# encodes a test signal. For the transform codecs a real encoder would be far
+# larger than the decoder under test, so those files are valid streams whose
+# coded values come from a fixed pseudo-random sequence instead: the decoder
+# still runs its whole path (entropy decoding, dequantisation, stereo, the
+# inverse transform and synthesis), which is all a checksum needs.
+
+import binascii
+import math
+import struct
+import uuid
+import zlib
+
+
+class BitWriter:
+    """MSB first bit packer"""
+
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.count = 0
+
+    def put(self, value, width):
+        if width == 0:
+            return
+        self.acc = (self.acc << width) | (value & ((1 << width) - 1))
+        self.count += width
+        while self.count >= 8:
+            self.count -= 8
+            self.out.append((self.acc >> self.count) & 0xff)
+        self.acc &= (1 << self.count) - 1
+
+    def bits(self):
+        return len(self.out) * 8 + self.count
+
+    def append(self, other):
+        for b in other.out:
+            self.put(b, 8)
+        self.put(other.acc, other.count)
+
+    def align(self, fill=0):
+        if self.count:
+            self.put(fill, 8 - self.count)
+
+    def data(self):
+        self.align()
+        return bytes(self.out)
+
+
+class BitWriterLE(BitWriter):
+    """LSB first bit packer, as Ogg, Vorbis and Opus use"""
+
+    def put(self, value, width):
+        if width == 0:
+            return
+        self.acc |= (value & ((1 << width) - 1)) << self.count
+        self.count += width
+        while self.count >= 8:
+            self.out.append(self.acc & 0xff)
+            self.acc >>= 8
+            self.count -= 8
+
+    def append(self, other):
+        for b in other.out:
+            self.put(b, 8)
+        self.put(other.acc, other.count)
+
+    def code(self, code, length):
+        """Huffman code word, first bit of the code first"""
+        for i in range(length - 1, -1, -1):
+            self.put(code >> i, 1)
+
+
+class Random:
+    """Park-Miller generator, for coded values that are the same everywhere"""
+
+    def __init__(self, seed):
+        self.state = seed
+
+    def next(self, bits):
+        self.state = (self.state * 48271) % 0x7fffffff
+        return self.state & ((1 << bits) - 1)
+
+    def below(self, n):
+        self.state = (self.state * 48271) % 0x7fffffff
+        return self.state % n
+
+class Signal:
+    """A sine sweep with some noise from a fixed LCG, so the samples are the
+    same on every host and Python version."""
+
+    def __init__(self, seed):
+        self.seed = seed
+
+    def samples(self, rate, count, channels, bits):
+        state = self.seed
+        amp = (1 << (bits - 1)) - 1
+        out = []
+        phase = 0.0
+        for n in range(count):
+            freq = 110.0 + 3000.0 * n / count
+            phase += 2 * math.pi * freq / rate
+            for c in range(channels):
+                state = (state * 1103515245 + 12345) & 0x7fffffff
+                noise = (state >> 16) / 32768.0 - 0.5
+                v = 0.7 * math.sin(phase + c) + 0.1 * noise
+                out.append(max(-amp - 1, min(amp, int(v * amp))))
+        return out
+
+
+def riff_wav(fmt, data):
+    body = b"WAVE" + b"fmt " + struct.pack("<I", len(fmt)) + fmt + \
+           b"data" + struct.pack("<I", len(data)) + data
+    if len(data) & 1:
+        body += b"\0"
+    return b"RIFF" + struct.pack("<I", len(body)) + body
+
+
+def wav_pcm(rate, channels, bits, samples):
+    width = bits // 8
+    fmt = struct.pack("<HHIIHH", 1, channels, rate, rate * channels * width,
+                      channels * width, bits)
+    if bits == 8:
+        data = bytes((s + 128) & 0xff for s in samples)
+    else:
+        data = b"".join((s & ((1 << bits) - 1)).to_bytes(width, "little")
+                        for s in samples)
+    return riff_wav(fmt, data)
+
+
+IMA_STEPS = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190,
+    209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499,
+    2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845,
+    8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+    22385, 24623, 27086, 29794, 32767]
+IMA_INDEX = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def wav_ima_adpcm(rate, samples):
+    """Mono IMA ADPCM, 256 byte blocks"""
+    block_align = 256
+    per_block = (block_align - 4) * 2 + 1
+    data = b""
+    for start in range(0, len(samples) - per_block + 1, per_block):
+        block = samples[start:start + per_block]
+        pred, index = block[0], 0
+        out = struct.pack("<hBB", pred, index, 0)
+        nibbles = []
+        for s in block[1:]:
+            step = IMA_STEPS[index]
+            diff = s - pred
+            code = 8 if diff < 0 else 0
+            diff = abs(diff)
+            delta = step >> 3
+            for bit, mult in ((4, step), (2, step >> 1), (1, step >> 2)):
+                if diff >= mult:
+                    code |= bit
+                    diff -= mult
+                    delta += mult
+            pred = max(-32768, min(32767, pred - delta if code & 8
+                                   else pred + delta))
+            index = max(0, min(88, index + IMA_INDEX[code & 7]))
+            nibbles.append(code)
+        out += bytes(nibbles[i] | (nibbles[i + 1] << 4)
+                     for i in range(0, len(nibbles), 2))
+        data += out
+    fmt = struct.pack("<HHIIHHHH", 0x11, 1, rate, rate * block_align //
+                      per_block, block_align, 4, 2, per_block)
+    return riff_wav(fmt, data)
+
+
+def ieee_extended(value):
+    exponent = 16383 + 63
+    mantissa = int(value)
+    while not mantissa & (1 << 63):
+        mantissa <<= 1
+        exponent -= 1
+    return struct.pack(">HQ", exponent, mantissa)
+
+
+def aiff(rate, channels, samples):
+    comm = struct.pack(">hIh", channels, len(samples) // channels, 16) + \
+           ieee_extended(rate)
+    ssnd = struct.pack(">II", 0, 0) + \
+           b"".join(struct.pack(">h", s) for s in samples)
+    body = b"AIFF" + b"COMM" + struct.pack(">I", len(comm)) + comm + \
+           b"SSND" + struct.pack(">I", len(ssnd)) + ssnd
+    return b"FORM" + struct.pack(">I", len(body)) + body
+
+
+def mulaw(s):
+    sign = 0x80 if s < 0 else 0
+    s = min(abs(s), 32635) + 0x84
+    exponent = 7
+    while exponent > 0 and not s & (0x4000 >> (7 - exponent)):
+        exponent -= 1
+    mantissa = (s >> (exponent + 3)) & 0x0f
+    return ~(sign | (exponent << 4) | mantissa) & 0xff
+
+
+def au_mulaw(rate, samples):
+    data = bytes(mulaw(s) for s in samples)
+    return struct.pack(">4sIIIII", b".snd", 24, len(data), 1, rate, 1) + data
+
+
+def alaw(s):
+    s >>= 3
+    if s >= 0:
+        mask = 0xd5
+    else:
+        mask = 0x55
+        s = -s - 1
+    seg = 0
+    while seg < 8 and s > (0x20 << seg) - 1:
+        seg += 1
+    if seg >= 8:
+        return 0x7f ^ mask
+    code = (seg << 4) | ((s >> 1 if seg < 2 else s >> seg) & 0x0f)
+    return code ^ mask
+
+
+def wav_alaw(rate, samples):
+    fmt = struct.pack("<HHIIHHH", 6, 1, rate, rate, 1, 8, 0)
+    return riff_wav(fmt, bytes(alaw(s) for s in samples))
+
+
+def wav_float(rate, channels, samples):
+    fmt = struct.pack("<HHIIHHH", 3, channels, rate, rate * channels * 4,
+                      channels * 4, 32, 0)
+    return riff_wav(fmt, b"".join(struct.pack("<f", s / 32768.0)
+                                  for s in samples))
+
+
+def adpcm_encode(target, state, step, codes):
+    """Greedy closed loop ADPCM encoder: for each sample take the code whose
+    decoded value lands nearest. step(state, code) models the decoder and
+    returns (state, value)."""
+    out = []
+    for s in target:
+        best = min(((step(state, c), c) for c in range(codes)),
+                   key=lambda t: abs(t[0][1] - s))
+        state = best[0][0]
+        out.append(best[1])
+    return out, state
+
+
+def ima_step(bits, index_table=None):
+    """create_pcmdata() of ima_adpcm_common.c; the state is (value, index)"""
+    table = index_table or [[-1, 2], [-1, -1, 1, 2], IMA_INDEX,
+                            [-1] * 8 + [1, 2, 4, 6, 8, 10, 13, 16]][bits - 2]
+    sign = 1 << (bits - 1)
+
+    def step(state, code):
+        value, index = state
+        size = IMA_STEPS[index]
+        delta = 0
+        check = 1 << (bits - 2)
+        while check:
+            if code & check:
+                delta += size
+            size >>= 1
+            check >>= 1
+        delta += size
+        value = max(-32768, min(32767, value - delta if code & sign
+                                else value + delta))
+        index = max(0, min(88, index + table[code & (sign - 1)]))
+        return (value, index), value
+    return step
+
+
+def pack_le(codes, bits):
+    """LSB first packing of fixed width codes"""
+    bw = BitWriterLE()
+    for c in codes:
+        bw.put(c, bits)
+    return bw.data()
+
+
+def wav_dvi_adpcm(rate, channels, bits, samples):
+    """IMA ADPCM with 2 to 5 bit codes, 257 samples per block. Each channel's
+    codes are packed LSB first and the channels take turns by 32-bit word."""
+    per_block = 257
+    block_align = 4 * channels + 32 * bits * channels
+    step = ima_step(bits)
+    frames = len(samples) // channels
+    data = b""
+    for start in range(0, frames - per_block + 1, per_block):
+        words = []
+        header = b""
+        for c in range(channels):
+            x = samples[start * channels + c:(start + per_block) * channels:
+                        channels]
+            header += struct.pack("<hBB", x[0], 0, 0)
+            codes, _ = adpcm_encode(x[1:], (x[0], 0), step, 1 << bits)
+            packed = pack_le(codes, bits)
+            words.append([packed[i:i + 4] for i in range(0, len(packed), 4)])
+        data += header + b"".join(b"".join(w) for w in zip(*words))
+    fmt = struct.pack("<HHIIHHHH", 0x11, channels, rate,
+                      rate * block_align // per_block, block_align, bits, 2,
+                      per_block)
+    return riff_wav(fmt, data)
+
+
+MS_ADPCM_COEFS = [(256, 0), (512, -256), (0, 0), (192, 64), (240, 0),
+                  (460, -208), (392, -232)]
+MS_ADPCM_ADAPT = [230, 230, 230, 230, 307, 409, 512, 614,
+                  768, 614, 512, 409, 307, 230, 230, 230]
+
+
+def ms_adpcm_step(coef):
+    """create_pcmdata() of ms_adpcm.c; the state is (s0, s1, delta)"""
+    def step(state, code):
+        s0, s1, delta = state
+        value = int((s0 * coef[0] + s1 * coef[1]) / 256)
+        value += delta * (code - ((code & 8) << 1))
+        value = max(-32768, min(32767, value))
+        delta = max(16, (MS_ADPCM_ADAPT[code] * delta) >> 8)
+        return (value, s0, delta), value
+    return step
+
+
+def wav_ms_adpcm(rate, samples):
+    """Stereo Microsoft ADPCM, 512 byte blocks, each block using the next of
+    the seven standard predictors"""
+    block_align = 512
+    per_block = block_align - 14 + 2
+    frames = len(samples) // 2
+    data = b""
+    for n, start in enumerate(range(0, frames - per_block + 1, per_block)):
+        coef = n % len(MS_ADPCM_COEFS)
+        codes = []
+        header = [b"", b"", b"", b""]
+        for c in range(2):
+            x = samples[start * 2 + c:(start + per_block) * 2:2]
+            header[0] += bytes([coef])
+            header[1] += struct.pack("<h", 16)
+            header[2] += struct.pack("<h", x[1])
+            header[3] += struct.pack("<h", x[0])
+            codes.append(adpcm_encode(x[2:], (x[1], x[0], 16),
+                                      ms_adpcm_step(MS_ADPCM_COEFS[coef]),
+                                      16)[0])
+        data += b"".join(header) + bytes((a << 4) | b
+                                         for a, b in zip(*codes))
+    fmt = struct.pack("<HHIIHHHHH", 2, 2, rate, rate * block_align //
+                      per_block, block_align, 4, 32, per_block,
+                      len(MS_ADPCM_COEFS)) + \
+        b"".join(struct.pack("<hh", *c) for c in MS_ADPCM_COEFS)
+    return riff_wav(fmt, data)
+
+
+YAMAHA_ADAPT = [230, 230, 230, 230, 307, 409, 512, 614]
+
+
+def yamaha_step(state, code):
+    """create_pcmdata() of yamaha_adpcm.c; the state is (value, step)"""
+    value, size = state
+    delta = size >> 3
+    if code & 4:
+        delta += size
+    if code & 2:
+        delta += size >> 1
+    if code & 1:
+        delta += size >> 2
+    value = max(-32768, min(32767, value - delta if code & 8
+                            else value + delta))
+    size = max(127, min(24576, (size * YAMAHA_ADAPT[code & 7]) >> 8))
+    return (value, size), value
+
+
+def wav_yamaha_adpcm(rate, samples):
+    """Stereo Yamaha ADPCM with the ACM driver's block header"""
+    block_align = (rate // 60 + 4) * 2
+    per_block = block_align - 8
+    frames = len(samples) // 2
+    data = b""
+    for start in range(0, frames - per_block, per_block):
+        codes = []
+        for c in range(2):
+            x = samples[start * 2 + c:(start + per_block + 1) * 2:2]
+            data += struct.pack("<hH", x[0], 127)
+            codes.append(adpcm_encode(x[1:], (x[0], 127), yamaha_step,
+                                      16)[0])
+        data += bytes(a | (b << 4) for a, b in zip(*codes))
+    fmt = struct.pack("<HHIIHHHH", 0x20, 2, rate, rate * block_align //
+                      per_block, block_align, 4, 2, per_block)
+    return riff_wav(fmt, data)
+
+
+def wav_swf_adpcm(rate, bits, samples):
+    """Stereo SWF ADPCM: one MSB first bit stream of 1024 sample blocks"""
+    per_block = 1024
+    step = ima_step(bits, [-1, -1, 2, 4] if bits == 3 else None)
+    frames = len(samples) // 2
+    bw = BitWriter()
+    bw.put(bits - 2, 2)
+    for start in range(0, frames - per_block + 1, per_block):
+        codes = []
+        for c in range(2):
+            x = samples[start * 2 + c:(start + per_block) * 2:2]
+            bw.put(x[0], 16)
+            bw.put(0, 6)
+            codes.append(adpcm_encode(x[1:], (x[0], 0), step, 1 << bits)[0])
+        for a, b in zip(*codes):
+            bw.put(a, bits)
+            bw.put(b, bits)
+    block_align = (((per_block - 1) * bits + 22) * 2 + 7) // 8
+    fmt = struct.pack("<HHIIHHHH", 0x5346, 2, rate, rate * block_align //
+                      per_block, block_align, bits, 2, per_block)
+    return riff_wav(fmt, bw.data())
+
+
+OKI_STEPS = [
+    16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80,
+    88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337,
+    371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282,
+    1411, 1552]
+
+
+def oki_step(state, code):
+    """create_pcmdata() of dialogic_oki_adpcm.c, 12-bit"""
+    value, index = state
+    size = OKI_STEPS[index]
+    delta = size >> 3
+    if code & 4:
+        delta += size
+    if code & 2:
+        delta += size >> 1
+    if code & 1:
+        delta += size >> 2
+    value = max(-2048, min(2047, value - delta if code & 8
+                           else value + delta))
+    index = max(0, min(48, index + IMA_INDEX[code & 7]))
+    return (value, index), value
+
+
+def vox(samples):
+    """Headerless Dialogic ADPCM, which is always 8 kHz mono"""
+    codes, _ = adpcm_encode([s >> 4 for s in samples], (0, 0), oki_step, 16)
+    return bytes((codes[i] << 4) | codes[i + 1]
+                 for i in range(0, len(codes) - 1, 2))
+
+
+def aifc(rate, channels, bits, compression, data, frames):
+    comm = struct.pack(">hIh", channels, frames, bits) + \
+        ieee_extended(rate) + compression + b"\0\0"
+    ssnd = struct.pack(">II", 0, 0) + data
+    body = b"AIFC" + b"FVER" + struct.pack(">II", 4, 0xa2805140) + \
+        b"COMM" + struct.pack(">I", len(comm)) + comm + \
+        b"SSND" + struct.pack(">I", len(ssnd)) + ssnd
+    if len(ssnd) & 1:
+        body += b"\0"
+    return b"FORM" + struct.pack(">I", len(body)) + body
+
+
+def aifc_float64(rate, channels, samples):
+    data = b"".join(struct.pack(">d", s / 32768.0) for s in samples)
+    return aifc(rate, channels, 64, b"fl64", data, len(samples) // channels)
+
+
+def aifc_alaw(rate, samples):
+    return aifc(rate, 1, 16, b"alaw", bytes(alaw(s) for s in samples),
+                len(samples))
+
+
+def aifc_ima4(rate, samples):
+    """Mono QuickTime IMA ADPCM: 34 byte packets of 64 samples. Each packet
+    header keeps the top 9 bits of the predictor."""
+    step = ima_step(4)
+    state = (0, 0)
+    data = b""
+    for start in range(0, len(samples) - 63, 64):
+        value = state[0] & ~0x7f
+        data += struct.pack(">hB", value, state[1])[:1] + \
+            bytes([(value & 0x80) | state[1]])
+        codes, state = adpcm_encode(samples[start:start + 64],
+                                    (value, state[1]), step, 16)
+        data += bytes(codes[i] | (codes[i + 1] << 4)
+                      for i in range(0, 64, 2))
+    return aifc(rate, 1, 16, b"ima4", data, len(data) // 34 * 64)
+
+
+WAVE64_GUID = b"\xf3\xac\xd3\x11\x8c\xd1\x00\xc0\x4f\x8e\xdb\x8a"
+
+
+def wave64(rate, channels, samples):
+    """16-bit Wave64: RIFF with GUID chunk ids, 64-bit sizes that include
+    the 24 byte chunk header, and 8 byte alignment"""
+    def chunk(name, data):
+        pad = b"\0" * (-len(data) & 7)
+        return name + WAVE64_GUID + struct.pack("<Q", len(data) + 24) + \
+            data + pad
+    fmt = struct.pack("<HHIIHH", 1, channels, rate, rate * channels * 2,
+                      channels * 2, 16)
+    body = b"wave" + WAVE64_GUID + chunk(b"fmt ", fmt) + \
+        chunk(b"data", b"".join(struct.pack("<h", s) for s in samples))
+    return b"riff\x2e\x91\xcf\x11\xa5\xd6\x28\xdb\x04\xc1\x00\x00" + \
+        struct.pack("<Q", len(body) + 24) + body
+
+
+def adx(rate, samples, loop_start):
+    """Stereo type 04 ADX with a loop from frame loop_start to the end, so
+    the decoder also runs its loop and fade out"""
+    a = math.sqrt(2) - math.cos(2 * math.pi * 500 / rate)
+    b = math.sqrt(2) - 1
+    c = (a - math.sqrt((a + b) * (a - b))) / b
+    coef1, coef2 = int(c * 8192), int(-c * c * 4096)
+
+    def step(scale):
+        def decode(state, code):
+            h1, h2 = state
+            d = code - 16 if code & 8 else code
+            value = d * scale + ((coef1 * h1 + coef2 * h2) >> 12)
+            value = max(-32768, min(32767, value))
+            return (value, h1), value
+        return decode
+
+    frames = len(samples) // 64
+    chanstart = 0x40
+    data = b""
+    state = [(0, 0), (0, 0)]
+    for n in range(frames):
+        for c in range(2):
+            x = samples[n * 64 + c:(n + 1) * 64:2]
+            h1, h2 = state[c]
+            peak = 0
+            for s in x:
+                peak = max(peak, abs(s - ((coef1 * h1 + coef2 * h2) >> 12)))
+                h1, h2 = s, h1
+            scale = max(1, peak // 7 + 1)
+            codes, state[c] = adpcm_encode(x, state[c], step(scale), 16)
+            data += struct.pack(">H", scale - 1) + \
+                bytes((codes[i] << 4) | codes[i + 1] for i in range(0, 32, 2))
+    header = struct.pack(">BBHBBBBIIHBB", 0x80, 0, chanstart - 4, 3, 18, 4, 2,
+                         rate, frames * 32, 500, 4, 0) + b"\0" * 16 + \
+        struct.pack(">IIIII", 1, loop_start * 32,
+                    chanstart + loop_start * 36, frames * 32,
+                    chanstart + len(data))
+    return header + b"\0\0(c)CRI" + data
+
+
+def int32(x):
+    x &= 0xffffffff
+    return x - (1 << 32) if x & 0x80000000 else x
+
+
+class TtaChannel:
+    """Per channel state of the TTA1 encoder: the adaptive hybrid filter of
+    libtta/filter.h and the adaptive rice parameters, both reset each frame"""
+
+    def __init__(self, bits):
+        self.shift = {1: 10, 2: 9, 3: 10}[(bits + 7) // 8]
+        self.pr_bits = 4 if bits <= 8 else 5
+        self.qm = [0] * 8
+        self.dl = [0] * 8
+        self.dx = [0] * 8
+        self.error = 0
+        self.last = 0
+        self.k = [10, 10]
+        self.sums = [1 << 14, 1 << 14]
+
+    def adapt(self, n, value):
+        k = self.k[n]
+        self.sums[n] += value - (self.sums[n] >> 4)
+        if k > 0 and self.sums[n] < min(1 << (k + 4), 1 << 31):
+            self.k[n] -= 1
+        elif self.sums[n] > min(1 << (k + 5), 1 << 31):
+            self.k[n] += 1
+
+    def encode(self, bw, x):
+        # stage 2: fixed order 1 prediction
+        value = x - ((self.last * ((1 << self.pr_bits) - 1)) >> self.pr_bits)
+        self.last = x
+        # stage 1: adaptive hybrid filter
+        sign = (self.error > 0) - (self.error < 0)
+        self.qm = [int32(q + sign * d) for q, d in zip(self.qm, self.dx)]
+        total = int32((1 << (self.shift - 1)) +
+                      sum(d * q for d, q in zip(self.dl, self.qm)))
+        residual = int32(value - (total >> self.shift))
+        self.error = residual
+        dl = self.dl
+        self.dx = self.dx[1:5] + [(dl[4] >> 30) | 1,
+                                  ((dl[5] >> 30) | 1) << 1,
+                                  ((dl[6] >> 30) | 1) << 1,
+                                  ((dl[7] >> 30) | 1) << 2]
+        d7 = int32(value - dl[7])
+        d6 = int32(d7 - dl[6])
+        d5 = int32(d6 - dl[5])
+        self.dl = dl[1:5] + [d5, d6, d7, value]
+        # adaptive rice code
+        u = 2 * residual - 1 if residual > 0 else -2 * residual
+        k0, k1 = self.k
+        if u < 1 << k0:
+            bw.put(0, 1)
+            bw.put(u, k0)
+        else:
+            v = u - (1 << k0)
+            ones = (v >> k1) + 1
+            while ones >= 16:
+                bw.put(0xffff, 16)
+                ones -= 16
+            bw.put((1 << ones) - 1, ones + 1)
+            bw.put(v, k1)
+            self.adapt(1, v)
+        self.adapt(0, u)
+
+
+def tta(rate, channels, bits, samples):
+    """TTA1 encoder, stereo decorrelated as libtta expects"""
+    total = len(samples) // channels
+    framelen = 256 * rate // 245
+    frames = []
+    for start in range(0, total, framelen):
+        state = [TtaChannel(bits) for _ in range(channels)]
+        bw = BitWriterLE()
+        for i in range(start, min(total, start + framelen)):
+            if channels == 1:
+                state[0].encode(bw, samples[i])
+            else:
+                left, right = samples[2 * i], samples[2 * i + 1]
+                side = right - left
+                state[0].encode(bw, side)
+                state[1].encode(bw, right - int(side / 2))
+        data = bw.data()
+        frames.append(data + struct.pack("<I", zlib.crc32(data)))
+    header = struct.pack("<4sHHHII", b"TTA1", 1, channels, bits, rate, total)
+    table = b"".join(struct.pack("<I", len(f)) for f in frames)
+    return header + struct.pack("<I", zlib.crc32(header)) + table + \
+        struct.pack("<I", zlib.crc32(table)) + b"".join(frames)
+
+
+def cdiv(a, b):
+    """C division, truncating towards zero"""
+    q = abs(a) // abs(b)
+    return q if (a < 0) == (b < 0) else -q
+
+
+class Shorten:
+    """MSB first writer of shorten's rice coded values"""
+
+    def __init__(self):
+        self.bw = BitWriter()
+
+    def ur(self, value, k):
+        q = value >> k
+        while q >= 16:
+            self.bw.put(0, 16)
+            q -= 16
+        self.bw.put(1, q + 1)
+        self.bw.put(value, k)
+
+    def sr(self, value, k):
+        self.ur(2 * value if value >= 0 else -2 * value - 1, k + 1)
+
+    def uint(self, value):
+        k = max(0, value.bit_length() - 1)
+        self.ur(k, 2)
+        self.ur(value, k)
+
+
+def shorten(rate, samples):
+    """Stereo 16-bit shorten version 2 with a four block running mean. The
+    blocks cycle through the DIFF0-3 and QLPC predictors; silent blocks use
+    ZERO."""
+    blocksize, nmean, maxnlpc = 256, 4, 4
+    frames = len(samples) // 2
+    wav = riff_wav(struct.pack("<HHIIHH", 1, 2, rate, rate * 4, 4, 16),
+                   b"")[:36] + b"data" + struct.pack("<I", frames * 4)
+    wav = wav[:4] + struct.pack("<I", 36 + frames * 4) + wav[8:]
+    out = Shorten()
+    out.bw.put(0x616a6b67, 32)
+    out.bw.put(2, 8)
+    for v in (5, 2, blocksize, maxnlpc, nmean, 0):
+        out.uint(v)
+    out.ur(9, 2)
+    out.ur(len(wav), 5)
+    for b in wav:
+        out.ur(b, 8)
+
+    history = [[0] * maxnlpc, [0] * maxnlpc]
+    means = [[0] * nmean, [0] * nmean]
+    n = 0
+    for start in range(0, frames, blocksize):
+        size = min(blocksize, frames - start)
+        if size != blocksize:
+            out.ur(5, 2)
+            out.uint(size)
+            blocksize = size
+        for c in range(2):
+            x = samples[start * 2 + c:(start + size) * 2:2]
+            hist = history[c]
+            coffset = cdiv(nmean // 2 + sum(means[c]), nmean)
+            if not any(x):
+                out.ur(8, 2)
+            else:
+                cmd = n % 5
+                n += 1
+                if cmd == 0:
+                    residual = [s - coffset for s in x]
+                    header = []
+                elif cmd < 4:
+                    coefs = [[1], [2, -1], [3, -3, 1]][cmd - 1]
+                    y = hist + x
+                    residual = [y[i] - sum(a * y[i - 1 - j]
+                                           for j, a in enumerate(coefs))
+                                for i in range(maxnlpc, len(y))]
+                    header = []
+                else:
+                    order = 1 + (n // 5) % maxnlpc
+                    y = [s - coffset for s in hist[-order:] + x]
+                    lpc = lpc_coefs(y, order, 15)
+                    coefs = [0] * order if lpc is None else \
+                        [int(round(a * 32 / (1 << lpc[0]))) for a in lpc[1]]
+                    residual = [y[i] - ((32 + sum(a * y[i - 1 - j] for j, a
+                                                  in enumerate(coefs))) >> 5)
+                                for i in range(order, len(y))]
+                    cmd = 7
+                    header = [order] + coefs
+                k = min(range(16), key=lambda k: sum(
+                    (2 * r if r >= 0 else -2 * r - 1) >> (k + 1)
+                    for r in residual) + len(residual) * k)
+                out.ur(cmd, 2)
+                out.ur(k, 3)
+                if header:
+                    out.ur(header[0], 2)
+                    for a in header[1:]:
+                        out.sr(a, 5)
+                for r in residual:
+                    out.sr(r, k)
+            means[c] = means[c][1:] + [cdiv(blocksize // 2 + sum(x),
+                                            blocksize)]
+            history[c] = (hist + x)[-maxnlpc:]
+    out.ur(4, 2)
+    return out.bw.data()
+
+
+WV_EXP2 = [min(255, int(256 * (2 ** (i / 256) - 1) + 0.5)) for i in range(256)]
+WV_LOG2 = [min(255, int(256 * math.log2(1 + i / 256) + 0.5))
+           for i in range(256)]
+WV_RATES = [6000, 8000, 9600, 11025, 12000, 16000, 22050, 24000, 32000,
+            44100, 48000, 64000, 88200, 96000, 192000]
+
+
+def wv_log2(value):
+    """mylog2() from libwavpack words.c"""
+    value += value >> 9
+    dbits = value.bit_length()
+    if value < 256:
+        return (dbits << 8) + WV_LOG2[(value << (9 - dbits)) & 0xff]
+    return (dbits << 8) + WV_LOG2[(value >> (dbits - 9)) & 0xff]
+
+
+def wv_exp2(log):
+    if log < 0:
+        return -wv_exp2(-log)
+    value = WV_EXP2[log & 0xff] | 0x100
+    log >>= 8
+    return value >> (9 - log) if log <= 9 else value << (log - 9)
+
+
+def wv_roundtrip(value):
+    """A decorrelation sample as it survives log2s() / exp2s()"""
+    log = -wv_log2(-value) if value < 0 else wv_log2(value)
+    return wv_exp2(log), log
+
+
+def wv_apply_weight(weight, sample):
+    """apply_weight() exactly as the decoder evaluates it"""
+    if -32768 <= sample < 32768:
+        return (weight * sample + 512) >> 10
+    return ((((sample & 0xffff) * weight) >> 9) +
+            ((sample & ~0xffff) >> 9) * weight + 1) >> 1
+
+
+def wv_update_weight(weight, source, result, clip=False):
+    if source and result:
+        weight += 2 if (source < 0) == (result < 0) else -2
+        if clip:
+            weight = max(-1024, min(1024, weight))
+    return weight
+
+
+class WavpackWords:
+    """send_words() / flush_word() from libwavpack words.c, stereo only"""
+
+    def __init__(self):
+        self.median = [[0, 0, 0], [0, 0, 0]]
+        self.holding_zero = self.holding_one = self.zeros_acc = 0
+        self.pend_data = self.pend_count = 0
+        self.bw = None
+
+    def counts(self, c, value):
+        med = self.median[c]
+
+        def get(i):
+            return (med[i] >> 4) + 1
+
+        def inc(i, div):
+            med[i] += ((med[i] + div) // div) * 5
+
+        def dec(i, div):
+            med[i] -= ((med[i] + div - 2) // div) * 2
+
+        if value < get(0):
+            low, high, ones = 0, get(0) - 1, 0
+            dec(0, 128)
+            return ones, low, high
+        low = get(0)
+        inc(0, 128)
+        if value - low < get(1):
+            high = low + get(1) - 1
+            dec(1, 64)
+            return 1, low, high
+        low += get(1)
+        inc(1, 64)
+        if value - low < get(2):
+            high = low + get(2) - 1
+            dec(2, 32)
+            return 2, low, high
+        ones = 2 + (value - low) // get(2)
+        low += (ones - 2) * get(2)
+        high = low + get(2) - 1
+        inc(2, 32)
+        return ones, low, high
+
+    def send(self, c, value):
+        if not (self.median[0][0] & ~1) and not self.holding_zero and \
+                not (self.median[1][0] & ~1):
+            if self.zeros_acc:
+                if value:
+                    self.flush()
+                else:
+                    self.zeros_acc += 1
+                    return
+            elif value:
+                self.bw.put(0, 1)
+            else:
+                self.median = [[0, 0, 0], [0, 0, 0]]
+                self.zeros_acc = 1
+                return
+        sign = int(value < 0)
+        if sign:
+            value = ~value
+        ones, low, high = self.counts(c, value)
+        if self.holding_zero:
+            if ones:
+                self.holding_one += 1
+            self.flush()
+            if ones:
+                self.holding_zero = 1
+                ones -= 1
+            else:
+                self.holding_zero = 0
+        else:
+            self.holding_zero = 1
+        self.holding_one = ones * 2
+        if high != low:
+            maxcode, code = high - low, value - low
+            bitcount = maxcode.bit_length()
+            extras = (1 << bitcount) - maxcode - 1
+            if code < extras:
+                self.pend(code, bitcount - 1)
+            else:
+                self.pend((code + extras) >> 1, bitcount - 1)
+                self.pend((code + extras) & 1, 1)
+        self.pend(sign, 1)
+        if not self.holding_zero:
+            self.flush()
+
+    def pend(self, value, width):
+        self.pend_data |= value << self.pend_count
+        self.pend_count += width
+
+    def run(self, count):
+        """count as a unary bit length followed by its low bits"""
+        self.bw.put((1 << count.bit_length()) - 1, count.bit_length())
+        self.bw.put(0, 1)
+        while count > 1:
+            self.bw.put(count & 1, 1)
+            count >>= 1
+
+    def flush(self):
+        if self.zeros_acc:
+            self.run(self.zeros_acc)
+            self.zeros_acc = 0
+        if self.holding_one:
+            if self.holding_one >= 16:
+                self.bw.put(0xffff, 17)
+                self.run(self.holding_one - 16)
+                self.holding_zero = 0
+            else:
+                self.bw.put((1 << self.holding_one) - 1, self.holding_one)
+            self.holding_one = 0
+        if self.holding_zero:
+            self.bw.put(0, 1)
+            self.holding_zero = 0
+        self.bw.put(self.pend_data, self.pend_count)
+        self.pend_data = self.pend_count = 0
+
+
+def wavpack(rate, samples, blocksize):
+    """Lossless stereo 16-bit WavPack 4 with the encoder's default joint
+    stereo and decorrelation terms (18, 18, 2, 3, -2)"""
+    terms = [18, 18, 2, 3, -2]
+    weights = [[0, 0] for _ in terms]
+    history = [[[0] * 8, [0] * 8] for _ in terms]
+    words = WavpackWords()
+    flags = 1 | 0x10 | 0x20 | 0x800 | 0x1000 | (15 << 18) | \
+        (WV_RATES.index(rate) << 23)
+    total = len(samples) // 2
+    out = b""
+    for start in range(0, total, blocksize):
+        count = min(blocksize, total - start)
+
+        def meta(ident, data):
+            size = struct.pack("<I", (len(data) + 1) >> 1)
+            odd = 0x40 if len(data) & 1 else 0
+            if len(data) > 510:
+                head = bytes([ident | odd | 0x80]) + size[:3]
+            else:
+                head = bytes([ident | odd]) + size[:1]
+            return head + data + b"\0" * (len(data) & 1)
+
+        # what the decoder will see: weights and the first term's samples
+        # are quantised, the other terms start from silence
+        blob = bytes(((t + 5) & 0x1f) | (2 << 5) for t in terms)
+        body = meta(2, blob)
+        blob = b""
+        for w in weights:
+            for c in range(2):
+                w[c] = max(-1024, min(1024, w[c]))
+                stored = (w[c] - ((w[c] + 64) >> 7) if w[c] > 0
+                          else w[c]) + 4 >> 3
+                blob += struct.pack("<b", stored)
+                w[c] = stored << 3
+                if w[c] > 0:
+                    w[c] += (w[c] + 64) >> 7
+        body += meta(3, blob)
+        blob = b""
+        for c in range(2):
+            for i in range(2):
+                history[0][c][i], log = wv_roundtrip(history[0][c][i])
+                blob += struct.pack("<h", log)
+        body += meta(4, blob)
+        for h in history[1:]:
+            h[0][:] = [0] * 8
+            h[1][:] = [0] * 8
+        blob = b""
+        for c in range(2):
+            for i in range(3):
+                log = wv_log2(words.median[c][i])
+                words.median[c][i] = wv_exp2(log)
+                blob += struct.pack("<H", log)
+        body += meta(5, blob)
+
+        crc = 0xffffffff
+        buf = []
+        for i in range(start, start + count):
+            left, right = samples[2 * i], samples[2 * i + 1]
+            crc = (crc * 9 + left * 3 + right) & 0xffffffff
+            left -= right
+            buf.append([left, right + (left >> 1)])
+        for t, w, h in zip(terms, weights, history):
+            for m, s in enumerate(buf):
+                if t == -2:
+                    sam_a, sam_b = s[1], h[1][0]
+                    h[1][0] = s[0]
+                    s[0] -= wv_apply_weight(w[0], sam_a)
+                    w[0] = wv_update_weight(w[0], sam_a, s[0], True)
+                    s[1] -= wv_apply_weight(w[1], sam_b)
+                    w[1] = wv_update_weight(w[1], sam_b, s[1], True)
+                    continue
+                for c in range(2):
+                    hc = h[c]
+                    if t == 18:
+                        sam = (3 * hc[0] - hc[1]) >> 1
+                        hc[1], hc[0] = hc[0], s[c]
+                    else:
+                        sam = hc[m & 7]
+                        hc[(m + t) & 7] = s[c]
+                    s[c] -= wv_apply_weight(w[c], sam)
+                    w[c] = wv_update_weight(w[c], sam, s[c])
+            if t in (2, 3):
+                m = count & 7
+                for hc in h:
+                    hc[:] = hc[m:] + hc[:m]
+        words.bw = BitWriterLE()
+        for s in buf:
+            words.send(0, s[0])
+            words.send(1, s[1])
+        words.flush()
+        bw = words.bw
+        while bw.count or len(bw.out) & 1:
+            bw.put(1, 1)
+        body += meta(0xa, bytes(bw.out))
+        out += b"wvpk" + struct.pack("<IHBBIIIII", len(body) + 24, 0x403, 0,
+                                     0, total, start, count, flags,
+                                     crc) + body
+    return out
+
+
+def protracker(seed):
+    """Four channel ProTracker module: a looped triangle, a looped square
+    and a one-shot noise burst, played with slides, arpeggio, vibrato and
+    portamento at speed 3"""
+    rnd = Random(seed)
+    triangle = [(abs(i - 16) * 16 - 128) for i in range(32)]
+    square = [96 if i < 32 else -96 for i in range(64)]
+    noise = [(rnd.next(8) - 128) * (2048 - i) // 2048 for i in range(2048)]
+    samples = [(triangle, 0, 32), (square, 0, 64), (noise, 0, 0)]
+
+    head = b"warble".ljust(20, b"\0")
+    for i in range(31):
+        if i < len(samples):
+            data, start, loop = samples[i]
+            head += b"".ljust(22, b"\0") + struct.pack(
+                ">HBBHH", len(data) // 2, 0, 64, start // 2,
+                loop // 2 if loop else 1)
+        else:
+            head += b"\0" * 28 + struct.pack(">H", 1)
+    head += bytes([1, 127]) + bytes(128) + b"M.K."
+
+    periods = [428, 381, 339, 320, 285, 254, 226, 214, 190, 170, 160, 143]
+    effects = [(0, 0x37), (4, 0x46), (3, 0x08), (0xa, 0x02), (1, 0x04),
+               (2, 0x03), (0xc, 0x20), (0, 0)]
+    pattern = b""
+    for row in range(64):
+        for ch in range(4):
+            inst = (0, 1, 1, 2)[ch] + 1
+            if row == 0 and ch == 0:
+                note, fx = periods[0], (0xf, 3)
+            elif (row + ch) % (4 + ch) == 0:
+                note = periods[rnd.below(len(periods))] >> (ch == 3)
+                fx = effects[rnd.below(len(effects))]
+            else:
+                note, inst = 0, 0
+                fx = effects[rnd.below(len(effects))] if ch < 3 else (0, 0)
+            pattern += struct.pack(">BBBB", (inst & 0x10) | (note >> 8),
+                                   note & 0xff, ((inst & 15) << 4) | fx[0],
+                                   fx[1])
+    body = b"".join(bytes(s & 0xff for s in data) for data, _, _ in samples)
+    return head + pattern + body
+
+
+def vgm(seed, seconds):
+    """SN76489 PSG tones and noise over a YM2413 FM bass line"""
+    rnd = Random(seed)
+    clock = 3579545
+    step = 44100 // 8
+    cmds = b""
+    # YM2413: preset instruments with sustain on channels 0 and 1
+    for ch, inst in ((0, 3), (1, 11)):
+        cmds += bytes([0x51, 0x30 + ch, (inst << 4) | 2])
+    for n in range(seconds * 8):
+        for ch in range(3):
+            if rnd.below(3):
+                freq = 220 * 2 ** (rnd.below(24) / 12)
+                period = min(1023, int(clock / (32 * freq)))
+                cmds += bytes([0x50, 0x80 | (ch << 5) | (period & 15),
+                               0x50, period >> 4,
+                               0x50, 0x90 | (ch << 5) | rnd.below(6)])
+            else:
+                cmds += bytes([0x50, 0x90 | (ch << 5) | 15])
+        cmds += bytes([0x50, 0xe0 | rnd.below(8),
+                       0x50, 0xf0 | (4 + rnd.below(12))])
+        for ch in range(2):
+            freq = 55 * 2 ** (rnd.below(24) / 12)
+            block = 3
+            fnum = int(freq * (1 << (19 - block)) / (clock / 72))
+            cmds += bytes([0x51, 0x20 + ch, 0,
+                           0x51, 0x10 + ch, fnum & 0xff,
+                           0x51, 0x20 + ch, 0x30 | (block << 1) | fnum >> 8])
+        cmds += bytes([0x61]) + struct.pack("<H", step)
+    cmds += b"\x66"
+    header = struct.pack("<4sIIIIIIIII", b"Vgm ", 0x40 + len(cmds) - 4,
+                         0x150, clock, clock, 0, seconds * 8 * step, 0, 0,
+                         60)
+    header += struct.pack("<HBBIII", 9, 16, 0, 0, 0, 0x40 - 0x34)
+    return header.ljust(0x40, b"\0") + cmds
+
+
+def mos6502_poke(writes):
+    """LDA #value / STA address for each (address, value)"""
+    return b"".join(bytes([0xa9, v, 0x8d, a & 0xff, a >> 8])
+                    for a, v in writes)
+
+
+def nsf():
+    """NES APU: both pulses, triangle and noise set up by the init routine;
+    the play routine sweeps the pulse and noise periods from a frame
+    counter"""
+    init = mos6502_poke([(0x4015, 0x0f), (0x4000, 0xbf), (0x4002, 0xfd),
+                         (0x4003, 0x00), (0x4004, 0x7a), (0x4006, 0xa9),
+                         (0x4007, 0x01), (0x4008, 0xff), (0x400a, 0x7f),
+                         (0x400b, 0x00), (0x400c, 0x34), (0x400e, 0x05),
+                         (0x400f, 0x00)]) + b"\x60"
+    play = bytes([0xe6, 0x00,               # inc $00
+                  0xa5, 0x00,               # lda $00
+                  0x8d, 0x02, 0x40,         # sta $4002
+                  0x4a, 0x4a,               # lsr ; lsr
+                  0x8d, 0x06, 0x40,         # sta $4006
+                  0x29, 0x0f,               # and #$0f
+                  0x8d, 0x0e, 0x40,         # sta $400e
+                  0x60])
+    load = 0x8000
+    header = struct.pack("<5sBBBHHH32s32s32sH8sHBB4x", b"NESM\x1a", 1, 1, 1,
+                         load, load, load + len(init), b"warble", b"", b"",
+                         16639, bytes(8), 19997, 0, 0)
+    return header + init + play
+
+
+def psid():
+    """C64 SID: sawtooth, pulse and triangle voices with the play routine
+    stepping voice 1's pitch and voice 2's pulse width every frame"""
+    load = 0x1000
+    init = mos6502_poke([(0xd418, 0x0f),
+                         (0xd400, 0x00), (0xd401, 0x11), (0xd405, 0x09),
+                         (0xd406, 0xf0), (0xd404, 0x21),
+                         (0xd407, 0x00), (0xd408, 0x16), (0xd409, 0x00),
+                         (0xd40a, 0x08), (0xd40c, 0x00), (0xd40d, 0xf0),
+                         (0xd40b, 0x41),
+                         (0xd40e, 0x00), (0xd40f, 0x08), (0xd413, 0x00),
+                         (0xd414, 0xf0), (0xd412, 0x11)]) + b"\x60"
+    play = bytes([0xe6, 0x02,               # inc $02
+                  0xa5, 0x02,               # lda $02
+                  0x8d, 0x00, 0xd4,         # sta $d400
+                  0x8d, 0x09, 0xd4,         # sta $d409
+                  0x29, 0x07,               # and #$07
+                  0x09, 0x10,               # ora #$10
+                  0x8d, 0x01, 0xd4,         # sta $d401
+                  0x60])
+    header = struct.pack(">4sHHHHHHHI32s32s32sHBBH", b"PSID", 2, 0x7c, 0,
+                         load, load + len(init), 1, 1, 0, b"warble", b"",
+                         b"", 0, 0, 0, 0)
+    return header + struct.pack("<H", load) + init + play
+
+
+def sap():
+    """Atari 8-bit stereo POKEY pair: pure tones and distortion on both
+    chips, the player sweeping two of the divisors every frame"""
+    load = 0x2000
+    init = mos6502_poke([(0xd20f, 0x03), (0xd21f, 0x03),
+                         (0xd208, 0x00), (0xd218, 0x01),
+                         (0xd200, 0x50), (0xd201, 0xa8),
+                         (0xd202, 0x79), (0xd203, 0xa6),
+                         (0xd204, 0x30), (0xd205, 0x24),
+                         (0xd210, 0x3c), (0xd211, 0xa8),
+                         (0xd212, 0xa2), (0xd213, 0xc6),
+                         (0xd216, 0x10), (0xd217, 0x83)]) + b"\x60"
+    play = bytes([0xe6, 0x80,               # inc $80
+                  0xa5, 0x80,               # lda $80
+                  0x8d, 0x00, 0xd2,         # sta $d200
+                  0x49, 0xff,               # eor #$ff
+                  0x8d, 0x12, 0xd2,         # sta $d212
+                  0x60])
+    code = init + play
+    header = ("SAP\r\nAUTHOR \"warble\"\r\nNAME \"POKEY\"\r\nSTEREO\r\n"
+              "TYPE B\r\nINIT %04X\r\nPLAYER %04X\r\nTIME 00:02.000\r\n" %
+              (load, load + len(init))).encode()
+    return header + struct.pack("<HHH", 0xffff, load, load + len(code) - 1) + \
+        code
+
+
+def sm83_poke(writes):
+    """LD A,value / LDH (address),A for each (I/O register, value)"""
+    return b"".join(bytes([0x3e, v, 0xe0, a & 0xff]) for a, v in writes)
+
+
+def gbs():
+    """Game Boy APU: two pulse channels, the wave channel playing a ramp and
+    the noise channel; the play routine sweeps pulse 1"""
+    load = 0x400
+    wave = [(i * 0x11) & 0xff for i in range(16)]
+    init = sm83_poke([(0xff26, 0x80), (0xff24, 0x77), (0xff25, 0xff),
+                      (0xff10, 0x00), (0xff11, 0x80), (0xff12, 0xf0),
+                      (0xff13, 0x0a), (0xff14, 0x87),
+                      (0xff16, 0x40), (0xff17, 0xa0), (0xff18, 0x83),
+                      (0xff19, 0x86), (0xff1a, 0x00)] +
+                     [(0xff30 + i, v) for i, v in enumerate(wave)] +
+                     [(0xff1a, 0x80), (0xff1c, 0x20), (0xff1d, 0x40),
+                      (0xff1e, 0x85), (0xff21, 0x71), (0xff22, 0x45),
+                      (0xff23, 0x80)]) + b"\xc9"
+    play = bytes([0x21, 0x00, 0xc0,         # ld hl,$c000
+                  0x34,                     # inc (hl)
+                  0x7e,                     # ld a,(hl)
+                  0xe0, 0x13,               # ldh ($13),a
+                  0xc9])
+    header = struct.pack("<3sBBBHHHHBB32s32s32s", b"GBS", 1, 1, 1, load,
+                         load, load + len(init), 0xfffe, 0, 0, b"warble",
+                         b"", b"")
+    return header + init + play
+
+
+def z80_out(port, writes):
+    """LD A,register / OUT (port),A / LD A,value / OUT (port+1),A"""
+    return b"".join(bytes([0x3e, r, 0xd3, port, 0x3e, v, 0xd3, port + 1])
+                    for r, v in writes)
+
+
+def ay_tones(select):
+    """AY-3-8910 setup shared by the Z80 formats: three tones, noise mixed
+    into C and the envelope generator on C. select(register, value) returns
+    the code writing one register."""
+    return b"".join(select(r, v) for r, v in (
+        (0, 0xfe), (1, 0x00), (2, 0x52), (3, 0x01), (4, 0xa0), (5, 0x02),
+        (6, 0x0c), (7, 0x18), (8, 0x0f), (9, 0x0c), (10, 0x10),
+        (11, 0x00), (12, 0x04), (13, 0x0e)))
+
+
+def ay():
+    """ZX Spectrum 128 AY file; the interrupt routine sweeps tone A"""
+    load = 0x8000
+
+    def spectrum(r, v):
+        return bytes([0x01, 0xfd, 0xff, 0x3e, r, 0xed, 0x79,
+                      0x06, 0xbf, 0x3e, v, 0xed, 0x79])
+
+    init = ay_tones(spectrum) + b"\xc9"
+    play = bytes([0x21, 0x00, 0x90,         # ld hl,$9000
+                  0x34, 0x7e, 0x5f,         # inc (hl) ; ld a,(hl) ; ld e,a
+                  0x01, 0xfd, 0xff,         # ld bc,$fffd
+                  0xaf, 0xed, 0x79,         # xor a ; out (c),a
+                  0x06, 0xbf, 0x7b,         # ld b,$bf ; ld a,e
+                  0xed, 0x79, 0xc9])        # out (c),a ; ret
+    code = init + play
+
+    # every pointer is a signed big endian offset from its own position
+    def ptr(at, to):
+        return struct.pack(">h", to - at)
+
+    tracks, data, points, blocks, text = 0x14, 0x18, 0x26, 0x2c, 0x38
+    out = b"ZXAYEMUL" + bytes([3, 0, 0, 0]) + ptr(0x0c, text) + \
+        ptr(0x0e, text) + bytes([0, 0]) + ptr(0x12, tracks)
+    out += ptr(tracks, text) + ptr(tracks + 2, data)
+    out += bytes([0, 1, 2, 3]) + struct.pack(">HH", 250, 0) + \
+        bytes([0, 0]) + ptr(data + 10, points) + ptr(data + 12, blocks)
+    out += struct.pack(">HHH", 0xfff0, load, load + len(init))
+    out += struct.pack(">HH", load, len(code)) + \
+        ptr(blocks + 4, text + 8) + bytes(6)
+    return out + b"warble\0\0" + code
+
+
+def kss():
+    """MSX: the AY PSG on ports $a0/$a1 and the Konami SCC with five
+    wavetable channels; the play routine sweeps SCC channel 1 and tone A"""
+    load = 0x4000
+    waves = bytes(int(127 * math.sin(2 * math.pi * i / 32)) & 0xff
+                  for i in range(32))
+    waves += bytes(0x60 if i < 12 else 0xa0 for i in range(32))
+    waves += bytes((i * 8 - 128) & 0xff for i in range(32))
+    waves += bytes((abs(i - 16) * 16 - 128) & 0xff for i in range(32))
+    scc = [(0x9880 + 2 * ch, lo) for ch, lo in enumerate(
+        (0xfe, 0x52, 0xa0, 0x7c, 0x3e))]
+    scc += [(0x9881 + 2 * ch, 0) for ch in range(5)]
+    scc += [(0x988a + ch, 0x0a) for ch in range(5)] + [(0x988f, 0x1f)]
+    init = ay_tones(lambda r, v: z80_out(0xa0, [(r, v)]))
+    src = load + len(init) + 11 + 5 * len(scc) + 1
+    init += bytes([0x21, src & 0xff, src >> 8,      # ld hl,waves
+                   0x11, 0x00, 0x98,                # ld de,$9800
+                   0x01, len(waves), 0x00,          # ld bc,len
+                   0xed, 0xb0])                     # ldir
+    init += b"".join(bytes([0x3e, v, 0x32, a & 0xff, a >> 8]) for a, v in scc)
+    init += b"\xc9" + waves
+    play = bytes([0x21, 0x00, 0xc0,         # ld hl,$c000
+                  0x34, 0x7e,               # inc (hl) ; ld a,(hl)
+                  0x32, 0x80, 0x98,         # ld ($9880),a
+                  0x5f, 0xaf,               # ld e,a ; xor a
+                  0xd3, 0xa0, 0x7b,         # out ($a0),a ; ld a,e
+                  0xd3, 0xa1, 0xc9])        # out ($a1),a ; ret
+    code = init + play
+    header = struct.pack("<4sHHHHBBBB", b"KSCC", load, len(code), load,
+                         load + len(init), 0, 0, 0, 0)
+    return header + code
+
+
+def sgc():
+    """Game Gear PSG: three tones and periodic noise panned through the
+    stereo register; the play routine sweeps tone 0 and the panning"""
+    load = 0x400
+    psg = [0x8e, 0x0f, 0x92, 0xa5, 0x0a, 0xb4, 0xc0, 0x1a, 0xd6, 0xe3,
+           0xf8]
+    init = b"".join(bytes([0x3e, v, 0xd3, 0x7f]) for v in psg) + \
+        bytes([0x3e, 0x5a, 0xd3, 0x06, 0xc9])
+    play = bytes([0x21, 0x00, 0xc0,         # ld hl,$c000
+                  0x34, 0x7e,               # inc (hl) ; ld a,(hl)
+                  0xd3, 0x06,               # out ($06),a
+                  0xe6, 0x0f,               # and $0f
+                  0xf6, 0x80,               # or $80
+                  0xd3, 0x7f,               # out ($7f),a
+                  0x3e, 0x08,               # ld a,$08
+                  0xd3, 0x7f, 0xc9])        # out ($7f),a ; ret
+    header = struct.pack("<4sBBHHHHHH14s4sBBBBB23s32s32s32s", b"SGC\x1a", 1,
+                         0, 0, load, load, load + len(init), 0xdff0, 0,
+                         bytes(14), bytes([0, 0, 1, 2]), 0, 1, 0, 0, 1,
+                         bytes(23), b"warble", b"", b"")
+    return header + init + play
+
+
+def hes():
+    """PC Engine: four wavetable channels and a noise channel on the HuC6280
+    PSG; a timer interrupt sweeps channel 0"""
+    base = 0xe000
+    waves = [[int(15.5 + 15.5 * math.sin(2 * math.pi * i / 32))
+              for i in range(32)],
+             [31 if i < 8 else 0 for i in range(32)],
+             [i for i in range(32)],
+             [abs(i - 16) * 2 for i in range(32)]]
+    periods = [0x1fc, 0x17d, 0x11d, 0x0be]
+    code = mos6502_poke([(0x0801, 0xff)])
+    table = base + 0x100
+    for c, period in enumerate(periods):
+        src = table + 32 * c
+        code += mos6502_poke([(0x0800, c), (0x0804, 0x00)])
+        code += bytes([0xa2, 0x00,                          # ldx #0
+                       0xbd, src & 0xff, src >> 8,          # lda wave,x
+                       0x8d, 0x06, 0x08,                    # sta $0806
+                       0xe8, 0xe0, 0x20, 0xd0, 0xf5])       # inx ; cpx ; bne
+        code += mos6502_poke([(0x0802, period & 0xff), (0x0803, period >> 8),
+                              (0x0805, 0xff), (0x0804, 0x9c)])
+    code += mos6502_poke([(0x0800, 5), (0x0805, 0xf0), (0x0807, 0x9c),
+                          (0x0804, 0x94),
+                          (0x0c00, 0x20), (0x0c01, 0x01), (0x1402, 0x03)])
+    code += b"\x58\x60"                     # cli ; rts
+    irq = base + len(code)
+    code += bytes([0x48,                    # pha
+                   0x8d, 0x03, 0x14,        # sta $1403
+                   0xee, 0x00, 0x20,        # inc $2000
+                   0xa9, 0x00,              # lda #0
+                   0x8d, 0x00, 0x08,        # sta $0800
+                   0xad, 0x00, 0x20,        # lda $2000
+                   0x8d, 0x02, 0x08,        # sta $0802
+                   0x68, 0x40])             # pla ; rti
+    rom = code.ljust(0x100, b"\0") + bytes(sum(waves, []))
+    rom = rom.ljust(0x1ff6, b"\0") + struct.pack("<HHHHH", irq, irq, irq,
+                                                 irq, base)
+    header = struct.pack("<4sBBH8s4sIII", b"HESM", 0, 0, base,
+                         bytes([0xff, 0xf8, 0, 0, 0, 0, 0, 0]), b"DATA",
+                         len(rom), 0, 0)
+    return header + rom
+
+
+def brr(samples, loop):
+    """BRR blocks of raw (filter 0) 4-bit samples at shift 12"""
+    blocks = b""
+    for i in range(0, len(samples), 16):
+        header = 0xc0 | (3 if loop and i + 16 >= len(samples) else 0)
+        nibbles = [s & 15 for s in samples[i:i + 16]]
+        blocks += bytes([header]) + bytes(nibbles[j] << 4 | nibbles[j + 1]
+                                          for j in range(0, 16, 2))
+    return blocks
+
+
+def spc():
+    """SNES: a square, saw and sine voice plus a noise voice held by the
+    S-DSP; the SPC700 only keys them on"""
+    ram = bytearray(0x10000)
+    code = bytes([0x8f, 0x4c, 0xf2,         # mov $f2,#$4c
+                  0x8f, 0x0f, 0xf3,         # mov $f3,#$0f
+                  0x2f, 0xfe])              # bra $
+    ram[0x200:0x200 + len(code)] = code
+    waves = [[7 if i < 16 else -8 for i in range(32)],
+             [i - 8 for i in range(16)],
+             [round(7 * math.sin(2 * math.pi * i / 32)) for i in range(32)]]
+    addr = 0x400
+    for n, wave in enumerate(waves):
+        data = brr(wave, True)
+        ram[0x300 + 4 * n:0x304 + 4 * n] = struct.pack("<HH", addr, addr)
+        ram[addr:addr + len(data)] = data
+        addr += len(data)
+    dsp = bytearray(128)
+    for v, (pitch, srcn, volume) in enumerate([(901, 0, 0x30), (676, 1, 0x28),
+                                               (1802, 2, 0x40),
+                                               (0x1000, 0, 0x10)]):
+        dsp[v << 4:(v << 4) + 8] = struct.pack("<BBHBBBB", volume,
+                                               0x70 - volume, pitch, srcn,
+                                               0, 0, 0x7f)
+    dsp[0x0c] = dsp[0x1c] = 0x60            # main volume
+    dsp[0x3d] = 0x08                        # noise on voice 3
+    dsp[0x5d] = 0x03                        # sample directory at $0300
+    dsp[0x6c] = 0x20 | 0x1c                 # echo writes off, noise rate
+    header = struct.pack("<33sBBBBHBBBBB2x32s32s16s32s11s3s5s32s",
+                         b"SNES-SPC700 Sound File Data v0.30", 0x1a, 0x1a,
+                         0x1a, 30, 0x200, 0, 0, 0, 0x02, 0xef,
+                         b"voices", b"warble", b"warble", b"",
+                         b"10/19/2026", b"002", b"00500", b"warble")
+    return header.ljust(0x100, b"\0") + ram + dsp + bytes(128)
+
+
+def lh5_stored(data):
+    """-lh5- stream in which every byte is a literal: with all 256 literal
+    codes 8 bits long the canonical Huffman code is the byte itself, so each
+    block only needs its code length tables"""
+    bw = BitWriter()
+    for i in range(0, len(data), 0xffff):
+        block = data[i:i + 0xffff]
+        bw.put(len(block), 16)
+        bw.put(0, 5)                        # one code length code...
+        bw.put(8 + 2, 5)                    # ...meaning "8 bits"
+        bw.put(256, 9)                      # for the 256 literals
+        bw.put(0, 4)                        # no positions
+        bw.put(0, 4)
+        for b in block:
+            bw.put(b, 8)
+    return bw.data()
+
+
+def vtx(frames):
+    """AY register dump in a VTX file; tone A sweeps and the envelope on C
+    restarts every second"""
+    setup = ay_tones(lambda r, v: bytes([v]))
+    regs = [bytearray(setup) for _ in range(frames)]
+    for n, r in enumerate(regs):
+        r[0] = (0xfe + n) & 0xff
+        if n % 50:
+            r[13] = 0xff
+    data = bytes(r[i] for i in range(14) for r in regs)
+    header = struct.pack("<2sBHIBHI", b"ay", 1, 0, 1773400, 50, 2026,
+                         len(data))
+    return header + b"voices\0warble\0\0\0\0" + lh5_stored(data)
+
+
+def smaf(samples):
+    """SMAF PCM audio track of headerless mono Yamaha ADPCM at 22050 Hz"""
+    codes = adpcm_encode(samples, (0, 0), yamaha_step, 16)[0]
+    data = bytes(a | (b << 4) for a, b in zip(codes[::2], codes[1::2]))
+
+    def chunk(name, body):
+        return name + struct.pack(">I", len(body)) + body
+
+    cnti = chunk(b"CNTI", bytes([0, 0, 1, 0, 0]) + b"ST:warble,")
+    atr = chunk(b"ATR\0", bytes([0, 0, 0x13, 0x00, 0, 0]) +
+                chunk(b"Awa\x01", data))
+    body = b"MMMD" + struct.pack(">I", len(cnti + atr) + 2) + cnti + atr
+    return body + struct.pack(">H", binascii.crc_hqx(body, 0xffff) ^ 0xffff)
+
+
+def mp4_atom(name, body):
+    return struct.pack(">I", len(body) + 8) + name + body
+
+
+def mp4(entry, rate, frames, durations, chunk_frames=4):
+    """Minimal M4A: one sound track whose sample table points into an mdat
+    after the moov"""
+    full = mp4_atom
+    stts = []
+    for d in durations:
+        if stts and stts[-1][1] == d:
+            stts[-1][0] += 1
+        else:
+            stts.append([1, d])
+    chunks = [frames[i:i + chunk_frames]
+              for i in range(0, len(frames), chunk_frames)]
+    stsc = [(1, len(chunks[0]))]
+    if len(chunks[-1]) != len(chunks[0]):
+        stsc.append((len(chunks), len(chunks[-1])))
+
+    def stbl(offset):
+        offsets = []
+        for c in chunks:
+            offsets.append(offset)
+            offset += sum(len(f) for f in c)
+        return full(b"stbl", b"".join([
+            full(b"stsd", struct.pack(">II", 0, 1) + entry),
+            full(b"stts", struct.pack(">II", 0, len(stts)) +
+                 b"".join(struct.pack(">II", *e) for e in stts)),
+            full(b"stsc", struct.pack(">II", 0, len(stsc)) +
+                 b"".join(struct.pack(">III", f, n, 1) for f, n in stsc)),
+            full(b"stsz", struct.pack(">III", 0, 0, len(frames)) +
+                 b"".join(struct.pack(">I", len(f)) for f in frames)),
+            full(b"stco", struct.pack(">II", 0, len(offsets)) +
+                 b"".join(struct.pack(">I", o) for o in offsets))]))
+
+    def moov(offset):
+        mdhd = full(b"mdhd", struct.pack(">IIIIIHH", 0, 0, 0, rate,
+                                         sum(durations), 0x55c4, 0))
+        hdlr = full(b"hdlr", struct.pack(">II4s12s", 0, 0, b"soun", b"") +
+                    b"\0")
+        smhd = full(b"smhd", bytes(8))
+        minf = full(b"minf", smhd + stbl(offset))
+        return full(b"moov", full(b"trak", full(b"mdia",
+                                                mdhd + hdlr + minf)))
+
+    ftyp = full(b"ftyp", b"M4A " + bytes(4) + b"M4A mp42isom")
+    head = ftyp + moov(0)
+    head = ftyp + moov(len(head) + 8)
+    return head + full(b"mdat", b"".join(frames))
+
+
+def mp4_sound_entry(format, channels, bits, rate, extension):
+    return mp4_atom(format, bytes(6) + struct.pack(">HHHIHHHHI", 1, 0, 0, 0,
+                                                   channels, bits, 0, 0,
+                                                   rate << 16) + extension)
+
+
+def alac_rice_value(bw, x, k, size):
+    """entropy_decode_value(): unary quotient by 2^k - 1, escape after 8"""
+    m = (1 << k) - 1
+    q, r = divmod(x, m)
+    if q > 8:
+        bw.put(0x1ff, 9)
+        bw.put(x, size)
+        return
+    bw.put((1 << (q + 1)) - 2, q + 1)
+    if k == 1:
+        return
+    if r:
+        bw.put(r + 1, k)
+    else:
+        bw.put(0, k - 1)
+
+
+def alac_rice(bw, residual, mult, history=10, kb=14):
+    """Adaptive Golomb coding of entropy_rice_decode(), zero runs included"""
+    sign = 0
+    i = 0
+    while i < len(residual):
+        v = residual[i]
+        d = 2 * v if v >= 0 else -2 * v - 1
+        k = min(kb, ((history >> 9) + 3).bit_length() - 1)
+        alac_rice_value(bw, d - sign, k, 17)
+        sign = 0
+        history += d * mult - ((history * mult) >> 9)
+        if d > 0xffff:
+            history = 0xffff
+        if history < 128 and i + 1 < len(residual):
+            run = 0
+            while i + 1 + run < len(residual) and residual[i + 1 + run] == 0:
+                run += 1
+            assert run < 1 << kb
+            k = (32 - history.bit_length()) + (history + 16) // 64 - 24
+            alac_rice_value(bw, run, k, 16)
+            i += run
+            sign = 1
+            history = 0
+        i += 1
+
+
+def alac_fir(x, coefs, quant):
+    """Residual of predictor_decompress_fir_adapt() with four taps"""
+    coefs = list(coefs)
+    err = [x[0]] + [x[i + 1] - x[i] for i in range(min(4, len(x) - 1))]
+    for i in range(5, len(x)):
+        b = x[i - 5:i]
+        s = sum((b[4 - j] - b[0]) * coefs[j] for j in range(4))
+        e = x[i] - (((1 << (quant - 1)) + s) >> quant) - b[0]
+        err.append(e)
+        sign = (e > 0) - (e < 0)
+        n = 3
+        while n >= 0 and e * sign > 0:
+            val = b[0] - b[4 - n]
+            if val:
+                coefs[n] += 1 if (val < 0) == (sign > 0) else -1
+                e -= ((abs(val) * sign) >> quant) * (4 - n)
+            n -= 1
+    return err
+
+
+def alac(rate, samples, frame_length=4096):
+    """Stereo 16-bit ALAC: a verbatim first frame, then weighted mid/side
+    frames with the adaptive four tap predictor"""
+    left, right = samples[0::2], samples[1::2]
+    frames, durations = [], []
+    coefs = [1024, -512, 0, 0]
+    for start in range(0, len(left), frame_length):
+        l, r = left[start:start + frame_length], right[start:start + frame_length]
+        n = len(l)
+        bw = BitWriter()
+        bw.put(1, 3)                        # stereo element
+        bw.put(0, 16)
+        bw.put(n != frame_length, 1)
+        bw.put(0, 2)
+        bw.put(start == 0, 1)
+        if n != frame_length:
+            bw.put(n, 32)
+        if start == 0:
+            for a, b in zip(l, r):
+                bw.put(a, 16)
+                bw.put(b, 16)
+        else:
+            diff = [a - b for a, b in zip(l, r)]
+            mid = [b + (d >> 1) for b, d in zip(r, diff)]
+            bw.put(1, 8)                    # interlacing shift
+            bw.put(1, 8)                    # left weight
+            for _ in range(2):
+                bw.put(0, 4)                # adaptive FIR
+                bw.put(9, 4)
+                bw.put(4, 3)                # rice modifier
+                bw.put(4, 5)
+                for c in coefs:
+                    bw.put(c, 16)
+            for ch in (mid, diff):
+                alac_rice(bw, alac_fir(ch, coefs, 9), 40)
+        bw.put(7, 3)                        # end tag
+        frames.append(bw.data())
+        durations.append(n)
+    config = mp4_atom(b"alac", struct.pack(">IIBBBBBBHIII", 0, frame_length,
+                                           0, 16, 40, 10, 14, 2, 255,
+                                           max(len(f) for f in frames),
+                                           0, rate))
+    return mp4(mp4_sound_entry(b"alac", 2, 16, rate, config), rate,
+               frames, durations)
+
+
+AAC_RATES = [96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000,
+             12000, 11025, 8000]
+
+
+def aac_pns_block(frame, channels, bands=49):
+    """AAC LC raw_data_block: a single channel or channel pair element of
+    long windows whose low bands are perceptual noise substitution and whose
+    top bands are silent. Each frame moves the noise energy, so the decoder's
+    PNS generator, window shapes and filterbank all run without a spectral
+    Huffman coder."""
+    bw = BitWriter()
+    bw.put(channels - 1, 3)                 # ID_SCE or ID_CPE
+    bw.put(0, 4)
+    if channels == 2:
+        bw.put(0, 1)                        # no common window
+    noise = bands - 9
+    for ch in range(channels):
+        bw.put(100, 8)                      # global gain
+        bw.put(0, 1)
+        bw.put(0, 2)                        # ONLY_LONG_SEQUENCE
+        bw.put((frame >> 2) & 1, 1)         # window shape
+        bw.put(bands, 6)
+        bw.put(0, 1)                        # no prediction
+        for cb, length in ((13, noise), (0, bands - noise)):
+            bw.put(cb, 4)
+            while length >= 31:
+                bw.put(31, 5)
+                length -= 31
+            bw.put(length, 5)
+        energy = 58 + int(8 * math.sin(2 * math.pi * (frame + 8 * ch) / 43))
+        bw.put(energy + 256, 9)             # first noise energy
+        for band in range(1, noise):
+            bw.put(0, 1)                    # scalefactor delta 0
+        bw.put(0, 3)                        # no pulse, TNS or gain control
+    bw.put(7, 3)                            # ID_END
+    return bw.data()
+
+
+def mp4_esds(config):
+    """esds atom of an MPEG-4 audio track"""
+    dsi = bytes([0x05, len(config)]) + config
+    dcd = bytes([0x04, 13 + len(dsi), 0x40, 0x15, 0, 0x18, 0]) + \
+        struct.pack(">II", 128000, 128000) + dsi
+    es = struct.pack(">HB", 1, 0) + dcd + bytes([0x06, 1, 2])
+    return mp4_atom(b"esds", bytes(4) + bytes([0x03, len(es)]) + es)
+
+
+def adts(rate, frames):
+    """Mono AAC LC in ADTS frames"""
+    out = b""
+    for n in range(frames):
+        block = aac_pns_block(n, 1)
+        bw = BitWriter()
+        bw.put(0xfff, 12)
+        bw.put(0, 1)                        # MPEG-4
+        bw.put(0, 2)
+        bw.put(1, 1)                        # no CRC
+        bw.put(1, 2)                        # LC
+        bw.put(AAC_RATES.index(rate), 4)
+        bw.put(0, 1)
+        bw.put(1, 3)                        # mono
+        bw.put(0, 4)
+        bw.put(7 + len(block), 13)
+        bw.put(0x7ff, 11)                   # variable rate
+        bw.put(0, 2)                        # one raw data block
+        out += bw.data() + block
+    return out
+
+
+def aac_mp4(rate, frames):
+    """AAC LC stereo in an M4A"""
+    config = struct.pack(">H", 2 << 11 | AAC_RATES.index(rate) << 7 | 2 << 3)
+    blocks = [aac_pns_block(n, 2) for n in range(frames)]
+    return mp4(mp4_sound_entry(b"mp4a", 2, 16, rate, mp4_esds(config)),
+               rate, blocks, [1024] * frames, 16)
+
+
+def rm_chunk(name, body, version=0):
+    return name + struct.pack(">IH", len(body) + 10, version) + body
+
+
+def realmedia(fourcc, rate, channels, extradata, packets, duration,
+              sub_packet_h=1, block_align=0, sub_packet_size=0):
+    """RealMedia file with one audio stream in a v4 RealAudio header.
+    packets are (timestamp in ms, keyframe, payload)."""
+    bitrate = sum(len(p[2]) for p in packets) * 8000 // max(1, duration)
+    ra = b".ra\xfd" + struct.pack(">HH", 4, 0) + b".ra4" + struct.pack(
+        ">IHIHI12xHHH2xH2xHH", 0, 4, 0, 0, block_align, sub_packet_h,
+        block_align, sub_packet_size, rate, 16, channels)
+    ra += b"\x04Int4\x04" + fourcc + bytes(3)
+    if extradata is not None:
+        ra += struct.pack(">I", len(extradata)) + extradata
+    mime = b"audio/x-pn-realaudio"
+    mdpr = rm_chunk(b"MDPR", struct.pack(">HIIIIIII", 0, bitrate, bitrate,
+                                         0, 0, 0, 0, duration) +
+                    b"\x06warble" + bytes([len(mime)]) + mime +
+                    struct.pack(">I", len(ra)) + ra)
+    data = b"".join(struct.pack(">HHHIBB", 0, len(p) + 12, 0, ts, 0,
+                                2 if key else 0) + p
+                    for ts, key, p in packets)
+    rmf = rm_chunk(b".RMF", struct.pack(">II", 0, 4))
+    head_size = len(rmf) + 50 + len(mdpr)
+    prop = rm_chunk(b"PROP", struct.pack(">IIIIIIIIIHH", bitrate, bitrate,
+                                         0, 0, len(packets), duration, 0,
+                                         0, head_size, 1, 0))
+    return (rmf + prop + mdpr +
+            rm_chunk(b"DATA", struct.pack(">II", len(packets), 0) + data) +
+            rm_chunk(b"INDX", struct.pack(">IHI", 0, 0, 0)))
+
+
+def raac(rate, frames):
+    """AAC LC stereo in RealMedia, one raw block per packet"""
+    packets = []
+    for n in range(frames):
+        block = aac_pns_block(n, 2)
+        packets.append((n * 1024 * 1000 // rate, True,
+                        struct.pack(">HH", 1 << 4, len(block)) + block))
+    config = struct.pack(">H", 2 << 11 | AAC_RATES.index(rate) << 7 | 2 << 3)
+    return realmedia(b"raac", rate, 2, b"\x02" + config, packets,
+                     frames * 1024 * 1000 // rate)
+
+
+# (width, code) of envelope steps -1 and 0 in each of the 13 Cook tables
+COOK_ENVELOPE_STEPS = [
+    ((3, 1), (3, 2)), ((3, 5), (4, 13)), ((3, 0), (3, 1)), ((3, 2), (3, 3)),
+    ((3, 1), (3, 2)), ((3, 2), (3, 3)), ((3, 4), (2, 0)), ((3, 3), (2, 0)),
+    ((3, 3), (3, 4)), ((3, 3), (3, 4)), ((3, 3), (2, 0)), ((3, 2), (2, 0)),
+    ((3, 3), (2, 0)),
+]
+
+
+def cook(rate, frames, seed, frame_bytes=186, subbands=37):
+    """Cook mono in RealMedia: a sloped envelope that swells over time,
+    with pseudo-random coefficients filling the rest of each frame"""
+    rng = Random(seed)
+    packets = []
+    for n in range(frames):
+        bw = BitWriter()
+        bw.put(0, 1)                            # no gain changes
+        bw.put(30 + int(6 * math.sin(2 * math.pi * n / frames)), 6)
+        for band in range(1, subbands):
+            table = min(max(band // 2, 1), 13) - 1
+            bw.put(*reversed(COOK_ENVELOPE_STEPS[table][band & 1 ^ 1]))
+        bw.put(rng.next(5), 5)                  # rate control vectors
+        while bw.bits() < frame_bytes * 8:
+            bw.put(rng.next(8), 8)
+        frame = bytes(b ^ (0x37c511f2 >> (24 - 8 * (k & 3)) & 0xff)
+                      for k, b in enumerate(bw.out[:frame_bytes]))
+        packets.append((n * 1024 * 1000 // rate, True, frame))
+    return realmedia(b"cook", rate, 1,
+                     struct.pack(">IHH4x", 0x1000001, 1024, subbands),
+                     packets, frames * 1024 * 1000 // rate, 1, frame_bytes,
+                     frame_bytes)
+
+
+def atrac3_unit(bw, frame, channel, rng, subbands=21):
+    """ATRAC3 sound unit over two QMF bands: no gain control or tonal
+    components, 3 bit constant length mantissas under a swelling tilt"""
+    bw.put(1, 2)                                # QMF bands coded - 1
+    bw.put(0, 6)                                # no gain points
+    bw.put(0, 5)                                # no tonal components
+    bw.put(subbands - 1, 5)
+    bw.put(1, 1)                                # constant length coding
+    for _ in range(subbands):
+        bw.put(3, 3)
+    for band in range(subbands):
+        bw.put(43 - band + int(4 * math.sin(2 * math.pi * frame / 43 +
+                                            channel)), 6)
+    for _ in range(ATRAC3_SUBBANDS[subbands]):
+        bw.put(rng.below(5) - 2, 3)
+
+
+ATRAC3_SUBBANDS = [0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144,
+                   160, 176, 192, 224, 256, 288, 320, 352]
+
+
+def atrac3_frame(frame, rng, joint, frame_bytes=384):
+    first = BitWriter()
+    first.put(0x28, 6)
+    atrac3_unit(first, frame, 0, rng)
+    first.put(0, -first.bits() & 7)
+    second = BitWriter()
+    if joint:
+        second.put(0, 4)                        # no channel weighting
+        second.put(0, 8)                        # matrix coefficients
+        second.put(3, 2)
+    else:
+        second.put(0x28, 6)
+    atrac3_unit(second, frame, 1, rng)
+    second.put(0, -second.bits() & 7)
+    if joint:
+        return (bytes(first.out) + bytes(frame_bytes - len(first.out) -
+                                         len(second.out)) +
+                bytes(reversed(second.out)))
+    half = frame_bytes // 2
+    return (bytes(first.out) + bytes(half - len(first.out)) +
+            bytes(second.out) + bytes(half - len(second.out)))
+
+
+def atrac3_rm(frames, seed, frame_bytes=384):
+    """ATRAC3 stereo in RealMedia, scrambled as RealAudio stores it"""
+    rng = Random(seed)
+    packets = []
+    for n in range(frames):
+        frame = atrac3_frame(n, rng, False, frame_bytes)
+        frame = bytes(b ^ (0x537f6103 >> (24 - 8 * (k & 3)) & 0xff)
+                      for k, b in enumerate(frame))
+        packets.append((n * 1024 * 1000 // 44100, True, frame))
+    return realmedia(b"atrc", 44100, 2,
+                     struct.pack(">IHHH", 4, 2048, 0x88e, 2), packets,
+                     frames * 1024 * 1000 // 44100, 1, frame_bytes,
+                     frame_bytes)
+
+
+def oma(frames, seed, frame_bytes=384):
+    """Joint stereo ATRAC3 behind an OpenMG EA3 header"""
+    rng = Random(seed)
+    header = bytearray(96)
+    header[0:6] = b"EA3\x01\x00\x60"
+    header[6:8] = b"\xff\xff"                  # not encrypted
+    header[33:36] = (1 << 17 | 1 << 13 | frame_bytes // 8).to_bytes(3, "big")
+    return (b"ea3\x03\x00\x00" + bytes(4) + bytes(header) +
+            b"".join(atrac3_frame(n, rng, True, frame_bytes)
+                     for n in range(frames)))
+
+
+def a52_exponents(bw, start, steps):
+    """D45 exponent groups, three deltas of -2..2 per 7 bit code"""
+    bw.put(start, 4)
+    steps = steps + [0] * (-len(steps) % 3)
+    for k in range(0, len(steps), 3):
+        d = steps[k:k + 3]
+        bw.put(25 * (d[0] + 2) + 5 * (d[1] + 2) + d[2] + 2, 7)
+    bw.put(0, 2)                                # gainrng
+
+
+def a52(frames, rate=48000, frmsizecod=8):
+    """Stereo A/52 frames with zero SNR offsets: no mantissas are coded,
+    every coefficient is dither shaped by D45 exponents"""
+    fscod = {48000: 0, 44100: 1, 32000: 2}[rate]
+    size = {48000: 4, 44100: 2 * 320 / 147, 32000: 6}[rate]
+    size = int(size * [32, 40, 48, 56, 64, 80][frmsizecod >> 1])
+    size += size & 1
+    out = bytearray()
+    for n in range(frames):
+        bw = BitWriter()
+        bw.put(0x0b77, 16)
+        bw.put(0, 16)                           # crc1, not checked
+        bw.put(fscod, 2)
+        bw.put(frmsizecod, 6)
+        bw.put(8, 5)                            # bsid
+        bw.put(0, 3)                            # bsmod
+        bw.put(2, 3)                            # acmod 2/0
+        bw.put(0, 2)                            # dsurmod
+        bw.put(0, 1)                            # lfeon
+        bw.put(27, 5)                           # dialnorm
+        bw.put(0, 3)                            # compre, langcode, audprodie
+        bw.put(0, 2)                            # copyrightb, origbs
+        bw.put(0, 3)                            # timecod1e, timecod2e, addbsie
+        for block in range(6):
+            bw.put(0, 2)                        # blksw
+            bw.put(3, 2)                        # dithflag
+            bw.put(0, 1)                        # dynrnge
+            bw.put(block == 0, 1)               # cplstre
+            if block == 0:
+                bw.put(0, 1)                    # cplinu
+            bw.put(block == 0, 1)               # rematstr
+            if block == 0:
+                bw.put(0b0110, 4)
+            fresh = block % 3 == 0
+            bw.put(3 if fresh else 0, 2)        # chexpstr D45 or reuse
+            bw.put(3 if fresh else 0, 2)
+            if fresh:
+                bw.put(36, 6)                   # chbwcod, 181 coefficients
+                bw.put(36, 6)
+                for ch in range(2):
+                    tilt = 3 + (n + block + 5 * ch) % 6
+                    a52_exponents(bw, 5 + ch, [1 if k % tilt == 0 else 0
+                                               for k in range(45)])
+            bw.put(block == 0, 1)               # baie
+            if block == 0:
+                bw.put(0b10111001100, 11)
+            bw.put(block == 0, 1)               # snroffste
+            if block == 0:
+                bw.put(0, 6 + 7 + 7)            # zero SNR offsets
+            bw.put(0, 1)                        # deltbaie
+            bw.put(0, 1)                        # skiple
+        bw.put(0, -bw.bits() & 7)
+        out += bytes(bw.out) + bytes(size - len(bw.out))
+    return bytes(out)
+
+
+def a52_rm(frames):
+    """A/52 in RealMedia, each frame byte swapped in its own packet"""
+    frame_bytes = len(a52(1, 44100))
+    stream = a52(frames, 44100)
+    packets = []
+    for n in range(frames):
+        frame = stream[n * frame_bytes:(n + 1) * frame_bytes]
+        swapped = bytes(frame[k ^ 1] for k in range(frame_bytes))
+        packets.append((n * 1536 * 1000 // 44100, True, swapped))
+    return realmedia(b"dnet", 44100, 2, None, packets,
+                     frames * 1536 * 1000 // 44100, 1, frame_bytes,
+                     frame_bytes)
+
+
+APE_COUNTS_3980 = [
+    0, 19578, 36160, 48417, 56323, 60899, 63265, 64435, 64971, 65232, 65351,
+    65416, 65447, 65466, 65476, 65482, 65485, 65488, 65490, 65491, 65492,
+] + list(range(65493, 65537))
+
+
+class RangeEncoder:
+    """Range coder that demac's decoder reads back: the range always
+    becomes a multiple of the symbol frequency, as in its update"""
+
+    def __init__(self):
+        self.out = bytearray()
+        self.low = 0
+        self.range = 1 << 31
+        self.buffer = 0
+        self.help = 0
+
+    def normalize(self):
+        while self.range <= 1 << 23:
+            if self.low < 0xff << 23:
+                self.out.append(self.buffer)
+                self.out += b"\xff" * self.help
+                self.help = 0
+                self.buffer = self.low >> 23
+            elif self.low & 1 << 31:
+                self.out.append(self.buffer + 1)
+                self.out += bytes(self.help)
+                self.help = 0
+                self.buffer = (self.low >> 23) & 0xff
+            else:
+                self.help += 1
+            self.range <<= 8
+            self.low = (self.low << 8) & 0x7fffffff
+
+    def encode(self, low, size, step):
+        self.normalize()
+        self.low += step * low
+        self.range = step * size
+
+    def freq(self, low, size, total):
+        self.normalize()
+        self.encode(low, size, self.range // total)
+
+    def shift(self, low, size, bits):
+        self.normalize()
+        self.encode(low, size, self.range >> bits)
+
+    def finish(self):
+        self.normalize()
+        value = (self.low >> 23) + 1
+        if value > 0xff:
+            self.out.append(self.buffer + 1)
+            self.out += bytes(self.help)
+        else:
+            self.out.append(self.buffer)
+            self.out += b"\xff" * self.help
+        self.out += bytes([value & 0xff]) + bytes(8)
+        return bytes(self.out)
+
+
+def ape_sign(x):
+    return 0 if x == 0 else (-1 if x > 0 else 1)
+
+
+class ApeFilter:
+    """One channel of demac's predictor, run forwards to find the residual
+    that makes it output a given sample"""
+
+    def __init__(self):
+        self.coefs_a = [360, 317, -109, 98]
+        self.coefs_b = [0] * 5
+        self.delay_a = [0] * 4                  # buf[xDELAYA - k]
+        self.delay_b = [0] * 5
+        self.signs_a = [0] * 4                  # buf[xADAPTCOEFFSA - k]
+        self.signs_b = [0] * 5
+        self.last = self.filter_a = self.filter_b = 0
+
+    def residual(self, target, other=None):
+        d = self.delay_a
+        d1 = self.last - d[0]
+        self.delay_a = [self.last, d1, d[1], d[2]]
+        self.signs_a = [ape_sign(self.last), ape_sign(d1)] + self.signs_a[1:3]
+        prediction = sum(x * c for x, c in zip(self.delay_a, self.coefs_a))
+        if other is not None:
+            d = self.delay_b
+            b0 = other - ((self.filter_b * 31) >> 5)
+            self.filter_b = other
+            self.delay_b = [b0, b0 - d[0], d[1], d[2], d[3]]
+            self.signs_b = ([ape_sign(b0), ape_sign(b0 - d[0])] +
+                            self.signs_b[1:4])
+            prediction += sum(x * c for x, c in
+                              zip(self.delay_b, self.coefs_b)) >> 1
+        self.last = target - ((self.filter_a * 31) >> 5)
+        self.filter_a = target
+        return self.last - (prediction >> 10)
+
+    def adapt(self, residual):
+        if residual:
+            step = -1 if residual > 0 else 1
+            self.coefs_a = [c + step * s
+                            for c, s in zip(self.coefs_a, self.signs_a)]
+            self.coefs_b = [c + step * s
+                            for c, s in zip(self.coefs_b, self.signs_b)]
+
+
+class ApeRice:
+    """demac's 3980 entropy coder state for one channel"""
+
+    def __init__(self):
+        self.ksum, self.k = 16 << 10, 10
+
+    def encode(self, rc, residual):
+        x = 2 * residual - 1 if residual > 0 else -2 * residual
+        pivot = max(self.ksum >> 5, 1)
+        overflow, base = divmod(x, pivot)
+        if overflow >= 63:
+            rc.shift(APE_COUNTS_3980[63], 1, 16)
+            rc.shift(overflow >> 16, 1, 16)
+            rc.shift(overflow & 0xffff, 1, 16)
+        else:
+            rc.shift(APE_COUNTS_3980[overflow],
+                     APE_COUNTS_3980[overflow + 1] -
+                     APE_COUNTS_3980[overflow], 16)
+        rc.freq(base, 1, pivot)
+        self.ksum += (x + 1) // 2 - ((self.ksum + 16) >> 5)
+        if self.k == 0:
+            self.k = 1
+        elif self.ksum < 1 << (self.k + 4):
+            self.k -= 1
+        elif self.ksum >= 2 << (self.k + 4):
+            self.k += 1
+
+
+def ape(rate, channels, samples):
+    """Monkey's Audio 3.99 "fast" in one frame: residuals come from a copy
+    of demac's predictors and go through its 3980 entropy coder"""
+    rc = RangeEncoder()
+    blocks = len(samples) // channels
+    if channels == 1:
+        y, rice = ApeFilter(), ApeRice()
+        for target in samples:
+            residual = y.residual(target)
+            y.adapt(residual)
+            rice.encode(rc, residual)
+    else:
+        y, x = ApeFilter(), ApeFilter()
+        rice_y, rice_x = ApeRice(), ApeRice()
+        for n in range(blocks):
+            left, right = samples[2 * n:2 * n + 2]
+            side = right - left
+            mid = left + int(side / 2)
+            residual_y = y.residual(side, x.filter_a)
+            residual_x = x.residual(mid, y.filter_a)
+            y.adapt(residual_y)
+            x.adapt(residual_x)
+            rice_y.encode(rc, residual_y)
+            rice_x.encode(rc, residual_x)
+    # CRC (not checked) with the frame flags bit clear, then the coded
+    # stream whose first byte the decoder skips; all of it is stored as
+    # little endian 32 bit words
+    stream = bytes(4) + rc.finish()
+    stream += bytes(-len(stream) & 3)
+    frame = b"".join(stream[n:n + 4][::-1] for n in range(0, len(stream), 4))
+    descriptor = struct.pack("<4sHHIIIIIII16s", b"MAC ", 3990, 0, 52, 24,
+                             4, 0, len(frame), 0, 0, bytes(16))
+    header = struct.pack("<HHIIIHHI", 1000, 0, blocks, blocks, 1, 16,
+                         channels, rate)
+    return descriptor + header + struct.pack("<I", 52 + 24 + 4) + frame
+
+
+def mpc(frames, seed, last=576, max_band=7):
+    """Musepack SV7: every band at 9 bit constant length resolution, a slow
+    tone in the lowest band over pseudo-random upper bands"""
+    rng = Random(seed)
+    bw = BitWriter()
+    bw.put(frames, 32)
+    bw.put(0, 2)                                # no intensity or M/S stereo
+    bw.put(max_band, 6)
+    bw.put(10, 4)                               # profile
+    bw.put(0, 2)
+    bw.put(0, 2)                                # 44100 Hz
+    bw.put(0, 16 * 5)                           # peak and replay gain
+    bw.put(1, 1)                                # true gapless
+    bw.put(last, 11)
+    bw.put(0, 1 + 19)
+    bw.put(0x71, 8)                             # encoder version
+    for n in range(frames):
+        frame = BitWriter()
+        frame.put(10, 4)
+        frame.put(10, 4)
+        for band in range(max_band * 2):
+            frame.put(1, 1)                     # same resolution as below
+        for band in range((max_band + 1) * 2):
+            frame.put(0, 2)                     # one scale factor per frame
+        for band in range((max_band + 1) * 2):
+            frame.put(0xc, 4)                   # absolute scale factor
+            frame.put(12 + band // 2 * 3 +
+                      int(4 * math.sin(2 * math.pi * n / frames)), 6)
+        for band in range(max_band + 1):
+            for channel in range(2):
+                for k in range(36):
+                    if band == 0:
+                        q = int(200 * math.sin(2 * math.pi * (n * 36 + k) /
+                                               (11 + channel)))
+                    else:
+                        q = rng.below(81) - 40
+                    frame.put(q + 255, 9)
+        bw.put(frame.bits(), 20)
+        bw.append(frame)
+    bw.put(last, 11)
+    data = bw.data()
+    data += bytes(-len(data) & 3)
+    return b"MP+\x07" + b"".join(data[k:k + 4][::-1]
+                                 for k in range(0, len(data), 4))
+
+
+def asf_guid(text):
+    return uuid.UUID(text).bytes_le
+
+
+def asf_object(guid, body):
+    return asf_guid(guid) + struct.pack("<Q", 24 + len(body)) + body
+
+
+def asf(codec_id, channels, rate, bitrate, bits, extradata, frames,
+        duration):
+    """ASF with one audio stream, one frame per packet as the payload of
+    a single media object"""
+    size = len(frames[0]) + 26
+    fileprop = asf_object("8cabdca1-a947-11cf-8ee4-00c00c205365",
+                          bytes(32) + struct.pack("<QQQQIIII", len(frames),
+                                                  duration * 10000,
+                                                  duration * 10000, 0, 2,
+                                                  size, size, bitrate))
+    wfx = struct.pack("<HHIIHHH", codec_id, channels, rate, bitrate // 8,
+                      len(frames[0]), bits, len(extradata)) + extradata
+    stream = asf_object("b7dc0791-a9b7-11cf-8ee6-00c00c205365",
+                        asf_guid("f8699e40-5b4d-11cf-a8fd-00805f5c442b") +
+                        asf_guid("20fb5700-5b55-11cf-a8fd-00805f5c442b") +
+                        struct.pack("<QIIHI", 0, len(wfx), 0, 1, 0) + wfx)
+    header = asf_object("75b22630-668e-11cf-a6d9-00aa0062ce6c",
+                        struct.pack("<IBB", 2, 1, 2) + fileprop + stream)
+    packets = b"".join(
+        b"\x82\0\0" + struct.pack("<BBIHBBIBII", 0, 0x5d, n * 100, 100,
+                                   0x81, n, 0, 8, len(frame), n * 100) +
+        frame for n, frame in enumerate(frames))
+    data = asf_object("75b22636-668e-11cf-a6d9-00aa0062ce6c",
+                      bytes(16) + struct.pack("<QH", len(frames), 0x101) +
+                      packets)
+    return header + data
+
+
+def wma_escape(bw, level, run):
+    bw.put(0x258, 11)
+    bw.put(level, 9)                            # total gain 45 and up
+    bw.put(run, 11)
+    bw.put(1, 1)
+
+
+WMA_LSP_INDEXES = [6, 12, 11, 11, 11, 11, 11, 3, 7, 6]
+
+
+def wma(frames, frame_bytes=186):
+    """WMA version 2 stereo at 32 kb/s: LSP coded envelopes, a few escape
+    coded spectral peaks and noise coded high bands"""
+    out = []
+    for n in range(frames):
+        bw = BitWriter()
+        bw.put(0, 1)                            # no M/S stereo
+        bw.put(3, 2)                            # both channels coded
+        bw.put(80, 7)                           # total gain - 1
+        for ch in range(2):
+            bw.put(0xf, 4)                      # all four high bands noise
+        for ch in range(2):
+            bw.put(30 + ch * 4, 7)
+            for _ in range(3):
+                bw.put(3, 4)                    # same power as below
+        for ch in range(2):
+            # ordered line spectral pairs near an even spread, with the
+            # middle ones wandering so the envelope moves
+            swing = round(1.5 * math.sin(2 * math.pi * n / 21 + ch))
+            lsp = WMA_LSP_INDEXES[:2] + [i + swing for i in
+                                         WMA_LSP_INDEXES[2:5]] + \
+                WMA_LSP_INDEXES[5:]
+            for i, width in zip(lsp, (3, 4, 4, 4, 4, 4, 4, 4, 3, 3)):
+                bw.put(i, width)
+        for ch in range(2):
+            wma_escape(bw, 40 + n % 20 * 20, 24 + ch * 8)
+            wma_escape(bw, 300, 40)
+            bw.put(0x3d, 6)                     # end of block
+        out.append(bw.data().ljust(frame_bytes, b"\0"))
+    return asf(0x161, 2, 44100, 32000, 16,
+               struct.pack("<IH", 0, 0), out, frames * 2048 * 1000 // 44100)
+
+
+def wmapro(frames, block_align=64):
+    """WMA Pro stereo: one 2048 sample subframe per frame and packet, a
+    few vector coded low bins under a sloped scale factor envelope"""
+    log2_frame_size = block_align.bit_length() - 1 + 4
+    out = []
+    for n in range(frames):
+        frame = BitWriter()
+        frame.put(0, 1)                         # no post processing
+        frame.put(0, 1)                         # no skip samples
+        frame.put(0, 2)                         # no fill or reserved bits
+        frame.put(0, 1)
+        frame.put(2, 2)                         # no channel transform
+        frame.put(3, 2)                         # both channels coded
+        frame.put(1, 1)                         # vector coded count follows
+        for ch in range(2):
+            frame.put(64 // 4, 10)
+        frame.put(31, 6)                        # quantization step 90 + 31
+        frame.put(31, 5)                        # + 31
+        frame.put(12, 5)                        # + 12
+        frame.put(0, 3)
+        frame.put(0, 2)                         # no channel modifiers
+        for ch in range(2):
+            frame.put(0, 2)                     # scale factor step 1
+            for band in range(26):              # 44.1 kHz, 2048 bins
+                frame.put(*((1, 1) if band < 3 else (1, 2)))
+        for ch in range(2):
+            frame.put(0, 1)                     # run level table 0
+            peaks = (2 + (n + 3 * ch) % 8, 11)
+            for group in range(16):
+                if group in peaks:
+                    frame.put(0x26, 6)          # 1, 0, 0, 0
+                    frame.put(1, 1)
+                else:
+                    frame.put(0x19, 5)
+            frame.put(0x2b, 7)                  # end of block
+        frame.put(0, 1)                         # padding
+        frame.put(0, 1)                         # last frame in the packet
+        bw = BitWriter()
+        bw.put(n & 15, 4)
+        bw.put(0, 2)
+        bw.put(0, log2_frame_size)              # nothing carried over
+        bw.put(frame.bits() + log2_frame_size, log2_frame_size)
+        bw.append(frame)
+        out.append(bw.data().ljust(block_align, b"\0"))
+    extradata = struct.pack("<HIIIH2x", 16, 3, 0, 0, 0x40)
+    return asf(0x162, 2, 44100, block_align * 8 * 44100 // 2048, 16,
+               extradata, out, frames * 2048 * 1000 // 44100)
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xff if crc & 0x80 else crc << 1
+    return crc
+
+
+def crc16(data):
+    crc = 0
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x8005) & 0xffff if crc & 0x8000 \
+                  else crc << 1
+    return crc
+
+
+def flac_streaminfo(rate, channels, bits, blocksize, total):
+    info = struct.pack(">HH", blocksize, blocksize) + b"\0" * 6 + \
+        ((rate << 44) | ((channels - 1) << 41) | ((bits - 1) << 36) |
+         total).to_bytes(8, "big") + b"\0" * 16
+    return b"fLaC" + bytes([0x80]) + len(info).to_bytes(3, "big") + info
+
+
+def flac_frame_header(n, channel_mode, bits, count):
+    size_code = {8: 1, 16: 4, 24: 6}[bits]
+    hdr = b"\xff\xf8" + bytes([0x70, (channel_mode << 4) | (size_code << 1),
+                               n]) + struct.pack(">H", count - 1)
+    return hdr + bytes([crc8(hdr)])
+
+
+def flac_verbatim(rate, channels, samples):
+    """16-bit FLAC with verbatim subframes, 4096 samples per frame"""
+    blocksize = 4096
+    total = len(samples) // channels
+    out = flac_streaminfo(rate, channels, 16, blocksize, total)
+    frames = (total + blocksize - 1) // blocksize
+    for n in range(frames):
+        count = min(blocksize, total - n * blocksize)
+        frame = flac_frame_header(n, channels - 1, 16, count)
+        for c in range(channels):
+            frame += b"\x02" + b"".join(
+                struct.pack(">h", samples[(n * blocksize + i) * channels + c])
+                for i in range(count))
+        out += frame + struct.pack(">H", crc16(frame))
+    return out
+
+
+def rice_cost(values, k):
+    return sum(u >> k for u in values) + len(values) * (k + 1)
+
+
+def rice_param(values, limit):
+    """Cheapest parameter near log2 of the mean"""
+    if not values:
+        return 0
+    mean = sum(values) // len(values)
+    guess = min(limit - 1, max(1, mean.bit_length() - 1))
+    return min(range(guess - 1, min(limit, guess + 2)),
+               key=lambda k: rice_cost(values, k))
+
+
+def flac_residual(bw, residual, blocksize, order, method):
+    """Partitioned rice coding with the cheapest partition order"""
+    limit = 15 if method == 0 else 31
+    folded = [(r << 1) ^ (r >> 63) for r in residual]
+    best = None
+    for porder in range(5):
+        size = blocksize >> porder
+        if blocksize % (1 << porder) or size <= order:
+            break
+        parts = [folded[max(0, p * size - order):(p + 1) * size - order]
+                 for p in range(1 << porder)]
+        params = [rice_param(part, limit) for part in parts]
+        cost = sum(rice_cost(part, k) for part, k in zip(parts, params))
+        if best is None or cost < best[0]:
+            best = (cost, porder, parts, params)
+    _, porder, parts, params = best
+    bw.put(method, 2)
+    bw.put(porder, 4)
+    for part, k in zip(parts, params):
+        bw.put(k, 4 if method == 0 else 5)
+        for u in part:
+            q = u >> k
+            while q >= 32:
+                bw.put(0, 32)
+                q -= 32
+            bw.put(1, q + 1)
+            bw.put(u, k)
+
+
+def fixed_residual(x, order):
+    coefs = [[], [1], [2, -1], [3, -3, 1], [4, -6, 4, -1]][order]
+    return [x[i] - sum(c * x[i - 1 - j] for j, c in enumerate(coefs))
+            for i in range(order, len(x))]
+
+
+def lpc_coefs(x, order, precision):
+    """Levinson-Durbin on the block autocorrelation, quantised"""
+    r = [sum(x[i] * x[i - lag] for i in range(lag, len(x)))
+         for lag in range(order + 1)]
+    if r[0] == 0:
+        return None
+    a = [0.0] * order
+    err = float(r[0])
+    for i in range(order):
+        acc = r[i + 1] - sum(a[j] * r[i - j] for j in range(i))
+        k = acc / err
+        a = [a[j] - k * a[i - 1 - j] for j in range(i)] + [k] + a[i + 1:]
+        err *= 1 - k * k
+        if err <= 0:
+            return None
+    cmax = max(abs(c) for c in a)
+    if cmax == 0:
+        return None
+    shift = min(15, max(0, precision - 1 - math.frexp(cmax)[1]))
+    limit = (1 << (precision - 1)) - 1
+    return shift, [max(-limit, min(limit, int(round(c * (1 << shift)))))
+                   for c in a]
+
+
+def lpc_residual(x, shift, coefs):
+    order = len(coefs)
+    return [x[i] - (sum(c * x[i - 1 - j] for j, c in enumerate(coefs))
+                    >> shift) for i in range(order, len(x))]
+
+
+def flac_subframe(bw, x, bits, method, lpc_order):
+    """Best of the fixed predictors and an LPC predictor"""
+    choices = [(sum(map(abs, r)), ("fixed", order, r))
+               for order in range(5) for r in [fixed_residual(x, order)]]
+    lpc = lpc_coefs(x, lpc_order, 12)
+    if lpc:
+        r = lpc_residual(x, *lpc)
+        choices.append((sum(map(abs, r)), ("lpc", lpc, r)))
+    kind, param, residual = min(choices, key=lambda c: c[0])[1]
+    if kind == "fixed":
+        bw.put(0x10 | (param << 1), 8)
+        order = param
+    else:
+        shift, coefs = param
+        order = len(coefs)
+        bw.put(0x40 | ((order - 1) << 1), 8)
+    for s in x[:order]:
+        bw.put(s, bits)
+    if kind == "lpc":
+        bw.put(12 - 1, 4)
+        bw.put(shift, 5)
+        for c in coefs:
+            bw.put(c, 12)
+    flac_residual(bw, residual, len(x), order, method)
+
+
+def flac_predictive(rate, channels, bits, samples, blocksize=4096):
+    """FLAC with fixed and LPC predictors, cycling through the stereo
+    decorrelation modes frame by frame"""
+    total = len(samples) // channels
+    out = flac_streaminfo(rate, channels, bits, blocksize, total)
+    frames = (total + blocksize - 1) // blocksize
+    for n in range(frames):
+        count = min(blocksize, total - n * blocksize)
+        chans = [samples[n * blocksize * channels + c:
+                         (n * blocksize + count) * channels:channels]
+                 for c in range(channels)]
+        mode = channels - 1
+        widths = [bits] * channels
+        if channels == 2:
+            mode = [1, 8, 9, 10][n % 4]
+            left, right = chans
+            side = [a - b for a, b in zip(left, right)]
+            if mode == 8:
+                chans, widths = [left, side], [bits, bits + 1]
+            elif mode == 9:
+                chans, widths = [side, right], [bits + 1, bits]
+            elif mode == 10:
+                chans = [[(a + b) >> 1 for a, b in zip(left, right)], side]
+                widths = [bits, bits + 1]
+        bw = BitWriter()
+        for x, width in zip(chans, widths):
+            flac_subframe(bw, x, width, n & 1, 8)
+        frame = flac_frame_header(n, mode, bits, count) + bw.data()
+        out += frame + struct.pack(">H", crc16(frame))
+    return out
+
+
+def mpeg_header(bw, version, layer, bitrate, samplerate, mode, mode_ext=0):
+    """version 3 = MPEG-1, 2 = MPEG-2; layer 1-3; no CRC, no padding"""
+    bw.put(0x7ff, 11)
+    bw.put(version, 2)
+    bw.put(4 - layer, 2)
+    bw.put(1, 1)
+    bw.put(bitrate, 4)
+    bw.put(samplerate, 2)
+    bw.put(0, 2)
+    bw.put(mode, 2)
+    bw.put(mode_ext, 2)
+    bw.put(0, 4)
+
+
+def mp1(frames, seed):
+    """Layer I, 44.1 kHz joint stereo at 192 kbps"""
+    rnd = Random(seed)
+    out = b""
+    for n in range(frames):
+        mode_ext = n % 4
+        bound = 4 + 4 * mode_ext
+        bw = BitWriter()
+        mpeg_header(bw, 3, 1, 6, 0, 1, mode_ext)
+        budget = 52 * 32 - 32
+        alloc = [[0] * 32, [0] * 32]
+        for sb in range(32):
+            for ch in range(2 if sb < bound else 1):
+                budget -= 4
+        for sb in range(32):
+            for ch in range(2 if sb < bound else 1):
+                nb = rnd.below(max(1, 15 - sb // 2))
+                cost = 6 * (2 if sb >= bound else 1) + 12 * (nb + 1)
+                if nb and cost <= budget:
+                    alloc[ch][sb] = nb
+                    budget -= cost
+                    if sb >= bound:
+                        alloc[1][sb] = nb
+        for sb in range(32):
+            for ch in range(2 if sb < bound else 1):
+                bw.put(alloc[ch][sb], 4)
+        for sb in range(32):
+            for ch in range(2):
+                if alloc[ch][sb]:
+                    bw.put(10 + rnd.below(40), 6)
+        for s in range(12):
+            for sb in range(32):
+                for ch in range(2 if sb < bound else 1):
+                    nb = alloc[ch][sb]
+                    if nb:
+                        bw.put(rnd.next(nb + 1), nb + 1)
+        out += bw.data().ljust(52 * 4, b"\0")
+    return out
+
+
+# Layer II quantisation classes: (levels, grouped, bits per sample or group)
+MP2_CLASSES = [
+    (3, 1, 5), (5, 1, 7), (7, 0, 3), (9, 1, 10), (15, 0, 4), (31, 0, 5),
+    (63, 0, 6), (127, 0, 7), (255, 0, 8), (511, 0, 9), (1023, 0, 10),
+    (2047, 0, 11), (4095, 0, 12), (8191, 0, 13), (16383, 0, 14),
+    (32767, 0, 15), (65535, 0, 16)]
+
+# ISO/IEC 11172-3 Table B.2b (44.1 kHz, 96 kbps and up per channel):
+# (bits of allocation, class of each allocation from 1 up) per subband
+MP2_ALLOC = (
+    [(4, [0, 2, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16])] * 3 +
+    [(4, [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 16])] * 8 +
+    [(3, [0, 1, 2, 3, 4, 5, 16])] * 12 +
+    [(2, [0, 1, 16])] * 7)
+
+
+def mp2(frames, seed):
+    """Layer II, 44.1 kHz at 192 kbps, alternating stereo and joint stereo"""
+    rnd = Random(seed)
+    size = 144 * 192000 // 44100
+    out = b""
+    for n in range(frames):
+        joint = n & 1
+        mode_ext = (n >> 1) % 4
+        bound = min(30, 4 + 4 * mode_ext) if joint else 30
+        bw = BitWriter()
+        mpeg_header(bw, 3, 2, 10, 0, joint, mode_ext)
+        budget = size * 8 - 32
+        for sb in range(30):
+            budget -= MP2_ALLOC[sb][0] * (2 if sb < bound else 1)
+        alloc = [[0] * 30, [0] * 30]
+        scfsi = [[0] * 30, [0] * 30]
+        for sb in range(30):
+            nbal, classes = MP2_ALLOC[sb]
+            for ch in range(2 if sb < bound else 1):
+                a = rnd.below(1 + ((1 << nbal) - 1) * (30 - sb) // 30)
+                if not a:
+                    continue
+                levels, grouped, bits = MP2_CLASSES[classes[a - 1]]
+                sel = [rnd.below(4) for _ in range(1 if sb < bound else 2)]
+                cost = sum(2 + 6 * [3, 2, 1, 2][x] for x in sel) + \
+                    12 * (bits if grouped else 3 * bits)
+                if cost <= budget:
+                    budget -= cost
+                    for c, x in enumerate(sel):
+                        alloc[ch + c][sb] = a
+                        scfsi[ch + c][sb] = x
+        for sb in range(30):
+            for ch in range(2 if sb < bound else 1):
+                bw.put(alloc[ch][sb], MP2_ALLOC[sb][0])
+        for sb in range(30):
+            for ch in range(2):
+                if alloc[ch][sb]:
+                    bw.put(scfsi[ch][sb], 2)
+        for sb in range(30):
+            for ch in range(2):
+                if alloc[ch][sb]:
+                    for _ in range([3, 2, 1, 2][scfsi[ch][sb]]):
+                        bw.put(10 + rnd.below(40), 6)
+        for gr in range(12):
+            for sb in range(30):
+                for ch in range(2 if sb < bound else 1):
+                    a = alloc[ch][sb]
+                    if not a:
+                        continue
+                    levels, grouped, bits = MP2_CLASSES[MP2_ALLOC[sb][1][a - 1]]
+                    if grouped:
+                        bw.put(rnd.below(levels ** 3), bits)
+                    else:
+                        for _ in range(3):
+                            bw.put(rnd.below(levels), bits)
+        out += bw.data().ljust(size, b"\0")
+    return out
+
+
+# Layer III: Huffman table 1 for (x, y) in 0..1 and count1 table A for
+# (v, w, x, y) in 0..1, ISO/IEC 11172-3 Table B.7, as (code, length)
+MP3_TABLE1 = [(1, 1), (1, 3), (1, 2), (0, 3)]
+MP3_COUNT1A = [
+    (1, 1), (5, 4), (4, 4), (5, 5), (6, 4), (5, 6), (4, 5), (4, 6),
+    (7, 4), (3, 5), (6, 5), (0, 6), (7, 5), (2, 6), (3, 6), (1, 6)]
+MP3_SLEN = [(0, 0), (0, 1), (0, 2), (0, 3), (3, 0), (1, 1), (1, 2), (1, 3),
+            (2, 1), (2, 2), (2, 3), (3, 1), (3, 2), (3, 3), (4, 2), (4, 3)]
+MP3_NSFB_LSF = [[6, 5, 5, 5], [9, 9, 9, 9], [6, 9, 9, 9]]
+
+
+class Mp3Granule:
+    """Side info and main data of one granule of one channel. The spectrum
+    only holds values of -1, 0 and 1, coded with table 1 and the count1
+    tables; the scalefactors and gains do the shaping."""
+
+    def __init__(self, rnd, lsf, block, budget, scfsi=0):
+        self.block_type, self.mixed = block
+        self.lsf = lsf
+        side = BitWriter()
+        main = BitWriter()
+        slen = []
+        if lsf:
+            sfc = rnd.below(400)
+            slen = [(sfc >> 4) // 5, (sfc >> 4) % 5, (sfc % 16) >> 2, sfc % 4]
+            index = 0 if self.block_type != 2 else (2 if self.mixed else 1)
+            for count, width in zip(MP3_NSFB_LSF[index], slen):
+                for _ in range(count):
+                    main.put(rnd.next(width), width)
+        else:
+            sfc = rnd.below(16)
+            slen1, slen2 = MP3_SLEN[sfc]
+            if self.block_type == 2:
+                widths = [slen1] * (17 if self.mixed else 18) + [slen2] * 18
+            else:
+                widths = []
+                for band, (count, width) in enumerate(
+                        ((6, slen1), (5, slen1), (5, slen2), (5, slen2))):
+                    if not scfsi & (8 >> band):
+                        widths += [width] * count
+            for width in widths:
+                main.put(rnd.next(width), width)
+        self.sfc = sfc
+
+        density = 20 + rnd.below(60)
+        big_values = 0
+        while big_values < 288 and main.bits() + 12 < budget:
+            if rnd.below(100) >= density * (288 - big_values) // 288:
+                x = y = 0
+            else:
+                x, y = rnd.next(1), rnd.next(1)
+            code, length = MP3_TABLE1[x * 2 + y]
+            main.put(code, length)
+            for v in (x, y):
+                if v:
+                    main.put(rnd.next(1), 1)
+            big_values += 1
+            if rnd.below(64) == 0:
+                break
+        self.big_values = big_values
+        self.count1table = rnd.next(1)
+        lines = big_values * 2
+        while lines + 4 <= 576 and main.bits() + 10 < budget:
+            quad = rnd.next(4) if rnd.below(4) == 0 else 0
+            if self.count1table:
+                main.put(15 - quad, 4)
+            else:
+                main.put(*MP3_COUNT1A[quad])
+            for bit in (8, 4, 2, 1):
+                if quad & bit:
+                    main.put(rnd.next(1), 1)
+            lines += 4
+        self.main = main
+
+        side.put(main.bits(), 12)
+        side.put(big_values, 9)
+        side.put(166 + rnd.below(25), 8)
+        side.put(sfc, 9 if lsf else 4)
+        if self.block_type:
+            side.put(1, 1)
+            side.put(self.block_type, 2)
+            side.put(self.mixed, 1)
+            side.put(1, 5)
+            side.put(1, 5)
+            for _ in range(3):
+                side.put(rnd.below(3), 3)
+        else:
+            side.put(0, 1)
+            side.put(1, 5)
+            side.put(1, 5)
+            side.put(1, 5)
+            side.put(rnd.below(8), 4)
+            side.put(rnd.below(4), 3)
+        if not lsf:
+            side.put(rnd.next(1), 1)
+        side.put(rnd.next(1), 1)
+        side.put(self.count1table, 1)
+        self.side = side
+
+
+def mp3(frames, seed, lsf=False):
+    """Layer III. MPEG-1 is 44.1 kHz at 128 kbps, cycling through the block
+    types and the stereo modes; MPEG-2 (lsf) is 22.05 kHz mono at 32 kbps.
+    Frames fill a varying share of the space they have, so main_data_begin
+    points back into the bit reservoir."""
+    rnd = Random(seed)
+    if lsf:
+        size, nch, ngr, side_bytes = 72 * 32000 // 22050, 1, 1, 9
+    else:
+        size, nch, ngr, side_bytes = 144 * 128000 // 44100, 2, 2, 32
+    slot = size - 4 - side_bytes
+    begin_max = 255 if lsf else 511
+    blocks = [(0, 0), (1, 0), (2, 0), (3, 0), (2, 1), (0, 0), (0, 0)]
+    stream = bytearray()
+    heads = []
+    for n in range(frames):
+        mode = 3 if lsf else (1 if n % 3 else 0)
+        mode_ext = (n // 3) % 4 if mode == 1 else 0
+        start = max(len(stream), n * slot - begin_max)
+        stream += bytes(start - len(stream))
+        budget = (n * slot + slot - start) * 8 * (40 + rnd.below(60)) // 100
+        kinds = [[blocks[(n * ngr + gr + (ch if mode != 1 else 0)) %
+                         len(blocks)] for ch in range(nch)]
+                 for gr in range(ngr)]
+        scfsi = [0 if lsf or any(kinds[gr][ch][0] == 2 for gr in range(ngr))
+                 else rnd.next(4) for ch in range(nch)]
+        side = BitWriter()
+        side.put(n * slot - start, 8 if lsf else 9)
+        side.put(0, (1 if nch == 1 else 2) if lsf else (5 if nch == 1 else 3))
+        main = BitWriter()
+        if not lsf:
+            for ch in range(nch):
+                side.put(scfsi[ch], 4)
+        for gr in range(ngr):
+            for ch in range(nch):
+                g = Mp3Granule(rnd, lsf, kinds[gr][ch], budget // (ngr * nch),
+                               scfsi[ch] if gr else 0)
+                side.append(g.side)
+                main.append(g.main)
+        hdr = BitWriter()
+        mpeg_header(hdr, 2 if lsf else 3, 3, 4 if lsf else 9, 0, mode,
+                    mode_ext)
+        heads.append(hdr.data() + side.data())
+        stream += main.data()
+        assert len(stream) <= (n + 1) * slot
+    stream += bytes(frames * slot - len(stream))
+    return b"".join(head + stream[n * slot:(n + 1) * slot]
+                    for n, head in enumerate(heads))
+
+
+def ogg_crc(data):
+    crc = 0
+    for b in data:
+        crc ^= b << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04c11db7) & 0xffffffff if crc & 0x80000000 \
+                  else (crc << 1) & 0xffffffff
+    return crc
+
+
+def ogg(packets, serial):
+    """Ogg stream of (packet, granule position) pairs. Each header packet
+    (granule None) ends a page; audio pages hold up to 4 kB."""
+    pages = []
+    page, lacing, granule = b"", [], 0
+
+    def flush(eos=False):
+        seq = len(pages)
+        hdr = struct.pack("<4sBBqIII", b"OggS", 0,
+                          (2 if seq == 0 else 0) | (4 if eos else 0),
+                          granule, serial, seq, 0) + \
+            bytes([len(lacing)]) + bytes(lacing)
+        crc = ogg_crc(hdr + page)
+        pages.append(hdr[:22] + struct.pack("<I", crc) + hdr[26:] + page)
+
+    for n, (packet, pos) in enumerate(packets):
+        seg = [255] * (len(packet) // 255) + [len(packet) % 255]
+        if lacing and (len(lacing) + len(seg) > 255 or
+                       len(page) + len(packet) > 4096):
+            flush()
+            page, lacing = b"", []
+        page += packet
+        lacing += seg
+        granule = pos if pos is not None else 0
+        if pos is None:
+            flush()
+            page, lacing = b"", []
+    if lacing:
+        flush(True)
+    return b"".join(pages)
+
+
+def vorbis_float(value):
+    """Codebook float: 21 bit mantissa, 10 bit exponent biased by 788"""
+    exponent = 0
+    mantissa = abs(value)
+    while mantissa != int(mantissa):
+        mantissa *= 2
+        exponent -= 1
+    return (0x80000000 if value < 0 else 0) | ((exponent + 788) << 21) | \
+        int(mantissa)
+
+
+def vorbis_words(lengths):
+    """Code words of a length list, assigned like _make_words() does"""
+    marker = [0] * 33
+    words = []
+    for length in lengths:
+        entry = marker[length]
+        words.append(entry)
+        for j in range(length, 0, -1):
+            if marker[j] & 1:
+                marker[j] = marker[1] + 1 if j == 1 else marker[j - 1] << 1
+                break
+            marker[j] += 1
+        for j in range(length + 1, 33):
+            if marker[j] >> 1 == entry:
+                entry = marker[j]
+                marker[j] = marker[j - 1] << 1
+            else:
+                break
+    return words
+
+
+class VorbisBook:
+    def __init__(self, dim, lengths, lattice=None):
+        self.dim = dim
+        self.lengths = lengths
+        self.words = vorbis_words(lengths)
+        self.lattice = lattice
+
+    def write(self, bw):
+        bw.put(0x564342, 24)
+        bw.put(self.dim, 16)
+        bw.put(len(self.lengths), 24)
+        bw.put(0, 2)
+        for length in self.lengths:
+            bw.put(length - 1, 5)
+        if not self.lattice:
+            bw.put(0, 4)
+            return
+        minimum, delta, values = self.lattice
+        bw.put(1, 4)
+        bw.put(vorbis_float(minimum), 32)
+        bw.put(vorbis_float(delta), 32)
+        bw.put(values.bit_length() - 1, 4)
+        bw.put(0, 1)
+        for v in range(values):
+            bw.put(v, values.bit_length())
+
+    def put(self, bw, entry):
+        bw.code(self.words[entry], self.lengths[entry])
+
+
+def vorbis(packets, seed, rate=44100):
+    """Stereo Vorbis, 256 and 2048 sample blocks, floor 1 and residue 2 with
+    channel coupling. Floor posts and residue vectors are random."""
+    rnd = Random(seed)
+    books = [
+        VorbisBook(1, [5] * 32),                           # floor posts
+        VorbisBook(2, [2, 2, 3, 3, 4, 4, 5, 5,
+                       6, 6, 7, 7, 8, 8, 8, 8]),           # residue classes
+        VorbisBook(2, [4] * 16, (-1.5, 1.0, 4)),           # coarse vectors
+        VorbisBook(4, [8] * 256, (-0.375, 0.25, 4)),       # fine vectors
+    ]
+    # per block size: floor posts (rangebits, x list), residue end
+    floors = [(7, [16, 32, 48, 64, 80, 96]),
+              (10, [8, 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768])]
+    cascades = [0, 1, 3, 2]
+    ident = BitWriterLE()
+    ident.put(1, 8)
+    ident.out += b"vorbis"
+    ident.put(0, 32)
+    ident.put(2, 8)
+    ident.put(rate, 32)
+    ident.put(0, 32)
+    ident.put(128000, 32)
+    ident.put(0, 32)
+    ident.put(8 | (11 << 4), 8)
+    ident.put(1, 1)
+    comment = BitWriterLE()
+    comment.put(3, 8)
+    comment.out += b"vorbis"
+    comment.put(7, 32)
+    comment.out += b"warble!"
+    comment.put(0, 32)
+    comment.put(1, 1)
+    setup = BitWriterLE()
+    setup.put(5, 8)
+    setup.out += b"vorbis"
+    setup.put(len(books) - 1, 8)
+    for book in books:
+        book.write(setup)
+    setup.put(0, 6)
+    setup.put(0, 16)
+    setup.put(len(floors) - 1, 6)
+    for rangebits, xs in floors:
+        setup.put(1, 16)
+        setup.put(len(xs) // 3, 5)
+        for _ in range(len(xs) // 3):
+            setup.put(0, 4)
+        setup.put(2, 3)       # class 0: three posts
+        setup.put(0, 2)       # no subclasses
+        setup.put(1, 8)       # book 0
+        setup.put(1, 2)       # multiplier 2, range 128
+        setup.put(rangebits, 4)
+        for x in xs:
+            setup.put(x, rangebits)
+    setup.put(1, 6)
+    for n in (128, 1024):
+        setup.put(2, 16)
+        setup.put(0, 24)
+        setup.put(2 * n, 24)
+        setup.put(31, 24)
+        setup.put(len(cascades) - 1, 6)
+        setup.put(1, 8)
+        for c in cascades:
+            setup.put(c, 3)
+            setup.put(0, 1)
+        setup.put(2, 8)       # class 1: coarse
+        setup.put(2, 8)       # class 2: coarse then fine
+        setup.put(3, 8)
+        setup.put(3, 8)       # class 3: fine
+    setup.put(1, 6)
+    for m in range(2):
+        setup.put(0, 16)
+        setup.put(0, 1)
+        setup.put(1, 1)
+        setup.put(0, 8)
+        setup.put(0, 1)       # magnitude channel 0
+        setup.put(1, 1)       # angle channel 1
+        setup.put(0, 2)
+        setup.put(0, 8)
+        setup.put(m, 8)
+        setup.put(m, 8)
+    setup.put(1, 6)
+    for m in range(2):
+        setup.put(m, 1)
+        setup.put(0, 16)
+        setup.put(0, 16)
+        setup.put(m, 8)
+    setup.put(1, 1)
+
+    out = [(ident.data(), None), (comment.data(), None),
+           (setup.data(), None)]
+    flags = [1 if (n // 6) % 3 else rnd.next(1) for n in range(packets + 1)]
+    granule = 0
+    for n in range(packets):
+        long_block = flags[n]
+        bw = BitWriterLE()
+        bw.put(0, 1)
+        bw.put(long_block, 1)
+        if long_block:
+            bw.put(flags[n - 1] if n else 1, 1)
+            bw.put(flags[n + 1], 1)
+        rangebits, xs = floors[long_block]
+        for ch in range(2):
+            if ch and rnd.below(8) == 0:
+                bw.put(0, 1)
+                continue
+            bw.put(1, 1)
+            bw.put(20 + rnd.below(30), 7)
+            bw.put(20 + rnd.below(30), 7)
+            for _ in xs:
+                books[0].put(bw, rnd.below(32))
+        partitions = 2 * (128, 1024)[long_block] // 32
+        classes = []
+        for stage in range(2):
+            for i in range(partitions):
+                if stage == 0 and i % 2 == 0:
+                    word = rnd.below(16)
+                    books[1].put(bw, word)
+                    classes += [word // 4, word % 4]
+                if cascades[classes[i]] & (1 << stage):
+                    book = books[2 + stage]
+                    for _ in range(32 // book.dim):
+                        book.put(bw, rnd.below(len(book.lengths)))
+        if n:
+            granule += ((256, 2048)[flags[n - 1]] +
+                        (256, 2048)[long_block]) // 4
+        out.append((bw.data(), granule))
+    return ogg(out, seed)
+
+
+def opus(packets, seed):
+    """Stereo Ogg Opus cycling through SILK, hybrid and CELT frames of each
+    bandwidth, mono and stereo, one and two frames per packet. The range
+    coder turns any payload into valid symbols, so payloads are random."""
+    rnd = Random(seed)
+    # TOC config, frame length in 1/400 s, payload bytes
+    configs = [(1, 8, 40), (5, 8, 50), (9, 8, 60), (13, 8, 120),
+               (15, 8, 160), (19, 8, 100), (23, 8, 140), (27, 8, 180),
+               (31, 8, 220), (29, 2, 60), (30, 4, 90), (11, 24, 150)]
+    head = b"OpusHead" + struct.pack("<BBHIhB", 1, 2, 312, 48000, -12 << 8, 0)
+    tags = b"OpusTags" + struct.pack("<I", 7) + b"warble!" + \
+        struct.pack("<I", 0)
+    out = [(head, None), (tags, None)]
+    granule = 0
+    for n in range(packets):
+        config, length, size = configs[n % len(configs)]
+        stereo = (n // len(configs)) & 1
+        frames = 2 if n % 5 == 4 and length <= 8 else 1
+        payload = bytes(rnd.next(8) for _ in range(size * frames))
+        out.append((bytes([(config << 3) | (stereo << 2) | (frames - 1)]) +
+                    payload, None))
+        granule += 120 * length * frames
+        out[-1] = (out[-1][0], granule)
+    # the codec drops the packet that ends the stream
+    out.append((b"\xf8\xff\xfe", granule + 960))
+    return ogg(out, seed)
+
+
+# Speex bits per frame of each narrowband and wideband submode, the mode
+# bits included
+SPEEX_NB_BITS = [0, 43, 119, 160, 220, 300, 364, 492, 79]
+SPEEX_WB_BITS = [0, 36, 112, 192, 352]
+
+
+def speex(packets, seed):
+    """Wideband stereo Ogg Speex, two frames per packet, cycling through the
+    narrowband and wideband submodes. Every field is a quantiser index, so
+    random values are all valid; ones are kept sparse so the gains stay low
+    and the output does not clip."""
+    rnd = Random(seed)
+    head = b"Speex   " + b"1.2rc1".ljust(20, b"\0") + \
+        struct.pack("<13i", 1, 80, 16000, 1, 4, 2, -1, 320, 0, 2, 0, 0, 0)
+    comment = struct.pack("<I", 7) + b"warble!" + struct.pack("<I", 0)
+    out = [(head, None), (comment, None)]
+    for n in range(packets):
+        bw = BitWriter()
+        for f in range(2):
+            # in-band stereo balance and energy ratio
+            bw.put(14, 5)
+            bw.put(9, 4)
+            bw.put(rnd.next(8), 8)
+            nb = 1 + (2 * n + f) % 8
+            bw.put(nb, 5)
+            for _ in range(SPEEX_NB_BITS[nb] - 5):
+                bw.put(int(rnd.below(6) == 0), 1)
+            wb = (n // 4 + f) % 5
+            if wb:
+                bw.put(8 | wb, 4)
+                for _ in range(SPEEX_WB_BITS[wb] - 4):
+                    bw.put(int(rnd.below(6) == 0), 1)
+        # speex_bits_insert_terminator(): a zero, then ones to the byte
+        if bw.count:
+            bw.put(0, 1)
+            bw.align(0xff)
+        out.append((bw.data(), 640 * (n + 1)))
+    return ogg(out, seed)
+
+
+# warble configuration for formats that never end on their own
+ENDLESS = "wait=44100:halt=1"
+
+
+def corpus():
+    """(name, file data[, warble configuration]) of every corpus file"""
+    sig = Signal(1)
+    s16 = sig.samples(44100, 44100, 2, 16)
+    s24mono = Signal(6).samples(48000, 24000, 1, 24)
+    return [
+        ("pcm16_stereo.wav", wav_pcm(44100, 2, 16, s16)),
+        ("pcm8_mono.wav", wav_pcm(22050, 1, 8,
+                                  Signal(2).samples(22050, 22050, 1, 8))),
+        ("pcm24_stereo.wav", wav_pcm(48000, 2, 24,
+                                     Signal(3).samples(48000, 24000, 2, 24))),
+        ("ima_adpcm.wav", wav_ima_adpcm(22050,
+                                        Signal(4).samples(22050, 22050, 1,
+                                                          16))),
+        ("pcm16_stereo.aiff", aiff(44100, 2, s16)),
+        ("mulaw.au", au_mulaw(8000, Signal(5).samples(8000, 16000, 1, 16))),
+        ("verbatim.flac", flac_verbatim(44100, 2, s16)),
+        ("predictive.flac", flac_predictive(44100, 2, 16, s16)),
+        ("layer1.mp1", mp1(40, 7)),
+        ("layer2.mp2", mp2(40, 8)),
+        ("layer3.mp3", mp3(40, 9)),
+        ("layer3_lsf.mp3", mp3(40, 10, True)),
+        ("stereo.ogg", vorbis(150, 11)),
+        ("modes.opus", opus(120, 12)),
+        ("wideband.spx", speex(100, 13)),
+        ("alaw.wav", wav_alaw(8000, Signal(7).samples(8000, 8000, 1, 16))),
+        ("float_stereo.wav", wav_float(22050, 2, s16[:22050])),
+        ("ms_adpcm.wav", wav_ms_adpcm(22050, s16[:22050])),
+        ("ima_adpcm2.wav", wav_dvi_adpcm(22050, 1, 2, s16[:11025])),
+        ("ima_adpcm3.wav", wav_dvi_adpcm(22050, 2, 3, s16[:22050])),
+        ("ima_adpcm5.wav", wav_dvi_adpcm(22050, 2, 5, s16[:22050])),
+        ("yamaha_adpcm.wav", wav_yamaha_adpcm(22050, s16[:22050])),
+        ("swf_adpcm.wav", wav_swf_adpcm(22050, 3, s16[:22050])),
+        ("oki_adpcm.vox", vox(Signal(8).samples(8000, 8000, 1, 16))),
+        ("float64_aifc.aif", aifc_float64(22050, 2, s16[:22050])),
+        ("alaw_aifc.aif", aifc_alaw(8000, Signal(9).samples(8000, 8000, 1, 16))),
+        ("ima4_aifc.aif", aifc_ima4(22050, s16[:11025])),
+        ("pcm16_mono.w64", wave64(22050, 1, s16[:11025])),
+        ("looped.adx", adx(22050, s16[:22050], 128)),
+        ("stereo.tta", tta(44100, 2, 16, s16 + s16[:11840])),
+        ("mono24.tta", tta(48000, 1, 24, s24mono)),
+        ("stereo.shn", shorten(44100, [0] * 512 + s16[:22050])),
+        ("predictive24.flac", flac_predictive(48000, 1, 24, s24mono, 1152)),
+        ("stereo.wv", wavpack(44100, s16, 11025)),
+        ("protracker.mod", protracker(14), ENDLESS),
+        ("psg_fm.vgm", vgm(15, 2)),
+        ("apu.nsf", nsf(), ENDLESS),
+        ("voices.sid", psid(), ENDLESS),
+        ("pokey.sap", sap()),
+        ("apu.gbs", gbs(), ENDLESS),
+        ("spectrum.ay", ay()),
+        ("scc.kss", kss(), ENDLESS),
+        ("gamegear.sgc", sgc(), ENDLESS),
+        ("pcengine.hes", hes(), ENDLESS),
+        ("voices.spc", spc()),
+        ("registers.vtx", vtx(100)),
+        ("yamaha_adpcm.mmf", smaf(Signal(16).samples(22050, 22050, 1, 16))),
+        ("stereo.m4a", alac(44100, s16)),
+        ("pns.mp4", aac_mp4(44100, 86)),
+        ("pns_mono.aac", adts(32000, 63)),
+        ("pns.rm", raac(44100, 86)),
+        ("cook.rm", cook(44100, 86, 17)),
+        ("atrac3.rm", atrac3_rm(86, 18)),
+        ("joint_stereo.oma", oma(86, 19)),
+        ("dither.ac3", a52(63)),
+        ("dnet.rm", a52_rm(57)),
+        ("stereo.ape", ape(44100, 2, s16)),
+        ("mono.ape", ape(22050, 1, s16[:11025])),
+        ("stereo.mpc", mpc(40, 20)),
+        ("stereo.wma", wma(43)),
+        ("stereo_pro.wma", wmapro(43)),
+    ]
+
+
@@ -0,0 +1,189 @@
+#!/usr/bin/python
+#             __________               __   ___.
+#   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+#   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+#   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+#   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+#                     \/            \/     \/    \/            \/
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+# KIND, either express or implied.
+#
+# Renders a buflib trace saved from the "View buflib trace" debug screen
+# (/buflib_trace.txt) as an SVG timeline of the buffer, and prints which
+# allocations cause the most moves and shrinks.
+#
+# Usage: buflib_trace.py buflib_trace.txt [out.svg]
+
+import sys
+
+WIDTH = 1000
+HEIGHT = 600
+MARGIN = 40
+
+COLOURS = ["#4e79a7", "#f28e2b", "#e15759", "#76b7b2", "#59a14f",
+           "#edc948", "#b07aa1", "#ff9da7", "#9c755f", "#bab0ac"]
+
+
+def parse(path):
+    size = 0
+    hz = 100
+    events = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith("# buflib trace"):
+                words = line.replace(",", " ").split()
+                for i, w in enumerate(words[:-1]):
+                    if w == "size":
+                        size = int(words[i + 1])
+                    elif w == "hz":
+                        hz = int(words[i + 1])
+                continue
+            if line.startswith("#"):
+                continue
+            f = line.split(None, 6)
+            events.append({"time": int(f[0]), "type": f[1],
+                           "handle": int(f[2]), "offset": int(f[3]),
+                           "size": int(f[4]), "from": int(f[5]),
+                           "name": f[6] if len(f) > 6 else "-"})
+    return size, hz, events
+
+
+def replay(events):
+    """Turns the events into (start, end, offset, size, name) spans."""
+    spans = []
+    moves = []
+    live = {}
+    t0 = events[0]["time"]
+    t1 = events[-1]["time"]
+
+    def close(handle, t):
+        s = live.pop(handle, None)
+        if s:
+            spans.append((s[0], t) + s[1:])
+
+    for ev in events:
+        t, h, kind = ev["time"], ev["handle"], ev["type"]
+        if kind == "alloc":
+            live[h] = (t, ev["offset"], ev["size"], ev["name"])
+        elif kind == "free":
+            if h not in live:  # allocated before the trace window
+                live[h] = (t0, ev["offset"], ev["size"], ev["name"])
+            close(h, t)
+        elif kind == "move":
+            if h not in live:
+                live[h] = (t0, ev["from"], ev["size"], ev["name"])
+            close(h, t)
+            live[h] = (t, ev["offset"], ev["size"], ev["name"])
+            moves.append((t, ev["from"], ev["offset"]))
+        elif kind == "shrink":
+            if h in live:
+                close(h, t)
+            live[h] = (t, ev["offset"], ev["size"], ev["name"])
+
+    for h in list(live):
+        close(h, t1)
+    return spans, moves, t0, t1
+
+
+def render(out, size, spans, moves, events, t0, t1):
+    span_t = max(t1 - t0, 1)
+    if not size:
+        size = max(s[2] + s[3] for s in spans) if spans else 1
+    w = WIDTH - 2 * MARGIN
+    h = HEIGHT - 2 * MARGIN
+
+    def x(t):
+        return MARGIN + (t - t0) * w / float(span_t)
+
+    def y(offset):
+        return MARGIN + offset * h / float(size)
+
+    names = sorted(set(s[4] for s in spans))
+    colour = dict((n, COLOURS[i % len(COLOURS)]) for i, n in enumerate(names))
+
+    out.write('<svg xmlns="http://www.w3.org/2000/svg" '
+              'width="%d" height="%d">\n' % (WIDTH, HEIGHT))
+    out.write('<rect x="%d" y="%d" width="%d" height="%d" fill="#fff" '
+              'stroke="#000"/>\n' % (MARGIN, MARGIN, w, h))
+    for start, end, offset, bsize, name in spans:
+        out.write('<rect x="%.1f" y="%.1f" width="%.1f" height="%.1f" '
+                  'fill="%s" fill-opacity="0.7"><title>%s %d B @%d</title>'
+                  '</rect>\n' % (x(start), y(offset),
+                                 max(x(end) - x(start), 1),
+                                 max(y(offset + bsize) - y(offset), 1),
+                                 colour[name], name, bsize, offset))
+    for t, src, dst in moves:
+        out.write('<line x1="%.1f" y1="%.1f" x2="%.1f" y2="%.1f" '
+                  'stroke="#000" stroke-width="0.5"/>\n'
+                  % (x(t), y(src), x(t), y(dst)))
+    for ev in events:
+        if ev["type"] in ("fail", "compact"):
+            out.write('<line x1="%.1f" y1="%d" x2="%.1f" y2="%d" '
+                      'stroke="%s"><title>%s %d B</title></line>\n'
+                      % (x(ev["time"]), MARGIN, x(ev["time"]), MARGIN + h,
+                         "red" if ev["type"] == "fail" else "grey",
+                         ev["type"], ev["size"]))
+    for i, n in enumerate(names):
+        out.write('<text x="%d" y="%d" font-size="10" fill="%s">%s</text>\n'
+                  % (MARGIN + i * 90, MARGIN - 8, colour[n], n))
+    out.write('<text x="%d" y="%d" font-size="10">offset 0</text>\n'
+              % (2, MARGIN + 10))
+    out.write('<text x="%d" y="%d" font-size="10">%d</text>\n'
+              % (2, MARGIN + h, size))
+    out.write('</svg>\n')
+
+
+def summary(events, hz):
+    stats = {}
+    for ev in events:
+        s = stats.setdefault(ev["name"], {"alloc": 0, "free": 0, "move": 0,
+                                          "move_bytes": 0, "shrink": 0,
+                                          "fail": 0})
+        if ev["type"] in s:
+            s[ev["type"]] += 1
+        if ev["type"] == "move":
+            s["move_bytes"] += ev["size"]
+
+    t = (events[-1]["time"] - events[0]["time"]) / float(hz)
+    print("%d events over %.1f s" % (len(events), t))
+    print("%-14s %6s %6s %6s %10s %6s %6s" % ("name", "alloc", "free",
+                                             "move", "moved B", "shrink",
+                                             "fail"))
+    for name, s in sorted(stats.items(),
+                          key=lambda i: (i[1]["move_bytes"], i[1]["shrink"]),
+                          reverse=True):
+        print("%-14s %6d %6d %6d %10d %6d %6d" % (name, s["alloc"], s["free"],
+                                                 s["move"], s["move_bytes"],
+                                                 s["shrink"], s["fail"]))
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: %s buflib_trace.txt [out.svg]" % sys.argv[0])
+        sys.exit(1)
+
+    size, hz, events = parse(sys.argv[1])
+    if not events:
+        print("no events in %s" % sys.argv[1])
+        sys.exit(1)
+
+    summary(events, hz)
+
+    spans, moves, t0, t1 = replay(events)
+    path = sys.argv[2] if len(sys.argv) > 2 else "buflib_trace.svg"
+    with open(path, "w") as out:
+        render(out, size, spans, moves, events, t0, t1)
+    print("wrote %s" % path)
+
+
+if __name__ == "__main__":
+    main()